@@ -167,6 +167,64 @@ struct argp_option program_options[] =
       GAL_OPTIONS_NOT_MANDATORY,
       GAL_OPTIONS_NOT_SET
     },
+    {
+      "stackcount",
+      UI_KEY_STACKCOUNT,
+      0,
+      0,
+      "Stacking files: also write number of used inputs.",
+      GAL_OPTIONS_GROUP_OUTPUT,
+      &p->stackcount,
+      GAL_OPTIONS_NO_ARG_TYPE,
+      GAL_OPTIONS_RANGE_0_OR_1,
+      GAL_OPTIONS_NOT_MANDATORY,
+      GAL_OPTIONS_NOT_SET
+    },
+    {
+      "stackrejected",
+      UI_KEY_STACKREJECTED,
+      0,
+      0,
+      "Stacking files: also write number of clipped.",
+      GAL_OPTIONS_GROUP_OUTPUT,
+      &p->stackrejected,
+      GAL_OPTIONS_NO_ARG_TYPE,
+      GAL_OPTIONS_RANGE_0_OR_1,
+      GAL_OPTIONS_NOT_MANDATORY,
+      GAL_OPTIONS_NOT_SET
+    },
+
+
+
+
+
+    /* Operating mode options. */
+    {
+      "stackrows",
+      UI_KEY_STACKROWS,
+      "INT",
+      0,
+      "Stacking files: rows in each strip (0: auto).",
+      GAL_OPTIONS_GROUP_OPERATING_MODE,
+      &p->stackrows,
+      GAL_TYPE_SIZE_T,
+      GAL_OPTIONS_RANGE_GE_0,
+      GAL_OPTIONS_NOT_MANDATORY,
+      GAL_OPTIONS_NOT_SET
+    },
+    {
+      "stackmaxopen",
+      UI_KEY_STACKMAXOPEN,
+      "INT",
+      0,
+      "Stacking files: max. open inputs (0: auto).",
+      GAL_OPTIONS_GROUP_OPERATING_MODE,
+      &p->stackmaxopen,
+      GAL_TYPE_SIZE_T,
+      GAL_OPTIONS_RANGE_GE_0,
+      GAL_OPTIONS_NOT_MANDATORY,
+      GAL_OPTIONS_NOT_SET
+    },
 
     {0}
   };
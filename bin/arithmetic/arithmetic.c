@@ -29,8 +29,12 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <string.h>
 #include <stdlib.h>
 
+#include <gnuastro/fit.h>
 #include <gnuastro/wcs.h>
 #include <gnuastro/fits.h>
+#include <gnuastro/pool.h>
+#include <gnuastro/blank.h>
+#include <gnuastro/qsort.h>
 #include <gnuastro/array.h>
 #include <gnuastro/binary.h>
 #include <gnuastro/threads.h>
@@ -45,6 +49,7 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include "main.h"
 
 #include "operands.h"
+#include "stackfits.h"
 #include "arithmetic.h"
 
 
@@ -196,148 +201,257 @@ struct arithmetic_filter_p
 
 
 
-/* Main filtering work function. */
+/* The sigma-clipping filters are done with a sliding window along the
+   fastest dimension: each thread takes one line of the input (along the
+   fastest dimension) at a time and keeps the non-blank elements within
+   the window sorted. When the window moves by one element, only the
+   elements of the column that leaves the window are removed and those of
+   the column that enters it are added (through a merge). Each column is
+   only sorted once (when it enters the window): the sorted columns that
+   are within the window are kept (in a circular buffer with one slot for
+   each column of the window) until they leave it.
+
+   Once the window is sorted, the cumulative sums of its values (and
+   their squares) are found so the mean and standard deviation of every
+   sigma-clipping round can be found in constant time (the clipped range
+   is contiguous in the sorted array). To avoid loosing precision in the
+   subtraction of the cumulative sums, the median of the window is
+   subtracted from all values. Otherwise, the clipping is identical to
+   'gal_statistics_sigma_clip'.
+
+   Therefore, for a window of 'W' elements, where each column has 'h'
+   elements, every pixel needs 'O(W)' operations (for the merge, the
+   removal and the cumulative sums) and 'O(h log h)' for sorting the
+   entering column. This is instead of the 'O(W log W)' of copying and
+   sorting the full window. */
+#define FILTER_SIGCLIP_COLUMN(IT, X) {                                  \
+    col=(IT *)columns + ((X)%fsize[f])*kmax;                            \
+    for(c=cn=0; c<k; ++c)                                               \
+      {                                                                 \
+        v=in[ base[c] + (X) ];                                          \
+        if( isfloat ? v==v : v!=b ) col[cn++]=v;                        \
+      }                                                                 \
+    if(cn>1) qsort(col, cn, sizeof *col, sortfunc);                     \
+    cnum[(X)%fsize[f]]=cn;                                              \
+  }
+
+#define FILTER_SIGCLIP(IT) {                                            \
+    IT *t, v, b, med_t;                                                 \
+    IT *in=input->array, *col, *a=sorted, *mg=merged;                  \
+    gal_blank_write(&b, input->type);                                   \
+                                                                        \
+    /* Go over all the elements of this line. */                        \
+    n=cl=cr=0;                                                          \
+    for(x=0; x<len; ++x)                                                \
+      {                                                                 \
+        /* Boundaries of the window along the fastest dimension. */     \
+        l = x<hnfsize[f] ? 0 : x-hnfsize[f];                            \
+        r = x+hpfsize[f]+1>len ? len : x+hpfsize[f]+1;                  \
+                                                                        \
+        /* Remove the columns that have left the window (both the     */\
+        /* column and the window are sorted, so the elements of the   */\
+        /* column are removed as soon as they are reached).           */\
+        for(; cl<l; ++cl)                                               \
+          {                                                             \
+            col=(IT *)columns + (cl%fsize[f])*kmax;                     \
+            cn=cnum[cl%fsize[f]];                                       \
+            for(i=j=nn=0; i<n; ++i)                                     \
+              if(j<cn && a[i]==col[j]) ++j; else mg[nn++]=a[i];         \
+            n=nn; t=a; a=mg; mg=t;                                      \
+          }                                                             \
+                                                                        \
+        /* Add the columns that have entered the window. */             \
+        for(; cr<r; ++cr)                                               \
+          {                                                             \
+            FILTER_SIGCLIP_COLUMN(IT, cr);                              \
+            i=j=nn=0;                                                   \
+            while(i<n && j<cn)                                          \
+              mg[nn++] = a[i]<=col[j] ? a[i++] : col[j++];              \
+            while(i<n)         mg[nn++] = a[i++];                       \
+            while(j<cn)        mg[nn++] = col[j++];                     \
+            n=nn; t=a; a=mg; mg=t;                                      \
+          }                                                             \
+                                                                        \
+        /* Do the sigma-clipping over the sorted window. */             \
+        switch(n)                                                       \
+          {                                                             \
+          case 0: o[x]=NAN;      break;                                 \
+          case 1: o[x]=a[0];     break;                                 \
+          default:                                                      \
+            shift=a[n/2];                                               \
+            ps[0]=ps2[0]=0.0f;                                          \
+            for(i=0;i<n;++i)                                            \
+              {                                                         \
+                d=a[i]-shift;                                           \
+                ps[i+1]=ps[i]+d;                                        \
+                ps2[i+1]=ps2[i]+d*d;                                    \
+              }                                                         \
+            num=0; st=0; size=n;                                        \
+            oldmed=oldmean=oldstd=NAN;                                  \
+            while(num<maxnum && size)                                   \
+              {                                                         \
+                /* Mean, standard deviation and median of this round. */\
+                if(size==1) { mean=a[st]; std=0.0f; }                   \
+                else                                                    \
+                  {                                                     \
+                    s=ps[st+size]-ps[st];                               \
+                    mean = shift + s/size;                              \
+                    std  = gal_statistics_std_from_sums(s,              \
+                                         ps2[st+size]-ps2[st], size);   \
+                  }                                                     \
+                med_t = ( size%2 ? a[st+size/2]                         \
+                          : (a[st+size/2]+a[st+size/2-1])/2 );          \
+                med=med_t;                                              \
+                                                                        \
+                /* Check the tolerance. */                              \
+                if( bytolerance && num>0 )                              \
+                  if( std==0 || ((oldstd - std) / std) < afp->sclip_param ) \
+                    {                                                   \
+                      if(std==0) {oldmed=med; oldstd=std; oldmean=mean;} \
+                      break;                                            \
+                    }                                                   \
+                                                                        \
+                /* Clip the elements out of the range (by changing the */\
+                /* starting point and size of the clipped range).     */\
+                e=st+size;                                              \
+                for(i=st; i<e; ++i)                                     \
+                  if( a[i] > (med - (afp->sclip_multip * std)) ) break; \
+                for(j=e; j>st; --j)                                     \
+                  if( a[j-1] < (med + (afp->sclip_multip * std)) )      \
+                    { size = j>i ? j-i : 0; break; }                    \
+                if(i<e) st=i;                                           \
+                                                                        \
+                /* Keep the values of this round. */                    \
+                oldmed=med; oldstd=std; oldmean=mean;                   \
+                ++num;                                                  \
+              }                                                         \
+            o[x] = ( (size==0 || (bytolerance && num==maxnum))          \
+                     ? NAN                                              \
+                     : ( afp->operator==ARITHMETIC_OP_FILTER_SIGCLIP_MEAN \
+                         ? oldmean : oldmed ) );                        \
+          }                                                             \
+      }                                                                 \
+  }
+
 static void *
-arithmetic_filter(void *in_prm)
+arithmetic_filter_sigclip(void *in_prm)
 {
   struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
   struct arithmetic_filter_p *afp=(struct arithmetic_filter_p *)tprm->params;
   gal_data_t *input=afp->input;
 
-  size_t sind=-1;
-  size_t ind, index, one=1;
-  gal_data_t *sigclip, *result=NULL;
+  float *o;
+  int (*sortfunc)(const void *, const void *)=NULL;
+  void *sorted, *merged, *columns;
+  double *ps, *ps2, d, s, shift, mean, std, med;
+  double oldmed, oldmean, oldstd;
   size_t *hpfsize=afp->hpfsize, *hnfsize=afp->hnfsize;
-  size_t *tsize, *dsize=input->dsize, *fsize=afp->fsize;
-  size_t i, j, coord[ARITHMETIC_FILTER_DIM], ndim=input->ndim;
+  size_t *dsize=input->dsize, *fsize=afp->fsize, ndim=input->ndim;
   size_t start[ARITHMETIC_FILTER_DIM], end[ARITHMETIC_FILTER_DIM];
-  gal_data_t *tile=gal_data_alloc(NULL, input->type, ndim, afp->fsize, NULL,
-                                  0, -1, 1, NULL, NULL, NULL);
-
-  /* Prepare the tile. */
-  free(tile->array);
-  tsize=tile->dsize;
-  tile->block=input;
-
-
-  /* Go over all the pixels that were assigned to this thread. */
-  for(i=0; tprm->indexs[i] != GAL_BLANK_SIZE_T; ++i)
+  size_t coord[ARITHMETIC_FILTER_DIM], cc[ARITHMETIC_FILTER_DIM];
+  size_t c, e, i, j, k, l, n, q, r, x, cl, cn, cr, nn, st, num, size, kmax;
+  size_t f=ndim-1, len=dsize[f], wsize=1, *base, *cnum, line, maxnum;
+  int isfloat=( input->type==GAL_TYPE_FLOAT32
+                || input->type==GAL_TYPE_FLOAT64 );
+  uint8_t bytolerance = afp->sclip_param>=1.0f ? 0 : 1;
+
+  /* Termination criteria, as in 'gal_statistics_sigma_clip'. */
+  maxnum = ( afp->sclip_param>=1.0f
+             ? afp->sclip_param
+             : GAL_STATISTICS_SIG_CLIP_MAX_CONVERGE );
+
+  /* Allocate the spaces that are necessary for each line. */
+  for(i=0;i<ndim;++i) wsize*=fsize[i];
+  base=gal_pointer_allocate(GAL_TYPE_SIZE_T, wsize/fsize[f], 0,
+                            __func__, "base");
+  kmax=wsize/fsize[f];
+  cnum=gal_pointer_allocate(GAL_TYPE_SIZE_T, fsize[f], 0, __func__, "cnum");
+  columns=gal_pointer_allocate(input->type, wsize, 0, __func__, "columns");
+  sorted=gal_pointer_allocate(input->type, wsize, 0, __func__, "sorted");
+  merged=gal_pointer_allocate(input->type, wsize, 0, __func__, "merged");
+  ps=gal_pointer_allocate(GAL_TYPE_FLOAT64, wsize+1, 0, __func__, "ps");
+  ps2=gal_pointer_allocate(GAL_TYPE_FLOAT64, wsize+1, 0, __func__, "ps2");
+
+  /* Function to sort the elements of each column. */
+  switch(input->type)
     {
-      /* For easy reading, put the index in 'ind'. */
-      ind=tprm->indexs[i];
-
-      /* Get the coordinate of the pixel. */
-      gal_dimension_index_to_coord(ind, ndim, dsize, coord);
+    case GAL_TYPE_UINT8:   sortfunc=gal_qsort_uint8_i;   break;
+    case GAL_TYPE_INT8:    sortfunc=gal_qsort_int8_i;    break;
+    case GAL_TYPE_UINT16:  sortfunc=gal_qsort_uint16_i;  break;
+    case GAL_TYPE_INT16:   sortfunc=gal_qsort_int16_i;   break;
+    case GAL_TYPE_UINT32:  sortfunc=gal_qsort_uint32_i;  break;
+    case GAL_TYPE_INT32:   sortfunc=gal_qsort_int32_i;   break;
+    case GAL_TYPE_UINT64:  sortfunc=gal_qsort_uint64_i;  break;
+    case GAL_TYPE_INT64:   sortfunc=gal_qsort_int64_i;   break;
+    case GAL_TYPE_FLOAT32: sortfunc=gal_qsort_float32_i; break;
+    case GAL_TYPE_FLOAT64: sortfunc=gal_qsort_float64_i; break;
+    default:
+      error(EXIT_FAILURE, 0, "%s: type code %d not recognized",
+            __func__, input->type);
+    }
 
-      /* See which dimensions need trimming. */
-      tile->size=1;
-      for(j=0;j<ndim;++j)
+  /* Go over all the lines that were assigned to this thread. */
+  for(q=0; tprm->indexs[q] != GAL_BLANK_SIZE_T; ++q)
+    {
+      /* Coordinates of the first element in this line. */
+      line=tprm->indexs[q];
+      o=(float *)(afp->out->array) + line*len;
+      gal_dimension_index_to_coord(line*len, ndim, dsize, coord);
+
+      /* The range of the window over the slower dimensions (it is fixed
+         for all the elements of the line). Note that we are dealing with
+         size_t (unsigned int) type here, so there are no negatives: a
+         negative result will produce an extremely large number, so
+         instead of checking for negative, we can just see if the result
+         of a subtraction is larger than the width of the input. */
+      for(j=0;j<f;++j)
         {
-          /* Estimate the coordinate of the filter's starting point. Note
-             that we are dealing with size_t (unsigned int) type here, so
-             there are no negatives. A negative result will produce an
-             extremely large number, so instead of checking for negative,
-             we can just see if the result of a subtraction is less than
-             the width of the input. */
-          if( (coord[j] - hnfsize[j] > dsize[j])
-              || (coord[j] + hpfsize[j] >= dsize[j]) )
-            {
-              start[j] = ( (coord[j] - hnfsize[j] > dsize[j])
-                           ? 0 : coord[j] - hnfsize[j] );
-              end[j]   = ( (coord[j] + hpfsize[j] >= dsize[j])
-                           ? dsize[j]
-                           : coord[j] + hpfsize[j] + 1);
-              tsize[j] = end[j] - start[j];
-            }
-          else  /* NOT on the edge (given requested filter width). */
-            {
-              tsize[j] = fsize[j];
-              start[j] = coord[j] - hnfsize[j];
-            }
-          tile->size *= tsize[j];
+          start[j] = ( (coord[j] - hnfsize[j] > dsize[j])
+                       ? 0 : coord[j] - hnfsize[j] );
+          end[j]   = ( (coord[j] + hpfsize[j] >= dsize[j])
+                       ? dsize[j] : coord[j] + hpfsize[j] + 1 );
         }
 
-      /* For a test.
-         printf("coord: %zu, %zu\n", coord[1]+1, coord[0]+1);
-         printf("\tstart: %zu, %zu\n", start[1]+1, start[0]+1);
-         printf("\ttsize: %zu, %zu\n", tsize[1], tsize[0]);
-      */
-
-      /* Set the tile's starting pointer. */
-      index=gal_dimension_coord_to_index(ndim, dsize, start);
-      tile->array=gal_pointer_increment(input->array, index, input->type);
-
-      /* Do the necessary calculation. */
-      switch(afp->operator)
+      /* Index of the first element (along the fastest dimension) of the
+         'k' columns that are within the window. */
+      k=0;
+      for(j=0;j<f;++j) cc[j]=start[j];
+      do
         {
-        case ARITHMETIC_OP_FILTER_MEDIAN:
-          result=gal_statistics_median(tile, 0);
-          break;
-
-
-        case ARITHMETIC_OP_FILTER_MEAN:
-          result=gal_statistics_mean(tile);
-          break;
-
-
-        case ARITHMETIC_OP_FILTER_SIGCLIP_MEAN:
-        case ARITHMETIC_OP_FILTER_SIGCLIP_MEDIAN:
-          /* Find the sigma-clipped results. */
-          sigclip=gal_statistics_sigma_clip(tile, afp->sclip_multip,
-                                            afp->sclip_param, 0, 1);
-
-          /* Set the required index. */
-          switch(afp->operator)
-            {
-            case ARITHMETIC_OP_FILTER_SIGCLIP_MEAN:   sind = 2; break;
-            case ARITHMETIC_OP_FILTER_SIGCLIP_MEDIAN: sind = 1; break;
-            default:
-              error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at "
-                    "%s to fix the problem. The 'afp->operator' value "
-                    "%d is not recognized as sigma-clipped median or "
-                    "mean", __func__, PACKAGE_BUGREPORT, afp->operator);
-            }
-
-          /* Allocate the output and write the value into it. */
-          result=gal_data_alloc(NULL, GAL_TYPE_FLOAT32, 1, &one, NULL,
-                                0, -1, 1, NULL, NULL, NULL);
-          ((float *)(result->array))[0] =
-            ((float *)(sigclip->array))[sind];
-
-          /* Clean up. */
-          gal_data_free(sigclip);
-          break;
-
+          cc[f]=0;
+          base[k++]=gal_dimension_coord_to_index(ndim, dsize, cc);
+          for(j=f; j>0; --j)
+            if( ++cc[j-1] < end[j-1] ) break; else cc[j-1]=start[j-1];
+        }
+      while(j>0);
 
+      /* Do the filtering over the line. */
+      switch(input->type)
+        {
+        case GAL_TYPE_UINT8:   FILTER_SIGCLIP( uint8_t  );  break;
+        case GAL_TYPE_INT8:    FILTER_SIGCLIP( int8_t   );  break;
+        case GAL_TYPE_UINT16:  FILTER_SIGCLIP( uint16_t );  break;
+        case GAL_TYPE_INT16:   FILTER_SIGCLIP( int16_t  );  break;
+        case GAL_TYPE_UINT32:  FILTER_SIGCLIP( uint32_t );  break;
+        case GAL_TYPE_INT32:   FILTER_SIGCLIP( int32_t  );  break;
+        case GAL_TYPE_UINT64:  FILTER_SIGCLIP( uint64_t );  break;
+        case GAL_TYPE_INT64:   FILTER_SIGCLIP( int64_t  );  break;
+        case GAL_TYPE_FLOAT32: FILTER_SIGCLIP( float    );  break;
+        case GAL_TYPE_FLOAT64: FILTER_SIGCLIP( double   );  break;
         default:
-          error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at %s "
-                "to fix the problem. 'afp->operator' code %d is not "
-                "recognized", PACKAGE_BUGREPORT, __func__,
-                afp->operator);
+          error(EXIT_FAILURE, 0, "%s: type code %d not recognized",
+                __func__, input->type);
         }
-
-      /* Make sure the output array type and result's type are the
-         same. */
-      if(result->type!=afp->out->type)
-        result=gal_data_copy_to_new_type_free(result, afp->out->type);
-
-
-      /* Copy the result into the output array. */
-      memcpy(gal_pointer_increment(afp->out->array, ind, afp->out->type),
-             result->array, gal_type_sizeof(afp->out->type));
-
-      /* Clean up for this pixel. */
-      gal_data_free(result);
     }
 
-
-  /* Clean up for this thread. */
-  tile->array=NULL;
-  tile->block=NULL;
-  gal_data_free(tile);
-
-
-  /* Wait for all the other threads to finish, then return. */
+  /* Clean up and wait for all the other threads to finish. */
+  free(ps);
+  free(ps2);
+  free(base);
+  free(cnum);
+  free(columns);
+  free(sorted);
+  free(merged);
   if(tprm->b) pthread_barrier_wait(tprm->b);
   return NULL;
 }
@@ -352,7 +466,7 @@ wrapper_for_filter(struct arithmeticparams *p, char *token, int operator)
   int type=GAL_TYPE_INVALID;
   size_t i=0, ndim, nparams, one=1;
   struct arithmetic_filter_p afp={0};
-  size_t fsize[ARITHMETIC_FILTER_DIM];
+  size_t fsize[ARITHMETIC_FILTER_DIM], stride[ARITHMETIC_FILTER_DIM];
   gal_data_t *tmp, *tmp2, *zero, *comp, *params_list=NULL;
   size_t hnfsize[ARITHMETIC_FILTER_DIM], hpfsize[ARITHMETIC_FILTER_DIM];
   int issigclip=(operator==ARITHMETIC_OP_FILTER_SIGCLIP_MEAN
@@ -511,18 +625,43 @@ wrapper_for_filter(struct arithmeticparams *p, char *token, int operator)
         }
 
 
-      /* Allocate the output dataset. Note that filtering doesn't change
-         the units of the dataset. */
-      afp.out=gal_data_alloc(NULL, type, ndim, afp.input->dsize,
-                             afp.input->wcs, 0, afp.input->minmapsize,
-                             afp.input->quietmmap, NULL, afp.input->unit,
-                             NULL);
-
-
-      /* Spin off threads for each pixel. */
-      gal_threads_spin_off(arithmetic_filter, &afp, afp.input->size,
-                           p->cp.numthreads, p->cp.minmapsize,
-                           p->cp.quietmmap);
+      /* The mean and median filters are sliding windows (with a stride
+         of one) that start 'hnfsize' elements before each element. So
+         they can be done with the running sums and running median of the
+         pooling library (independent of the filter size). */
+      if(operator==ARITHMETIC_OP_FILTER_MEAN
+         || operator==ARITHMETIC_OP_FILTER_MEDIAN)
+        {
+          for(i=0;i<ndim;++i) stride[i]=1;
+          afp.out=gal_pool_window(afp.input,
+                                  ( operator==ARITHMETIC_OP_FILTER_MEAN
+                                    ? GAL_POOL_MEAN : GAL_POOL_MEDIAN ),
+                                  fsize, stride, hnfsize,
+                                  p->cp.numthreads);
+          if(afp.input->unit)
+            gal_checkset_allocate_copy(afp.input->unit, &afp.out->unit);
+        }
+      else
+        {
+          /* Allocate the output dataset (the sigma-clipping results are
+             in 32-bit floating point, like 'gal_statistics_sigma_clip').
+             Note that filtering doesn't change the units of the
+             dataset. */
+          afp.out=gal_data_alloc(NULL, GAL_TYPE_FLOAT32, ndim,
+                                 afp.input->dsize, afp.input->wcs, 0,
+                                 afp.input->minmapsize,
+                                 afp.input->quietmmap, NULL,
+                                 afp.input->unit, NULL);
+
+          /* Spin off threads for each line along the fastest dimension,
+             then convert the output to the desired type. */
+          gal_threads_spin_off(arithmetic_filter_sigclip, &afp,
+                               afp.input->size/afp.input->dsize[ndim-1],
+                               p->cp.numthreads, p->cp.minmapsize,
+                               p->cp.quietmmap);
+          if(afp.out->type!=type)
+            afp.out=gal_data_copy_to_new_type_free(afp.out, type);
+        }
     }
 
 
@@ -963,9 +1102,12 @@ static void
 arithmetic_collapse(struct arithmeticparams *p, char *token, int operator)
 {
   long dim;
+  size_t ndim;
   float p1=NAN, p2=NAN;
   int qmm=p->cp.quietmmap;
+  char *filename=NULL, *hdu=NULL;
   gal_data_t *dimension=NULL, *input=NULL;
+  int streamop=GAL_DIMENSION_COLLAPSE_INVALID;
   size_t nt=p->cp.numthreads, mms=p->cp.minmapsize;
   gal_data_t *collapsed=NULL, *param1=NULL, *param2=NULL;
 
@@ -986,8 +1128,30 @@ arithmetic_collapse(struct arithmeticparams *p, char *token, int operator)
     }
 
 
-  /* Final popped operand is the desired input dataset. */
-  input = operands_pop(p, token);
+  /* Final popped operand is the desired input dataset. When it is a FITS
+     image that hasn't been read yet and the operator can be calculated
+     incrementally, it will be collapsed directly from the file (one block
+     of slices at a time), so the full dataset is never in memory. */
+  switch(operator)
+    {
+    case ARITHMETIC_OP_COLLAPSE_SUM:
+      streamop=GAL_DIMENSION_COLLAPSE_SUM;    break;
+    case ARITHMETIC_OP_COLLAPSE_MEAN:
+      streamop=GAL_DIMENSION_COLLAPSE_MEAN;   break;
+    case ARITHMETIC_OP_COLLAPSE_NUMBER:
+      streamop=GAL_DIMENSION_COLLAPSE_NUMBER; break;
+    case ARITHMETIC_OP_COLLAPSE_MIN:
+      streamop=GAL_DIMENSION_COLLAPSE_MIN;    break;
+    case ARITHMETIC_OP_COLLAPSE_MAX:
+      streamop=GAL_DIMENSION_COLLAPSE_MAX;    break;
+    }
+  if(streamop!=GAL_DIMENSION_COLLAPSE_INVALID)
+    filename=operands_pop_fits_image(p, &hdu, &ndim);
+  if(filename==NULL)
+    {
+      input = operands_pop(p, token);
+      ndim = input->ndim;
+    }
 
 
   /* Sanity checks. */
@@ -999,10 +1163,10 @@ arithmetic_collapse(struct arithmeticparams *p, char *token, int operator)
     error(EXIT_FAILURE, 0, "first popped operand of 'collapse-*' operators "
           "(dimension to collapse) must be positive (larger than zero), it "
           "is %ld", dim);
-  if(dim > input->ndim)
+  if(dim > ndim)
     error(EXIT_FAILURE, 0, "input dataset to '%s' has %zu dimension(s), "
           "but you have asked to collapse along dimension %ld", token,
-          input->ndim, dim);
+          ndim, dim);
   if(param1)
     {
       arithmetic_collapse_single_value(param1, "third", "sigclip-",
@@ -1025,63 +1189,72 @@ arithmetic_collapse(struct arithmeticparams *p, char *token, int operator)
   if(p->wcs_collapsed==0)
     {
       p->wcs_collapsed=1;
-      input->wcs=p->refdata.wcs;
+      if(input) input->wcs=p->refdata.wcs;
+      else      gal_wcs_remove_dimension(p->refdata.wcs, dim);
     }
 
 
   /* Run the relevant library function. */
-  switch(operator)
+  if(filename)
     {
-    case ARITHMETIC_OP_COLLAPSE_SUM:
-      collapsed=gal_dimension_collapse_sum(input, input->ndim-dim, NULL);
-      break;
-
-    case ARITHMETIC_OP_COLLAPSE_MEAN:
-      collapsed=gal_dimension_collapse_mean(input, input->ndim-dim, NULL);
-      break;
-
-    case ARITHMETIC_OP_COLLAPSE_NUMBER:
-      collapsed=gal_dimension_collapse_number(input, input->ndim-dim);
-      break;
-
-    case ARITHMETIC_OP_COLLAPSE_MIN:
-      collapsed=gal_dimension_collapse_minmax(input, input->ndim-dim, 0);
-      break;
-
-    case ARITHMETIC_OP_COLLAPSE_MAX:
-      collapsed=gal_dimension_collapse_minmax(input, input->ndim-dim, 1);
-      break;
-
-    case ARITHMETIC_OP_COLLAPSE_MEDIAN:
-      collapsed=gal_dimension_collapse_median(input, input->ndim-dim,
-                                              nt, mms, qmm);
-      break;
-
-    case ARITHMETIC_OP_COLLAPSE_SIGCLIP_STD:
-      collapsed=gal_dimension_collapse_sclip_std(input, input->ndim-dim,
-                                                 p1, p2, nt, mms, qmm);
-      break;
-
-    case ARITHMETIC_OP_COLLAPSE_SIGCLIP_MEAN:
-      collapsed=gal_dimension_collapse_sclip_mean(input, input->ndim-dim,
-                                                  p1, p2, nt, mms, qmm);
-      break;
-
-    case ARITHMETIC_OP_COLLAPSE_SIGCLIP_MEDIAN:
-      collapsed=gal_dimension_collapse_sclip_median(input, input->ndim-dim,
+      collapsed=gal_dimension_collapse_fits(filename, hdu, ndim-dim,
+                                            streamop, NULL, nt, mms,
+                                            qmm);
+      free(hdu);
+    }
+  else
+    switch(operator)
+      {
+      case ARITHMETIC_OP_COLLAPSE_SUM:
+        collapsed=gal_dimension_collapse_sum(input, ndim-dim, NULL, nt);
+        break;
+
+      case ARITHMETIC_OP_COLLAPSE_MEAN:
+        collapsed=gal_dimension_collapse_mean(input, ndim-dim, NULL, nt);
+        break;
+
+      case ARITHMETIC_OP_COLLAPSE_NUMBER:
+        collapsed=gal_dimension_collapse_number(input, ndim-dim, nt);
+        break;
+
+      case ARITHMETIC_OP_COLLAPSE_MIN:
+        collapsed=gal_dimension_collapse_minmax(input, ndim-dim, 0, nt);
+        break;
+
+      case ARITHMETIC_OP_COLLAPSE_MAX:
+        collapsed=gal_dimension_collapse_minmax(input, ndim-dim, 1, nt);
+        break;
+
+      case ARITHMETIC_OP_COLLAPSE_MEDIAN:
+        collapsed=gal_dimension_collapse_median(input, ndim-dim,
+                                                nt, mms, qmm);
+        break;
+
+      case ARITHMETIC_OP_COLLAPSE_SIGCLIP_STD:
+        collapsed=gal_dimension_collapse_sclip_std(input, ndim-dim,
+                                                   p1, p2, nt, mms, qmm);
+        break;
+
+      case ARITHMETIC_OP_COLLAPSE_SIGCLIP_MEAN:
+        collapsed=gal_dimension_collapse_sclip_mean(input, ndim-dim,
                                                     p1, p2, nt, mms, qmm);
-      break;
+        break;
 
-    case ARITHMETIC_OP_COLLAPSE_SIGCLIP_NUMBER:
-      collapsed=gal_dimension_collapse_sclip_number(input, input->ndim-dim,
-                                                    p1, p2, nt, mms, qmm);
-      break;
+      case ARITHMETIC_OP_COLLAPSE_SIGCLIP_MEDIAN:
+        collapsed=gal_dimension_collapse_sclip_median(input, ndim-dim,
+                                                      p1, p2, nt, mms, qmm);
+        break;
 
-    default:
-      error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at %s to fix the "
-            "problem. The operator code %d is not recognized", __func__,
-            PACKAGE_BUGREPORT, operator);
-    }
+      case ARITHMETIC_OP_COLLAPSE_SIGCLIP_NUMBER:
+        collapsed=gal_dimension_collapse_sclip_number(input, ndim-dim,
+                                                      p1, p2, nt, mms, qmm);
+        break;
+
+      default:
+        error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at %s to fix the "
+              "problem. The operator code %d is not recognized", __func__,
+              PACKAGE_BUGREPORT, operator);
+      }
 
 
   /* If a WCS structure existed, a modified WCS is now present in
@@ -1311,6 +1484,63 @@ arithmetic_repeat(struct arithmeticparams *p, char *token, int operator)
 
 
 
+/* Fit a polynomial on every line of the input along one dimension and
+   replace the input with the fitted model. */
+static void
+arithmetic_fit_polynomial(struct arithmeticparams *p, char *token,
+                          int operator)
+{
+  long dim;
+  size_t maxpower;
+  gal_data_t *input, *power, *dimension, *out;
+  uint8_t robustid = ( operator==ARITHMETIC_OP_FIT_POLYNOMIAL_ROBUST
+                       ? GAL_FIT_ROBUST_BISQUARE
+                       : GAL_FIT_ROBUST_INVALID );
+
+  /* Pop the operands: maximum power, dimension and the dataset. */
+  power     = operands_pop(p, token);
+  dimension = operands_pop(p, token);
+  input     = operands_pop(p, token);
+
+  /* Sanity checks. */
+  if(power->size!=1 || dimension->size!=1)
+    error(EXIT_FAILURE, 0, "the first and second popped operands of "
+          "'%s' (maximum power of the polynomial and the dimension to "
+          "fit along) must be single numbers", token);
+  if( power->type==GAL_TYPE_FLOAT32 || power->type==GAL_TYPE_FLOAT64
+      || dimension->type==GAL_TYPE_FLOAT32
+      || dimension->type==GAL_TYPE_FLOAT64 )
+    error(EXIT_FAILURE, 0, "the first and second popped operands of "
+          "'%s' (maximum power of the polynomial and the dimension to "
+          "fit along) must have an integer type", token);
+  dimension=gal_data_copy_to_new_type_free(dimension, GAL_TYPE_LONG);
+  dim=((long *)(dimension->array))[0];
+  if(dim<=0 || dim>input->ndim)
+    error(EXIT_FAILURE, 0, "input dataset to '%s' has %zu dimension(s), "
+          "but you have asked to fit along dimension %ld", token,
+          input->ndim, dim);
+  power=gal_data_copy_to_new_type_free(power, GAL_TYPE_LONG);
+  if( ((long *)(power->array))[0] < 0 )
+    error(EXIT_FAILURE, 0, "the maximum power of the polynomial (first "
+          "popped operand of '%s') cannot be negative", token);
+  maxpower=((long *)(power->array))[0];
+
+  /* Do the fit (the dimension is counted from 1 in the FITS standard, but
+     the library uses C's order). */
+  out=gal_fit_1d_polynomial_dim(input, input->ndim-dim, maxpower,
+                                robustid, 1, p->cp.numthreads);
+
+  /* Clean up and put the model on the stack. */
+  gal_data_free(power);
+  gal_data_free(input);
+  gal_data_free(dimension);
+  operands_add(p, NULL, out);
+}
+
+
+
+
+
 
 
 
@@ -1398,6 +1628,10 @@ arithmetic_set_operator(char *string, size_t *num_operands, int *inlib)
         { op=ARITHMETIC_OP_ADD_DIMENSION_FAST;    *num_operands=0; }
       else if (!strcmp(string, "repeat"))
         { op=ARITHMETIC_OP_REPEAT;                *num_operands=0; }
+      else if (!strcmp(string, "fit-polynomial"))
+        { op=ARITHMETIC_OP_FIT_POLYNOMIAL;        *num_operands=0; }
+      else if (!strcmp(string, "fit-polynomial-robust"))
+        { op=ARITHMETIC_OP_FIT_POLYNOMIAL_ROBUST; *num_operands=0; }
       else
         error(EXIT_FAILURE, 0, "the argument '%s' could not be "
               "interpretted as a file name, named dataset, number, "
@@ -1496,6 +1730,15 @@ arithmetic_operator_run(struct arithmeticparams *p, int operator,
              linked list of any number of operands within the single 'd1'
              pointer. */
           numop=pop_number_of_operands(p, operator, operator_string, &d2);
+
+          /* When the inputs of a stacking operator are FITS images that
+             haven't been read yet (and its output is the final output),
+             they are stacked strip by strip (without reading them
+             completely) and the output is written directly. */
+          if( stackfits(p, operator, operator_string, numop, d2) )
+            return;
+
+          /* Put all the operands in a list. */
           for(i=0;i<numop;++i)
             gal_list_data_add(&d1, operands_pop(p, operator_string));
           break;
@@ -1628,6 +1871,11 @@ arithmetic_operator_run(struct arithmeticparams *p, int operator,
           arithmetic_repeat(p, operator_string, operator);
           break;
 
+        case ARITHMETIC_OP_FIT_POLYNOMIAL:
+        case ARITHMETIC_OP_FIT_POLYNOMIAL_ROBUST:
+          arithmetic_fit_polynomial(p, operator_string, operator);
+          break;
+
         default:
           error(EXIT_FAILURE, 0, "%s: a bug! please contact us at "
                 "%s to fix the problem. The code %d is not "
@@ -1723,79 +1971,13 @@ arithmetic_final_data(struct arithmeticparams *p)
 
 
 
-/* This function implements the reverse polish algorithm as explained
-   in the Wikipedia page.
-
-   NOTE that in ui.c, the input linked list of tokens was ordered to
-   have the same order as what the user provided. */
-void
-reversepolish(struct arithmeticparams *p)
+/* Write the final operand(s) into the output. */
+static void
+arithmetic_final_write(struct arithmeticparams *p)
 {
   char *printnum;
   struct operand *otmp;
-  size_t num_operands=0;
-  gal_list_str_t *token;
-  gal_data_t *tmp, *data, *col;
-  struct gal_options_common_params *cp=&p->cp;
-  int inlib, operator=GAL_ARITHMETIC_OP_INVALID;
-
-  /* Prepare the processing: */
-  p->popcounter=0;
-  p->operands=NULL;
-  p->setprm.params=p;
-  p->setprm.tokencounter=0;
-  p->setprm.tokens=p->tokens;
-  p->setprm.pop=operands_pop_wrapper_set;
-  p->setprm.used_later=arithmetic_set_name_used_later;
-
-  /* Go over each input token and do the work. */
-  for(token=p->tokens;token!=NULL;token=token->next)
-    {
-      /* The 'tofile-' operator's string can end in a '.fits', similar to a
-         FITS file input file. So, it needs to be checked before checking
-         for a filename. If we have a name or number, then add it to the
-         operands linked list. Otherwise, pull out two members and do the
-         specified operation on them. */
-      operator=GAL_ARITHMETIC_OP_INVALID;
-      if( !strncmp(OPERATOR_PREFIX_TOFILE, token->v,
-                   OPERATOR_PREFIX_LENGTH_TOFILE) )
-        arithmetic_tofile(p, token->v, 0);
-      else if( !strncmp(OPERATOR_PREFIX_TOFILEFREE, token->v,
-                   OPERATOR_PREFIX_LENGTH_TOFILE) )
-        arithmetic_tofile(p, token->v, 1);
-      else if( !strncmp(token->v, GAL_ARITHMETIC_SET_PREFIX,
-                        GAL_ARITHMETIC_SET_PREFIX_LENGTH) )
-        gal_arithmetic_set_name(&p->setprm, token->v);
-      else if( (col=gal_arithmetic_load_col(token->v, cp->searchin,
-                                            cp->ignorecase,
-                                            cp->minmapsize,
-                                            cp->quietmmap))!=NULL )
-        operands_add(p, NULL, col);
-      else if(    gal_array_file_recognized(token->v)
-               || gal_arithmetic_set_is_name(p->setprm.named, token->v) )
-        operands_add(p, token->v, NULL);
-      else if( (data=gal_data_copy_string_to_number(token->v)) )
-        {
-          /* The 'minmapsize' and 'quietmmap' parameters should be passed
-             onto the library within numbers also (since they are the
-             only things that go in the library sometimes). */
-          data->quietmmap=p->cp.quietmmap;
-          data->minmapsize=p->cp.minmapsize;
-          operands_add(p, NULL, data);
-        }
-
-      /* Last option is an operator: the program will abort if the token
-         isn't an operator. */
-      else
-        {
-          operator=arithmetic_set_operator(token->v, &num_operands, &inlib);
-          arithmetic_operator_run(p, operator, token->v, num_operands, inlib);
-        }
-
-      /* Increment the token counter. */
-      ++p->setprm.tokencounter;
-    }
-
+  gal_data_t *tmp, *data;
 
   /* If there aren't any more operands (a variable has been set but not
      used), then there is nothing to create. */
@@ -1867,6 +2049,95 @@ reversepolish(struct arithmeticparams *p)
   /* Clean up, note that above, we copied the pointer to 'refdata->wcs'
      into 'data', so it is freed when freeing 'data'. */
   gal_data_free(data);
+}
+
+
+
+
+
+/* This function implements the reverse polish algorithm as explained
+   in the Wikipedia page.
+
+   NOTE that in ui.c, the input linked list of tokens was ordered to
+   have the same order as what the user provided. */
+void
+reversepolish(struct arithmeticparams *p)
+{
+  size_t num_operands=0;
+  gal_list_str_t *token;
+  gal_data_t *data, *col;
+  struct gal_options_common_params *cp=&p->cp;
+  int inlib, operator=GAL_ARITHMETIC_OP_INVALID;
+
+  /* Prepare the processing: */
+  p->popcounter=0;
+  p->operands=NULL;
+  p->setprm.params=p;
+  p->setprm.tokencounter=0;
+  p->setprm.tokens=p->tokens;
+  p->setprm.pop=operands_pop_wrapper_set;
+  p->setprm.used_later=arithmetic_set_name_used_later;
+
+  /* Go over each input token and do the work. */
+  for(token=p->tokens;token!=NULL;token=token->next)
+    {
+      /* The 'tofile-' operator's string can end in a '.fits', similar to a
+         FITS file input file. So, it needs to be checked before checking
+         for a filename. If we have a name or number, then add it to the
+         operands linked list. Otherwise, pull out two members and do the
+         specified operation on them. */
+      operator=GAL_ARITHMETIC_OP_INVALID;
+      if( !strncmp(OPERATOR_PREFIX_TOFILE, token->v,
+                   OPERATOR_PREFIX_LENGTH_TOFILE) )
+        arithmetic_tofile(p, token->v, 0);
+      else if( !strncmp(OPERATOR_PREFIX_TOFILEFREE, token->v,
+                   OPERATOR_PREFIX_LENGTH_TOFILE) )
+        arithmetic_tofile(p, token->v, 1);
+      else if( !strncmp(token->v, GAL_ARITHMETIC_SET_PREFIX,
+                        GAL_ARITHMETIC_SET_PREFIX_LENGTH) )
+        gal_arithmetic_set_name(&p->setprm, token->v);
+      else if( (col=gal_arithmetic_load_col(token->v, cp->searchin,
+                                            cp->ignorecase,
+                                            cp->minmapsize,
+                                            cp->quietmmap))!=NULL )
+        operands_add(p, NULL, col);
+      else if(    gal_array_file_recognized(token->v)
+               || gal_arithmetic_set_is_name(p->setprm.named, token->v) )
+        operands_add(p, token->v, NULL);
+      else if( (data=gal_data_copy_string_to_number(token->v)) )
+        {
+          /* The 'minmapsize' and 'quietmmap' parameters should be passed
+             onto the library within numbers also (since they are the
+             only things that go in the library sometimes). */
+          data->quietmmap=p->cp.quietmmap;
+          data->minmapsize=p->cp.minmapsize;
+          operands_add(p, NULL, data);
+        }
+
+      /* Last option is an operator: the program will abort if the token
+         isn't an operator. */
+      else
+        {
+          operator=arithmetic_set_operator(token->v, &num_operands, &inlib);
+          arithmetic_operator_run(p, operator, token->v, num_operands, inlib);
+        }
+
+      /* Increment the token counter. */
+      ++p->setprm.tokencounter;
+    }
+
+
+  /* The stacking maps are only written when stacking FITS files. */
+  if( (p->stackcount || p->stackrejected) && p->stackwritten==0 )
+    error(EXIT_FAILURE, 0, "'--stackcount' and '--stackrejected' are only "
+          "relevant when the last operator is a stacking operator (like "
+          "'sigclip-mean') and all its operands are FITS images");
+
+
+  /* Write the output (if it hasn't already been written while stacking
+     FITS files), then clean up. */
+  if(p->stackwritten==0)
+    arithmetic_final_write(p);
   free(p->refdata.dsize);
   gal_list_data_free(p->setprm.named);
 
@@ -60,6 +60,8 @@ enum arithmetic_prog_operators
   ARITHMETIC_OP_ADD_DIMENSION_SLOW,
   ARITHMETIC_OP_ADD_DIMENSION_FAST,
   ARITHMETIC_OP_REPEAT,
+  ARITHMETIC_OP_FIT_POLYNOMIAL,
+  ARITHMETIC_OP_FIT_POLYNOMIAL_ROBUST,
 };
 
 
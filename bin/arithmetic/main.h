@@ -86,15 +86,20 @@ struct arithmeticparams
   char           *metaunit;  /* FITS name (BUNIT keyword) of output.    */
   char        *metacomment;  /* FITS comment of output.                 */
   uint8_t         writeall;  /* Write all outputs.                      */
+  uint8_t       stackcount;  /* Write number of used inputs (stacking). */
+  uint8_t    stackrejected;  /* Write number of clipped inputs.         */
 
   /* Operating mode: */
   int        wcs_collapsed;  /* If the internal WCS is already collapsed.*/
+  size_t         stackrows;  /* Rows in each strip of file stacking.    */
+  size_t      stackmaxopen;  /* Maximum open inputs in file stacking.   */
 
   /* Internal: */
   uint8_t          envseed;  /* To setup the random number generator.   */
   struct operand *operands;  /* The operands linked list.               */
   int     outnamerequested;  /* ==1 if the user has given '--otuput'.   */
   time_t           rawtime;  /* Starting time of the program.           */
+  uint8_t     stackwritten;  /* Output was written while stacking.      */
 };
 
 
@@ -218,10 +218,41 @@ operands_add(struct arithmeticparams *p, char *filename, gal_data_t *data)
 
 
 
+/* When the reference data structure's dimensionality is zero, it means
+   that this is the first image that is read. So, write its basic
+   information into the reference data structure for future checks. */
+static void
+operands_set_refdata(struct arithmeticparams *p, size_t ndim, size_t *dsize)
+{
+  size_t i;
+
+  if(p->refdata.ndim==0)
+    {
+      /* Set the dimensionality. */
+      p->refdata.ndim=ndim;
+
+      /* Allocate the dsize array. */
+      errno=0;
+      p->refdata.dsize=malloc(p->refdata.ndim
+                              * sizeof *p->refdata.dsize);
+      if(p->refdata.dsize==NULL)
+        error(EXIT_FAILURE, errno, "%s: allocating %zu bytes for "
+              "p->refdata.dsize", __func__,
+              p->refdata.ndim * sizeof *p->refdata.dsize);
+
+      /* Write the values into it. */
+      for(i=0;i<p->refdata.ndim;++i)
+        p->refdata.dsize[i]=dsize[i];
+    }
+}
+
+
+
+
+
 gal_data_t *
 operands_pop(struct arithmeticparams *p, char *operator)
 {
-  size_t i;
   gal_data_t *data;
   char *filename, *hdu;
   struct operand *operands=p->operands;
@@ -245,28 +276,8 @@ operands_pop(struct arithmeticparams *p, char *operator)
                                  p->cp.quietmmap);
       data->ndim=gal_dimension_remove_extra(data->ndim, data->dsize, NULL);
 
-      /* When the reference data structure's dimensionality is non-zero, it
-         means that this is not the first image read. So, write its basic
-         information into the reference data structure for future
-         checks. */
-      if(p->refdata.ndim==0)
-        {
-          /* Set the dimensionality. */
-          p->refdata.ndim=(data)->ndim;
-
-          /* Allocate the dsize array. */
-          errno=0;
-          p->refdata.dsize=malloc(p->refdata.ndim
-                                  * sizeof *p->refdata.dsize);
-          if(p->refdata.dsize==NULL)
-            error(EXIT_FAILURE, errno, "%s: allocating %zu bytes for "
-                  "p->refdata.dsize", __func__,
-                  p->refdata.ndim * sizeof *p->refdata.dsize);
-
-          /* Write the values into it. */
-          for(i=0;i<p->refdata.ndim;++i)
-            p->refdata.dsize[i]=data->dsize[i];
-        }
+      /* Keep the basic information of the first read image. */
+      operands_set_refdata(p, data->ndim, data->dsize);
 
       /* Report the read image if desired: */
       if(!p->cp.quiet) printf(" - Read: %s (hdu %s).\n", filename, hdu);
@@ -297,6 +308,74 @@ operands_pop(struct arithmeticparams *p, char *operator)
 
 
 
+/* Some operators can be applied on a FITS image without reading it
+   completely into memory. If the top operand is a FITS image that hasn't
+   been read yet, this function will pop it and return its file name (the
+   HDU and number of dimensions will be written into the given pointers).
+   Otherwise, it will return NULL and the stack will not be touched. */
+char *
+operands_pop_fits_image(struct arithmeticparams *p, char **hdu,
+                        size_t *ndim)
+{
+  size_t *dsize;
+  char *filename;
+  struct operand *operands=p->operands;
+
+  /* See if the top operand is a FITS image. */
+  if( operands==NULL
+      || operands->filename==NULL
+      || gal_fits_file_recognized(operands->filename)==0
+      || gal_fits_hdu_format(operands->filename,
+                             operands->hdu)!=IMAGE_HDU )
+    return NULL;
+
+  /* Read the size and remove possibly extra dimensions. */
+  dsize=gal_fits_img_info_dim(operands->filename, operands->hdu, ndim);
+  *ndim=gal_dimension_remove_extra(*ndim, dsize, NULL);
+  if(*ndim==0) { free(dsize); return NULL; }
+
+  /* Pop the operand. */
+  filename=operands_pop_file(p, hdu, *ndim, dsize);
+  free(dsize);
+  return filename;
+}
+
+
+
+
+
+/* Pop the top operand (that must be a file that hasn't been read yet and
+   whose number of dimensions and size are already known by the caller)
+   without reading it. The file name is returned and the HDU (that should
+   be freed by the caller) is written into 'hdu'. */
+char *
+operands_pop_file(struct arithmeticparams *p, char **hdu, size_t ndim,
+                  size_t *dsize)
+{
+  char *filename;
+  struct operand *operands=p->operands;
+
+  /* Keep the basic information of the first read image. */
+  operands_set_refdata(p, ndim, dsize);
+
+  /* Report the image if desired and add to the number of popped FITS
+     images. */
+  filename=operands->filename;
+  if(!p->cp.quiet)
+    printf(" - Read: %s (hdu %s).\n", filename, operands->hdu);
+  ++p->popcounter;
+
+  /* Remove this node from the queue, return the file name. */
+  *hdu=operands->hdu;
+  p->operands=operands->next;
+  free(operands);
+  return filename;
+}
+
+
+
+
+
 /* Wrapper to use the 'operands_pop' function with the 'set-' operator. */
 gal_data_t *
 operands_pop_wrapper_set(void *in)
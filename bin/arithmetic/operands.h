@@ -32,6 +32,14 @@ operands_add(struct arithmeticparams *p, char *filename, gal_data_t *data);
 gal_data_t *
 operands_pop(struct arithmeticparams *p, char *operator);
 
+char *
+operands_pop_fits_image(struct arithmeticparams *p, char **hdu,
+                        size_t *ndim);
+
+char *
+operands_pop_file(struct arithmeticparams *p, char **hdu, size_t ndim,
+                  size_t *dsize);
+
 gal_data_t *
 operands_pop_wrapper_set(void *in);
 
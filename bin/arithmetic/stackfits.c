@@ -0,0 +1,693 @@
+/*********************************************************************
+Arithmetic - Do arithmetic operations on images.
+Arithmetic is part of GNU Astronomy Utilities (Gnuastro) package.
+
+Original author:
+     Mohammad Akhlaghi <mohammad@akhlaghi.org>
+Contributing author(s):
+Copyright (C) 2026 Free Software Foundation, Inc.
+
+Gnuastro is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation, either version 3 of the License, or (at your
+option) any later version.
+
+Gnuastro is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+#include <config.h>
+
+#include <stdio.h>
+#include <errno.h>
+#include <error.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#include <gnuastro/wcs.h>
+#include <gnuastro/fits.h>
+#include <gnuastro/blank.h>
+#include <gnuastro/pointer.h>
+#include <gnuastro/dimension.h>
+#include <gnuastro/arithmetic.h>
+
+#include "main.h"
+
+#include "operands.h"
+#include "stackfits.h"
+
+
+
+
+/* When the multi-operand (stacking) operators are given many FITS images
+   that haven't been read yet (and their output is the final output), the
+   inputs are not read into memory: the same strip of rows (along the
+   slowest dimension) is read from all of them and stacked, then the
+   output strip is written before going onto the next strip. */
+
+/* Memory (in bytes) for the strips of all the inputs when '--stackrows'
+   and '--maxmemory' aren't given. */
+#define STACKFITS_STRIPS_BYTES 1073741824
+
+/* When the maximum number of open inputs is found from the system's
+   limit on the number of open files, this many are kept for other
+   purposes (for example the standard streams and the output). */
+#define STACKFITS_RESERVED_FILES 16
+
+struct stackfits_input
+{
+  char          *filename;  /* Name of input (command-line token).      */
+  char               *hdu;  /* HDU of the input.                        */
+  fitsfile          *fptr;  /* CFITSIO pointer (NULL when closed).      */
+  size_t         lastused;  /* Counter of last read (for the LRU).      */
+  gal_data_t       *strip;  /* This input's strip in memory.            */
+};
+
+struct stackfitsparams
+{
+  struct stackfits_input *in; /* Information on each input.             */
+  size_t            numin;  /* Number of inputs.                        */
+  size_t            nopen;  /* Number of open inputs.                   */
+  size_t          maxopen;  /* Maximum number of open inputs.           */
+  size_t          counter;  /* Counter of the reads (for the LRU).      */
+  size_t          rowsize;  /* Number of elements in each row.          */
+  uint8_t            type;  /* Type of the inputs.                      */
+  void             *blank;  /* Blank value of the type.                 */
+};
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/**********************************************************************/
+/************             Checks and preparations       ***************/
+/**********************************************************************/
+/* See if the given multi-operand operator can be applied on the files
+   directly: it should be the last token and all of its inputs should be
+   FITS files that haven't been read yet. Nothing else should remain on
+   the stack of operands. The HDUs aren't opened here (they are opened
+   and checked only once, in 'stackfits_prepare'). */
+static int
+stackfits_possible(struct arithmeticparams *p, int operator, size_t numop)
+{
+  size_t i;
+  struct operand *op=p->operands;
+
+  /* Only the stacking operators. */
+  switch(operator)
+    {
+    case GAL_ARITHMETIC_OP_MIN:
+    case GAL_ARITHMETIC_OP_MAX:
+    case GAL_ARITHMETIC_OP_NUMBER:
+    case GAL_ARITHMETIC_OP_SUM:
+    case GAL_ARITHMETIC_OP_MEAN:
+    case GAL_ARITHMETIC_OP_STD:
+    case GAL_ARITHMETIC_OP_MEDIAN:
+    case GAL_ARITHMETIC_OP_QUANTILE:
+    case GAL_ARITHMETIC_OP_SIGCLIP_STD:
+    case GAL_ARITHMETIC_OP_SIGCLIP_MEAN:
+    case GAL_ARITHMETIC_OP_SIGCLIP_MEDIAN:
+    case GAL_ARITHMETIC_OP_SIGCLIP_NUMBER:
+      break;
+    default:
+      return 0;
+    }
+
+  /* The output of this operator should be the final output. */
+  if( gal_list_str_number(p->tokens) != p->setprm.tokencounter+1 )
+    return 0;
+
+  /* All the inputs should be FITS files that haven't been read yet. */
+  for(i=0;i<numop;++i)
+    {
+      if( op==NULL
+          || op->filename==NULL
+          || gal_fits_file_recognized(op->filename)==0 )
+        return 0;
+      op=op->next;
+    }
+  return op==NULL;
+}
+
+
+
+
+
+/* The maximum number of inputs that can be open at the same time. */
+static size_t
+stackfits_max_open(struct arithmeticparams *p, size_t numin)
+{
+  struct rlimit rl;
+  size_t out=p->stackmaxopen;
+
+  /* If not given by the user, use the system's limit. */
+  if(out==0)
+    {
+      if( getrlimit(RLIMIT_NOFILE, &rl)==0
+          && rl.rlim_cur!=RLIM_INFINITY )
+        out = ( rl.rlim_cur > 2*STACKFITS_RESERVED_FILES
+                ? rl.rlim_cur - STACKFITS_RESERVED_FILES
+                : rl.rlim_cur/2 );
+      else
+        out=numin;
+    }
+
+  /* There is no need to go beyond the number of inputs. */
+  return out>numin ? numin : (out ? out : 1);
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/**********************************************************************/
+/************           Reading the input strips        ***************/
+/**********************************************************************/
+/* Close the least recently used input. */
+static void
+stackfits_close_lru(struct stackfitsparams *sp)
+{
+  int status=0;
+  size_t i, lru=GAL_BLANK_SIZE_T;
+  struct stackfits_input *in=sp->in;
+
+  /* Find the least recently used input. */
+  for(i=0;i<sp->numin;++i)
+    if( in[i].fptr
+        && ( lru==GAL_BLANK_SIZE_T || in[i].lastused<in[lru].lastused ) )
+      lru=i;
+
+  /* Close it. */
+  if(lru!=GAL_BLANK_SIZE_T)
+    {
+      fits_close_file(in[lru].fptr, &status);
+      gal_fits_io_error(status, NULL);
+      in[lru].fptr=NULL;
+      --sp->nopen;
+    }
+}
+
+
+
+
+
+/* Close all the open inputs. */
+static void
+stackfits_close_all(struct stackfitsparams *sp)
+{
+  size_t i;
+  int status=0;
+
+  for(i=0;i<sp->numin;++i)
+    if(sp->in[i].fptr)
+      {
+        fits_close_file(sp->in[i].fptr, &status);
+        gal_fits_io_error(status, NULL);
+        sp->in[i].fptr=NULL;
+      }
+  sp->nopen=0;
+}
+
+
+
+
+
+/* Make sure the given input is open. If the maximum number of open files
+   is reached, the least recently used one is closed. If the file can't be
+   opened (for example CFITSIO or the operating system don't allow more
+   open files), the maximum is decreased and another file is closed. When
+   no other file is open, the error is reported. */
+static void
+stackfits_open(struct stackfitsparams *sp, size_t ind)
+{
+  struct stackfits_input *in=&sp->in[ind];
+
+  /* If the file is already open, there is nothing to do. */
+  if(in->fptr) return;
+
+  /* Open the file. */
+  if(sp->nopen>=sp->maxopen) stackfits_close_lru(sp);
+  while( (in->fptr=gal_fits_hdu_open(in->filename, in->hdu, READONLY,
+                                     sp->nopen==0))==NULL )
+    {
+      sp->maxopen=sp->nopen;
+      stackfits_close_lru(sp);
+    }
+  ++sp->nopen;
+}
+
+
+
+
+
+/* Read 'nrows' rows (along the slowest dimension), starting from
+   'firstrow' (counting from 0) of the given input into its strip. */
+static void
+stackfits_read(struct stackfitsparams *sp, size_t ind, size_t firstrow,
+               size_t nrows)
+{
+  int anyblank, status=0;
+  struct stackfits_input *in=&sp->in[ind];
+  gal_data_t *strip=in->strip;
+
+  /* Make sure the file is open and keep the counter for the LRU. */
+  stackfits_open(sp, ind);
+  in->lastused=sp->counter++;
+
+  /* Correct the size of the strip (the last one can be shorter). */
+  strip->flag=0;
+  strip->dsize[0]=nrows;
+  strip->size=nrows*sp->rowsize;
+
+  /* Read the strip. */
+  fits_read_img(in->fptr, gal_fits_type_to_datatype(sp->type),
+                (LONGLONG)(firstrow*sp->rowsize+1), strip->size,
+                sp->blank, strip->array, &anyblank, &status);
+  if(status) gal_fits_io_error(status, NULL);
+}
+
+
+
+
+
+/* Open all the inputs (while they are still on the stack of operands),
+   check their HDU type and size and keep them open (as far as possible)
+   for reading the first strip: this is the only place that the headers
+   of the inputs are read. If the inputs should be processed as before
+   (see below), all the files are closed and NULL is returned. Otherwise,
+   the size of the inputs is returned. */
+static size_t *
+stackfits_prepare(struct stackfitsparams *sp, struct operand *op,
+                  char *token, size_t *ndim)
+{
+  int type, hdutype, status=0;
+  struct stackfits_input *in, *ref=NULL;
+  size_t i, d, indim, *idsize, *dsize=NULL;
+
+  /* Go over the inputs (the top operand is the last input). */
+  for(i=sp->numin; i>0; --i, op=op->next)
+    {
+      /* Open this input (the least recently used input may be closed if
+         too many are open). */
+      in=&sp->in[i-1];
+      in->hdu=op->hdu;
+      in->filename=op->filename;
+      stackfits_open(sp, i-1);
+      in->lastused=sp->counter++;
+
+      /* Only images can be read strip by strip. */
+      if( fits_get_hdu_type(in->fptr, &hdutype, &status) )
+        gal_fits_io_error(status, NULL);
+      if(hdutype!=IMAGE_HDU) break;
+
+      /* Read the basic information of this input. */
+      gal_fits_img_info(in->fptr, &type, &indim, &idsize, NULL, NULL);
+      indim=gal_dimension_remove_extra(indim, idsize, NULL);
+
+      /* The first input that is read is the reference of the others. 1D
+         outputs are written as tables (or printed on the standard
+         output) and 64-bit unsigned integers are converted when writing,
+         so they will be processed as before. */
+      if(ref==NULL)
+        {
+          ref=in;
+          sp->type=type;
+          *ndim=indim;
+          dsize=idsize;
+          if(indim<2 || type==GAL_TYPE_UINT64) break;
+        }
+      else
+        {
+          if(type!=sp->type)
+            error(EXIT_FAILURE, 0, "the types of all operands to the "
+                  "'%s' operator must be same, but %s (hdu %s) is '%s' "
+                  "while %s (hdu %s) is '%s'", token, in->filename,
+                  in->hdu, gal_type_name(type, 1), ref->filename,
+                  ref->hdu, gal_type_name(sp->type, 1));
+          if(indim!=*ndim)
+            error(EXIT_FAILURE, 0, "the sizes of all operands to the "
+                  "'%s' operator must be same, but %s (hdu %s) has %zu "
+                  "dimensions while %s (hdu %s) has %zu", token,
+                  in->filename, in->hdu, indim, ref->filename, ref->hdu,
+                  *ndim);
+          for(d=0;d<indim;++d)
+            if(idsize[d]!=dsize[d])
+              error(EXIT_FAILURE, 0, "the sizes of all operands to the "
+                    "'%s' operator must be same, but %s (hdu %s) is "
+                    "different from %s (hdu %s)", token, in->filename,
+                    in->hdu, ref->filename, ref->hdu);
+          free(idsize);
+        }
+    }
+
+  /* If the inputs should be processed as before, close them. */
+  if(i>0)
+    {
+      stackfits_close_all(sp);
+      free(dsize);
+      return NULL;
+    }
+
+  /* Return the size. */
+  return dsize;
+}
+
+
+
+
+
+/* Find the number of rows in each strip and allocate the strips. */
+static void
+stackfits_strips(struct arithmeticparams *p, struct stackfitsparams *sp,
+                 size_t ndim, size_t *dsize, size_t *nrows)
+{
+  size_t i, d, bytes;
+
+  /* Set the number of rows in each strip. */
+  sp->rowsize=gal_dimension_total_size(ndim, dsize)/dsize[0];
+  if(p->stackrows) *nrows=p->stackrows;
+  else
+    {
+      bytes = p->cp.maxmemory ? p->cp.maxmemory : STACKFITS_STRIPS_BYTES;
+      *nrows = bytes / (sp->numin * sp->rowsize * gal_type_sizeof(sp->type));
+      if(*nrows==0) *nrows=1;
+    }
+  if(*nrows>dsize[0]) *nrows=dsize[0];
+
+  /* Allocate the strips (with the largest number of rows) and put them in
+     a list (with the same order as the inputs). */
+  d=dsize[0];
+  dsize[0]=*nrows;
+  for(i=0;i<sp->numin;++i)
+    sp->in[i].strip=gal_data_alloc(NULL, sp->type, ndim, dsize, NULL, 0,
+                                   p->cp.minmapsize, p->cp.quietmmap,
+                                   NULL, NULL, NULL);
+  for(i=0;i<sp->numin;++i)
+    sp->in[i].strip->next = i<sp->numin-1 ? sp->in[i+1].strip : NULL;
+  dsize[0]=d;
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/**********************************************************************/
+/************           Writing the output strips       ***************/
+/**********************************************************************/
+/* Create an image HDU (with the given type and size) in the output and
+   write its keywords (the pixels are written later, strip by strip). The
+   number of the HDU is returned. */
+static int
+stackfits_hdu_create(struct arithmeticparams *p, fitsfile *fptr,
+                     uint8_t type, size_t ndim, size_t *dsize, char *name,
+                     char *unit, char *comment)
+{
+  void *blank;
+  long *naxes;
+  size_t i;
+  int hdunum, status=0;
+  gal_fits_list_key_t *keys=NULL;
+
+  /* Create the HDU. */
+  naxes=gal_pointer_allocate( ( sizeof(long)==8
+                                ? GAL_TYPE_INT64
+                                : GAL_TYPE_INT32 ), ndim, 0, __func__,
+                              "naxes");
+  for(i=0;i<ndim;++i) naxes[ndim-1-i]=dsize[i];
+  fits_create_img(fptr, gal_fits_type_to_bitpix(type), ndim, naxes,
+                  &status);
+  gal_fits_io_error(status, NULL);
+  free(naxes);
+
+  /* Remove the two comment lines put by CFITSIO (see
+     'gal_fits_img_write_to_ptr'). */
+  fits_delete_key(fptr, "COMMENT", &status);
+  fits_delete_key(fptr, "COMMENT", &status);
+  status=0;
+
+  /* Since the pixels aren't known yet, the BLANK keyword is always
+     written for integer types. */
+  if(type!=GAL_TYPE_FLOAT32 && type!=GAL_TYPE_FLOAT64)
+    {
+      blank=gal_fits_key_img_blank(type);
+      if(fits_write_key(fptr, gal_fits_type_to_datatype(type), "BLANK",
+                        blank, "Pixels with no data.", &status) )
+        gal_fits_io_error(status, "adding the BLANK keyword");
+      free(blank);
+    }
+
+  /* Write the metadata, WCS and version information. The header is
+     complete before any pixel is written, so CFITSIO never has to shift
+     the pixels to make room for new keywords. */
+  if(name)    fits_write_key(fptr, TSTRING, "EXTNAME", name, "", &status);
+  if(unit)    fits_write_key(fptr, TSTRING, "BUNIT", unit, "", &status);
+  if(comment) fits_write_comment(fptr, comment, &status);
+  gal_fits_io_error(status, NULL);
+  if(p->refdata.wcs) gal_wcs_write_in_fitsptr(fptr, p->refdata.wcs);
+  gal_fits_key_write_version_in_ptr(&keys, PROGRAM_NAME, fptr);
+
+  /* Return the HDU number. */
+  fits_get_hdu_num(fptr, &hdunum);
+  return hdunum;
+}
+
+
+
+
+
+/* Write the given strip (starting from element 'first', counting from 0)
+   into the given HDU. */
+static void
+stackfits_write(fitsfile *fptr, int hdunum, gal_data_t *strip,
+                size_t first)
+{
+  int status=0;
+  fits_movabs_hdu(fptr, hdunum, NULL, &status);
+  fits_write_img(fptr, gal_fits_type_to_datatype(strip->type),
+                 (LONGLONG)(first+1), strip->size, strip->array, &status);
+  gal_fits_io_error(status, NULL);
+}
+
+
+
+
+
+/* The number of rejected (clipped) inputs of each pixel: the number of
+   usable inputs minus the number that remained after clipping (it is
+   written into 'snum'). When the clipping has no result in a pixel (for
+   example it doesn't converge with a tolerance), the number after
+   clipping is blank; the number of rejected inputs is then also left
+   blank. */
+static void
+stackfits_rejected(gal_data_t *num, gal_data_t *snum)
+{
+  uint32_t *n=num->array, *s=snum->array, *sf=s+snum->size;
+  do { if(*s!=GAL_BLANK_UINT32) *s=*n-*s; ++n; } while(++s<sf);
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/**********************************************************************/
+/************               High-level function         ***************/
+/**********************************************************************/
+/* If the inputs of the given stacking operator can be stacked from the
+   files (see 'stackfits_possible' and 'stackfits_prepare'), stack them
+   strip by strip, write the output and return 1. Otherwise, return 0
+   without changing the operands (or freeing 'params'). */
+int
+stackfits(struct arithmeticparams *p, int operator, char *token,
+          size_t numop, gal_data_t *params)
+{
+  fitsfile *ofp=NULL;
+  struct stackfitsparams sp;
+  int status=0, ohdu=0, chdu=0, rhdu=0;
+  size_t i, j, s, ndim, row, nrows, nr, *dsize;
+  gal_data_t *out, *num=NULL, *snum=NULL, *list;
+  size_t nt=p->cp.numthreads;
+
+  /* See if the inputs may be stacked from the files. */
+  if( stackfits_possible(p, operator, numop)==0 ) return 0;
+
+  /* Initialize the parameters and open the inputs. */
+  memset(&sp, 0, sizeof sp);
+  sp.numin=numop;
+  sp.maxopen=stackfits_max_open(p, numop);
+  errno=0;
+  sp.in=calloc(numop, sizeof *sp.in);
+  if(sp.in==NULL)
+    error(EXIT_FAILURE, errno, "%s: %zu bytes for 'sp.in'", __func__,
+          numop*sizeof *sp.in);
+  dsize=stackfits_prepare(&sp, p->operands, token, &ndim);
+  if(dsize==NULL) { free(sp.in); return 0; }
+
+  /* The rejected inputs are only defined for sigma-clipping. */
+  if(p->stackrejected)
+    switch(operator)
+      {
+      case GAL_ARITHMETIC_OP_SIGCLIP_STD:
+      case GAL_ARITHMETIC_OP_SIGCLIP_MEAN:
+      case GAL_ARITHMETIC_OP_SIGCLIP_MEDIAN:
+      case GAL_ARITHMETIC_OP_SIGCLIP_NUMBER:
+        break;
+      default:
+        error(EXIT_FAILURE, 0, "'--stackrejected' is only relevant for "
+              "the sigma-clipping stacking operators (like "
+              "'sigclip-mean'), but the operator is '%s'", token);
+      }
+
+  /* Pop the inputs (the first popped input is the last one; they have
+     all been checked above) and allocate the strips. */
+  for(i=numop;i>0;--i)
+    sp.in[i-1].filename=operands_pop_file(p, &sp.in[i-1].hdu, ndim, dsize);
+  stackfits_strips(p, &sp, ndim, dsize, &nrows);
+  sp.blank=gal_blank_alloc_write(sp.type);
+  list=sp.in[0].strip;
+  if(!p->cp.quiet)
+    printf(" - Stacking %zu inputs in strips of %zu row(s) (at most %zu "
+           "open files).\n", numop, nrows, sp.maxopen);
+
+  /* Go over the strips. */
+  for(s=0, row=0; row<dsize[0]; ++s, row+=nrows)
+    {
+      /* Read this strip from all inputs. The order is reversed in every
+         other strip, so the most recently used inputs (that are still
+         open) are read first. */
+      nr = row+nrows>dsize[0] ? dsize[0]-row : nrows;
+      for(j=0;j<numop;++j)
+        stackfits_read(&sp, s%2 ? numop-1-j : j, row, nr);
+
+      /* Stack the strip (without freeing or changing the strips and
+         parameters). For the rejected inputs, the number of inputs after
+         clipping is returned by the same sigma-clipping (as the next
+         element of the output). */
+      out=gal_arithmetic_stack(operator, nt,
+                               ( p->stackrejected
+                                 ? GAL_ARITHMETIC_FLAG_CLIPNUM : 0 ),
+                               list, params, NULL, NULL);
+      if(p->stackcount || p->stackrejected)
+        num=gal_arithmetic_stack(GAL_ARITHMETIC_OP_NUMBER, nt, 0, list,
+                                 NULL, NULL, NULL);
+      if(p->stackrejected)
+        {
+          snum=out->next;
+          out->next=NULL;
+          stackfits_rejected(num, snum);
+        }
+
+      /* Create the output HDUs when the first strip is ready (the type
+         of the output is only known here). */
+      if(row==0)
+        {
+          ofp=gal_fits_open_to_write(p->cp.output);
+          ohdu=stackfits_hdu_create(p, ofp, out->type, ndim, dsize,
+                                    p->metaname, p->metaunit,
+                                    p->metacomment);
+          if(p->stackcount)
+            chdu=stackfits_hdu_create(p, ofp, num->type, ndim, dsize,
+                                      "COUNT", NULL, "Number of inputs "
+                                      "used in each pixel.");
+          if(p->stackrejected)
+            rhdu=stackfits_hdu_create(p, ofp, snum->type, ndim, dsize,
+                                      "REJECTED", NULL, "Number of "
+                                      "inputs clipped in each pixel.");
+        }
+
+      /* Write the output strip(s) and clean up. */
+      stackfits_write(ofp, ohdu, out, row*sp.rowsize);
+      if(chdu) stackfits_write(ofp, chdu, num, row*sp.rowsize);
+      if(rhdu) stackfits_write(ofp, rhdu, snum, row*sp.rowsize);
+      gal_data_free(out);
+      if(num)  { gal_data_free(num);  num=NULL;  }
+      if(snum) { gal_data_free(snum); snum=NULL; }
+    }
+
+  /* Close the output and inputs. Note that the file names are the
+     command-line tokens (like in 'operands_pop'), so they are not freed
+     here (only the HDUs belong to the popped operands). */
+  fits_close_file(ofp, &status);
+  gal_fits_io_error(status, NULL);
+  stackfits_close_all(&sp);
+  for(i=0;i<numop;++i)
+    {
+      sp.in[i].strip->next=NULL;
+      gal_data_free(sp.in[i].strip);
+      free(sp.in[i].hdu);
+    }
+
+  /* Let the user know and clean up. */
+  p->stackwritten=1;
+  if(!p->cp.quiet)
+    printf(" - Write (final): %s\n", p->cp.output);
+  if(params) gal_list_data_free(params);
+  free(sp.blank);
+  free(dsize);
+  free(sp.in);
+  return 1;
+}
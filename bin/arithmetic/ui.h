@@ -51,6 +51,10 @@ enum option_keys_enum
   /* Only with long version (start with a value 1000, the rest will be set
      automatically). */
   UI_KEY_ENVSEED         = 1000,
+  UI_KEY_STACKCOUNT,
+  UI_KEY_STACKREJECTED,
+  UI_KEY_STACKROWS,
+  UI_KEY_STACKMAXOPEN,
 };
 
 
@@ -116,6 +116,32 @@ struct argp_option program_options[] =
       GAL_OPTIONS_NOT_MANDATORY,
       GAL_OPTIONS_NOT_SET
     },
+    {
+      "pyramid",
+      UI_KEY_PYRAMID,
+      "STR",
+      0,
+      "Directory to write a tiled multi-resolution pyramid.",
+      GAL_OPTIONS_GROUP_OUTPUT,
+      &p->pyramid,
+      GAL_TYPE_STRING,
+      GAL_OPTIONS_RANGE_ANY,
+      GAL_OPTIONS_NOT_MANDATORY,
+      GAL_OPTIONS_NOT_SET
+    },
+    {
+      "pyramidtile",
+      UI_KEY_PYRAMIDTILE,
+      "INT",
+      0,
+      "Width of the (square) tiles in '--pyramid'.",
+      GAL_OPTIONS_GROUP_OUTPUT,
+      &p->pyramidtile,
+      GAL_TYPE_SIZE_T,
+      GAL_OPTIONS_RANGE_GT_0,
+      GAL_OPTIONS_NOT_MANDATORY,
+      GAL_OPTIONS_NOT_SET
+    },
 
 
 
@@ -34,6 +34,7 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <gnuastro/txt.h>
 #include <gnuastro/fits.h>
 #include <gnuastro/jpeg.h>
+#include <gnuastro/threads.h>
 #include <gnuastro/arithmetic.h>
 
 #include <gnuastro-internal/timing.h>
@@ -168,13 +169,73 @@ convertt_truncate(struct converttparams *p)
 /**************************************************************/
 /**************       convert to 8 bit          ***************/
 /**************************************************************/
+#define CONVERTT_CHUNK 262144   /* Pixels in each thread action.         */
+struct convertt_uchar_params
+{
+  float              *in;   /* Input (single precision) array.        */
+  unsigned char     *out;   /* Output array.                          */
+  size_t            size;   /* Number of elements.                    */
+  float              min;   /* Minimum value.                         */
+  float                m;   /* Multiple to scale to 'maxbyte'.        */
+  unsigned char  maxbyte;   /* Maximum output value.                  */
+  uint8_t         invert;   /* Invert the output.                     */
+};
+
+
+
+
+
+/* Scale the values of each chunk between '0' and 'maxbyte' (directly
+   into the 8-bit output). The scaled value is first kept in single
+   precision, then converted like 'gal_data_copy_to_new_type', so the
+   output is the same as scaling in place and copying it afterwards. */
+static void *
+convertt_scale_to_uchar_on_thread(void *in_prm)
+{
+  struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
+  struct convertt_uchar_params *up=tprm->params;
+
+  float v, *in=up->in;
+  size_t i, k, start, end;
+  unsigned char *out=up->out, maxbyte=up->maxbyte;
+
+  /* Go over all the chunks that were assigned to this thread. */
+  for(i=0; tprm->indexs[i]!=GAL_BLANK_SIZE_T; ++i)
+    {
+      start=tprm->indexs[i]*CONVERTT_CHUNK;
+      end = ( start+CONVERTT_CHUNK > up->size
+              ? up->size : start+CONVERTT_CHUNK );
+      if(up->invert)
+        for(k=start;k<end;++k)
+          {
+            v = isnan(in[k]) ? maxbyte : maxbyte-(in[k]-up->min)*up->m;
+            out[k] = isnan(v) ? UINT8_MAX : v;
+          }
+      else
+        for(k=start;k<end;++k)
+          {
+            v = isnan(in[k]) ? 0 : (in[k]-up->min)*up->m;
+            out[k] = isnan(v) ? UINT8_MAX : v;
+          }
+    }
+
+  /* Wait for all the other threads to finish, then return. */
+  if(tprm->b) pthread_barrier_wait(tprm->b);
+  return NULL;
+}
+
+
+
+
+
 void
 convertt_scale_to_uchar(struct converttparams *p)
 {
   size_t size=p->chll->size;
+  struct convertt_uchar_params up;
   unsigned char *u, *fu, maxbyte=p->maxbyte;
   gal_data_t *channel, *prev, *copied, *mind, *maxd;
-  float *f, *ff, m, tmin, tmax, min=FLT_MAX, max=-FLT_MAX;
+  float m, tmin, tmax, min=FLT_MAX, max=-FLT_MAX;
 
   /* Convert everything to single precision floating point type and find
      the minimum and maximum values of all the channels in the process. */
@@ -242,27 +303,31 @@ convertt_scale_to_uchar(struct converttparams *p)
 
   /* Convert all the non-blank channels to unsigned char. */
   prev=NULL;
+  up.m=m;
+  up.min=min;
+  up.size=size;
+  up.maxbyte=maxbyte;
+  up.invert=p->invert;
   for(channel=p->chll; channel!=NULL; channel=channel->next)
     {
       if(channel->status==0)
         {
-          /* Convert the values into a range between '0' and 'maxbyte'. */
-          ff=(f=channel->array)+size;
-          if(p->invert)
-            {
-              do
-                *f = isnan(*f) ? maxbyte : maxbyte-(*f-min)*m;
-              while(++f<ff);
-            }
-          else
-            {
-              do
-                *f = isnan(*f) ? 0 : (*f-min)*m;
-              while(++f<ff);
-            }
-
-          /* Change the type to unsigned char. */
-          copied=gal_data_copy_to_new_type(channel, GAL_TYPE_UINT8);
+          /* Allocate the output (with the same metadata). */
+          copied=gal_data_alloc(NULL, GAL_TYPE_UINT8, channel->ndim,
+                                channel->dsize, channel->wcs, 0,
+                                p->cp.minmapsize, p->cp.quietmmap,
+                                channel->name, channel->unit,
+                                channel->comment);
+          copied->flag=channel->flag & ~GAL_DATA_FLAG_FOREIGN;
+
+          /* Scale the values into a range between '0' and 'maxbyte' on
+             multiple threads. */
+          up.in=channel->array;
+          up.out=copied->array;
+          gal_threads_spin_off(convertt_scale_to_uchar_on_thread, &up,
+                               (size+CONVERTT_CHUNK-1)/CONVERTT_CHUNK,
+                               p->cp.numthreads, p->cp.minmapsize,
+                               p->cp.quietmmap);
 
           /* Correct the pointers. */
           copied->next=channel->next;
@@ -30,6 +30,7 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include "main.h"
 
 #include "ui.h"                  /* needs main.h.                  */
+#include "pyramid.h"
 #include "convertt.h"
 
 int
@@ -37,14 +38,18 @@ main(int argc, char *argv[])
 {
   struct converttparams p={{{0},0},0};
 
+  /* Run as a batch server if requested (only returns for each job). */
+  gal_options_batch(&argc, &argv);
+
   /* Set the starting time.*/
   time(&p.rawtime);
 
   /* Read the input parameters.*/
   ui_read_check_inputs_setup(argc, argv, &p);
 
-  /* Run Convert. */
-  convertt(&p);
+  /* Run Convert (for a tiled pyramid, the input is read as the tiles are
+     built). */
+  if(p.pyramid) pyramid(&p); else convertt(&p);
 
   /* Free all non-freed allocations. */
   ui_free_report(&p);
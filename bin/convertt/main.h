@@ -99,6 +99,8 @@ struct converttparams
   char           *changestr;  /* String of change values.              */
   uint8_t  changeaftertrunc;  /* First convert, then truncate.         */
   uint8_t            invert;  /* ==1: invert the output image.         */
+  char             *pyramid;  /* Directory of tiled pyramid.           */
+  size_t        pyramidtile;  /* Width of each tile in the pyramid.    */
   char           *marksname;  /* Filename with table with mark info.   */
   char            *markshdu;  /* HDU of table with mark info.          */
   char                *mode;  /* Mode of the coordinates for marks.    */
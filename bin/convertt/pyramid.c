@@ -0,0 +1,543 @@
+/*********************************************************************
+ConvertType - Convert between various types of files.
+ConvertType is part of GNU Astronomy Utilities (Gnuastro) package.
+
+Original author:
+     Mohammad Akhlaghi <mohammad@akhlaghi.org>
+Contributing author(s):
+Copyright (C) 2026 Free Software Foundation, Inc.
+
+Gnuastro is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation, either version 3 of the License, or (at your
+option) any later version.
+
+Gnuastro is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+#include <config.h>
+
+#include <math.h>
+#include <float.h>
+#include <stdio.h>
+#include <errno.h>
+#include <error.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <gnuastro/fits.h>
+#include <gnuastro/jpeg.h>
+#include <gnuastro/pool.h>
+#include <gnuastro/threads.h>
+#include <gnuastro/dimension.h>
+
+#include <gnuastro-internal/timing.h>
+#include <gnuastro-internal/checkset.h>
+
+#include "main.h"
+#include "pyramid.h"
+
+
+
+
+
+
+
+
+
+
+/**************************************************************/
+/**************        Internal structures      ***************/
+/**************************************************************/
+/* Maximum number of levels (more than enough for any image that can be
+   stored in a FITS file). */
+#define PYRAMID_MAXLEVELS 64
+
+/* Each level of the pyramid keeps one strip (with the height of a tile)
+   of its rows in memory. Once a strip is full, its tiles are written and
+   it is reduced into the next level's strip. */
+struct pyramid_level
+{
+  gal_data_t      *strip;   /* Rows of this level (float64).          */
+  size_t          filled;   /* Number of rows filled in the strip.    */
+  size_t         tilerow;   /* Row of the next tiles to write.        */
+  size_t           width;   /* Width of this level.                   */
+  char          *dirname;   /* Directory keeping this level's tiles.  */
+};
+
+struct pyramid_params
+{
+  struct converttparams *p; /* Program's parameters.                  */
+  struct pyramid_level  *l; /* Level that should be written.          */
+  size_t         nlevels;   /* Number of levels in the pyramid.       */
+  struct pyramid_level levels[PYRAMID_MAXLEVELS]; /* All the levels.  */
+
+  /* For conversion to 8-bit. */
+  double             min;   /* Value that becomes zero.               */
+  double               m;   /* Multiple to convert to 0 to 'maxbyte'. */
+  double             low;   /* Lower truncation value ('--fluxlow').  */
+  double            high;   /* Higher truncation value ('--fluxhigh').*/
+};
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/**************************************************************/
+/**************         Reading the input       ***************/
+/**************************************************************/
+/* Open the input and make sure it is a 2D image. */
+static fitsfile *
+pyramid_open(struct converttparams *p, char *hdu, size_t *dsize)
+{
+  int type;
+  fitsfile *fptr;
+  char *name=NULL, *unit=NULL;
+  size_t ndim, *idsize;
+
+  /* Open the file and read the basic information. */
+  fptr=gal_fits_hdu_open_format(p->inputnames->v, hdu, 0);
+  gal_fits_img_info(fptr, &type, &ndim, &idsize, &name, &unit);
+  ndim=gal_dimension_remove_extra(ndim, idsize, NULL);
+  if(ndim!=2)
+    error(EXIT_FAILURE, 0, "%s (hdu %s): has %zu dimensions, but only 2D "
+          "images can be converted to a pyramid", p->inputnames->v, hdu,
+          ndim);
+
+  /* Clean up and return. */
+  dsize[0]=idsize[0];
+  dsize[1]=idsize[1];
+  if(name) free(name);
+  if(unit) free(unit);
+  free(idsize);
+  return fptr;
+}
+
+
+
+
+
+/* Read the given number of rows into the strip (in double precision, with
+   blank values as NaN). */
+static void
+pyramid_read_rows(fitsfile *fptr, gal_data_t *strip, size_t firstrow,
+                  size_t nrows)
+{
+  int anyblank, status=0;
+  double blank=NAN;
+  size_t width=strip->dsize[1];
+
+  fits_read_img(fptr, TDOUBLE, (LONGLONG)(firstrow*width+1), nrows*width,
+                &blank, strip->array, &anyblank, &status);
+  if(status) gal_fits_io_error(status, NULL);
+
+  /* The strip is re-used, so the blank flags that were cached for the
+     previous rows (when pooling it) are no longer valid. */
+  strip->flag &= ~(GAL_DATA_FLAG_BLANK_CH | GAL_DATA_FLAG_HASBLANK);
+}
+
+
+
+
+
+/* Clip the value within the requested range. */
+static double
+pyramid_truncate(struct pyramid_params *pp, double v)
+{
+  if(v<pp->low)  return pp->low;
+  if(v>pp->high) return pp->high;
+  return v;
+}
+
+
+
+
+
+/* Find the scaling parameters like 'convertt_scale_to_uchar' (the
+   minimum and maximum are found after truncation). When both of the
+   minimum and maximum are forced, the input doesn't need to be read,
+   otherwise, it is read (strip by strip) to find the extrema. */
+static void
+pyramid_scale_params(struct pyramid_params *pp, fitsfile *fptr,
+                     size_t *dsize)
+{
+  struct converttparams *p=pp->p;
+  gal_data_t *strip=pp->levels[0].strip, *tmp;
+  double v, *d, *df, min=FLT_MAX, max=-FLT_MAX;
+  size_t i, nrows, height=strip->dsize[0];
+
+  /* Set the truncation values. */
+  pp->low=-INFINITY;
+  pp->high=INFINITY;
+  if(p->fluxlow)
+    {
+      tmp=gal_data_copy_to_new_type(p->fluxlow, GAL_TYPE_FLOAT64);
+      pp->low=((double *)(tmp->array))[0];
+      gal_data_free(tmp);
+    }
+  if(p->fluxhigh)
+    {
+      tmp=gal_data_copy_to_new_type(p->fluxhigh, GAL_TYPE_FLOAT64);
+      pp->high=((double *)(tmp->array))[0];
+      gal_data_free(tmp);
+    }
+
+  /* Find the minimum and maximum (if necessary). */
+  if( !(p->fluxlow && p->forcemin && p->fluxhigh && p->forcemax) )
+    for(i=0;i<dsize[0];i+=height)
+      {
+        nrows = i+height>dsize[0] ? dsize[0]-i : height;
+        pyramid_read_rows(fptr, strip, i, nrows);
+        df=(d=strip->array)+nrows*dsize[1];
+        do
+          if( !isnan(*d) )
+            {
+              v=pyramid_truncate(pp, *d);
+              if(v<min) min=v;
+              if(v>max) max=v;
+            }
+        while(++d<df);
+      }
+
+  /* Forced extrema. */
+  if(p->fluxlow  && p->forcemin) min=pp->low;
+  if(p->fluxhigh && p->forcemax) max=pp->high;
+
+  /* Conversion parameters (in single precision like the non-pyramid
+     conversion). */
+  pp->min=(float)min;
+  pp->m=(float)p->maxbyte/((float)max-(float)min);
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/**************************************************************/
+/**************          Writing tiles          ***************/
+/**************************************************************/
+/* Each action is one tile in the strip of the requested level. */
+static void *
+pyramid_write_on_thread(void *in_prm)
+{
+  struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
+  struct pyramid_params *pp=tprm->params;
+  struct converttparams *p=pp->p;
+  struct pyramid_level *l=pp->l;
+
+  float v;
+  char *filename;
+  gal_data_t *tile;
+  double *in, *strip=l->strip->array;
+  unsigned char *out, maxbyte=p->maxbyte;
+  size_t i, r, c, start, tsize=p->pyramidtile, dsize[2];
+
+  /* Go over all the tiles that were assigned to this thread. */
+  for(i=0; tprm->indexs[i]!=GAL_BLANK_SIZE_T; ++i)
+    {
+      /* Allocate the 8-bit tile. */
+      start=tprm->indexs[i]*tsize;
+      dsize[0]=l->filled;
+      dsize[1]=start+tsize>l->width ? l->width-start : tsize;
+      tile=gal_data_alloc(NULL, GAL_TYPE_UINT8, 2, dsize, NULL, 0,
+                          p->cp.minmapsize, p->cp.quietmmap, NULL, NULL,
+                          NULL);
+
+      /* Scale the values like 'convertt_scale_to_uchar'. */
+      out=tile->array;
+      for(r=0;r<dsize[0];++r)
+        {
+          in=strip+r*l->width+start;
+          for(c=0;c<dsize[1];++c)
+            {
+              if(isnan(in[c])) v = p->invert ? maxbyte : 0;
+              else
+                {
+                  v=((float)pyramid_truncate(pp, in[c])-(float)pp->min)
+                    * (float)pp->m;
+                  if(p->invert) v=maxbyte-v;
+                }
+              *out++ = isnan(v) ? UINT8_MAX : v;
+            }
+        }
+
+      /* Write the tile. */
+      if( asprintf(&filename, "%s/%zu_%zu.jpg", l->dirname, l->tilerow,
+                   tprm->indexs[i])<0 )
+        error(EXIT_FAILURE, 0, "%s: asprintf allocation", __func__);
+      gal_jpeg_write(tile, filename, p->quality, p->widthincm);
+
+      /* Clean up. */
+      free(filename);
+      gal_data_free(tile);
+    }
+
+  /* Wait for all the other threads to finish, then return. */
+  if(tprm->b) pthread_barrier_wait(tprm->b);
+  return NULL;
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/**************************************************************/
+/**************         Building levels         ***************/
+/**************************************************************/
+static void
+pyramid_add_rows(struct pyramid_params *pp, size_t lind, double *rows,
+                 size_t nrows);
+
+
+
+/* Write the tiles of the filled rows in the strip of the given level,
+   then reduce them (with a 2x2 mean) into the next level. */
+static void
+pyramid_flush(struct pyramid_params *pp, size_t lind)
+{
+  struct converttparams *p=pp->p;
+  struct pyramid_level *l=&pp->levels[lind];
+
+  gal_data_t *pooled;
+  size_t height=l->strip->dsize[0], wsize[2]={2,2};
+
+  /* Write all the tiles of this strip in parallel. */
+  pp->l=l;
+  gal_threads_spin_off(pyramid_write_on_thread, pp,
+                       (l->width+p->pyramidtile-1)/p->pyramidtile,
+                       p->cp.numthreads, p->cp.minmapsize,
+                       p->cp.quietmmap);
+
+  /* Reduce the strip into the next level (if there is any). The strip's
+     size is temporarily set to the filled rows (the last strip of a level
+     can be shorter). */
+  if(lind+1<pp->nlevels)
+    {
+      l->strip->dsize[0]=l->filled;
+      l->strip->size=l->filled*l->width;
+      pooled=gal_pool_window(l->strip, GAL_POOL_MEAN, wsize, NULL, NULL,
+                             p->cp.numthreads);
+      l->strip->dsize[0]=height;
+      l->strip->size=height*l->width;
+      pyramid_add_rows(pp, lind+1, pooled->array, pooled->dsize[0]);
+      gal_data_free(pooled);
+    }
+
+  /* Prepare this level for the next strip. */
+  l->filled=0;
+  ++l->tilerow;
+}
+
+
+
+
+
+/* Add rows to the strip of the given level, and flush it when it is
+   full. Since the tile height is even, the rows of a reduced strip never
+   overflow the next level's strip. */
+static void
+pyramid_add_rows(struct pyramid_params *pp, size_t lind, double *rows,
+                 size_t nrows)
+{
+  struct pyramid_level *l=&pp->levels[lind];
+  double *strip=l->strip->array;
+
+  memcpy(strip+l->filled*l->width, rows, nrows*l->width*sizeof *strip);
+  l->strip->flag &= ~(GAL_DATA_FLAG_BLANK_CH | GAL_DATA_FLAG_HASBLANK);
+  l->filled+=nrows;
+  if(l->filled==l->strip->dsize[0]) pyramid_flush(pp, lind);
+}
+
+
+
+
+
+/* Prepare the levels: the pyramid continues until both sides of the last
+   level fit in one tile. */
+static void
+pyramid_prepare_levels(struct pyramid_params *pp, size_t *dsize)
+{
+  struct converttparams *p=pp->p;
+
+  int errnum;
+  size_t i, height=dsize[0], sdsize[2];
+
+  /* Make the top directory. */
+  if( (errnum=gal_checkset_mkdir(p->pyramid)) )
+    error(EXIT_FAILURE, errnum, "%s: making the pyramid's directory",
+          p->pyramid);
+
+  /* Set the levels. */
+  pp->nlevels=0;
+  sdsize[0]=p->pyramidtile;
+  sdsize[1]=dsize[1];
+  do
+    {
+      if(pp->nlevels==PYRAMID_MAXLEVELS)
+        error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at '%s' to "
+              "fix the problem. More than %d levels are necessary",
+              __func__, PACKAGE_BUGREPORT, PYRAMID_MAXLEVELS);
+
+      /* Allocate this level's strip. */
+      pp->levels[pp->nlevels].width=sdsize[1];
+      pp->levels[pp->nlevels].strip=gal_data_alloc(NULL, GAL_TYPE_FLOAT64,
+                                                   2, sdsize, NULL, 0,
+                                                   p->cp.minmapsize,
+                                                   p->cp.quietmmap, NULL,
+                                                   NULL, NULL);
+
+      /* Make this level's directory. */
+      if( asprintf(&pp->levels[pp->nlevels].dirname, "%s/%zu", p->pyramid,
+                   pp->nlevels)<0 )
+        error(EXIT_FAILURE, 0, "%s: asprintf allocation", __func__);
+      if( (errnum=gal_checkset_mkdir(pp->levels[pp->nlevels].dirname)) )
+        error(EXIT_FAILURE, errnum, "%s: making the directory of level "
+              "%zu", pp->levels[pp->nlevels].dirname, pp->nlevels);
+
+      /* Go to the next level. */
+      ++pp->nlevels;
+      if(height<=p->pyramidtile && sdsize[1]<=p->pyramidtile) break;
+      height = height/2 + height%2;
+      sdsize[1] = sdsize[1]/2 + sdsize[1]%2;
+    }
+  while(1);
+
+  /* Initialize the counters. */
+  for(i=0;i<pp->nlevels;++i)
+    pp->levels[i].filled=pp->levels[i].tilerow=0;
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/**************************************************************/
+/**************          Main function          ***************/
+/**************************************************************/
+/* Read the input in strips (with the height of a tile) and write all the
+   levels of the pyramid as JPEG tiles in one pass over the input. */
+void
+pyramid(struct converttparams *p)
+{
+  size_t i, nrows, dsize[2];
+  struct pyramid_params pp={0};
+  struct pyramid_level *first;
+  struct timeval t1;
+  fitsfile *fptr;
+  int status=0;
+  char *hdu;
+
+  /* Open the input and prepare the levels. */
+  if(!p->cp.quiet) gettimeofday(&t1, NULL);
+  hdu = p->globalhdu ? p->globalhdu : p->hdus->v;
+  fptr=pyramid_open(p, hdu, dsize);
+  pp.p=p;
+  pyramid_prepare_levels(&pp, dsize);
+  first=&pp.levels[0];
+
+  /* Find the scaling parameters. */
+  pyramid_scale_params(&pp, fptr, dsize);
+
+  /* Read the input strip by strip: each strip fills the first level and
+     all the higher levels are built from it (while it is in memory). */
+  for(i=0;i<dsize[0];i+=p->pyramidtile)
+    {
+      nrows = i+p->pyramidtile>dsize[0] ? dsize[0]-i : p->pyramidtile;
+      pyramid_read_rows(fptr, first->strip, i, nrows);
+      first->filled=nrows;
+      if(nrows==p->pyramidtile) pyramid_flush(&pp, 0);
+    }
+
+  /* Flush the (possibly) partially filled strips of all levels (from the
+     bottom, so the rows of each level go into the next before it is
+     flushed). */
+  for(i=0;i<pp.nlevels;++i)
+    if(pp.levels[i].filled) pyramid_flush(&pp, i);
+
+  /* Close the input. */
+  fits_close_file(fptr, &status);
+  gal_fits_io_error(status, NULL);
+
+  /* Report the result. */
+  if(!p->cp.quiet)
+    {
+      if( asprintf(&hdu, "%zu levels of %zux%zu JPEG tiles written in "
+                   "'%s'", pp.nlevels, p->pyramidtile, p->pyramidtile,
+                   p->pyramid)<0 )
+        error(EXIT_FAILURE, 0, "%s: asprintf allocation", __func__);
+      gal_timing_report(&t1, hdu, 0);
+      free(hdu);
+    }
+
+  /* Clean up. */
+  for(i=0;i<pp.nlevels;++i)
+    {
+      free(pp.levels[i].dirname);
+      gal_data_free(pp.levels[i].strip);
+    }
+}
@@ -1705,12 +1705,73 @@ ui_marks_read(struct converttparams *p)
 
 
 
+/***********************************************************************/
+/****************          Tiled pyramid output     ********************/
+/***********************************************************************/
+/* The pyramid is built while the input is read (strip by strip), so the
+   input channels aren't read here and the output name isn't used. */
+static void
+ui_pyramid_check(struct converttparams *p)
+{
+  /* Only a single FITS image is currently supported. */
+  if(p->inputnames==NULL || p->inputnames->next
+     || !gal_fits_file_recognized(p->inputnames->v) )
+    error(EXIT_FAILURE, 0, "'--pyramid' needs exactly one input FITS "
+          "image");
+  gal_checkset_check_file(p->inputnames->v);
+  if(p->globalhdu==NULL && p->hdus==NULL)
+    error(EXIT_FAILURE, 0, "no HDU specified for '%s'. Please use the "
+          "'--hdu' ('-h') or '--globalhdu' ('-g') options",
+          p->inputnames->v);
+
+  /* Options that need the full image in memory. */
+  if(p->changestr || p->marksname)
+    error(EXIT_FAILURE, 0, "'--change' and '--marks' can't be used with "
+          "'--pyramid'");
+  if(p->colormap && p->colormap->status!=COLOR_GRAY)
+    error(EXIT_FAILURE, 0, "only the 'gray' colormap can currently be "
+          "used with '--pyramid'");
+
+  /* The tiles. */
+  if(p->pyramidtile<2 || p->pyramidtile%2)
+    error(EXIT_FAILURE, 0, "%zu is not acceptable for '--pyramidtile': "
+          "it should be an even number (larger than zero), so each tile "
+          "of a level is built from complete 2x2 pixels of the previous "
+          "one", p->pyramidtile);
+  if(p->quality == GAL_BLANK_UINT8 || p->quality > 100)
+    error(EXIT_FAILURE, 0, "the '--quality' ('-u') option is necessary "
+          "for the JPEG tiles of '--pyramid' and should be between 1 and "
+          "100 (inclusive)");
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
 /***********************************************************************/
 /****************       High-level preparations     ********************/
 /***********************************************************************/
 void
 ui_preparations(struct converttparams *p)
 {
+  /* For a tiled pyramid, the input is read during the processing. */
+  if(p->pyramid) { ui_pyramid_check(p); return; }
+
   /* Convert the change string into the proper list. */
   if(p->changestr)
     p->change=ui_make_change_struct(p->changestr);
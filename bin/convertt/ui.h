@@ -69,6 +69,8 @@ enum option_keys_enum
      automatically). */
   UI_KEY_COLORMAP            = 1000,
   UI_KEY_RGBTOHSV,
+  UI_KEY_PYRAMID,
+  UI_KEY_PYRAMIDTILE,
   UI_KEY_BORDERCOLOR,
   UI_KEY_MARKS,
   UI_KEY_MARKSHDU,
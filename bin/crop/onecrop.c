@@ -223,14 +223,11 @@ onecrop_ipolygon_fl(double *ipolygon, size_t nvertices, long *fpixel,
 
 
 
+/* Set the pixels that should be masked (where the mask is equal to
+   'polygonout') to blank. */
 #define POLYGON_MASK(CTYPE) {                                           \
     CTYPE *ba=array, *bb=gal_blank_alloc_write(type);                   \
-    for(i=0;i<size;++i)                                                 \
-      {                                                                 \
-        point[0]=i%s1+1; point[1]=i/s1+1;                               \
-        if((*isinside)(ipolygon, point, nvertices)==polygonout)         \
-          ba[i]=*bb;                                                    \
-      }                                                                 \
+    for(i=0;i<size;++i) if(m[i]==polygonout) ba[i]=*bb;                 \
     free(bb);                                                           \
   }
 
@@ -239,11 +236,14 @@ void
 polygonmask(struct onecropparams *crp, void *array, long *fpixel_i,
             size_t s0, size_t s1)
 {
+  uint8_t *m;
+  gal_data_t *mask;
+  double *ipolygon;
   int type=crp->p->type;
-  double *ipolygon, point[2];
+  gal_polygon_prepared_t *pp;
   int polygonout=crp->p->polygonout;
-  int (*isinside)(double *, double *, size_t);
   size_t i, *ordinds, size=s0*s1, nvertices=crp->p->nvertices;
+  size_t dsize[2]={s0, s1};
 
   /* First of all, allocate enough space to put a copy of the input
      coordinates (we will be using that after sorting in an
@@ -293,13 +293,17 @@ polygonmask(struct onecropparams *crp, void *array, long *fpixel_i,
           "in counter-clockwise order _and_ don't use the '--polygonsort' "
           "option", __func__);
 
-  /* Set the function for checking if a point is inside the polygon. For
-     concave polygons the process is more complex and thus
-     slower. Therefore when the polygon is convex, its better to use the
-     simpler/faster function. */
-  isinside = ( gal_polygon_is_convex(ipolygon, nvertices)
-               ? gal_polygon_is_inside_convex
-               : gal_polygon_is_inside );
+  /* Build the mask of the pixels inside the polygon: instead of checking
+     every pixel, the spans of pixels inside the polygon are filled on
+     each row. When the polygon is convex, the result is identical to
+     'gal_polygon_is_inside_convex' on every pixel, otherwise to
+     'gal_polygon_is_inside'. Crops are already done on separate threads,
+     so only one thread is used here. */
+  pp=gal_polygon_prepare(ipolygon, nvertices,
+                         gal_polygon_is_convex(ipolygon, nvertices));
+  mask=gal_polygon_prepared_mask(pp, dsize, 1, crp->p->cp.minmapsize,
+                                 crp->p->cp.quietmmap);
+  m=mask->array;
 
   /* Go over all the pixels in the image and if they are within the
      polygon keep them if the user has asked for it.*/
@@ -323,6 +327,8 @@ polygonmask(struct onecropparams *crp, void *array, long *fpixel_i,
   /* Clean up: */
   free(ordinds);
   free(ipolygon);
+  gal_data_free(mask);
+  gal_polygon_prepared_free(pp);
 }
 
 
@@ -30,6 +30,7 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 
 #include <gnuastro/wcs.h>
 #include <gnuastro/fits.h>
+#include <gnuastro/threads.h>
 #include <gnuastro/pointer.h>
 #include <gnuastro-internal/timing.h>
 
@@ -917,45 +918,49 @@ keywords_value_in_output_rest(struct fitsparams *p, gal_data_t *out,
 
 
 
-static void
-keywords_value(struct fitsparams *p)
+/* Parameters to read the keywords of all inputs in parallel. */
+struct keywords_value_params
 {
-  int status;
-  fitsfile *fptr=NULL;
-  gal_list_str_t *input, *tmp;
-  size_t i, ii=0, ninput, nkeys;
-  gal_data_t *out=NULL, *keysll=NULL;
+  struct fitsparams    *p;     /* Main program parameters.             */
+  char             **names;    /* Names of the input files.            */
+  gal_data_t       **keys;     /* Keywords of each input file.         */
+  size_t            nkeys;     /* Number of keywords to read.          */
+};
 
-  /* Count how many inputs there are, and allocate the first column with
-     the name. */
-  ninput=gal_list_str_number(p->input);
-  if(ninput>1 || p->cp.quiet==0)
-    out=gal_data_alloc(NULL, GAL_TYPE_STRING, 1, &ninput, NULL, 0,
-                       p->cp.minmapsize, p->cp.quietmmap, "FILENAME",
-                       "name", "Name of input file.");
 
-  /* Allocate the structure to host the desired keywords read from each
-     FITS file and their values. But first convert the list of strings (for
-     keyword names), (where each string can be a comma-separated list) into
-     a list with a single value per string. */
-  gal_options_merge_list_of_csv(&p->keyvalue);
-  nkeys=gal_list_str_number(p->keyvalue);
 
-  /* Parse each input file, read the keywords and put them in the output
-     list. */
-  for(input=p->input; input!=NULL; input=input->next)
+
+
+/* Read the requested keywords of each input file. */
+static void *
+keywords_value_on_thread(void *in_prm)
+{
+  struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
+  struct keywords_value_params *kp=
+    (struct keywords_value_params *)tprm->params;
+  struct fitsparams *p=kp->p;
+
+  int status;
+  fitsfile *fptr;
+  gal_list_str_t *tmp;
+  gal_data_t *keysll;
+  size_t i, j, ind;
+
+  /* Go over all the files that were assigned to this thread. */
+  for(i=0; tprm->indexs[i] != GAL_BLANK_SIZE_T; ++i)
     {
       /* Open the input FITS file. */
-      fptr=gal_fits_hdu_open(input->v, p->cp.hdu, READONLY, 1);
+      ind = tprm->indexs[i];
+      fptr=gal_fits_hdu_open(kp->names[ind], p->cp.hdu, READONLY, 1);
 
       /* Allocate the array to keep the keys. */
-      i=0;
-      keysll=gal_data_array_calloc(nkeys);
+      j=0;
+      keysll=kp->keys[ind]=gal_data_array_calloc(kp->nkeys);
       for(tmp=p->keyvalue; tmp!=NULL; tmp=tmp->next)
         {
-          if(tmp->next) keysll[i].next=&keysll[i+1];
-          keysll[i].name=tmp->v;
-          ++i;
+          if(tmp->next) keysll[j].next=&keysll[j+1];
+          keysll[j].name=tmp->v;
+          ++j;
         }
 
       /* Read the keys. Note that we only need the comments and units if
@@ -967,8 +972,70 @@ keywords_value(struct fitsparams *p)
       status=0;
       if(fits_close_file(fptr, &status))
         gal_fits_io_error(status, NULL);
+    }
 
+  /* Wait for all the other threads to finish, then return. */
+  if(tprm->b) pthread_barrier_wait(tprm->b);
+  return NULL;
+}
+
+
+
+
+
+static void
+keywords_value(struct fitsparams *p)
+{
+  gal_list_str_t *input;
+  size_t i, ii=0, ninput;
+  gal_data_t *out=NULL, *keysll=NULL;
+  struct keywords_value_params kp={0};
+
+  /* The inputs are opened with CFITSIO on each thread, so it needs to be
+     configured in multi-thread mode ('fits_is_reentrant' is only
+     available from CFITSIO 3.30). Otherwise, just use a single thread. */
+#if GAL_CONFIG_HAVE_FITS_IS_REENTRANT == 1
+  size_t nthreads = fits_is_reentrant() ? p->cp.numthreads : 1;
+#else
+  size_t nthreads=1;
+#endif
+
+  /* Count how many inputs there are, and allocate the first column with
+     the name. */
+  ninput=gal_list_str_number(p->input);
+  if(ninput>1 || p->cp.quiet==0)
+    out=gal_data_alloc(NULL, GAL_TYPE_STRING, 1, &ninput, NULL, 0,
+                       p->cp.minmapsize, p->cp.quietmmap, "FILENAME",
+                       "name", "Name of input file.");
+
+  /* Allocate the structure to host the desired keywords read from each
+     FITS file and their values. But first convert the list of strings (for
+     keyword names), (where each string can be a comma-separated list) into
+     a list with a single value per string. */
+  gal_options_merge_list_of_csv(&p->keyvalue);
+  kp.nkeys=gal_list_str_number(p->keyvalue);
+
+  /* Read the keywords of all the input files in parallel (when there are
+     many inputs, opening them is the most expensive part). */
+  kp.p=p;
+  kp.names=gal_pointer_allocate(GAL_TYPE_STRING, ninput, 0, __func__,
+                                "kp.names");
+  errno=0;
+  kp.keys=malloc(ninput*sizeof *kp.keys);
+  if(kp.keys==NULL)
+    error(EXIT_FAILURE, errno, "%s: allocating %zu bytes for 'kp.keys'",
+          __func__, ninput*sizeof *kp.keys);
+  for(i=0, input=p->input; input!=NULL; input=input->next)
+    kp.names[i++]=input->v;
+  gal_threads_spin_off(keywords_value_on_thread, &kp, ninput, nthreads,
+                       p->cp.minmapsize, p->cp.quietmmap);
+
+  /* Put the keywords of each input file in the output list (in the same
+     order as the inputs). */
+  for(input=p->input; input!=NULL; input=input->next)
+    {
       /* Write the values of this column into the final output. */
+      keysll=kp.keys[ii];
       if(ii==0)
         {
           ++ii;
@@ -980,9 +1047,11 @@ keywords_value(struct fitsparams *p)
                                       ii++);
 
       /* Clean up. */
-      for(i=0;i<nkeys;++i) keysll[i].name=NULL;
-      gal_data_array_free(keysll, nkeys, 1);
+      for(i=0;i<kp.nkeys;++i) keysll[i].name=NULL;
+      gal_data_array_free(keysll, kp.nkeys, 1);
     }
+  free(kp.names);
+  free(kp.keys);
 
   /* Write the values. */
   gal_checkset_writable_remove(p->cp.output, p->input->v, 0,
@@ -39,6 +39,9 @@ main (int argc, char *argv[])
   int r;
   struct fitsparams p={{{0},0},0};
 
+  /* Run as a batch server if requested (only returns for each job). */
+  gal_options_batch(&argc, &argv);
+
   /* Get the starting time. */
   time(&p.rawtime);
 
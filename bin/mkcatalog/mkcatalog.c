@@ -798,14 +798,20 @@ mkcatalog(struct mkcatalogparams *p)
      it to assign a column to the clumps in the final catalog. */
   if( p->cp.numthreads > 1 ) pthread_mutex_init(&p->mutex, NULL);
 
-  /* Do the processing on each thread. */
+  /* Do the processing on each thread. Note that the objects are not
+     traced individually (there can be millions of them), the time of each
+     thread is recorded within 'gal_threads_spin_off'. */
+  gal_timing_trace_begin("mkcatalog: measure objects");
   gal_threads_spin_off(mkcatalog_single_object, p, p->numobjects,
                        p->cp.numthreads, p->cp.minmapsize,
                        p->cp.quietmmap);
+  gal_timing_trace_end("mkcatalog: measure objects");
 
   /* Post-thread processing, for example to convert image coordinates to RA
      and Dec. */
+  gal_timing_trace_begin("mkcatalog: wcs conversion");
   mkcatalog_wcs_conversion(p);
+  gal_timing_trace_end("mkcatalog: wcs conversion");
 
   /* If the columns need to be sorted (by object ID), then some adjustments
      need to be made (possibly to both the objects and clumps catalogs). */
@@ -813,7 +819,9 @@ mkcatalog(struct mkcatalogparams *p)
     sort_clumps_by_objid(p);
 
   /* Write the filled columns into the output. */
+  gal_timing_trace_begin("mkcatalog: write outputs");
   mkcatalog_write_outputs(p);
+  gal_timing_trace_end("mkcatalog: write outputs");
 
   /* Destroy the mutex. */
   if( p->cp.numthreads>1 ) pthread_mutex_destroy(&p->mutex);
@@ -1264,9 +1264,13 @@ parse_order_based(struct mkcatalog_passparams *pp)
   double *ci;
   float *sigcliparr;
   gal_data_t *result;
+  char *mmapname=NULL;
+  void *valsbuf=NULL;
+  gal_data_view_t objview;
   int32_t *O, *OO, *C=NULL;
-  size_t i, increment=0, num_increment=1;
+  gal_data_view_t *clumpsview=NULL;
   gal_data_t *objvals=NULL, **clumpsvals=NULL;
+  size_t i, nvals, increment=0, num_increment=1;
   size_t *tsize=pp->tile->dsize, ndim=p->objects->ndim;
   size_t counter=0, *ccounter=NULL, tmpsize=pp->oi[OCOL_NUM];
 
@@ -1305,11 +1309,22 @@ parse_order_based(struct mkcatalog_passparams *pp)
       return;
     }
 
-  /* We know we have pixels to use, so allocate space for the values within
-     the object. */
-  objvals=gal_data_alloc(NULL, p->values->type, 1, &tmpsize, NULL, 0,
-                         p->cp.minmapsize, p->cp.quietmmap, NULL, NULL,
-                         NULL);
+  /* We know we have pixels to use, so allocate a single buffer to keep
+     the values within the object, followed by the values within each of
+     its clumps. This function is called for every object, so the
+     containers of the object and its clumps are only views into this
+     buffer (to avoid allocating and freeing a 'gal_data_t', its 'dsize'
+     and its array for each one of them). */
+  nvals=tmpsize;
+  if(p->clumps)
+    for(i=0;i<pp->clumpsinobj;++i)
+      nvals += (size_t)(pp->ci[ i * CCOL_NUMCOLS + CCOL_NUM ]);
+  valsbuf=gal_pointer_allocate_ram_or_mmap(p->values->type, nvals, 0,
+                                           p->cp.minmapsize, &mmapname,
+                                           p->cp.quietmmap, __func__,
+                                           "valsbuf");
+  objvals=gal_data_view(&objview, valsbuf, p->values->type, 1, &tmpsize,
+                        NULL);
 
   /* Clump preparations. */
   if(p->clumps)
@@ -1320,20 +1335,28 @@ parse_order_based(struct mkcatalog_passparams *pp)
       if(clumpsvals==NULL)
         error(EXIT_FAILURE, errno, "%s: couldn't allocate 'clumpsvals' "
               "for %zu clumps", __func__, pp->clumpsinobj);
+      errno=0;
+      clumpsview=malloc(pp->clumpsinobj * sizeof *clumpsview);
+      if(clumpsview==NULL)
+        error(EXIT_FAILURE, errno, "%s: couldn't allocate 'clumpsview' "
+              "for %zu clumps", __func__, pp->clumpsinobj);
 
-      /* Allocate the array necessary to keep the values of each clump. */
+      /* Set the view to keep the values of each clump (after those of the
+         object). */
+      nvals=objvals->size;
       ccounter=gal_pointer_allocate(GAL_TYPE_SIZE_T, pp->clumpsinobj, 1,
                                     __func__, "ccounter");
       for(i=0;i<pp->clumpsinobj;++i)
         {
           tmpsize=pp->ci[ i * CCOL_NUMCOLS + CCOL_NUM ];
           clumpsvals[i] = ( tmpsize
-                            ? gal_data_alloc(NULL, p->values->type, 1,
-                                             &tmpsize, NULL, 0,
-                                             p->cp.minmapsize,
-                                             p->cp.quietmmap,
-                                             NULL, NULL, NULL)
+                            ? gal_data_view(&clumpsview[i],
+                                            gal_pointer_increment(valsbuf,
+                                                 nvals, p->values->type),
+                                            p->values->type, 1, &tmpsize,
+                                            NULL)
                             : NULL );
+          nvals+=tmpsize;
         }
     }
 
@@ -1421,8 +1444,6 @@ parse_order_based(struct mkcatalog_passparams *pp)
       || p->oiflag[ OCOL_FRACMAX2NUM ] )
     parse_area_of_frac_sum(pp, objvals, pp->oi, 1);
 
-  /* Clean up the object values. */
-  gal_data_free(objvals);
 
 
   /* Calculate the necessary value for clumps. */
@@ -1514,11 +1535,13 @@ parse_order_based(struct mkcatalog_passparams *pp)
                   if(p->ciflag[CCOL_FRACMAX2SUM]) ci[CCOL_FRACMAX2SUM]=NAN;
                 }
             }
-
-          /* Clean up this clump's values. */
-          gal_data_free(clumpsvals[i]);
         }
+      free(clumpsview);
       free(clumpsvals);
       free(ccounter);
     }
+
+  /* Clean up the buffer that was hosting all the values. */
+  if(mmapname) gal_pointer_mmap_free(&mmapname, p->cp.quietmmap);
+  else         free(valsbuf);
 }
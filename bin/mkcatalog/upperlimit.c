@@ -448,8 +448,9 @@ static void
 upperlimit_measure(struct mkcatalog_passparams *pp, int32_t clumplab,
                    int do_measurement)
 {
-  float *scarr;
   gal_data_t *column;
+  float *scarr, sumval;
+  gal_data_view_t sumview;
   size_t init_size, col, one=1;
   struct mkcatalogparams *p=pp->p;
   gal_data_t *sum, *qfunc=NULL, *sigclip=NULL;
@@ -476,9 +477,9 @@ upperlimit_measure(struct mkcatalog_passparams *pp, int32_t clumplab,
                   /* Similar to the case for sigma-clipping, we'll need to
                      keep the size here also. */
                   init_size=pp->up_vals->size;
-                  sum=gal_data_alloc(NULL, GAL_TYPE_FLOAT32, 1, &one, NULL, 0,
-                                     -1, 1, NULL, NULL, NULL);
-                  ((float *)(sum->array))[0]=o[clumplab?CCOL_SUM:OCOL_SUM];
+                  sumval=o[clumplab?CCOL_SUM:OCOL_SUM];
+                  sum=gal_data_view(&sumview, &sumval, GAL_TYPE_FLOAT32, 1,
+                                    &one, NULL);
                   qfunc=gal_statistics_quantile_function(pp->up_vals, sum, 1);
 
                   /* Fill in the column. */
@@ -486,8 +487,7 @@ upperlimit_measure(struct mkcatalog_passparams *pp, int32_t clumplab,
                   pp->up_vals->size=pp->up_vals->dsize[0]=init_size;
                   o[col] = ((double *)(qfunc->array))[0];
 
-                  /* Clean up. */
-                  gal_data_free(sum);
+                  /* Clean up ('sum' is a view on the stack). */
                   gal_data_free(qfunc);
                 }
               break;
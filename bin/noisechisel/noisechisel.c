@@ -241,16 +241,24 @@ void
 noisechisel(struct noisechiselparams *p)
 {
   /* Convolve the image. */
+  gal_timing_trace_begin("noisechisel: convolve");
   noisechisel_convolve(p);
+  gal_timing_trace_end("noisechisel: convolve");
 
   /* Do the initial detection. */
+  gal_timing_trace_begin("noisechisel: initial detection");
   detection_initial(p);
+  gal_timing_trace_end("noisechisel: initial detection");
 
   /* Remove false detections. */
+  gal_timing_trace_begin("noisechisel: detection");
   detection(p);
+  gal_timing_trace_end("noisechisel: detection");
 
   /* Find the final Sky and Sky STD values. */
+  gal_timing_trace_begin("noisechisel: sky and std");
   sky_and_std(p, p->skyname);
+  gal_timing_trace_end("noisechisel: sky and std");
 
   /* Abort if the user only wanted to see until this point.*/
   if(p->skyname && !p->continueaftercheck)
@@ -258,5 +266,7 @@ noisechisel(struct noisechiselparams *p)
                          "derivation of final Sky (and its STD) value");
 
   /* Write the output. */
+  gal_timing_trace_begin("noisechisel: output");
   noisechisel_output(p);
+  gal_timing_trace_end("noisechisel: output");
 }
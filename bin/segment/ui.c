@@ -625,13 +625,12 @@ ui_prepare_tiles(struct segmentparams *p)
   gal_tile_full_permutation(ltl);
 
 
-  /* If the input has blank elements, then set the appropriate flag for
-     each tile.*/
-  if( p->input->flag & GAL_DATA_FLAG_HASBLANK )
-    {
-      gal_tile_block_blank_flag(tl->tiles,  p->cp.numthreads);
-      gal_tile_block_blank_flag(ltl->tiles, p->cp.numthreads);
-    }
+  /* Set the blank flag of each tile. When the input has no blank
+     elements (its flags have already been set), the tiles aren't parsed:
+     they are just flagged as blank-free, so later checks on each tile
+     don't need to parse it either. */
+  gal_tile_block_blank_flag(tl->tiles,  p->cp.numthreads);
+  gal_tile_block_blank_flag(ltl->tiles, p->cp.numthreads);
 
 
   /* Make the tile check image if requested. */
@@ -555,6 +555,19 @@ struct argp_option program_options[] =
       GAL_OPTIONS_NOT_MANDATORY,
       GAL_OPTIONS_NOT_SET
     },
+    {
+      "modebins",
+      UI_KEY_MODEBINS,
+      "INT",
+      0,
+      "Find mode from histogram with INT bins.",
+      UI_GROUP_SKY,
+      &p->modebins,
+      GAL_TYPE_SIZE_T,
+      GAL_OPTIONS_RANGE_GE_0,
+      GAL_OPTIONS_NOT_MANDATORY,
+      GAL_OPTIONS_NOT_SET
+    },
     {
       "meanmedqdiff",
       UI_KEY_MEANMEDQDIFF,
@@ -875,6 +888,19 @@ struct argp_option program_options[] =
       GAL_OPTIONS_NOT_MANDATORY,
       GAL_OPTIONS_NOT_SET
     },
+    {
+      "fitgroup",
+      UI_KEY_FITGROUP,
+      "STR/INT",
+      0,
+      "Column with group of each row: one fit per group.",
+      UI_GROUP_FIT,
+      &p->fitgroup,
+      GAL_TYPE_STRING,
+      GAL_OPTIONS_RANGE_ANY,
+      GAL_OPTIONS_NOT_MANDATORY,
+      GAL_OPTIONS_NOT_SET
+    },
     {
       "fitestimate",
       UI_KEY_FITESTIMATE,
@@ -38,6 +38,9 @@ main (int argc, char *argv[])
   struct timeval t1;
   struct statisticsparams p={{{0},0},0};
 
+  /* Run as a batch server if requested (only returns for each job). */
+  gal_options_batch(&argc, &argv);
+
   /* Set the starting time. */
   time(&p.rawtime);
   gettimeofday(&t1, NULL);
@@ -83,6 +83,7 @@ struct statisticsparams
   char     *fitestimatehdu;  /* HDU for values to estimate the fit.      */
   size_t       fitmaxpower;  /* Maximum power of polynomial fit.         */
   char      *fitrobustname;  /* Name of robust function.                 */
+  char           *fitgroup;  /* Column to group rows for separate fits.  */
 
   uint8_t        asciihist;  /* Print an ASCII histogram.                */
   uint8_t         asciicfp;  /* Print an ASCII cumulative frequency plot.*/
@@ -104,6 +105,7 @@ struct statisticsparams
   float       onebinstart2;  /* Shift bins to start at this value.       */
   uint8_t        maxbinone;  /* Set the maximum bin to 1.                */
   float         mirrordist;  /* Maximum distance after mirror for mode.  */
+  size_t          modebins;  /* Histogram bins for mode (0: exact mode). */
 
   char         *kernelname;  /* File name of kernel to convolve input.   */
   char               *khdu;  /* Kernel HDU.                              */
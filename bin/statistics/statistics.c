@@ -76,6 +76,20 @@ statistics_pull_out_element(gal_data_t *input, size_t index)
 
 
 
+/* The mode is found from a histogram when '--modebins' is given. */
+static gal_data_t *
+statistics_mode(struct statisticsparams *p, gal_data_t *input,
+                float mirrordist, int inplace)
+{
+  return ( p->modebins
+           ? gal_statistics_mode_hist(input, mirrordist, p->modebins)
+           : gal_statistics_mode(input, mirrordist, inplace) );
+}
+
+
+
+
+
 static double
 statistics_read_check_args(struct statisticsparams *p)
 {
@@ -134,7 +148,10 @@ statistics_print_one_row(struct statisticsparams *p)
       case UI_KEY_MODESYMVALUE:
         modearr = ( modearr
                     ? modearr
-                    : gal_statistics_mode(p->sorted, p->mirrordist, 0) );
+                    : statistics_mode(p, ( p->modebins
+                                           ? p->input
+                                           : p->sorted ),
+                                      p->mirrordist, 0) );
         d=modearr->array;
         if(d[2]<GAL_STATISTICS_MODE_GOOD_SYM) d[0]=d[1]=NAN;
         break;
@@ -426,7 +443,7 @@ statistics_on_tile(struct statisticsparams *p)
                 case UI_KEY_MODEQUANT:    mind=1;  break;
                 case UI_KEY_MODESYMVALUE: mind=3;  break;
                 }
-              tmp=gal_statistics_mode(tile, p->mirrordist, 1);
+              tmp=statistics_mode(p, tile, p->mirrordist, 1);
               ttmp=statistics_pull_out_element(tmp, mind);
               gal_data_free(tmp);
               tmp=ttmp;
@@ -1043,7 +1060,7 @@ print_basics(struct statisticsparams *p)
      to be found in place to save time/memory. But having a sorted array
      can decrease the floating point accuracy of the standard deviation. So
      we'll do the median calculation in the end.*/
-  tmp=gal_statistics_mode(p->input, mirrdist, 1);
+  tmp=statistics_mode(p, p->input, mirrdist, 1);
   d=tmp->array;
   if(d[2]>GAL_STATISTICS_MODE_GOOD_SYM)
     {        /* Same format as 'gal_data_write_to_string' */
@@ -1718,6 +1735,91 @@ statistics_fit_polynomial(struct statisticsparams *p)
 
 
 
+/* Separate fits for every group of rows. The group column is the last
+   input column (see 'ui_read_columns'). */
+static void
+statistics_fit_groups(struct statisticsparams *p)
+{
+  gal_list_str_t *cn;
+  gal_data_t *fit, *group, *w=NULL;
+  struct gal_fits_list_key_t *keys=NULL;
+  gal_data_t *x=p->input, *y=x->next;
+  size_t neededcols, ncols=gal_list_data_number(p->input)-1;
+
+  /* Make sure the number of columns is correct. */
+  switch(p->fitid)
+    {
+    case GAL_FIT_LINEAR_WEIGHTED:
+    case GAL_FIT_POLYNOMIAL_WEIGHTED:
+    case GAL_FIT_LINEAR_NO_CONSTANT_WEIGHTED: neededcols=3; break;
+    default:                                  neededcols=2;
+    }
+  if(ncols!=neededcols)
+    error(EXIT_FAILURE, 0, "'%s' fitting requires %zu columns as input "
+          "(in addition to the '--fitgroup' column), but %zu columns "
+          "have been given", p->fitname, neededcols, ncols);
+  if(neededcols==3) w=y->next;
+  group=gal_list_data_last(p->input);
+
+  /* Do the fits. */
+  fit=gal_fit_1d_groups(x, y, w, group, p->fitid, p->fitmaxpower,
+                        p->fitrobustid, p->cp.numthreads);
+
+  /* Basic information of the fits. */
+  cn=p->columns;
+  gal_fits_key_list_title_add(&keys, "Fit settings", 0);
+  gal_fits_key_list_add(&keys, GAL_TYPE_STRING, "FITTYPE", 0,
+                        gal_fit_name_from_id(p->fitid), 0,
+                        "Functional form of the fitting.", 0, NULL, 0);
+  if( p->fitid==GAL_FIT_POLYNOMIAL
+      || p->fitid==GAL_FIT_POLYNOMIAL_ROBUST
+      || p->fitid==GAL_FIT_POLYNOMIAL_WEIGHTED )
+    gal_fits_key_list_add(&keys, GAL_TYPE_SIZE_T, "FITMAXP", 0,
+                          &p->fitmaxpower, 0,
+                          "Maximum power of polynomial.", 0, NULL, 0);
+  if(p->fitid==GAL_FIT_POLYNOMIAL_ROBUST)
+    gal_fits_key_list_add(&keys, GAL_TYPE_STRING, "FITROBST", 0,
+                          p->fitrobustname, 0,
+                          "Robust fitting (rejecting outliers) function.",
+                          0, NULL, 0);
+  gal_fits_key_list_add(&keys, GAL_TYPE_STRING, "FITIN", 0,
+                        p->inputname, 0,"Name of file with input columns.",
+                        0, NULL, 0);
+  gal_fits_key_list_add(&keys, GAL_TYPE_STRING, "FITXCOL", 0, cn->v, 0,
+                        "Name or Number of independent (X) column.", 0,
+                        NULL, 0);
+  gal_fits_key_list_add(&keys, GAL_TYPE_STRING, "FITYCOL", 0,
+                        cn->next->v, 0, "Name or Number of measured (Y) "
+                        "column.", 0, NULL, 0);
+  if(w)
+    {
+      gal_fits_key_list_add(&keys, GAL_TYPE_STRING, "FITWCOL", 0,
+                            cn->next->next->v, 0,
+                            "Name or Number of weight column.", 0, NULL, 0);
+      gal_fits_key_list_add(&keys, GAL_TYPE_STRING, "FITWNAT", 0,
+                            statistics_fit_whtnat(p), 0,
+                            "Nature of weight column.", 0, NULL, 0);
+    }
+  gal_fits_key_list_add(&keys, GAL_TYPE_STRING, "FITGCOL", 0,
+                        p->fitgroup, 0, "Name or Number of group column.",
+                        0, NULL, 0);
+  gal_fits_key_list_reverse(&keys);
+
+  /* Write the table of fits (one row per group). */
+  if(p->cp.quiet==0 && p->cp.output)
+    printf("%s: %zu groups fitted, written to %s\n", PROGRAM_NAME,
+           fit->size, p->cp.output);
+  gal_table_write(fit, &keys, NULL, p->cp.tableformat, p->cp.output,
+                  "FIT_GROUPS", 0);
+
+  /* Clean up. */
+  gal_list_data_free(fit);
+}
+
+
+
+
+
 static void
 statistics_fit(struct statisticsparams *p)
 {
@@ -1728,6 +1830,9 @@ statistics_fit(struct statisticsparams *p)
     error(EXIT_FAILURE, 0, "at least two columns are necessary for "
           "the fitting operations");
 
+  /* Separate fits for every group. */
+  if(p->fitgroup) { statistics_fit_groups(p); return; }
+
   /* Do the fitting. */
   switch(p->fitid)
     {
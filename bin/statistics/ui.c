@@ -505,6 +505,13 @@ ui_read_check_only_options(struct statisticsparams *p)
       }
 
 
+  /* The histogram for the mode needs at least two bins (zero is for the
+     exact mode). */
+  if(p->modebins==1)
+    error(EXIT_FAILURE, 0, "'--modebins' must be larger than 1 (or 0 "
+          "for the exact mode from the sorted dataset)");
+
+
   /* If less than and greater than are both given, make sure that the value
      to greater than is smaller than the value to less-than. */
   if( !isnan(p->lessthan) && !isnan(p->greaterequal)
@@ -593,7 +600,15 @@ ui_read_check_only_options(struct statisticsparams *p)
                       p->fitrobustname);
             }
         }
+
+      /* Estimation is done on a single fit. */
+      if(p->fitgroup && p->fitestimate)
+        error(EXIT_FAILURE, 0, "'--fitestimate' cannot be called with "
+              "'--fitgroup' (there is one fit for every group)");
     }
+  else if(p->fitgroup)
+    error(EXIT_FAILURE, 0, "'--fitgroup' is only relevant in the fitting "
+          "mode (when '--fit' is called)");
 
   /* Reverse the list of statistics to print in one row and also the
      arguments, so it has the same order the user wanted. */
@@ -795,7 +810,10 @@ ui_make_sorted_if_necessary(struct statisticsparams *p)
   for(tmp=p->singlevalue; tmp!=NULL; tmp=tmp->next)
     switch(tmp->v)
       {
+      /* The histogram-based mode doesn't need a sorted array. */
       case UI_KEY_MODE:
+        if(p->modebins==0) is_necessary=1;
+        break;
       case UI_KEY_MEDIAN:
       case UI_KEY_QUANTILE:
       case UI_KEY_QUANTFUNC:
@@ -895,6 +913,15 @@ ui_read_columns(struct statisticsparams *p)
      coma) into one list. */
   ui_read_columns_in_one(p);
 
+  /* The group column of the fits is read as the last column (so the rows
+     with a blank value in any column are removed together). */
+  if(p->fitgroup)
+    {
+      gal_list_str_reverse(&p->columns);
+      gal_list_str_add(&p->columns, p->fitgroup, 1);
+      gal_list_str_reverse(&p->columns);
+    }
+
   /* If any columns are specified, and fitting hasn't been requested, make
      sure there is a maximum of two columns.  */
   if(p->fitname==NULL && gal_list_str_number(p->columns)>2)
@@ -1076,7 +1103,7 @@ ui_preparations_fit_weight(struct statisticsparams *p)
     case GAL_FIT_LINEAR_NO_CONSTANT_WEIGHTED:
 
       /* Basic sanity check first. */
-      if( gal_list_data_number(p->input)<3)
+      if( gal_list_data_number(p->input) < 3 + (p->fitgroup!=NULL) )
         error(EXIT_FAILURE, 0, "no weight column specified! A "
               "weight-based fit needs a third input column");
       if(p->fitweight==0)
@@ -99,6 +99,7 @@ enum option_keys_enum
   UI_KEY_MAXBINONE,
   UI_KEY_KHDU,
   UI_KEY_MIRRORDIST,
+  UI_KEY_MODEBINS,
   UI_KEY_MEANMEDQDIFF,
   UI_KEY_OUTLIERSIGMA,
   UI_KEY_OUTLIERSCLIP,
@@ -118,6 +119,7 @@ enum option_keys_enum
   UI_KEY_FITESTIMATEHDU,
   UI_KEY_FITESTIMATECOL,
   UI_KEY_FITROBUST,
+  UI_KEY_FITGROUP,
 };
 
 
@@ -22,6 +22,7 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 **********************************************************************/
 #include <config.h>
 
+#include <math.h>
 #include <stdio.h>
 #include <errno.h>
 #include <error.h>
@@ -30,6 +31,7 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 
 #include <gnuastro/wcs.h>
 #include <gnuastro/type.h>
+#include <gnuastro/threads.h>
 #include <gnuastro/pointer.h>
 #include <gnuastro/statistics.h>
 
@@ -924,6 +926,409 @@ arithmetic_sortedtointerval(struct tableparams *p, gal_data_t **stack,
 
 
 
+/*********************************************************************/
+/********************    Fused column arithmetic  ********************/
+/*********************************************************************/
+/* When all the operators of a column arithmetic expression are simple
+   element-wise operators on floating point columns, there is no need to
+   call 'gal_arithmetic' for each operator (which will allocate a new
+   column for every step and parse all the rows for every operator).
+   Instead, the expression is "compiled" into a list of steps, and the
+   full expression is evaluated over blocks of rows (that fit into the
+   CPU cache) on multiple threads. Within each block, all the values are
+   kept in double precision, but after any step whose output type (as
+   defined by 'gal_arithmetic') is 32-bit floating point, the values are
+   rounded to single precision. So the output is identical to calling
+   'gal_arithmetic' for each operator. */
+#define ARITHMETIC_FUSED_CHUNK    4096
+#define ARITHMETIC_FUSED_MAXDEPTH 100
+
+struct arithmetic_fused_step
+{
+  int          operator;  /* Operator code (OP_INVALID: operand).        */
+  uint8_t          type;  /* Output type of this step.                   */
+  size_t         numops;  /* OPERATOR: number of operands.               */
+  void           *array;  /* OPERAND: array of column (NULL: constant).  */
+  double       constant;  /* OPERAND: value of constant.                 */
+};
+
+struct arithmetic_fused_params
+{
+  size_t         nsteps;  /* Number of steps in the expression.          */
+  size_t       maxdepth;  /* Maximum depth of the stack.                 */
+  gal_data_t       *out;  /* Output column.                              */
+  struct arithmetic_fused_step *steps; /* Steps of the expression.       */
+};
+
+
+
+
+
+/* Output type of the operators that can be fused (following the rules of
+   'gal_arithmetic'). If the operator can't be fused, or its output isn't
+   a floating point type, 'GAL_TYPE_INVALID' is returned. */
+static uint8_t
+arithmetic_fused_type(int operator, uint8_t t1, uint8_t t2)
+{
+  uint8_t otype;
+
+  switch(operator)
+    {
+    /* Binary arithmetic operators. */
+    case GAL_ARITHMETIC_OP_PLUS:
+    case GAL_ARITHMETIC_OP_MINUS:
+    case GAL_ARITHMETIC_OP_MULTIPLY:
+    case GAL_ARITHMETIC_OP_DIVIDE:
+      otype=gal_type_out(t1, t2);
+      break;
+
+    /* Binary functions: integer inputs are converted to 64-bit floating
+       point before the operation. */
+    case GAL_ARITHMETIC_OP_POW:
+      otype=gal_type_out( ( t1==GAL_TYPE_FLOAT32 || t1==GAL_TYPE_FLOAT64
+                            ? t1 : GAL_TYPE_FLOAT64 ),
+                          ( t2==GAL_TYPE_FLOAT32 || t2==GAL_TYPE_FLOAT64
+                            ? t2 : GAL_TYPE_FLOAT64 ) );
+      break;
+
+    /* Unary functions. */
+    case GAL_ARITHMETIC_OP_SQRT:
+    case GAL_ARITHMETIC_OP_LOG:
+    case GAL_ARITHMETIC_OP_LOG10:
+    case GAL_ARITHMETIC_OP_SIN:
+    case GAL_ARITHMETIC_OP_COS:
+    case GAL_ARITHMETIC_OP_TAN:
+    case GAL_ARITHMETIC_OP_ASIN:
+    case GAL_ARITHMETIC_OP_ACOS:
+    case GAL_ARITHMETIC_OP_ATAN:
+      otype = t1==GAL_TYPE_FLOAT64 ? GAL_TYPE_FLOAT64 : GAL_TYPE_FLOAT32;
+      break;
+
+    /* The absolute value doesn't change the type. */
+    case GAL_ARITHMETIC_OP_ABS:
+      otype=t1;
+      break;
+
+    /* Not a fusable operator. */
+    default: return GAL_TYPE_INVALID;
+    }
+
+  /* Only floating point outputs can be fused. */
+  return ( otype==GAL_TYPE_FLOAT32 || otype==GAL_TYPE_FLOAT64
+           ? otype : GAL_TYPE_INVALID );
+}
+
+
+
+
+
+/* Convert the tokens of the column arithmetic into a list of steps that
+   can be evaluated in a fused way. If any of the tokens can't be fused,
+   return NULL. */
+static struct arithmetic_fused_step *
+arithmetic_fused_compile(struct tableparams *p,
+                         struct arithmetic_token *tokens,
+                         size_t *nsteps, size_t *maxdepth, size_t *size)
+{
+  gal_data_t *col, *tmp;
+  struct arithmetic_token *token;
+  struct arithmetic_fused_step *steps, *st;
+  uint8_t stack[ARITHMETIC_FUSED_MAXDEPTH];
+  size_t i=0, depth=0, numcols=0, numops=0;
+
+  /* Count the number of tokens and allocate the steps. */
+  for(token=tokens; token!=NULL; token=token->next) ++i;
+  *nsteps=i;
+  errno=0;
+  steps=calloc(i, sizeof *steps);
+  if(steps==NULL)
+    error(EXIT_FAILURE, errno, "%s: couldn't allocate %zu bytes for "
+          "'steps'", __func__, i*sizeof *steps);
+
+  /* Parse the tokens. The types of the elements in the stack are kept in
+     'stack' to find the output type of each step. */
+  *size=0;
+  *maxdepth=0;
+  for(token=tokens, st=steps; token!=NULL; token=token->next, ++st)
+    {
+      /* An operator. */
+      if(token->operator!=GAL_ARITHMETIC_OP_INVALID)
+        {
+          /* Only library operators with one or two operands can be
+             fused (and the stack should have enough operands). */
+          if( token->inlib==0
+              || token->num_operands<1 || token->num_operands>2
+              || depth<token->num_operands )
+            { free(steps); return NULL; }
+
+          /* Set the output type. */
+          st->operator=token->operator;
+          st->numops=token->num_operands;
+          st->type=arithmetic_fused_type(token->operator,
+                                         ( token->num_operands==1
+                                           ? stack[depth-1]
+                                           : stack[depth-2] ),
+                                         stack[depth-1]);
+          if(st->type==GAL_TYPE_INVALID) { free(steps); return NULL; }
+
+          /* Update the stack. */
+          depth -= token->num_operands - 1;
+          stack[depth-1]=st->type;
+          ++numops;
+        }
+
+      /* A constant. */
+      else if(token->constant)
+        {
+          if(token->constant->type==GAL_TYPE_STRING)
+            { free(steps); return NULL; }
+          tmp=gal_data_copy_to_new_type(token->constant, GAL_TYPE_FLOAT64);
+          st->constant=*(double *)(tmp->array);
+          st->operator=GAL_ARITHMETIC_OP_INVALID;
+          st->type=token->constant->type;
+          gal_data_free(tmp);
+        }
+
+      /* A column from the table. */
+      else if(token->index!=GAL_BLANK_SIZE_T)
+        {
+          col=p->colarray[token->index];
+          if( col->ndim!=1
+              || (numcols && col->size!=*size)
+              || ( col->type!=GAL_TYPE_FLOAT32
+                   && col->type!=GAL_TYPE_FLOAT64 ) )
+            { free(steps); return NULL; }
+          st->operator=GAL_ARITHMETIC_OP_INVALID;
+          st->array=col->array;
+          st->type=col->type;
+          *size=col->size;
+          ++numcols;
+        }
+
+      /* Any other token (for example names, or columns from other
+         files) can't be fused. */
+      else { free(steps); return NULL; }
+
+      /* Put the type of the operand on the stack. */
+      if(st->operator==GAL_ARITHMETIC_OP_INVALID)
+        {
+          if(depth==ARITHMETIC_FUSED_MAXDEPTH) { free(steps); return NULL; }
+          stack[depth++]=st->type;
+        }
+      if(depth>*maxdepth) *maxdepth=depth;
+    }
+
+  /* The expression should produce a single non-empty column (which
+     involves at least one operator). */
+  if(depth!=1 || numcols==0 || numops==0 || *size==0)
+    { free(steps); return NULL; }
+
+  /* Return the steps. */
+  return steps;
+}
+
+
+
+
+
+/* Evaluate the fused expression over the blocks of rows that are
+   assigned to this thread. */
+#define ARITHMETIC_FUSED_BINARY(OP) {                                   \
+    a=reg+(d-2)*ARITHMETIC_FUSED_CHUNK;                                 \
+    b=reg+(d-1)*ARITHMETIC_FUSED_CHUNK;                                 \
+    for(j=0;j<n;++j) a[j] = OP;                                         \
+  }
+
+#define ARITHMETIC_FUSED_UNARY(OP) {                                    \
+    a=reg+(d-1)*ARITHMETIC_FUSED_CHUNK;                                 \
+    for(j=0;j<n;++j) a[j] = OP;                                         \
+  }
+
+static void *
+arithmetic_fused_worker(void *in_prm)
+{
+  struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
+  struct arithmetic_fused_params *fp=
+    (struct arithmetic_fused_params *)tprm->params;
+
+  float *f;
+  double *a, *b, *reg;
+  size_t i, j, n, s, d, start;
+  struct arithmetic_fused_step *st;
+
+  /* Allocate the "registers" (one block of rows for each element of the
+     stack). */
+  reg=gal_pointer_allocate(GAL_TYPE_FLOAT64,
+                           fp->maxdepth*ARITHMETIC_FUSED_CHUNK, 0,
+                           __func__, "reg");
+
+  /* Go over all the blocks that were assigned to this thread. */
+  for(i=0; tprm->indexs[i] != GAL_BLANK_SIZE_T; ++i)
+    {
+      /* Range of rows in this block. */
+      start=tprm->indexs[i]*ARITHMETIC_FUSED_CHUNK;
+      n = ( start+ARITHMETIC_FUSED_CHUNK > fp->out->size
+            ? fp->out->size-start : ARITHMETIC_FUSED_CHUNK );
+
+      /* Go over the steps of the expression. */
+      for(d=s=0; s<fp->nsteps; ++s)
+        {
+          st=&fp->steps[s];
+          switch(st->operator)
+            {
+            /* Put an operand on the stack. */
+            case GAL_ARITHMETIC_OP_INVALID:
+              a=reg+(d++)*ARITHMETIC_FUSED_CHUNK;
+              if(st->array==NULL)
+                for(j=0;j<n;++j) a[j]=st->constant;
+              else if(st->type==GAL_TYPE_FLOAT32)
+                {
+                  f=(float *)(st->array)+start;
+                  for(j=0;j<n;++j) a[j]=f[j];
+                }
+              else
+                memcpy(a, (double *)(st->array)+start, n*sizeof *a);
+              continue;
+
+            /* Operators. */
+            case GAL_ARITHMETIC_OP_PLUS:
+              ARITHMETIC_FUSED_BINARY( a[j] + b[j] );             break;
+            case GAL_ARITHMETIC_OP_MINUS:
+              ARITHMETIC_FUSED_BINARY( a[j] - b[j] );             break;
+            case GAL_ARITHMETIC_OP_MULTIPLY:
+              ARITHMETIC_FUSED_BINARY( a[j] * b[j] );             break;
+            case GAL_ARITHMETIC_OP_DIVIDE:
+              ARITHMETIC_FUSED_BINARY( a[j] / b[j] );             break;
+            case GAL_ARITHMETIC_OP_POW:
+              ARITHMETIC_FUSED_BINARY( pow(a[j], b[j]) );         break;
+            case GAL_ARITHMETIC_OP_SQRT:
+              ARITHMETIC_FUSED_UNARY( sqrt(a[j]) );               break;
+            case GAL_ARITHMETIC_OP_LOG:
+              ARITHMETIC_FUSED_UNARY( log(a[j]) );                break;
+            case GAL_ARITHMETIC_OP_LOG10:
+              ARITHMETIC_FUSED_UNARY( log10(a[j]) );              break;
+            case GAL_ARITHMETIC_OP_SIN:
+              ARITHMETIC_FUSED_UNARY( sin(a[j]*M_PI/180.0f) );    break;
+            case GAL_ARITHMETIC_OP_COS:
+              ARITHMETIC_FUSED_UNARY( cos(a[j]*M_PI/180.0f) );    break;
+            case GAL_ARITHMETIC_OP_TAN:
+              ARITHMETIC_FUSED_UNARY( tan(a[j]*M_PI/180.0f) );    break;
+            case GAL_ARITHMETIC_OP_ASIN:
+              ARITHMETIC_FUSED_UNARY( asin(a[j])*180.0f/M_PI );   break;
+            case GAL_ARITHMETIC_OP_ACOS:
+              ARITHMETIC_FUSED_UNARY( acos(a[j])*180.0f/M_PI );   break;
+            case GAL_ARITHMETIC_OP_ATAN:
+              ARITHMETIC_FUSED_UNARY( atan(a[j])*180.0f/M_PI );   break;
+            case GAL_ARITHMETIC_OP_ABS:
+              ARITHMETIC_FUSED_UNARY( fabs(a[j]) );               break;
+            default:
+              error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at %s "
+                    "to fix the problem. The operator code %d is not "
+                    "recognized", __func__, PACKAGE_BUGREPORT,
+                    st->operator);
+            }
+
+          /* The output of the operator replaces its operands on the
+             stack. If the output of this operator is single precision in
+             'gal_arithmetic', round the values. */
+          d -= st->numops-1;
+          if(st->type==GAL_TYPE_FLOAT32)
+            {
+              a=reg+(d-1)*ARITHMETIC_FUSED_CHUNK;
+              for(j=0;j<n;++j) a[j]=(float)(a[j]);
+            }
+        }
+
+      /* Write the result into the output. */
+      if(fp->out->type==GAL_TYPE_FLOAT32)
+        {
+          f=(float *)(fp->out->array)+start;
+          for(j=0;j<n;++j) f[j]=reg[j];
+        }
+      else
+        memcpy((double *)(fp->out->array)+start, reg, n*sizeof *reg);
+    }
+
+  /* Clean up, wait for all the other threads to finish, then return. */
+  free(reg);
+  if(tprm->b) pthread_barrier_wait(tprm->b);
+  return NULL;
+}
+
+
+
+
+
+/* If the expression of this column can be fused, evaluate it and put the
+   output in the output table. If it can't be fused, return 0 (so the
+   operators are called one by one). */
+static int
+arithmetic_fused(struct tableparams *p, struct column_pack *outpack)
+{
+  size_t size;
+  struct arithmetic_token *token;
+  struct arithmetic_fused_params fp;
+
+  /* See if the expression can be fused. */
+  fp.steps=arithmetic_fused_compile(p, outpack->arith, &fp.nsteps,
+                                    &fp.maxdepth, &size);
+  if(fp.steps==NULL) return 0;
+
+  /* Allocate the output column and do the evaluation on multiple threads
+     (each action is one block of rows). */
+  fp.out=gal_data_alloc(NULL, fp.steps[fp.nsteps-1].type, 1, &size, NULL,
+                        0, p->cp.minmapsize, p->cp.quietmmap, NULL, NULL,
+                        NULL);
+  gal_threads_spin_off(arithmetic_fused_worker, &fp,
+                       size/ARITHMETIC_FUSED_CHUNK
+                       + (size%ARITHMETIC_FUSED_CHUNK ? 1 : 0),
+                       p->cp.numthreads, p->cp.minmapsize,
+                       p->cp.quietmmap);
+
+  /* Set the metadata (like 'arithmetic_operator_run', the placeholder
+     name is set once for every operator, so the names of the next columns
+     don't change) and free the inputs. */
+  for(token=outpack->arith; token!=NULL; token=token->next)
+    if(token->operator!=GAL_ARITHMETIC_OP_INVALID)
+      arithmetic_placeholder_name(fp.out);
+    else if(token->constant)
+      {
+        gal_data_free(token->constant);
+        token->constant=NULL;
+      }
+    else
+      {
+        gal_data_free(p->colarray[token->index]);
+        p->colarray[token->index]=NULL;
+      }
+
+  /* Add the output to the final table. */
+  gal_list_data_add(&p->table, fp.out);
+
+  /* Clean up and return. */
+  free(fp.steps);
+  return 1;
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
 /*********************************************************************/
 /********************          Operations        *********************/
 /*********************************************************************/
@@ -1060,7 +1465,8 @@ arithmetic_read_at_usage(struct tableparams *p,
     {
       /* Search all the existing columns in the table. */
       for(i=0; i<p->numcolarray; ++i)
-        if( p->colarray[i]->name
+        if( p->colarray[i]
+            && p->colarray[i]->name
             && strcasecmp(p->colarray[i]->name, token->id_at_usage)==0 )
           return p->colarray[i];
 
@@ -1112,6 +1518,10 @@ arithmetic_reverse_polish(struct tableparams *p,
   gal_data_t *single, *stack=NULL;
   struct gal_arithmetic_set_params setprm={0};
 
+  /* If the expression can be evaluated in a fused manner, there is no
+     need to continue. */
+  if( arithmetic_fused(p, outpack) ) return;
+
   /* Initialize the arithmetic functions/pointers. */
   setprm.params=&stack;
   setprm.tokens=outpack->arith;
@@ -39,6 +39,9 @@ main (int argc, char *argv[])
 {
   struct tableparams p={{{0},0},0};
 
+  /* Run as a batch server if requested (only returns for each job). */
+  gal_options_batch(&argc, &argv);
+
   /* Set they starting time. */
   time(&p.rawtime);
 
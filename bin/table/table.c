@@ -226,74 +226,29 @@ table_selection_range(struct tableparams *p, gal_data_t *col)
 
 
 
-/* Read column value of any type as a double for the polygon options. */
-static double
-selection_polygon_read_point(gal_data_t *col, size_t i)
-{
-  /* Check and assign the points to the points array. */
-  switch(col->type)
-    {
-    case GAL_TYPE_INT8:    return (( int8_t   *)col->array)[i];
-    case GAL_TYPE_UINT8:   return (( uint8_t  *)col->array)[i];
-    case GAL_TYPE_UINT16:  return (( uint16_t *)col->array)[i];
-    case GAL_TYPE_INT16:   return (( int16_t  *)col->array)[i];
-    case GAL_TYPE_UINT32:  return (( uint32_t *)col->array)[i];
-    case GAL_TYPE_INT32:   return (( int32_t  *)col->array)[i];
-    case GAL_TYPE_UINT64:  return (( uint64_t *)col->array)[i];
-    case GAL_TYPE_INT64:   return (( int64_t  *)col->array)[i];
-    case GAL_TYPE_FLOAT32: return (( float    *)col->array)[i];
-    case GAL_TYPE_FLOAT64: return (( double   *)col->array)[i];
-    default:
-      error(EXIT_FAILURE, 0, "%s: type code %d not recognized",
-            __func__, col->type);
-    }
-
-  /* Control should not reach here. */
-  error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at %s to fix the "
-        "problem. Control should not reach the end of this function",
-        __func__, PACKAGE_BUGREPORT);
-  return NAN;
-}
-
-
-
-
-
-/* Mask the rows that are not in the given polygon. */
+/* Mask the rows that are not in the given polygon. The polygon is first
+   prepared, so checking each point is fast (on average, independent of
+   the number of vertices) and the points are checked on multiple
+   threads. */
 static gal_data_t *
 table_selection_polygon(struct tableparams *p, gal_data_t *col1,
                         gal_data_t *col2, int in1out0)
 {
-  uint8_t *oarr;
-  double point[2];
-  gal_data_t *out=NULL;
-  size_t i, psize=p->polygon->size/2;
-
-  /* Allocate the output array: This array will have a '0' for the points
-     which are inside the polygon and '1' for those that are outside of it
-     (to be masked/removed from the input). */
-  out=gal_data_alloc(NULL, GAL_TYPE_UINT8, 1, col1->dsize, NULL, 0, -1, 1,
-                     NULL, NULL, NULL);
-  oarr=out->array;
+  uint8_t *o, *of;
+  gal_data_t *out;
+  gal_polygon_prepared_t *pp;
 
-  /* Loop through all the rows in the given columns and check the points.*/
-  for(i=0; i<col1->size; i++)
-    {
-      /* Read the column values as a double. */
-      point[0]=selection_polygon_read_point(col1, i);
-      point[1]=selection_polygon_read_point(col2, i);
-
-      /* For '--inpolygon', if point is inside polygon, put 0, otherwise
-         1. Note that we are building a mask for the rows that must be
-         discarded, so we want '1' for the points we don't want. */
-      oarr[i] = (in1out0
-                 ? !gal_polygon_is_inside(p->polygon->array, point, psize)
-                 :  gal_polygon_is_inside(p->polygon->array, point, psize));
-
-      /* For a check
-      printf("(%f,%f): %s, %u\n", point[0], point[1], oarr[i]);
-      */
-    }
+  /* Find the points inside the polygon. */
+  pp=gal_polygon_prepare(p->polygon->array, p->polygon->size/2, 0);
+  out=gal_polygon_prepared_is_inside_points(pp, col1, col2,
+                                            p->cp.numthreads);
+  gal_polygon_prepared_free(pp);
+
+  /* The output should have a '0' for the points which should be kept and
+     '1' for those that should be masked/removed from the input. So for
+     '--inpolygon', the points inside the polygon should become 0. */
+  if(in1out0 && out->size)
+    { of=(o=out->array)+out->size; do *o=!*o; while(++o<of); }
 
   /* Return the output column. */
   return out;
@@ -579,7 +534,6 @@ table_sort(struct tableparams *p)
 {
   gal_data_t *perm;
   size_t c=0, *s, *sf, dsize0=p->table->dsize[0];
-  int (*qsortfn)(const void *, const void *)=NULL;
 
   /* In case there are no columns to sort, skip this function. */
   if(p->table->size==0 || p->table->array==NULL || p->table->dsize==NULL)
@@ -607,47 +561,10 @@ table_sort(struct tableparams *p)
           "section of the book/manual):\n\n"
           "    $ info gnuastro \"gnuastro text table format\"");
 
-  /* Set the proper qsort function. */
-  if(p->descending)
-    switch(p->sortcol->type)
-      {
-      case GAL_TYPE_UINT8:   qsortfn=gal_qsort_index_single_uint8_d;   break;
-      case GAL_TYPE_INT8:    qsortfn=gal_qsort_index_single_int8_d;    break;
-      case GAL_TYPE_UINT16:  qsortfn=gal_qsort_index_single_uint16_d;  break;
-      case GAL_TYPE_INT16:   qsortfn=gal_qsort_index_single_int16_d;   break;
-      case GAL_TYPE_UINT32:  qsortfn=gal_qsort_index_single_uint32_d;  break;
-      case GAL_TYPE_INT32:   qsortfn=gal_qsort_index_single_int32_d;   break;
-      case GAL_TYPE_UINT64:  qsortfn=gal_qsort_index_single_uint64_d;  break;
-      case GAL_TYPE_INT64:   qsortfn=gal_qsort_index_single_int64_d;   break;
-      case GAL_TYPE_FLOAT32: qsortfn=gal_qsort_index_single_float32_d; break;
-      case GAL_TYPE_FLOAT64: qsortfn=gal_qsort_index_single_float64_d; break;
-      default:
-        error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at %s to fix "
-              "the problem. The code '%u' wasn't recognized as a data type",
-              __func__, PACKAGE_BUGREPORT, p->sortcol->type);
-      }
-  else
-    switch(p->sortcol->type)
-      {
-      case GAL_TYPE_UINT8:   qsortfn=gal_qsort_index_single_uint8_i;   break;
-      case GAL_TYPE_INT8:    qsortfn=gal_qsort_index_single_int8_i;    break;
-      case GAL_TYPE_UINT16:  qsortfn=gal_qsort_index_single_uint16_i;  break;
-      case GAL_TYPE_INT16:   qsortfn=gal_qsort_index_single_int16_i;   break;
-      case GAL_TYPE_UINT32:  qsortfn=gal_qsort_index_single_uint32_i;  break;
-      case GAL_TYPE_INT32:   qsortfn=gal_qsort_index_single_int32_i;   break;
-      case GAL_TYPE_UINT64:  qsortfn=gal_qsort_index_single_uint64_i;  break;
-      case GAL_TYPE_INT64:   qsortfn=gal_qsort_index_single_int64_i;   break;
-      case GAL_TYPE_FLOAT32: qsortfn=gal_qsort_index_single_float32_i; break;
-      case GAL_TYPE_FLOAT64: qsortfn=gal_qsort_index_single_float64_i; break;
-      default:
-        error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at %s to fix "
-              "the problem. The code '%u' wasn't recognized as a data type",
-              __func__, PACKAGE_BUGREPORT, p->sortcol->type);
-      }
-
   /* Sort the indexs from the values. */
-  gal_qsort_index_single=p->sortcol->array;
-  qsort(perm->array, perm->size, sizeof *s, qsortfn);
+  gal_qsort_radix_index(p->sortcol->array, p->sortcol->type, perm->array,
+                        perm->size, p->descending, p->cp.numthreads,
+                        p->cp.minmapsize, p->cp.quietmmap);
 
   /* For a check (only on float32 type 'sortcol'):
   {
@@ -45,6 +45,7 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <gnuastro/units.h>
 #include <gnuastro/qsort.h>
 #include <gnuastro/pointer.h>
+#include <gnuastro/cosmology.h>
 #include <gnuastro/threads.h>
 #include <gnuastro/dimension.h>
 #include <gnuastro/statistics.h>
@@ -378,15 +379,6 @@ arithmetic_abs(int flags, gal_data_t *in)
 
 
 
-/* Wrapper functions for RA/Dec strings. */
-static char *
-arithmetic_units_degree_to_ra(double decimal)
-{ return gal_units_degree_to_ra(decimal, 0); }
-
-static char *
-arithmetic_units_degree_to_dec(double decimal)
-{ return gal_units_degree_to_dec(decimal, 0); }
-
 #define UNIFUNC_RUN_FUNCTION_ON_ELEMENT(OT, IT, OP, BEFORE, AFTER){     \
     OT *oa=o->array;                                                    \
     IT *ia=in->array, *iaf=ia + in->size;                               \
@@ -431,44 +423,6 @@ arithmetic_units_degree_to_dec(double decimal)
             "UNIARY_FUNCTION_ON_ELEMENT", in->type);                    \
     }
 
-#define UNIARY_FUNCTION_ON_ELEMENT_OUTPUT_STRING(OP)     \
-  switch(in->type)                                                      \
-    {                                                                   \
-    case GAL_TYPE_UINT8:                                                \
-      UNIFUNC_RUN_FUNCTION_ON_ELEMENT(char *, uint8_t,  OP, +0, +0)     \
-        break;                                                          \
-    case GAL_TYPE_INT8:                                                 \
-      UNIFUNC_RUN_FUNCTION_ON_ELEMENT(char *, int8_t,   OP, +0, +0)     \
-        break;                                                          \
-    case GAL_TYPE_UINT16:                                               \
-      UNIFUNC_RUN_FUNCTION_ON_ELEMENT(char *, uint16_t, OP, +0, +0)     \
-        break;                                                          \
-    case GAL_TYPE_INT16:                                                \
-      UNIFUNC_RUN_FUNCTION_ON_ELEMENT(char *, int16_t,  OP, +0, +0)     \
-        break;                                                          \
-    case GAL_TYPE_UINT32:                                               \
-      UNIFUNC_RUN_FUNCTION_ON_ELEMENT(char *, uint32_t, OP, +0, +0)     \
-        break;                                                          \
-    case GAL_TYPE_INT32:                                                \
-      UNIFUNC_RUN_FUNCTION_ON_ELEMENT(char *, int32_t,  OP, +0, +0)     \
-        break;                                                          \
-    case GAL_TYPE_UINT64:                                               \
-      UNIFUNC_RUN_FUNCTION_ON_ELEMENT(char *, uint64_t, OP, +0, +0)     \
-        break;                                                          \
-    case GAL_TYPE_INT64:                                                \
-      UNIFUNC_RUN_FUNCTION_ON_ELEMENT(char *, int64_t,  OP, +0, +0)     \
-        break;                                                          \
-    case GAL_TYPE_FLOAT32:                                              \
-      UNIFUNC_RUN_FUNCTION_ON_ELEMENT(char *, float,    OP, +0, +0)     \
-        break;                                                          \
-    case GAL_TYPE_FLOAT64:                                              \
-      UNIFUNC_RUN_FUNCTION_ON_ELEMENT(char *, double,   OP, +0, +0)     \
-        break;                                                          \
-    default:                                                            \
-      error(EXIT_FAILURE, 0, "%s: type code %d not recognized",         \
-            "UNIARY_FUNCTION_ON_ELEMENT_OUTPUT_STRING", in->type);      \
-    }
-
 #define UNIARY_FUNCTION_ON_ELEMENT(OP, BEFORE, AFTER)                   \
   switch(in->type)                                                      \
     {                                                                   \
@@ -507,41 +461,6 @@ arithmetic_units_degree_to_dec(double decimal)
             "UNIARY_FUNCTION_ON_ELEMENT", in->type);                    \
     }
 
-#define UNIFUNC_RUN_FUNCTION_ON_ELEMENT_SEXAGESIMAL(OT, OP){            \
-    OT *oa=o->array;                                                    \
-    char **ia, **iaf;                                                   \
-    /* If the input dataset isn't a string (it was parsed as a */       \
-    /* number, stop the program and let the user know what to do. */    \
-    /* This can happen with the Arithmetic program, for example if */   \
-    /* this command is called: 'astarithmetic 16 ra-to-deg'. */         \
-    if(in->type!=GAL_TYPE_STRING)                                       \
-      error(EXIT_FAILURE, 0, "%s: the input should be a string in "     \
-            "the format of %s (where the '_' are place-holders for "    \
-            "numbers). This error may happen when you are calling a "   \
-            "command like \"astarithmetic 16 %s\" or \"echo %s | "      \
-            "asttable -c'arith $1 %s'\". In such cases, please use "    \
-            "this command: "                                            \
-            "\"echo %s | asttable\" (by default, when a string type "   \
-            "isn't specified for a column, and it conforms to the "     \
-            "pattern above, 'asttable' does the conversion "            \
-            "internally; this is the cause of the second type of "      \
-            "error above). The '%s' operator is only relevant for "     \
-            "many sexagesimal values in a string-type table column",    \
-            gal_arithmetic_operator_string(operator),                   \
-            ( operator==GAL_ARITHMETIC_OP_RA_TO_DEGREE                  \
-              ? "'_h_m_s' or '_h_m_'"                                   \
-              : "'_d_m_s' or '_d_m_'" ),                                \
-            gal_arithmetic_operator_string(operator),                   \
-            ( operator==GAL_ARITHMETIC_OP_RA_TO_DEGREE                  \
-              ? "16h0m0" : "16d0m0" ),                                  \
-            gal_arithmetic_operator_string(operator),                   \
-            ( operator==GAL_ARITHMETIC_OP_RA_TO_DEGREE                  \
-              ? "16h0m0" : "16d0m0" ),                                  \
-            gal_arithmetic_operator_string(operator));                  \
-    iaf = (ia=in->array) + in->size;                                    \
-    do *oa++ = OP(*ia++); while(ia<iaf);                                \
-}
-
 static gal_data_t *
 arithmetic_function_unary(int operator, int flags, gal_data_t *in)
 {
@@ -558,11 +477,7 @@ arithmetic_function_unary(int operator, int flags, gal_data_t *in)
      is integer type and user requested inplace opereation, if its not a
      floating point type, it will not be in-place. */
   if( (flags & GAL_ARITHMETIC_FLAG_INPLACE)
-      && ( in->type==GAL_TYPE_FLOAT32 || in->type==GAL_TYPE_FLOAT64 )
-      && ( operator != GAL_ARITHMETIC_OP_RA_TO_DEGREE
-      &&   operator != GAL_ARITHMETIC_OP_DEC_TO_DEGREE
-      &&   operator != GAL_ARITHMETIC_OP_DEGREE_TO_RA
-      &&   operator != GAL_ARITHMETIC_OP_DEGREE_TO_DEC ) )
+      && ( in->type==GAL_TYPE_FLOAT32 || in->type==GAL_TYPE_FLOAT64 ) )
     inplace=1;
 
   /* Set the output pointer. */
@@ -573,17 +488,9 @@ arithmetic_function_unary(int operator, int flags, gal_data_t *in)
     }
   else
     {
-      /* Check for operators which have fixed output types */
-      if(         operator == GAL_ARITHMETIC_OP_RA_TO_DEGREE
-               || operator == GAL_ARITHMETIC_OP_DEC_TO_DEGREE )
-        otype = GAL_TYPE_FLOAT64;
-      else if(    operator == GAL_ARITHMETIC_OP_DEGREE_TO_RA
-               || operator == GAL_ARITHMETIC_OP_DEGREE_TO_DEC )
-        otype = GAL_TYPE_STRING;
-      else
-        otype = ( in->type==GAL_TYPE_FLOAT64
-                  ? GAL_TYPE_FLOAT64
-                  : GAL_TYPE_FLOAT32 );
+      otype = ( in->type==GAL_TYPE_FLOAT64
+                ? GAL_TYPE_FLOAT64
+                : GAL_TYPE_FLOAT32 );
 
       /* Set the final output type. */
       o = gal_data_alloc(NULL, otype, in->ndim, in->dsize, in->wcs,
@@ -641,18 +548,6 @@ arithmetic_function_unary(int operator, int flags, gal_data_t *in)
       UNIARY_FUNCTION_ON_ELEMENT( gal_units_ly_to_au, +0, +0); break;
     case GAL_ARITHMETIC_OP_AU_TO_LY:
       UNIARY_FUNCTION_ON_ELEMENT( gal_units_au_to_ly, +0, +0); break;
-    case GAL_ARITHMETIC_OP_RA_TO_DEGREE:
-      UNIFUNC_RUN_FUNCTION_ON_ELEMENT_SEXAGESIMAL(double, gal_units_ra_to_degree);
-      break;
-    case GAL_ARITHMETIC_OP_DEC_TO_DEGREE:
-      UNIFUNC_RUN_FUNCTION_ON_ELEMENT_SEXAGESIMAL(double, gal_units_dec_to_degree);
-      break;
-    case GAL_ARITHMETIC_OP_DEGREE_TO_RA:
-      UNIARY_FUNCTION_ON_ELEMENT_OUTPUT_STRING(arithmetic_units_degree_to_ra);
-      break;
-    case GAL_ARITHMETIC_OP_DEGREE_TO_DEC:
-      UNIARY_FUNCTION_ON_ELEMENT_OUTPUT_STRING(arithmetic_units_degree_to_dec);
-      break;
     default:
       error(EXIT_FAILURE, 0, "%s: operator code %d not recognized",
             __func__, operator);
@@ -677,6 +572,74 @@ arithmetic_function_unary(int operator, int flags, gal_data_t *in)
 
 
 
+/* Conversion between sexagesimal strings and degrees. These are done on
+   the full column (with multiple threads) in the 'units' library. */
+static gal_data_t *
+arithmetic_sexagesimal(int operator, int flags, gal_data_t *in,
+                       size_t numthreads)
+{
+  gal_data_t *out=NULL;
+
+  /* The dataset may be empty. In this case, the output should also be
+     empty (we can have tables and images with 0 rows or pixels!). */
+  if(in->size==0 || in->array==NULL) return in;
+
+  /* If the input dataset isn't a string (it was parsed as a number, stop
+     the program and let the user know what to do. This can happen with
+     the Arithmetic program, for example if this command is called:
+     'astarithmetic 16 ra-to-deg'. */
+  if( in->type!=GAL_TYPE_STRING
+      && (    operator==GAL_ARITHMETIC_OP_RA_TO_DEGREE
+           || operator==GAL_ARITHMETIC_OP_DEC_TO_DEGREE ) )
+    error(EXIT_FAILURE, 0, "%s: the input should be a string in "
+          "the format of %s (where the '_' are place-holders for "
+          "numbers). This error may happen when you are calling a "
+          "command like \"astarithmetic 16 %s\" or \"echo %s | "
+          "asttable -c'arith $1 %s'\". In such cases, please use "
+          "this command: "
+          "\"echo %s | asttable\" (by default, when a string type "
+          "isn't specified for a column, and it conforms to the "
+          "pattern above, 'asttable' does the conversion "
+          "internally; this is the cause of the second type of "
+          "error above). The '%s' operator is only relevant for "
+          "many sexagesimal values in a string-type table column",
+          gal_arithmetic_operator_string(operator),
+          ( operator==GAL_ARITHMETIC_OP_RA_TO_DEGREE
+            ? "'_h_m_s' or '_h_m_'"
+            : "'_d_m_s' or '_d_m_'" ),
+          gal_arithmetic_operator_string(operator),
+          ( operator==GAL_ARITHMETIC_OP_RA_TO_DEGREE
+            ? "16h0m0" : "16d0m0" ),
+          gal_arithmetic_operator_string(operator),
+          ( operator==GAL_ARITHMETIC_OP_RA_TO_DEGREE
+            ? "16h0m0" : "16d0m0" ),
+          gal_arithmetic_operator_string(operator));
+
+  /* Do the conversion. */
+  switch(operator)
+    {
+    case GAL_ARITHMETIC_OP_RA_TO_DEGREE:
+      out=gal_units_ra_to_degree_column(in, numthreads);       break;
+    case GAL_ARITHMETIC_OP_DEC_TO_DEGREE:
+      out=gal_units_dec_to_degree_column(in, numthreads);      break;
+    case GAL_ARITHMETIC_OP_DEGREE_TO_RA:
+      out=gal_units_degree_to_ra_column(in, 0, numthreads);    break;
+    case GAL_ARITHMETIC_OP_DEGREE_TO_DEC:
+      out=gal_units_degree_to_dec_column(in, 0, numthreads);   break;
+    default:
+      error(EXIT_FAILURE, 0, "%s: operator code %d not recognized",
+            __func__, operator);
+    }
+
+  /* Clean up and return. */
+  if(flags & GAL_ARITHMETIC_FLAG_FREE) gal_data_free(in);
+  return out;
+}
+
+
+
+
+
 /* Call functions in the 'gnuastro/statistics' library. */
 static gal_data_t *
 arithmetic_from_statistics(int operator, int flags, gal_data_t *input)
@@ -1424,74 +1387,176 @@ arithmetic_where(int flags, gal_data_t *out, gal_data_t *cond,
 /***********************************************************************/
 /***************        Multiple operand operators        **************/
 /***********************************************************************/
+/* The output of each thread is measured over blocks of neighboring pixels
+   (with 'blocksize' pixels). The values of the block's pixels from all
+   the inputs (that are read sequentially from each input) are kept in a
+   small scratch array that fits in the CPU's cache: for the operators
+   that need all the values of a pixel (like the median), the values of
+   each pixel are contiguous ('[pixel][input]'); for the other operators,
+   each pixel's statistic is accumulated over the block for one input
+   after another. */
+#define MULTIOPERAND_BLOCK_BYTES 262144
+#define MULTIOPERAND_BLOCK_MAX   4096
+
+/* Arrays with fewer elements than this are sorted with an insertion
+   sort. */
+#define MULTIOPERAND_SMALL_SORT  16
+
 struct multioperandparams
 {
   gal_data_t      *list;        /* List of input datasets.           */
   gal_data_t       *out;        /* Output dataset.                   */
+  gal_data_t   *clipnum;        /* Number remaining after clipping.  */
   size_t           dnum;        /* Number of input dataset.          */
   int          operator;        /* Operator to use.                  */
   uint8_t     *hasblank;        /* Array of 0s or 1s for each input. */
   float              p1;        /* Sigma-cliping parameter 1.        */
   float              p2;        /* Sigma-cliping parameter 2.        */
+  float        *weights;        /* Weight of each input (or NULL).   */
+  uint8_t       **masks;        /* Mask of each input (or NULL).     */
+  size_t      blocksize;        /* Number of pixels in each block.   */
 };
 
 
 
 
 
-#define MULTIOPERAND_MIN(TYPE) {                                        \
-    size_t n, j=0;                                                      \
-    TYPE t, max, *o=p->out->array;                                      \
-    gal_type_max(p->list->type, &max);                                  \
-                                                                        \
-    /* Go over all the pixels assigned to this thread. */               \
-    for(tind=0; tprm->indexs[tind] != GAL_BLANK_SIZE_T; ++tind)         \
+/* Set the range of pixels in this block ('start' and 'end') from the
+   block's index. */
+#define MULTIOPERAND_BLOCK_RANGE {                                      \
+    start=tprm->indexs[tind]*p->blocksize;                              \
+    end=start+p->blocksize;                                             \
+    if(end>p->out->size) end=p->out->size;                              \
+  }
+
+
+/* If the 'J'-th element of the 'I'-th input should be used: it is not
+   masked and is not blank (only integers and non-NaN floats: v==v is
+   1). */
+#define MULTIOPERAND_USE(I, J)                                          \
+  (    ( p->masks==NULL || p->masks[I]==NULL || p->masks[I][J]==0 )     \
+    && ( p->hasblank[I]==0                                              \
+         || ( b==b                                                      \
+              ? a[I][J]!=b                                /* Integer */ \
+              : a[I][J]==a[I][J] ) ) )                    /* Float   */
+
+
+/* Partition the elements 'LO' to 'HI' (inclusive) of 'X' around the
+   median of its first, middle and last elements: after it, the elements
+   until 'LJ' are smaller or equal to the pivot, those after 'LI' are
+   larger or equal to it and those in between are equal to it. */
+#define MULTIOPERAND_PARTITION(TYPE, X, LO, HI, LI, LJ) {               \
+    TYPE pv, sw;                                                        \
+    pv=(X)[(LO)+((HI)-(LO))/2];                                         \
+    if( ((X)[LO]<pv) != ((X)[LO]<(X)[HI]) ) pv=(X)[LO];                 \
+    else if( ((X)[HI]<pv) != ((X)[HI]<(X)[LO]) ) pv=(X)[HI];            \
+    LI=(LO); LJ=(HI);                                                   \
+    while(LI<=LJ)                                                       \
       {                                                                 \
-        /* Initialize, 'j' is desired pixel's index. */                 \
-        n=0;                                                            \
-        t=max;                                                          \
-        j=tprm->indexs[tind];                                           \
-                                                                        \
-        for(i=0;i<p->dnum;++i)  /* Loop over each array. */             \
-          {   /* Only for integer types, b==b. */                       \
-            if( p->hasblank[i] && b==b)                                 \
-              {                                                         \
-                if( a[i][j] != b )                                      \
-                  { t = a[i][j] < t ? a[i][j] : t; ++n; }               \
-              }                                                         \
-            else { t = a[i][j] < t ? a[i][j] : t; ++n; }                \
+        while( (X)[LI]<pv ) ++LI;                                       \
+        while( (X)[LJ]>pv ) --LJ;                                       \
+        if(LI<=LJ) { sw=(X)[LI]; (X)[LI++]=(X)[LJ]; (X)[LJ--]=sw; }     \
+      }                                                                 \
+  }
+
+
+/* Sort the elements 'LO' to 'HI' (inclusive) of 'X' with an insertion
+   sort (which is fastest for small arrays). */
+#define MULTIOPERAND_INSERTION_SORT(TYPE, X, LO, HI) {                  \
+    TYPE sv;                                                            \
+    long si, sj;                                                        \
+    for(si=(LO)+1;si<=(HI);++si)                                        \
+      {                                                                 \
+        sv=(X)[si];                                                     \
+        for(sj=si; sj>(LO) && (X)[sj-1]>sv; --sj) (X)[sj]=(X)[sj-1];    \
+        (X)[sj]=sv;                                                     \
+      }                                                                 \
+  }
+
+
+/* Sort the 'N' elements of 'X' in increasing order. This is a quicksort
+   that is done in place (without the function call of 'qsort' for every
+   comparison): the larger part of each partition is kept in a stack and
+   the smaller part is sorted first (so the stack never needs more than
+   'log2(N)' elements). Small parts are sorted with an insertion sort. */
+#define MULTIOPERAND_SORT(TYPE, X, N) {                                 \
+    long stk[2*64], top=0, lo, hi, li, lj;                              \
+    stk[top++]=0;                                                       \
+    stk[top++]=(long)(N)-1;                                             \
+    while(top)                                                          \
+      {                                                                 \
+        hi=stk[--top];                                                  \
+        lo=stk[--top];                                                  \
+        while(hi-lo >= MULTIOPERAND_SMALL_SORT)                         \
+          {                                                             \
+            MULTIOPERAND_PARTITION(TYPE, X, lo, hi, li, lj);            \
+            if(lj-lo < hi-li) { stk[top++]=li; stk[top++]=hi; hi=lj; }  \
+            else              { stk[top++]=lo; stk[top++]=lj; lo=li; }  \
           }                                                             \
-        o[j] = n ? t : b;  /* No usable elements: set to blank. */      \
+        MULTIOPERAND_INSERTION_SORT(TYPE, X, lo, hi);                   \
       }                                                                 \
   }
 
 
+/* Put the 'K'-th smallest element of the 'N' elements of 'X' in its
+   sorted position, such that all elements before it are smaller or
+   equal ('quickselect'). */
+#define MULTIOPERAND_SELECT(TYPE, X, N, K) {                            \
+    long lo=0, hi=(long)(N)-1, li, lj;                                  \
+    while(hi-lo >= MULTIOPERAND_SMALL_SORT)                             \
+      {                                                                 \
+        MULTIOPERAND_PARTITION(TYPE, X, lo, hi, li, lj);                \
+        if( (long)(K)<=lj )      hi=lj;                                 \
+        else if( (long)(K)>=li ) lo=li;                                 \
+        else break;                                                     \
+      }                                                                 \
+    if(hi-lo < MULTIOPERAND_SMALL_SORT)                                 \
+      MULTIOPERAND_INSERTION_SORT(TYPE, X, lo, hi);                     \
+  }
 
 
+/* If the 'N' elements of 'X' are sorted in decreasing order (with the
+   same check as 'gal_statistics_is_sorted'). */
+#define MULTIOPERAND_IS_DECREASING(X, N, OUT) {                         \
+    size_t di;                                                          \
+    OUT=0;                                                              \
+    if( (N)>1 && (X)[1]<(X)[0] )                                        \
+      {                                                                 \
+        for(di=1; di<(N)-1; ++di) if( (X)[di+1] > (X)[di] ) break;      \
+        OUT = di==(N)-1;                                                \
+      }                                                                 \
+  }
 
-#define MULTIOPERAND_MAX(TYPE) {                                        \
-    size_t n, j=0;                                                      \
-    TYPE t, min, *o=p->out->array;                                      \
-    gal_type_min(p->list->type, &min);                                  \
+
+
+
+
+#define MULTIOPERAND_MIN(TYPE) {                                        \
+    TYPE max, *o=p->out->array;                                         \
+    gal_type_max(p->list->type, &max);                                  \
                                                                         \
-    /* Go over all the pixels assigned to this thread. */               \
+    /* Go over all the blocks assigned to this thread. */               \
     for(tind=0; tprm->indexs[tind] != GAL_BLANK_SIZE_T; ++tind)         \
       {                                                                 \
-        /* Initialize, 'j' is desired pixel's index. */                 \
-        n=0;                                                            \
-        t=min;                                                          \
-        j=tprm->indexs[tind];                                           \
+        /* Initialize the block's extrema and counters. */              \
+        MULTIOPERAND_BLOCK_RANGE;                                       \
+        for(j=start;j<end;++j) { ext[j-start]=max; cnt[j-start]=0; }    \
                                                                         \
-        for(i=0;i<p->dnum;++i)  /* Loop over each array. */             \
-          {   /* Only for integer types, b==b. */                       \
-            if( p->hasblank[i] && b==b)                                 \
+        /* Loop over each array (only for integer types, b==b). */      \
+        for(i=0;i<p->dnum;++i)                                          \
+          for(j=start;j<end;++j)                                        \
+            if( ( p->masks==NULL || p->masks[i]==NULL                   \
+                  || p->masks[i][j]==0 )                                \
+                && ( !(p->hasblank[i] && b==b) || a[i][j]!=b ) )        \
               {                                                         \
-                if( a[i][j] != b )                                      \
-                  { t = a[i][j] > t ? a[i][j] : t; ++n; }               \
+                k=j-start;                                              \
+                ext[k] = a[i][j] < ext[k] ? a[i][j] : ext[k];           \
+                ++cnt[k];                                               \
               }                                                         \
-            else { t = a[i][j] > t ? a[i][j] : t; ++n; }                \
-          }                                                             \
-        o[j] = n ? t : b;  /* No usable elements: set to blank. */      \
+                                                                        \
+        /* No usable elements: set to blank. */                         \
+        for(j=start;j<end;++j)                                          \
+          o[j] = cnt[j-start] ? ext[j-start] : b;                       \
       }                                                                 \
   }
 
@@ -1499,31 +1564,32 @@ struct multioperandparams
 
 
 
-#define MULTIOPERAND_NUM {                                              \
-    int use;                                                            \
-    size_t n, j;                                                        \
-    uint32_t *o=p->out->array;                                          \
+#define MULTIOPERAND_MAX(TYPE) {                                        \
+    TYPE min, *o=p->out->array;                                         \
+    gal_type_min(p->list->type, &min);                                  \
                                                                         \
-    /* Go over all the pixels assigned to this thread. */               \
+    /* Go over all the blocks assigned to this thread. */               \
     for(tind=0; tprm->indexs[tind] != GAL_BLANK_SIZE_T; ++tind)         \
       {                                                                 \
-        /* Initialize, 'j' is desired pixel's index. */                 \
-        n=0;                                                            \
-        j=tprm->indexs[tind];                                           \
+        /* Initialize the block's extrema and counters. */              \
+        MULTIOPERAND_BLOCK_RANGE;                                       \
+        for(j=start;j<end;++j) { ext[j-start]=min; cnt[j-start]=0; }    \
                                                                         \
-        for(i=0;i<p->dnum;++i)  /* Loop over each array. */             \
-          {                                                             \
-            /* Only integers and non-NaN floats: v==v is 1. */          \
-            if(p->hasblank[i])                                          \
-              use = ( b==b                                              \
-                      ? ( a[i][j]!=b       ? 1 : 0 )      /* Integer */ \
-                      : ( a[i][j]==a[i][j] ? 1 : 0 ) );   /* Float   */ \
-            else use=1;                                                 \
+        /* Loop over each array (only for integer types, b==b). */      \
+        for(i=0;i<p->dnum;++i)                                          \
+          for(j=start;j<end;++j)                                        \
+            if( ( p->masks==NULL || p->masks[i]==NULL                   \
+                  || p->masks[i][j]==0 )                                \
+                && ( !(p->hasblank[i] && b==b) || a[i][j]!=b ) )        \
+              {                                                         \
+                k=j-start;                                              \
+                ext[k] = a[i][j] > ext[k] ? a[i][j] : ext[k];           \
+                ++cnt[k];                                               \
+              }                                                         \
                                                                         \
-            /* Increment counter if necessary. */                       \
-            if(use) ++n;                                                \
-          }                                                             \
-        o[j] = n;                                                       \
+        /* No usable elements: set to blank. */                         \
+        for(j=start;j<end;++j)                                          \
+          o[j] = cnt[j-start] ? ext[j-start] : b;                       \
       }                                                                 \
   }
 
@@ -1531,270 +1597,348 @@ struct multioperandparams
 
 
 
-#define MULTIOPERAND_SUM {                                              \
-    int use;                                                            \
-    double sum;                                                         \
-    size_t n, j;                                                        \
-    float *o=p->out->array;                                             \
+/* The number, sum, mean and standard deviation are found by accumulating
+   the (weighted) sums of each pixel in the block over all the inputs. When
+   no weights are given, the weight of each input is 1 and the outputs are
+   the same as the un-weighted statistics. */
+#define MULTIOPERAND_SUMS {                                             \
+    double v, w;                                                        \
+    float *of=p->out->array;                                            \
+    uint32_t *ou=p->out->array;                                         \
                                                                         \
-    /* Go over all the pixels assigned to this thread. */               \
+    /* Go over all the blocks assigned to this thread. */               \
     for(tind=0; tprm->indexs[tind] != GAL_BLANK_SIZE_T; ++tind)         \
       {                                                                 \
-        /* Initialize, 'j' is desired pixel's index. */                 \
-        n=0;                                                            \
-        sum=0.0f;                                                       \
-        j=tprm->indexs[tind];                                           \
+        /* Initialize the block's sums and counters. */                 \
+        MULTIOPERAND_BLOCK_RANGE;                                       \
+        for(j=start;j<end;++j)                                          \
+          { k=j-start; cnt[k]=0; sum[k]=sum2[k]=wsum[k]=0.0f; }         \
                                                                         \
-        for(i=0;i<p->dnum;++i)  /* Loop over each array. */             \
-          {                                                             \
-            /* Only integers and non-NaN floats: v==v is 1. */          \
-            if(p->hasblank[i])                                          \
-              use = ( b==b                                              \
-                      ? ( a[i][j]!=b       ? 1 : 0 )     /* Integer */  \
-                      : ( a[i][j]==a[i][j] ? 1 : 0 ) );  /* Float   */  \
-            else use=1;                                                 \
+        /* Loop over each array. Without weights, masks or blank */     \
+        /* values, the inner loop doesn't need any check. */            \
+        for(i=0;i<p->dnum;++i)                                          \
+          if(p->weights)                                                \
+            {                                                           \
+              w=p->weights[i];                                          \
+              for(j=start;j<end;++j)                                    \
+                if( MULTIOPERAND_USE(i, j) )                            \
+                  {                                                     \
+                    k=j-start;                                          \
+                    v=a[i][j];                                          \
+                    ++cnt[k];                                           \
+                    wsum[k] += w;                                       \
+                    sum2[k] += w * v * v;                               \
+                    sum[k]  += w * v;                                   \
+                  }                                                     \
+            }                                                           \
+          else if( (p->masks==NULL || p->masks[i]==NULL)                \
+                   && p->hasblank[i]==0 )                               \
+            for(j=start;j<end;++j)                                      \
+              {                                                         \
+                k=j-start;                                              \
+                ++cnt[k];                                               \
+                sum2[k] += a[i][j] * a[i][j];                           \
+                sum[k]  += a[i][j];                                     \
+              }                                                         \
+          else                                                          \
+            for(j=start;j<end;++j)                                      \
+              if( MULTIOPERAND_USE(i, j) )                              \
+                {                                                       \
+                  k=j-start;                                            \
+                  ++cnt[k];                                             \
+                  sum2[k] += a[i][j] * a[i][j];                         \
+                  sum[k]  += a[i][j];                                   \
+                }                                                       \
                                                                         \
-            /* Use in sum if necessary. */                              \
-            if(use) { sum += a[i][j]; ++n; }                            \
+        /* Write the output. Not using 'b' for the floating point */    \
+        /* outputs, because the input type may be integer. */           \
+        for(j=start;j<end;++j)                                          \
+          {                                                             \
+            k=j-start;                                                  \
+            w = p->weights ? wsum[k] : cnt[k];                          \
+            switch(p->operator)                                         \
+              {                                                         \
+              case GAL_ARITHMETIC_OP_NUMBER: ou[j]=cnt[k];       break; \
+              case GAL_ARITHMETIC_OP_SUM:                               \
+                of[j] = cnt[k] ? sum[k] : NAN;                   break; \
+              case GAL_ARITHMETIC_OP_MEAN:                              \
+                of[j] = cnt[k] ? sum[k]/w : NAN;                 break; \
+              case GAL_ARITHMETIC_OP_STD:                               \
+                of[j] = ( cnt[k]                                        \
+                          ? sqrt( (sum2[k]-sum[k]*sum[k]/w)/w )         \
+                          : NAN );                               break; \
+              }                                                         \
           }                                                             \
-        o[j] = n ? sum : NAN; /* Not using 'b', because input type */   \
-      }           /* may be integer, while output is always float. */   \
+      }                                                                 \
   }
 
 
 
 
 
-#define MULTIOPERAND_MEAN {                                             \
-    int use;                                                            \
-    double sum;                                                         \
-    size_t n, j;                                                        \
-    float *o=p->out->array;                                             \
-                                                                        \
-    /* Go over all the pixels assigned to this thread. */               \
-    for(tind=0; tprm->indexs[tind] != GAL_BLANK_SIZE_T; ++tind)         \
-      {                                                                 \
-        /* Initialize, 'j' is desired pixel's index. */                 \
-        n=0;                                                            \
-        sum=0.0f;                                                       \
-        j=tprm->indexs[tind];                                           \
-                                                                        \
-        for(i=0;i<p->dnum;++i)  /* Loop over each array. */             \
+/* Fill the scratch array with the usable values of every pixel in the
+   block (in '[pixel][input]' order: the values of each pixel are
+   contiguous). Each input is read sequentially over the block. */
+#define MULTIOPERAND_GATHER {                                           \
+    MULTIOPERAND_BLOCK_RANGE;                                           \
+    for(j=start;j<end;++j) cnt[j-start]=0;                              \
+    for(i=0;i<p->dnum;++i)                                              \
+      for(j=start;j<end;++j)                                            \
+        if( MULTIOPERAND_USE(i, j) )                                    \
           {                                                             \
-            /* Only integers and non-NaN floats: v==v is 1. */          \
-            if(p->hasblank[i])                                          \
-              use = ( b==b                                              \
-                      ? ( a[i][j]!=b       ? 1 : 0 )     /* Integer */  \
-                      : ( a[i][j]==a[i][j] ? 1 : 0 ) );  /* Float   */  \
-            else use=1;                                                 \
-                                                                        \
-            /* Calculate the mean if necessary. */                      \
-            if(use) { sum += a[i][j]; ++n; }                            \
+            k=j-start;                                                  \
+            scr[k*p->dnum + cnt[k]++]=a[i][j];                          \
           }                                                             \
-        o[j] = n ? sum/n : NAN; /* Not using 'b', because input type */ \
-      }             /* may be integer, while output is always float. */ \
   }
 
 
 
 
 
-#define MULTIOPERAND_STD {                                              \
-    int use;                                                            \
-    size_t n, j;                                                        \
-    double sum, sum2;                                                   \
+#define MULTIOPERAND_MEDIAN(TYPE) {                                     \
+    size_t n;                                                           \
+    TYPE *x, hi, lo;                                                    \
     float *o=p->out->array;                                             \
                                                                         \
-    /* Go over all the pixels assigned to this thread. */               \
+    /* Go over all the blocks assigned to this thread. */               \
     for(tind=0; tprm->indexs[tind] != GAL_BLANK_SIZE_T; ++tind)         \
       {                                                                 \
-        /* Initialize, 'j' is desired pixel's index. */                 \
-        n=0;                                                            \
-        sum=sum2=0.0f;                                                  \
-        j=tprm->indexs[tind];                                           \
-                                                                        \
-        for(i=0;i<p->dnum;++i)  /* Loop over each array. */             \
+        MULTIOPERAND_GATHER;                                            \
+        for(j=start;j<end;++j)                                          \
           {                                                             \
-            /* Only integers and non-NaN floats: v==v is 1. */          \
-            if(p->hasblank[i])                                          \
-              use = ( b==b                                              \
-                      ? ( a[i][j]!=b       ? 1 : 0 )     /* Integer */  \
-                      : ( a[i][j]==a[i][j] ? 1 : 0 ) );  /* Float   */  \
-            else use=1;                                                 \
-                                                                        \
-            /* Calculate the necessary parameters if necessary. */      \
-            if(use)                                                     \
+            /* Select the middle element(s) of this pixel. When the */  \
+            /* number is even, the largest element before the middle */ \
+            /* is the other middle element. */                          \
+            k=j-start;                                                  \
+            n=cnt[k];                                                   \
+            x=scr+k*p->dnum;                                            \
+            if(n)                                                       \
               {                                                         \
-                sum2 += a[i][j] * a[i][j];                              \
-                sum  += a[i][j];                                        \
-                ++n;                                                    \
+                MULTIOPERAND_SELECT(TYPE, x, n, n/2);          \
+                hi=x[n/2];                                              \
+                if(n%2) o[j]=hi;                                        \
+                else                                                    \
+                  {                                                     \
+                    lo=x[0];                                            \
+                    for(i=1;i<n/2;++i) if(x[i]>lo) lo=x[i];             \
+                    o[j]=(hi + lo)/2;                                   \
+                  }                                                     \
               }                                                         \
-          }                                                             \
-        o[j] = n ? sqrt( (sum2-sum*sum/n)/n ) : NAN; /* Not using 'b' */ \
-      } /* because input may be integer, but output is always float. */ \
+            else                                                        \
+              o[j]=NAN; /* Not using 'b' because input may be integer */\
+          }                             /* but output is always float.*/\
+      }                                                                 \
   }
 
 
 
 
 
-#define MULTIOPERAND_MEDIAN(TYPE, QSORT_F) {                            \
-    int use;                                                            \
-    size_t n, j;                                                        \
-    float *o=p->out->array;                                             \
-    TYPE *pixs=gal_pointer_allocate(p->list->type, p->dnum, 0,          \
-                                    __func__, "pixs");                  \
+/* For the rare pixels where the usable values are already sorted in
+   decreasing order, 'gal_statistics_quantile' and
+   'gal_statistics_sigma_clip' work on the decreasing array (without
+   sorting), so the result may be different in the floating point
+   round-off error. To have identical outputs, they are given to these
+   functions in such cases. */
+#define MULTIOPERAND_CONT_SET {                                         \
+    memcpy(cont->array, x, n*sizeof *x);                                \
+    cont->flag=0;                                                       \
+    cont->size=cont->dsize[0]=n;                                        \
+  }
+
+#define MULTIOPERAND_QUANTILE(TYPE) {                                   \
+    int dec;                                                            \
+    size_t n, ind;                                                      \
+    gal_data_t *quantile;                                               \
+    TYPE *x, *o=p->out->array;                                          \
                                                                         \
-    /* Go over all the pixels assigned to this thread. */               \
+    /* Go over all the blocks assigned to this thread. */               \
     for(tind=0; tprm->indexs[tind] != GAL_BLANK_SIZE_T; ++tind)         \
       {                                                                 \
-        /* Initialize, 'j' is desired pixel's index. */                 \
-        n=0;                                                            \
-        j=tprm->indexs[tind];                                           \
-                                                                        \
-        /* Loop over each array: 'i' is input dataset's index. */       \
-        for(i=0;i<p->dnum;++i)                                          \
+        MULTIOPERAND_GATHER;                                            \
+        for(j=start;j<end;++j)                                          \
           {                                                             \
-            /* Only integers and non-NaN floats: v==v is 1. */          \
-            if(p->hasblank[i])                                          \
-              use = ( b==b                                              \
-                      ? ( a[i][j]!=b       ? 1 : 0 )     /* Integer */  \
-                      : ( a[i][j]==a[i][j] ? 1 : 0 ) );  /* Float   */  \
-            else use=1;                                                 \
-                                                                        \
-            /* Put the value into the array of values. */               \
-            if(use) pixs[n++]=a[i][j];                                  \
-          }                                                             \
+            k=j-start;                                                  \
+            n=cnt[k];                                                   \
+            x=scr+k*p->dnum;                                            \
+            if(n==0) { o[j]=b; continue; }                              \
                                                                         \
-        /* Sort all the values for this pixel and return the median. */ \
-        if(n)                                                           \
-          {                                                             \
-            qsort(pixs, n, sizeof *pixs, QSORT_F);                      \
-            o[j] = n%2 ? pixs[n/2] : (pixs[n/2] + pixs[n/2-1])/2 ;      \
+            /* Find the quantile. */                                    \
+            MULTIOPERAND_IS_DECREASING(x, n, dec);                      \
+            if(dec)                                                     \
+              {                                                         \
+                MULTIOPERAND_CONT_SET;                                  \
+                quantile=gal_statistics_quantile(cont, p->p1, 1);       \
+                o[j]=*(TYPE *)(quantile->array);                        \
+                gal_data_free(quantile);                                \
+              }                                                         \
+            else                                                        \
+              {                                                         \
+                ind=gal_statistics_quantile_index(n, p->p1);            \
+                MULTIOPERAND_SELECT(TYPE, x, n, ind);          \
+                o[j]=x[ind];                                            \
+              }                                                         \
           }                                                             \
-        else                                                            \
-          o[j]=NAN; /* Not using 'b' because input may be integer */    \
-      }                             /* but output is always float.*/    \
-                                                                        \
-    /* Clean up. */                                                     \
-    free(pixs);                                                         \
+      }                                                                 \
   }
 
 
 
 
 
-#define MULTIOPERAND_QUANTILE(TYPE) {                                   \
-    size_t n, j;                                                        \
-    gal_data_t *quantile;                                               \
-    TYPE *o=p->out->array;                                              \
-    TYPE *pixs=gal_pointer_allocate(p->list->type, p->dnum, 0,          \
-                                    __func__, "pixs");                  \
-    gal_data_t *cont=gal_data_alloc(pixs, p->list->type, 1, &p->dnum,   \
-                                    NULL, 0, -1, 1, NULL, NULL, NULL);  \
+/* Sigma-clip the sorted (increasing) 'n' elements of 'x' with exactly the
+   same steps as 'gal_statistics_sigma_clip' (see the comments there), but
+   without any allocation. The four outputs (number, median, mean and
+   standard deviation) are written in 'sarr'. */
+#define MULTIOPERAND_SIGCLIP_SORTED(TYPE) {                             \
+    TYPE med_t;                                                         \
+    size_t ci, num=0, size=n, st=0, newst;                              \
+    long ca, cb;                                                        \
+    double v, s, s2, med, mean, std;                                    \
+    double oldmed=NAN, oldmean=NAN, oldstd=NAN;                         \
                                                                         \
-    /* Go over all the pixels assigned to this thread. */               \
-    for(tind=0; tprm->indexs[tind] != GAL_BLANK_SIZE_T; ++tind)         \
+    if(n==1)                                                            \
+      { sarr[0]=1; sarr[1]=sarr[2]=x[0]; sarr[3]=0; }                   \
+    else                                                                \
       {                                                                 \
-        /* Initialize, 'j' is desired pixel's index. */                 \
-        n=0;                                                            \
-        j=tprm->indexs[tind];                                           \
+        while(num<maxnum && size)                                       \
+          {                                                             \
+            /* Mean and standard deviation. */                          \
+            s=s2=0.0f;                                                  \
+            if(size==1) { s=x[st]; mean=s; std=0; }                     \
+            else                                                        \
+              {                                                         \
+                for(ci=st;ci<st+size;++ci)                              \
+                  { v=x[ci]; s+=v; s2+=v*v; }                           \
+                mean=s/size;                                            \
+                std=gal_statistics_std_from_sums(s, s2, size);          \
+              }                                                         \
                                                                         \
-        /* Read the necessay values from each input. */                 \
-        for(i=0;i<p->dnum;++i) pixs[n++]=a[i][j];                       \
+            /* Median (in the input type). */                           \
+            med_t = ( size%2                                            \
+                      ? x[st+size/2]                                    \
+                      : (x[st+size/2]+x[st+size/2-1])/2 );              \
+            med=med_t;                                                  \
                                                                         \
-        /* If there are any elements, measure the  */                   \
-        if(n)                                                           \
-          {                                                             \
-            /* Calculate the quantile and put it in the output. */      \
-            quantile=gal_statistics_quantile(cont, p->p1, 1);           \
-            memcpy(&o[j], quantile->array,                              \
-                   gal_type_sizeof(p->list->type));                     \
-            gal_data_free(quantile);                                    \
+            /* Check the tolerance. */                                  \
+            if( bytolerance && num>0 )                                  \
+              if( std==0 || ((oldstd - std) / std) < p->p2 )            \
+                {                                                       \
+                  if(std==0) {oldmed=med; oldstd=std; oldmean=mean;}    \
+                  break;                                                \
+                }                                                       \
                                                                         \
-            /* Since we are doing sigma-clipping in place, the size, */ \
-            /* and flags need to be reset. */                           \
-            cont->flag=0;                                               \
-            cont->size=cont->dsize[0]=p->dnum;                          \
+            /* Clip the outliers from the start and end. */             \
+            newst=st;                                                   \
+            for(ca=st; ca<(long)(st+size); ++ca)                        \
+              if( x[ca] > (med - (p->p1 * std)) ) { newst=ca; break; }  \
+            for(cb=st+size-1; cb>=(long)st; --cb)                       \
+              if( x[cb] < (med + (p->p1 * std)) )                       \
+                { size = cb>=ca ? cb-ca+1 : 0; break; }                 \
+            st=newst;                                                   \
+                                                                        \
+            /* Keep this round's measurements. */                       \
+            oldmed=med;                                                 \
+            oldstd=std;                                                 \
+            oldmean=mean;                                               \
+            ++num;                                                      \
           }                                                             \
+                                                                        \
+        /* Write the outputs. */                                        \
+        if( size==0 || (bytolerance && num==maxnum) )                   \
+          sarr[0] = sarr[1] = sarr[2] = sarr[3] = NAN;                  \
         else                                                            \
-          o[j]=b;                                                       \
+          {                                                             \
+            sarr[0] = size;                                             \
+            sarr[1] = oldmed;                                           \
+            sarr[2] = oldmean;                                          \
+            sarr[3] = oldstd;                                           \
+          }                                                             \
       }                                                                 \
-                                                                        \
-    /* Clean up (note that 'pixs' is inside of 'cont'). */              \
-    gal_data_free(cont);                                                \
   }
 
-
-
-
-
 #define MULTIOPERAND_SIGCLIP(TYPE) {                                    \
-    size_t n, j;                                                        \
+    int dec;                                                            \
+    TYPE *x;                                                            \
+    size_t n;                                                           \
     gal_data_t *sclip;                                                  \
+    float *sarr, sarrs[4];                                              \
     uint32_t *N=p->out->array;                                          \
-    float *sarr, *o=p->out->array;                                      \
-    TYPE *pixs=gal_pointer_allocate(p->list->type, p->dnum, 0,          \
-                                    __func__, "pixs");                  \
-    gal_data_t *cont=gal_data_alloc(pixs, p->list->type, 1, &p->dnum,   \
-                                    NULL, 0, -1, 1, NULL, NULL, NULL);  \
+    uint32_t *C=p->clipnum ? p->clipnum->array : NULL;                  \
+    float *o=p->out->array;                                             \
+    uint8_t bytolerance = p->p2>=1.0f ? 0 : 1;                          \
+    size_t maxnum = ( p->p2>=1.0f                                       \
+                      ? p->p2                                           \
+                      : GAL_STATISTICS_SIG_CLIP_MAX_CONVERGE );         \
                                                                         \
-    /* Go over all the pixels assigned to this thread. */               \
+    /* Go over all the blocks assigned to this thread. */               \
     for(tind=0; tprm->indexs[tind] != GAL_BLANK_SIZE_T; ++tind)         \
       {                                                                 \
-        /* Initialize, 'j' is desired pixel's index. */                 \
-        n=0;                                                            \
-        j=tprm->indexs[tind];                                           \
-                                                                        \
-        /* Read the necessay values from each input. */                 \
-        for(i=0;i<p->dnum;++i) pixs[n++]=a[i][j];                       \
-                                                                        \
-        /* If there are any usable elements, measure the  */            \
-        if(n)                                                           \
+        MULTIOPERAND_GATHER;                                            \
+        for(j=start;j<end;++j)                                          \
           {                                                             \
-            /* Calculate the sigma-clip and write it in. */             \
-            sclip=gal_statistics_sigma_clip(cont, p->p1, p->p2, 1, 1);  \
-            sarr=sclip->array;                                          \
+            /* Sigma-clip this pixel's values. */                       \
+            k=j-start;                                                  \
+            n=cnt[k];                                                   \
+            x=scr+k*p->dnum;                                            \
+            sclip=NULL;                                                 \
+            MULTIOPERAND_IS_DECREASING(x, n, dec);                      \
+            if(dec)                                                     \
+              {                                                         \
+                MULTIOPERAND_CONT_SET;                                  \
+                sclip=gal_statistics_sigma_clip(cont, p->p1, p->p2,     \
+                                                1, 1);                  \
+                sarr=sclip->array;                                      \
+              }                                                         \
+            else if(n)                                                  \
+              {                                                         \
+                sarr=sarrs;                                             \
+                MULTIOPERAND_SORT(TYPE, x, n);                 \
+                MULTIOPERAND_SIGCLIP_SORTED(TYPE);                      \
+              }                                                         \
+            else                                                        \
+              {                                                         \
+                sarr=sarrs;                                             \
+                sarr[0] = sarr[1] = sarr[2] = sarr[3] = NAN;            \
+              }                                                         \
+                                                                        \
+            /* Write the requested output (with no usable elements, */  \
+            /* the number is 0 and the rest are NaN: not using 'b' */   \
+            /* because input can be an integer but output is float). */ \
             switch(p->operator)                                         \
               {                                                         \
               case GAL_ARITHMETIC_OP_SIGCLIP_STD:    o[j]=sarr[3]; break;\
               case GAL_ARITHMETIC_OP_SIGCLIP_MEAN:   o[j]=sarr[2]; break;\
               case GAL_ARITHMETIC_OP_SIGCLIP_MEDIAN: o[j]=sarr[1]; break;\
-              case GAL_ARITHMETIC_OP_SIGCLIP_NUMBER: N[j]=sarr[0]; break;\
+              case GAL_ARITHMETIC_OP_SIGCLIP_NUMBER:                    \
+                N[j] = n ? sarr[0] : 0;                          break; \
               default:                                                  \
                 error(EXIT_FAILURE, 0, "%s: a bug! the code %d is not " \
                       "valid for sigma-clipping results", __func__,     \
                       p->operator);                                     \
               }                                                         \
-            gal_data_free(sclip);                                       \
                                                                         \
-            /* Since we are doing sigma-clipping in place, the size, */ \
-            /* and flags need to be reset. */                           \
-            cont->flag=0;                                               \
-            cont->size=cont->dsize[0]=p->dnum;                          \
+            /* Number after clipping (blank when there is no result). */\
+            if(C)                                                       \
+              C[j] = ( n==0 ? 0                                         \
+                       : isnan(sarr[0]) ? GAL_BLANK_UINT32 : sarr[0] ); \
+            if(sclip) gal_data_free(sclip);                             \
           }                                                             \
-        else                                                            \
-          o[j] = ( p->operator==GAL_ARITHMETIC_OP_SIGCLIP_NUMBER        \
-                   ? 0.0    /* Not using 'b' because input can be an */ \
-                   : NAN );   /* integer but output is always float. */ \
       }                                                                 \
-                                                                        \
-    /* Clean up (note that 'pixs' is inside of 'cont'). */              \
-    gal_data_free(cont);                                                \
   }
 
 
 
 
 
-#define MULTIOPERAND_TYPE_SET(TYPE, QSORT_F) {                          \
-    TYPE b, **a;                                                        \
-    gal_data_t *tmp;                                                    \
-    size_t i=0, tind;                                                   \
+#define MULTIOPERAND_TYPE_SET(TYPE) {                                   \
+    TYPE b, **a, *ext=NULL, *scr=NULL;                                  \
+    gal_data_t *tmp, *cont=NULL;                                        \
+    double *sum=NULL, *sum2=NULL, *wsum=NULL;                           \
+    size_t i=0, j, k, tind, start, end, *cnt;                           \
                                                                         \
     /* Allocate space to keep the pointers to the arrays of each. */    \
-    /* Input data structure. The operators will increment these */      \
-    /* pointers while parsing them. */                                  \
+    /* Input data structure. */                                         \
     errno=0;                                                            \
     a=malloc(p->dnum*sizeof *a);                                        \
     if(a==NULL)                                                         \
@@ -1806,6 +1950,34 @@ struct multioperandparams
     for(tmp=p->list;tmp!=NULL;tmp=tmp->next)                            \
       a[i++]=tmp->array;                                                \
                                                                         \
+    /* Allocate the block's (per-thread) scratch arrays. */             \
+    cnt=gal_pointer_allocate(GAL_TYPE_SIZE_T, p->blocksize, 0,          \
+                             __func__, "cnt");                          \
+    switch(p->operator)                                                 \
+      {                                                                 \
+      case GAL_ARITHMETIC_OP_MIN:                                       \
+      case GAL_ARITHMETIC_OP_MAX:                                       \
+        ext=gal_pointer_allocate(p->list->type, p->blocksize, 0,        \
+                                 __func__, "ext");                      \
+        break;                                                          \
+      case GAL_ARITHMETIC_OP_NUMBER:                                    \
+      case GAL_ARITHMETIC_OP_SUM:                                       \
+      case GAL_ARITHMETIC_OP_MEAN:                                      \
+      case GAL_ARITHMETIC_OP_STD:                                       \
+        sum=gal_pointer_allocate(GAL_TYPE_FLOAT64, p->blocksize, 0,     \
+                                 __func__, "sum");                      \
+        sum2=gal_pointer_allocate(GAL_TYPE_FLOAT64, p->blocksize, 0,    \
+                                  __func__, "sum2");                    \
+        wsum=gal_pointer_allocate(GAL_TYPE_FLOAT64, p->blocksize, 0,    \
+                                  __func__, "wsum");                    \
+        break;                                                          \
+      default:                                                          \
+        scr=gal_pointer_allocate(p->list->type, p->blocksize*p->dnum,   \
+                                 0, __func__, "scr");                   \
+        cont=gal_data_alloc(NULL, p->list->type, 1, &p->dnum, NULL, 0,  \
+                            -1, 1, NULL, NULL, NULL);                   \
+      }                                                                 \
+                                                                        \
     /* Do the operation. */                                             \
     switch(p->operator)                                                 \
       {                                                                 \
@@ -1818,23 +1990,14 @@ struct multioperandparams
         break;                                                          \
                                                                         \
       case GAL_ARITHMETIC_OP_NUMBER:                                    \
-        MULTIOPERAND_NUM;                                               \
-        break;                                                          \
-                                                                        \
       case GAL_ARITHMETIC_OP_SUM:                                       \
-        MULTIOPERAND_SUM;                                               \
-        break;                                                          \
-                                                                        \
       case GAL_ARITHMETIC_OP_MEAN:                                      \
-        MULTIOPERAND_MEAN;                                              \
-        break;                                                          \
-                                                                        \
       case GAL_ARITHMETIC_OP_STD:                                       \
-        MULTIOPERAND_STD;                                               \
+        MULTIOPERAND_SUMS;                                              \
         break;                                                          \
                                                                         \
       case GAL_ARITHMETIC_OP_MEDIAN:                                    \
-        MULTIOPERAND_MEDIAN(TYPE, QSORT_F);                             \
+        MULTIOPERAND_MEDIAN(TYPE);                                      \
         break;                                                          \
                                                                         \
       case GAL_ARITHMETIC_OP_QUANTILE:                                  \
@@ -1855,6 +2018,13 @@ struct multioperandparams
                                                                         \
     /* Clean up. */                                                     \
     free(a);                                                            \
+    free(cnt);                                                          \
+    if(ext)  free(ext);                                                 \
+    if(scr)  free(scr);                                                 \
+    if(sum)  free(sum);                                                 \
+    if(sum2) free(sum2);                                                \
+    if(wsum) free(wsum);                                                \
+    if(cont) gal_data_free(cont);                                       \
   }
 
 
@@ -1873,34 +2043,34 @@ multioperand_on_thread(void *in_prm)
   switch(p->list->type)
     {
     case GAL_TYPE_UINT8:
-      MULTIOPERAND_TYPE_SET(uint8_t,   gal_qsort_uint8_i);
+      MULTIOPERAND_TYPE_SET(uint8_t);
       break;
     case GAL_TYPE_INT8:
-      MULTIOPERAND_TYPE_SET(int8_t,    gal_qsort_int8_i);
+      MULTIOPERAND_TYPE_SET(int8_t);
       break;
     case GAL_TYPE_UINT16:
-      MULTIOPERAND_TYPE_SET(uint16_t,  gal_qsort_uint16_i);
+      MULTIOPERAND_TYPE_SET(uint16_t);
       break;
     case GAL_TYPE_INT16:
-      MULTIOPERAND_TYPE_SET(int16_t,   gal_qsort_int16_i);
+      MULTIOPERAND_TYPE_SET(int16_t);
       break;
     case GAL_TYPE_UINT32:
-      MULTIOPERAND_TYPE_SET(uint32_t,  gal_qsort_uint32_i);
+      MULTIOPERAND_TYPE_SET(uint32_t);
       break;
     case GAL_TYPE_INT32:
-      MULTIOPERAND_TYPE_SET(int32_t,   gal_qsort_int32_i);
+      MULTIOPERAND_TYPE_SET(int32_t);
       break;
     case GAL_TYPE_UINT64:
-      MULTIOPERAND_TYPE_SET(uint64_t,  gal_qsort_uint64_i);
+      MULTIOPERAND_TYPE_SET(uint64_t);
       break;
     case GAL_TYPE_INT64:
-      MULTIOPERAND_TYPE_SET(int64_t,   gal_qsort_int64_i);
+      MULTIOPERAND_TYPE_SET(int64_t);
       break;
     case GAL_TYPE_FLOAT32:
-      MULTIOPERAND_TYPE_SET(float,     gal_qsort_float32_i);
+      MULTIOPERAND_TYPE_SET(float);
       break;
     case GAL_TYPE_FLOAT64:
-      MULTIOPERAND_TYPE_SET(double,    gal_qsort_float64_i);
+      MULTIOPERAND_TYPE_SET(double);
       break;
     default:
       error(EXIT_FAILURE, 0, "%s: type code %d not recognized",
@@ -1921,10 +2091,12 @@ multioperand_on_thread(void *in_prm)
    the linked list must have a NULL pointer as its 'next' element. */
 static gal_data_t *
 arithmetic_multioperand(int operator, int flags, gal_data_t *list,
-                        gal_data_t *params, size_t numthreads)
+                        gal_data_t *params, size_t numthreads,
+                        float *weights, gal_data_t *masks)
 {
   size_t i=0, dnum=1;
   float p1=NAN, p2=NAN;
+  uint8_t **marr=NULL;
   struct multioperandparams p;
   gal_data_t *out, *tmp, *ttmp;
   uint8_t *hasblank, otype=GAL_TYPE_INVALID;
@@ -2010,8 +2182,60 @@ arithmetic_multioperand(int operator, int flags, gal_data_t *list,
     }
 
 
-  /* Set the output data structure. */
-  if( (flags & GAL_ARITHMETIC_FLAG_INPLACE) && otype==list->type)
+  /* The sigma-clipping parameters are checked here (once), the same
+     checks are done in 'gal_statistics_sigma_clip'. */
+  switch(operator)
+    {
+    case GAL_ARITHMETIC_OP_SIGCLIP_STD:
+    case GAL_ARITHMETIC_OP_SIGCLIP_MEAN:
+    case GAL_ARITHMETIC_OP_SIGCLIP_MEDIAN:
+    case GAL_ARITHMETIC_OP_SIGCLIP_NUMBER:
+      if( p1<=0 )
+        error(EXIT_FAILURE, 0, "%s: 'multip', must be greater than zero. "
+              "The given value was %g", __func__, p1);
+      if( p2<=0 )
+        error(EXIT_FAILURE, 0, "%s: 'param', must be greater than zero. "
+              "The given value was %g", __func__, p2);
+      if( p2 >= 1.0f && ceil(p2) != p2 )
+        error(EXIT_FAILURE, 0, "%s: when 'param' is larger than 1.0, it "
+              "is interpretted as an absolute number of clips. So it must "
+              "be an integer. However, your given value %g", __func__, p2);
+      break;
+    }
+
+
+  /* The masks (if given) should correspond to the inputs. */
+  if(masks)
+    {
+      if(gal_list_data_number(masks)!=dnum)
+        error(EXIT_FAILURE, 0, "%s: the number of masks (%zu) is not the "
+              "same as the number of inputs (%zu)", __func__,
+              gal_list_data_number(masks), dnum);
+      errno=0;
+      marr=malloc(dnum*sizeof *marr);
+      if(marr==NULL)
+        error(EXIT_FAILURE, errno, "%s: %zu bytes for 'marr'", __func__,
+              dnum*sizeof *marr);
+      for(tmp=masks;tmp!=NULL;tmp=tmp->next)
+        {
+          if(tmp->array && tmp->type!=GAL_TYPE_UINT8)
+            error(EXIT_FAILURE, 0, "%s: masks must have an unsigned "
+                  "8-bit integer type, but one has a type of '%s'",
+                  __func__, gal_type_name(tmp->type, 1));
+          if(tmp->array && gal_dimension_is_different(list, tmp))
+            error(EXIT_FAILURE, 0, "%s: the sizes of all masks must be "
+                  "the same as the inputs", __func__);
+          marr[i++]=tmp->array;
+        }
+      i=0;
+    }
+
+
+  /* Set the output data structure (when the number after clipping is
+     requested, the output's 'next' pointer will be used for it, so the
+     output can't be in the list). */
+  if( (flags & GAL_ARITHMETIC_FLAG_INPLACE) && otype==list->type
+      && !(flags & GAL_ARITHMETIC_FLAG_CLIPNUM) )
     out = list;                 /* The top element in the list. */
   else
     out = gal_data_alloc(NULL, otype, list->ndim, list->dsize,
@@ -2019,6 +2243,25 @@ arithmetic_multioperand(int operator, int flags, gal_data_t *list,
                          NULL, NULL, NULL);
 
 
+  /* For the sigma-clipping operators, the number of inputs that remained
+     after clipping can also be requested (it will be returned as the
+     'next' element of the output). */
+  p.clipnum=NULL;
+  if(flags & GAL_ARITHMETIC_FLAG_CLIPNUM)
+    switch(operator)
+      {
+      case GAL_ARITHMETIC_OP_SIGCLIP_STD:
+      case GAL_ARITHMETIC_OP_SIGCLIP_MEAN:
+      case GAL_ARITHMETIC_OP_SIGCLIP_MEDIAN:
+      case GAL_ARITHMETIC_OP_SIGCLIP_NUMBER:
+        p.clipnum=gal_data_alloc(NULL, GAL_TYPE_UINT32, list->ndim,
+                                 list->dsize, list->wcs, 0,
+                                 list->minmapsize, list->quietmmap,
+                                 NULL, NULL, NULL);
+        break;
+      }
+
+
   /* hasblank is used to see if a blank value should be checked for each
      list element or not. */
   hasblank=gal_pointer_allocate(GAL_TYPE_UINT8, dnum, 0, __func__,
@@ -2034,10 +2277,34 @@ arithmetic_multioperand(int operator, int flags, gal_data_t *list,
   p.out=out;
   p.list=list;
   p.dnum=dnum;
+  p.masks=marr;
+  p.weights=weights;
   p.operator=operator;
   p.hasblank=hasblank;
-  gal_threads_spin_off(multioperand_on_thread, &p, out->size, numthreads,
-                       list->minmapsize, list->quietmmap);
+  switch(operator)
+    {
+    /* Operators that only accumulate don't need the scratch array (their
+       memory for each block doesn't depend on the number of inputs). */
+    case GAL_ARITHMETIC_OP_MIN:
+    case GAL_ARITHMETIC_OP_MAX:
+    case GAL_ARITHMETIC_OP_NUMBER:
+    case GAL_ARITHMETIC_OP_SUM:
+    case GAL_ARITHMETIC_OP_MEAN:
+    case GAL_ARITHMETIC_OP_STD:
+      p.blocksize=MULTIOPERAND_BLOCK_MAX;
+      break;
+    default:
+      p.blocksize=( MULTIOPERAND_BLOCK_BYTES
+                    / (dnum*gal_type_sizeof(list->type)) );
+      if(p.blocksize>MULTIOPERAND_BLOCK_MAX)
+        p.blocksize=MULTIOPERAND_BLOCK_MAX;
+    }
+  if(p.blocksize<16)                    p.blocksize=16;
+  if(p.blocksize>out->size)             p.blocksize=out->size;
+  if(out->size)
+    gal_threads_spin_off(multioperand_on_thread, &p,
+                         1+(out->size-1)/p.blocksize, numthreads,
+                         list->minmapsize, list->quietmmap);
 
 
   /* Clean up and return. Note that the operation might have been done in
@@ -2056,7 +2323,9 @@ arithmetic_multioperand(int operator, int flags, gal_data_t *list,
         }
       if(params) gal_list_data_free(params);
     }
+  if(marr) free(marr);
   free(hasblank);
+  if(p.clipnum) out->next=p.clipnum;
   return out;
 }
 
@@ -2064,6 +2333,42 @@ arithmetic_multioperand(int operator, int flags, gal_data_t *list,
 
 
 
+/* Stack the datasets in 'list' with one of the multi-operand operators
+   (like the 'GAL_ARITHMETIC_OP_MEDIAN' in 'gal_arithmetic'), but
+   optionally with a weight and a mask for each input. */
+gal_data_t *
+gal_arithmetic_stack(int operator, size_t numthreads, int flags,
+                     gal_data_t *list, gal_data_t *params,
+                     float *weights, gal_data_t *masks)
+{
+  switch(operator)
+    {
+    case GAL_ARITHMETIC_OP_MIN:
+    case GAL_ARITHMETIC_OP_MAX:
+    case GAL_ARITHMETIC_OP_NUMBER:
+    case GAL_ARITHMETIC_OP_SUM:
+    case GAL_ARITHMETIC_OP_MEAN:
+    case GAL_ARITHMETIC_OP_STD:
+    case GAL_ARITHMETIC_OP_MEDIAN:
+    case GAL_ARITHMETIC_OP_QUANTILE:
+    case GAL_ARITHMETIC_OP_SIGCLIP_STD:
+    case GAL_ARITHMETIC_OP_SIGCLIP_MEAN:
+    case GAL_ARITHMETIC_OP_SIGCLIP_MEDIAN:
+    case GAL_ARITHMETIC_OP_SIGCLIP_NUMBER:
+      break;
+    default:
+      error(EXIT_FAILURE, 0, "%s: the '%s' operator is not a stacking "
+            "(multi-operand) operator", __func__,
+            gal_arithmetic_operator_string(operator));
+    }
+  return arithmetic_multioperand(operator, flags, list, params,
+                                 numthreads, weights, masks);
+}
+
+
+
+
+
 
 
 
@@ -2311,13 +2616,32 @@ arithmetic_binary(int operator, int flags, gal_data_t *l, gal_data_t *r)
 
 
 
+/* Number of elements that are given to each thread in one job by the
+   binary function operators. */
+#define BINFUNC_CHUNK 65536
+
+/* Parameters for the threads of the binary function operators. */
+struct binfuncparams
+{
+  gal_data_t         *l;        /* Left operand.                     */
+  gal_data_t         *r;        /* Right operand.                    */
+  gal_data_t         *o;        /* Output dataset.                   */
+  int          operator;        /* Operator to use.                  */
+};
+
+/* Apply the operator on the elements in the '[start, end)' range (set in
+   'binfunc_on_thread'). */
 #define BINFUNC_RUN_FUNCTION(OT, RT, LT, OP, AFTER){                    \
+    size_t i;                                                           \
     LT *la=l->array;                                                    \
     RT *ra=r->array;                                                    \
-    OT *oa=o->array, *of=oa + o->size;                                  \
-    if(l->size==r->size) do *oa = OP(*la++, *ra++) AFTER; while(++oa<of); \
-    else if(l->size==1)  do *oa = OP(*la,   *ra++) AFTER; while(++oa<of); \
-    else                 do *oa = OP(*la++, *ra  ) AFTER; while(++oa<of); \
+    OT *oa=o->array;                                                    \
+    if(l->size==r->size)                                                \
+      for(i=start;i<end;++i) oa[i] = OP(la[i], ra[i]) AFTER;            \
+    else if(l->size==1)                                                 \
+      for(i=start;i<end;++i) oa[i] = OP(la[0], ra[i]) AFTER;            \
+    else                                                                \
+      for(i=start;i<end;++i) oa[i] = OP(la[i], ra[0]) AFTER;            \
   }
 
 
@@ -2366,11 +2690,71 @@ arithmetic_binary(int operator, int flags, gal_data_t *l, gal_data_t *r)
     }
 
 
+/* Worker function on each thread: 'tprm->indexs' are the chunks of
+   'BINFUNC_CHUNK' elements. */
+static void *
+binfunc_on_thread(void *in_prm)
+{
+  struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
+  struct binfuncparams *p=(struct binfuncparams *)tprm->params;
+
+  size_t i, start, end;
+  gal_data_t *l=p->l, *r=p->r, *o=p->o;
+
+  /* Go over all the chunks that were assigned to this thread. */
+  for(i=0; tprm->indexs[i]!=GAL_BLANK_SIZE_T; ++i)
+    {
+      /* Set the range of this chunk. */
+      start=tprm->indexs[i]*BINFUNC_CHUNK;
+      end=start+BINFUNC_CHUNK;
+      if(end>o->size) end=o->size;
+
+      /* Apply the operator. */
+      switch(p->operator)
+        {
+        case GAL_ARITHMETIC_OP_POW:
+          BINFUNC_F_OPERATOR_SET( pow,   +0 );         break;
+        case GAL_ARITHMETIC_OP_ATAN2:
+          BINFUNC_F_OPERATOR_SET( atan2, *180.0f/M_PI ); break;
+        case GAL_ARITHMETIC_OP_SB_TO_MAG:
+          BINFUNC_F_OPERATOR_SET( gal_units_sb_to_mag, +0 ); break;
+        case GAL_ARITHMETIC_OP_MAG_TO_SB:
+          BINFUNC_F_OPERATOR_SET( gal_units_mag_to_sb, +0 ); break;
+        case GAL_ARITHMETIC_OP_COUNTS_TO_MAG:
+          BINFUNC_F_OPERATOR_SET( gal_units_counts_to_mag, +0 ); break;
+        case GAL_ARITHMETIC_OP_MAG_TO_COUNTS:
+          BINFUNC_F_OPERATOR_SET( gal_units_mag_to_counts, +0 ); break;
+        case GAL_ARITHMETIC_OP_COUNTS_TO_JY:
+          BINFUNC_F_OPERATOR_SET( gal_units_counts_to_jy, +0 ); break;
+        case GAL_ARITHMETIC_OP_JY_TO_COUNTS:
+          BINFUNC_F_OPERATOR_SET( gal_units_jy_to_counts, +0 ); break;
+        case GAL_ARITHMETIC_OP_COUNTS_TO_NANOMAGGY:
+          BINFUNC_F_OPERATOR_SET( gal_units_counts_to_nanomaggy, +0 );
+          break;
+        case GAL_ARITHMETIC_OP_NANOMAGGY_TO_COUNTS:
+          BINFUNC_F_OPERATOR_SET( gal_units_nanomaggy_to_counts, +0 );
+          break;
+        default:
+          error(EXIT_FAILURE, 0, "%s: operator code %d not recognized",
+                __func__, p->operator);
+        }
+    }
+
+  /* Wait for all the other threads to finish, then return. */
+  if(tprm->b) pthread_barrier_wait(tprm->b);
+  return NULL;
+}
+
+
+
+
+
 static gal_data_t *
 arithmetic_function_binary_flt(int operator, int flags, gal_data_t *il,
-                               gal_data_t *ir)
+                               gal_data_t *ir, size_t numthreads)
 {
   int final_otype;
+  struct binfuncparams p;
   size_t out_size, minmapsize;
   gal_data_t *l, *r, *o=NULL;
   int quietmmap=il->quietmmap && ir->quietmmap;
@@ -2435,33 +2819,15 @@ arithmetic_function_binary_flt(int operator, int flags, gal_data_t *il,
                        quietmmap, NULL, NULL, NULL);
 
 
-  /* Start setting the operator and operands. */
-  switch(operator)
-    {
-    case GAL_ARITHMETIC_OP_POW:
-      BINFUNC_F_OPERATOR_SET( pow,   +0 );         break;
-    case GAL_ARITHMETIC_OP_ATAN2:
-      BINFUNC_F_OPERATOR_SET( atan2, *180.0f/M_PI ); break;
-    case GAL_ARITHMETIC_OP_SB_TO_MAG:
-      BINFUNC_F_OPERATOR_SET( gal_units_sb_to_mag, +0 ); break;
-    case GAL_ARITHMETIC_OP_MAG_TO_SB:
-      BINFUNC_F_OPERATOR_SET( gal_units_mag_to_sb, +0 ); break;
-    case GAL_ARITHMETIC_OP_COUNTS_TO_MAG:
-      BINFUNC_F_OPERATOR_SET( gal_units_counts_to_mag, +0 ); break;
-    case GAL_ARITHMETIC_OP_MAG_TO_COUNTS:
-      BINFUNC_F_OPERATOR_SET( gal_units_mag_to_counts, +0 ); break;
-    case GAL_ARITHMETIC_OP_COUNTS_TO_JY:
-      BINFUNC_F_OPERATOR_SET( gal_units_counts_to_jy, +0 ); break;
-    case GAL_ARITHMETIC_OP_JY_TO_COUNTS:
-      BINFUNC_F_OPERATOR_SET( gal_units_jy_to_counts, +0 ); break;
-    case GAL_ARITHMETIC_OP_COUNTS_TO_NANOMAGGY:
-      BINFUNC_F_OPERATOR_SET( gal_units_counts_to_nanomaggy, +0 ); break;
-    case GAL_ARITHMETIC_OP_NANOMAGGY_TO_COUNTS:
-      BINFUNC_F_OPERATOR_SET( gal_units_nanomaggy_to_counts, +0 ); break;
-    default:
-      error(EXIT_FAILURE, 0, "%s: operator code %d not recognized",
-            __func__, operator);
-    }
+  /* Apply the operator over chunks of the output with multiple
+     threads. */
+  p.l=l;
+  p.r=r;
+  p.o=o;
+  p.operator=operator;
+  gal_threads_spin_off(binfunc_on_thread, &p,
+                       1+(o->size-1)/BINFUNC_CHUNK, numthreads,
+                       minmapsize, quietmmap);
 
 
   /* Clean up. Note that if the input arrays can be freed, and any of right
@@ -2508,7 +2874,8 @@ arithmetic_function_binary_flt(int operator, int flags, gal_data_t *il,
      d3: Area.      */
 static gal_data_t *
 arithmetic_counts_to_from_sb(int operator, int flags, gal_data_t *d1,
-                             gal_data_t *d2, gal_data_t *d3)
+                             gal_data_t *d2, gal_data_t *d3,
+                             size_t numthreads)
 {
   gal_data_t *tmp, *out=NULL;
 
@@ -2516,16 +2883,20 @@ arithmetic_counts_to_from_sb(int operator, int flags, gal_data_t *d1,
     {
     case GAL_ARITHMETIC_OP_COUNTS_TO_SB:
       tmp=arithmetic_function_binary_flt(GAL_ARITHMETIC_OP_COUNTS_TO_MAG,
-                                         flags, d1, d2); /* d2=zeropoint */
+                                         flags, d1, d2,
+                                         numthreads); /* d2=zeropoint */
       out=arithmetic_function_binary_flt(GAL_ARITHMETIC_OP_MAG_TO_SB,
-                                         flags, tmp, d3); /* d3=area */
+                                         flags, tmp, d3,
+                                         numthreads); /* d3=area */
       break;
 
     case GAL_ARITHMETIC_OP_SB_TO_COUNTS:
       tmp=arithmetic_function_binary_flt(GAL_ARITHMETIC_OP_SB_TO_MAG,
-                                         flags, d1, d3); /* d3-->area */
+                                         flags, d1, d3,
+                                         numthreads); /* d3-->area */
       out=arithmetic_function_binary_flt(GAL_ARITHMETIC_OP_MAG_TO_COUNTS,
-                                         flags, tmp, d2); /* d2=zeropoint */
+                                         flags, tmp, d2,
+                                         numthreads); /* d2=zeropoint */
       break;
 
     default:
@@ -2542,6 +2913,107 @@ arithmetic_counts_to_from_sb(int operator, int flags, gal_data_t *d1,
 
 
 
+/* Read the single value of a cosmological parameter. */
+static double
+arithmetic_cosmology_param(gal_data_t *data, int operator, char *name)
+{
+  double out;
+  gal_data_t *tmp;
+
+  /* Sanity check. */
+  if(data->size!=1)
+    error(EXIT_FAILURE, 0, "%s: the '%s' operand (cosmological "
+          "parameter) should only contain a single number, but it has "
+          "%zu elements", gal_arithmetic_operator_string(operator),
+          name, data->size);
+
+  /* Read the value as double precision floating point. */
+  tmp=gal_data_copy_to_new_type(data, GAL_TYPE_FLOAT64);
+  out=((double *)(tmp->array))[0];
+  gal_data_free(tmp);
+  return out;
+}
+
+
+
+
+
+/* Absolute values of the implied radiation density that are smaller than
+   this are floating point round-off (see 'arithmetic_cosmology'). */
+#define ARITHMETIC_COSMOLOGY_ROUNDOFF 1e-8
+
+/* The list of arguments are:
+     d1: Redshift.
+     d2: Hubble constant (km/sec/Mpc) at z=0.
+     d3: Cosmological constant fractional density at z=0.
+     d4: Matter fractional density at z=0.
+
+   The radiation fractional density is implied from the fact that the sum
+   of the three fractional densities must be one (this is also checked in
+   the cosmology library). For flat cosmologies without radiation, the
+   subtraction can round to a very small negative number (for example
+   1-0.6911-0.3089 is -5.55e-17), which the cosmology library would
+   reject. So such round-off residuals are set to zero. */
+static gal_data_t *
+arithmetic_cosmology(int operator, int flags, gal_data_t *d1,
+                     gal_data_t *d2, gal_data_t *d3, gal_data_t *d4,
+                     size_t numthreads)
+{
+  gal_data_t *out;
+  int quantity=GAL_COSMOLOGY_INVALID;
+  double H0, olambda, omatter, oradiation;
+
+  /* Read the cosmological parameters. */
+  H0=arithmetic_cosmology_param(d2, operator, "H0");
+  olambda=arithmetic_cosmology_param(d3, operator, "olambda");
+  omatter=arithmetic_cosmology_param(d4, operator, "omatter");
+  oradiation=1.0-olambda-omatter;
+  if( fabs(oradiation) < ARITHMETIC_COSMOLOGY_ROUNDOFF ) oradiation=0.0;
+
+  /* Set the desired quantity. */
+  switch(operator)
+    {
+    case GAL_ARITHMETIC_OP_Z_TO_AGE:
+      quantity=GAL_COSMOLOGY_AGE;                 break;
+    case GAL_ARITHMETIC_OP_Z_TO_PROPER_DISTANCE:
+      quantity=GAL_COSMOLOGY_PROPER_DISTANCE;     break;
+    case GAL_ARITHMETIC_OP_Z_TO_ANGULAR_DISTANCE:
+      quantity=GAL_COSMOLOGY_ANGULAR_DISTANCE;    break;
+    case GAL_ARITHMETIC_OP_Z_TO_LUMINOSITY_DISTANCE:
+      quantity=GAL_COSMOLOGY_LUMINOSITY_DISTANCE; break;
+    case GAL_ARITHMETIC_OP_Z_TO_DISTANCE_MODULUS:
+      quantity=GAL_COSMOLOGY_DISTANCE_MODULUS;    break;
+    case GAL_ARITHMETIC_OP_Z_TO_ABSMAG_CONV:
+      quantity=GAL_COSMOLOGY_TO_ABSOLUTE_MAG;     break;
+    case GAL_ARITHMETIC_OP_Z_TO_COMOVING_VOLUME:
+      quantity=GAL_COSMOLOGY_COMOVING_VOLUME;     break;
+    case GAL_ARITHMETIC_OP_Z_TO_CRITICAL_DENSITY:
+      quantity=GAL_COSMOLOGY_CRITICAL_DENSITY;    break;
+    default:
+      error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at '%s' to "
+            "fix the problem. The code '%d' is not a recognized "
+            "operator for this function", __func__, PACKAGE_BUGREPORT,
+            operator);
+    }
+
+  /* Do the calculation (the cosmology library will build the integral
+     table once and evaluate it on all elements in parallel). */
+  out=gal_cosmology_array(d1, quantity, H0, olambda, omatter, oradiation,
+                          numthreads);
+
+  /* Clean up and return. */
+  if(flags & GAL_ARITHMETIC_FLAG_FREE)
+    {
+      gal_data_free(d1); gal_data_free(d2);
+      gal_data_free(d3); gal_data_free(d4);
+    }
+  return out;
+}
+
+
+
+
+
 static gal_data_t *
 arithmetic_box_around_ellipse(gal_data_t *a_data, gal_data_t *b_data,
                               gal_data_t *pa_data, int flags)
@@ -3236,6 +3708,24 @@ gal_arithmetic_set_operator(char *string, size_t *num_operands)
   else if( !strcmp(string, "au-to-ly"))
     { op=GAL_ARITHMETIC_OP_AU_TO_LY;          *num_operands=1;  }
 
+  /* Cosmological operators. */
+  else if( !strcmp(string, "z-to-age"))
+    { op=GAL_ARITHMETIC_OP_Z_TO_AGE;          *num_operands=4;  }
+  else if( !strcmp(string, "z-to-proper-distance"))
+    { op=GAL_ARITHMETIC_OP_Z_TO_PROPER_DISTANCE; *num_operands=4; }
+  else if( !strcmp(string, "z-to-angular-distance"))
+    { op=GAL_ARITHMETIC_OP_Z_TO_ANGULAR_DISTANCE; *num_operands=4; }
+  else if( !strcmp(string, "z-to-luminosity-distance"))
+    { op=GAL_ARITHMETIC_OP_Z_TO_LUMINOSITY_DISTANCE; *num_operands=4; }
+  else if( !strcmp(string, "z-to-distance-modulus"))
+    { op=GAL_ARITHMETIC_OP_Z_TO_DISTANCE_MODULUS; *num_operands=4; }
+  else if( !strcmp(string, "z-to-absmag-conv"))
+    { op=GAL_ARITHMETIC_OP_Z_TO_ABSMAG_CONV;  *num_operands=4;  }
+  else if( !strcmp(string, "z-to-comoving-volume"))
+    { op=GAL_ARITHMETIC_OP_Z_TO_COMOVING_VOLUME; *num_operands=4; }
+  else if( !strcmp(string, "z-to-critical-density"))
+    { op=GAL_ARITHMETIC_OP_Z_TO_CRITICAL_DENSITY; *num_operands=4; }
+
   /* Statistical/higher-level operators. */
   else if (!strcmp(string, "minvalue"))
     { op=GAL_ARITHMETIC_OP_MINVAL;            *num_operands=1;  }
@@ -3500,6 +3990,15 @@ gal_arithmetic_operator_string(int operator)
     case GAL_ARITHMETIC_OP_LY_TO_AU:        return "ly-to-au";
     case GAL_ARITHMETIC_OP_AU_TO_LY:        return "au-to-ly";
 
+    case GAL_ARITHMETIC_OP_Z_TO_AGE:        return "z-to-age";
+    case GAL_ARITHMETIC_OP_Z_TO_PROPER_DISTANCE: return "z-to-proper-distance";
+    case GAL_ARITHMETIC_OP_Z_TO_ANGULAR_DISTANCE: return "z-to-angular-distance";
+    case GAL_ARITHMETIC_OP_Z_TO_LUMINOSITY_DISTANCE: return "z-to-luminosity-distance";
+    case GAL_ARITHMETIC_OP_Z_TO_DISTANCE_MODULUS: return "z-to-distance-modulus";
+    case GAL_ARITHMETIC_OP_Z_TO_ABSMAG_CONV: return "z-to-absmag-conv";
+    case GAL_ARITHMETIC_OP_Z_TO_COMOVING_VOLUME: return "z-to-comoving-volume";
+    case GAL_ARITHMETIC_OP_Z_TO_CRITICAL_DENSITY: return "z-to-critical-density";
+
     case GAL_ARITHMETIC_OP_MINVAL:          return "minvalue";
     case GAL_ARITHMETIC_OP_MAXVAL:          return "maxvalue";
     case GAL_ARITHMETIC_OP_NUMBERVAL:       return "numbervalue";
@@ -3656,12 +4155,17 @@ gal_arithmetic(int operator, size_t numthreads, int flags, ...)
     case GAL_ARITHMETIC_OP_AU_TO_LY:
     case GAL_ARITHMETIC_OP_MAG_TO_JY:
     case GAL_ARITHMETIC_OP_JY_TO_MAG:
+      d1 = va_arg(va, gal_data_t *);
+      out=arithmetic_function_unary(operator, flags, d1);
+      break;
+
+    /* Sexagesimal conversion of full columns. */
     case GAL_ARITHMETIC_OP_RA_TO_DEGREE:
     case GAL_ARITHMETIC_OP_DEC_TO_DEGREE:
     case GAL_ARITHMETIC_OP_DEGREE_TO_RA:
     case GAL_ARITHMETIC_OP_DEGREE_TO_DEC:
       d1 = va_arg(va, gal_data_t *);
-      out=arithmetic_function_unary(operator, flags, d1);
+      out=arithmetic_sexagesimal(operator, flags, d1, numthreads);
       break;
 
     /* Binary function operators. */
@@ -3677,7 +4181,8 @@ gal_arithmetic(int operator, size_t numthreads, int flags, ...)
     case GAL_ARITHMETIC_OP_COUNTS_TO_NANOMAGGY:
       d1 = va_arg(va, gal_data_t *);
       d2 = va_arg(va, gal_data_t *);
-      out=arithmetic_function_binary_flt(operator, flags, d1, d2);
+      out=arithmetic_function_binary_flt(operator, flags, d1, d2,
+                                         numthreads);
       break;
 
     /* More complex operators. */
@@ -3686,10 +4191,28 @@ gal_arithmetic(int operator, size_t numthreads, int flags, ...)
       d1 = va_arg(va, gal_data_t *);
       d2 = va_arg(va, gal_data_t *);
       d3 = va_arg(va, gal_data_t *);
-      out=arithmetic_counts_to_from_sb(operator, flags, d1, d2, d3);
+      out=arithmetic_counts_to_from_sb(operator, flags, d1, d2, d3,
+                                       numthreads);
 
       break;
 
+    /* Cosmological operators. */
+    case GAL_ARITHMETIC_OP_Z_TO_AGE:
+    case GAL_ARITHMETIC_OP_Z_TO_PROPER_DISTANCE:
+    case GAL_ARITHMETIC_OP_Z_TO_ANGULAR_DISTANCE:
+    case GAL_ARITHMETIC_OP_Z_TO_LUMINOSITY_DISTANCE:
+    case GAL_ARITHMETIC_OP_Z_TO_DISTANCE_MODULUS:
+    case GAL_ARITHMETIC_OP_Z_TO_ABSMAG_CONV:
+    case GAL_ARITHMETIC_OP_Z_TO_COMOVING_VOLUME:
+    case GAL_ARITHMETIC_OP_Z_TO_CRITICAL_DENSITY:
+      d1 = va_arg(va, gal_data_t *);
+      d2 = va_arg(va, gal_data_t *);
+      d3 = va_arg(va, gal_data_t *);
+      d4 = va_arg(va, gal_data_t *);
+      out=arithmetic_cosmology(operator, flags, d1, d2, d3, d4,
+                               numthreads);
+      break;
+
     /* Statistical operators that return one value. */
     case GAL_ARITHMETIC_OP_MINVAL:
     case GAL_ARITHMETIC_OP_MAXVAL:
@@ -3730,7 +4253,8 @@ gal_arithmetic(int operator, size_t numthreads, int flags, ...)
     case GAL_ARITHMETIC_OP_SIGCLIP_NUMBER:
       d1 = va_arg(va, gal_data_t *);
       d2 = va_arg(va, gal_data_t *);
-      out=arithmetic_multioperand(operator, flags, d1, d2, numthreads);
+      out=arithmetic_multioperand(operator, flags, d1, d2, numthreads,
+                                    NULL, NULL);
       break;
 
     /* Binary operators that only work on integer types. */
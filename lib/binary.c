@@ -35,6 +35,8 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <gnuastro/pointer.h>
 #include <gnuastro/dimension.h>
 
+#include <gnuastro-internal/timing.h>
+
 
 
 
@@ -504,6 +506,7 @@ gal_binary_connected_components(gal_data_t *binary, gal_data_t **out,
   if(binary->block)
     error(EXIT_FAILURE, 0, "%s: currently, the input data structure to "
           "must not be a tile", __func__);
+  gal_timing_trace_begin("binary: connected components");
 
 
   /* Prepare the dataset for the labels. */
@@ -586,6 +589,7 @@ gal_binary_connected_components(gal_data_t *binary, gal_data_t **out,
 
   /* Clean up and return the total number. */
   free(dinc);
+  gal_timing_trace_end("binary: connected components");
   return curlab-1;
 }
 
@@ -916,7 +920,7 @@ binary_make_padded_inverse(gal_data_t *input, gal_data_t **outtile)
 
 
   /* Put the input's flags into the inverted array and the tile. */
-  inv->flag = tile->flag = input->flag;
+  inv->flag = tile->flag = input->flag & ~GAL_DATA_FLAG_FOREIGN;
 
 
   /* Fill the central regions. */
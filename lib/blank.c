@@ -31,6 +31,7 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 
 #include <gnuastro/data.h>
 #include <gnuastro/tile.h>
+#include <gnuastro/type.h>
 #include <gnuastro/blank.h>
 #include <gnuastro/pointer.h>
 #include <gnuastro/statistics.h>
@@ -731,25 +732,86 @@ gal_blank_flag_apply(gal_data_t *input, gal_data_t *flag)
 
 
 
+/* Return the spans of zero-valued elements in 'flag' (the elements to
+   keep when removing the flagged elements): two elements for each span,
+   the index of its first element and the number of elements in it. The
+   number of spans is written in 'nspans'. */
+static size_t *
+blank_flag_spans(gal_data_t *flag, size_t *nspans)
+{
+  int pass;
+  size_t *spans=NULL;
+  uint8_t *f, *s, *st=flag->array, *ff=st+flag->size;
+
+  /* In the first pass, only count the spans, in the second, fill them. */
+  for(pass=0;pass<2;++pass)
+    {
+      *nspans=0;
+      for(f=st; f<ff; )
+        {
+          while(f<ff && *f) ++f;
+          s=f; while(f<ff && *f==0) ++f;
+          if(f>s)
+            {
+              if(spans)
+                { spans[2 * *nspans]=s-st; spans[2 * *nspans + 1]=f-s; }
+              ++*nspans;
+            }
+        }
+
+      /* Allocate the spans for the second pass. */
+      if(pass==0)
+        {
+          if(*nspans==0) break;
+          spans=gal_pointer_allocate(GAL_TYPE_SIZE_T, 2 * *nspans, 0,
+                                     __func__, "spans");
+        }
+    }
+  return spans;
+}
+
+
+
+
+
+/* Move the given spans of a numeric dataset to its start. Each span
+   element is 'nelem' elements of the dataset (for example a row of a
+   multi-dimensional column). The returned value is the number of kept
+   span elements. */
+static size_t
+blank_spans_apply(gal_data_t *input, size_t *spans, size_t nspans,
+                  size_t nelem)
+{
+  size_t i, o=0;
+  char *a=input->array;
+  size_t width=nelem*gal_type_sizeof(input->type);
+
+  /* Move each span to its final place (if necessary). */
+  for(i=0;i<nspans;++i)
+    {
+      if(o!=spans[2*i])
+        memmove(a+o*width, a+spans[2*i]*width, spans[2*i+1]*width);
+      o+=spans[2*i+1];
+    }
+  return o;
+}
+
+
+
+
+
 /* Remove flagged elements from a dataset (which may not necessarily
    blank), convert it to a 1D dataset and adjust the size properly. In
    practice this function doesn't 'realloc' the input array, all it does is
    to shift the blank eleemnts to the end and adjust the size elements of
-   the 'gal_data_t'. */
-#define BLANK_FLAG_REMOVE(IT) {                                         \
-    IT *a=input->array, *af=a+input->size, *o=input->array;             \
-    do {                                                                \
-      if(*f==0) {++num; *o++=*a; }                                      \
-      ++f;                                                              \
-    }                                                                   \
-    while(++a<af);                                                      \
-  }
+   the 'gal_data_t'. For numeric types, the contiguous spans of elements
+   to keep are moved as a whole. */
 void
 gal_blank_flag_remove(gal_data_t *input, gal_data_t *flag)
 {
   char **strarr;
-  size_t i, num=0;
   uint8_t *f=flag->array;
+  size_t i, *spans, nspans, num=0;
 
   /* Sanity check. */
   if(flag->type!=GAL_TYPE_UINT8)
@@ -768,16 +830,20 @@ gal_blank_flag_remove(gal_data_t *input, gal_data_t *flag)
   /* Shift all non-blank elements to the start of the array. */
   switch(input->type)
     {
-    case GAL_TYPE_UINT8:    BLANK_FLAG_REMOVE( uint8_t  );    break;
-    case GAL_TYPE_INT8:     BLANK_FLAG_REMOVE( int8_t   );    break;
-    case GAL_TYPE_UINT16:   BLANK_FLAG_REMOVE( uint16_t );    break;
-    case GAL_TYPE_INT16:    BLANK_FLAG_REMOVE( int16_t  );    break;
-    case GAL_TYPE_UINT32:   BLANK_FLAG_REMOVE( uint32_t );    break;
-    case GAL_TYPE_INT32:    BLANK_FLAG_REMOVE( int32_t  );    break;
-    case GAL_TYPE_UINT64:   BLANK_FLAG_REMOVE( uint64_t );    break;
-    case GAL_TYPE_INT64:    BLANK_FLAG_REMOVE( int64_t  );    break;
-    case GAL_TYPE_FLOAT32:  BLANK_FLAG_REMOVE( float    );    break;
-    case GAL_TYPE_FLOAT64:  BLANK_FLAG_REMOVE( double   );    break;
+    case GAL_TYPE_UINT8:
+    case GAL_TYPE_INT8:
+    case GAL_TYPE_UINT16:
+    case GAL_TYPE_INT16:
+    case GAL_TYPE_UINT32:
+    case GAL_TYPE_INT32:
+    case GAL_TYPE_UINT64:
+    case GAL_TYPE_INT64:
+    case GAL_TYPE_FLOAT32:
+    case GAL_TYPE_FLOAT64:
+      spans=blank_flag_spans(flag, &nspans);
+      num=blank_spans_apply(input, spans, nspans, 1);
+      if(spans) free(spans);
+      break;
     case GAL_TYPE_STRING:
       strarr=input->array;
       for(i=0;i<input->size;++i)
@@ -886,18 +952,154 @@ blank_flag_remove_dim0(gal_data_t *input, gal_data_t *flag)
 
 
 
+/* Parse the contiguous runs (spans) of non-blank elements in a contiguous
+   numeric dataset. Within each span there is no blank, so instead of
+   checking and copying every element (with a branch per element), the
+   start and end of each span are found in tight loops and the whole span
+   is processed at once. When there are no (or few) blank elements, or
+   when they are clustered (like masked regions of an image), the number
+   of spans is much smaller than the number of elements.
+
+   If 'spans!=NULL', the starting index and number of elements in each
+   span will be written in it (it should have space for two times the
+   number of spans). If 'remove!=0', all the non-blank spans will be moved
+   to the start of the array (with 'memmove' and only if necessary). The
+   returned value is the number of spans, or (if 'remove!=0') the number
+   of non-blank elements. */
+#define BLANK_SPANS(IT) {                                               \
+    IT b, *s, *st=input->array, *a=st, *af=a+input->size, *o=st;        \
+    gal_blank_write(&b, input->type);                                   \
+    while(a<af)                                                         \
+      {                                                                 \
+        /* Skip the blank elements and find the end of the span. If */  \
+        /* the blank is NaN, it will fail any comparison.           */  \
+        if(b==b)                                                        \
+          {                                                             \
+            while(a<af && *a==b) ++a;                                   \
+            s=a; while(a<af && *a!=b) ++a;                              \
+          }                                                             \
+        else                                                            \
+          {                                                             \
+            while(a<af && *a!=*a) ++a;                                  \
+            s=a; while(a<af && *a==*a) ++a;                             \
+          }                                                             \
+                                                                        \
+        /* Use this span. */                                            \
+        if(a>s)                                                         \
+          {                                                             \
+            if(spans)                                                   \
+              { spans[2*out]=s-st; spans[2*out+1]=a-s; }                \
+            if(remove)                                                  \
+              {                                                         \
+                if(o!=s) memmove(o, s, (a-s)*sizeof *s);                \
+                o+=a-s;                                                 \
+              }                                                         \
+            ++out;                                                      \
+          }                                                             \
+      }                                                                 \
+    if(remove) out=o-st;                                                \
+  }
+static size_t
+blank_spans(gal_data_t *input, size_t *spans, int remove)
+{
+  size_t out=0;
+
+  /* Parse the dataset. */
+  switch(input->type)
+    {
+    case GAL_TYPE_UINT8:    BLANK_SPANS( uint8_t  );    break;
+    case GAL_TYPE_INT8:     BLANK_SPANS( int8_t   );    break;
+    case GAL_TYPE_UINT16:   BLANK_SPANS( uint16_t );    break;
+    case GAL_TYPE_INT16:    BLANK_SPANS( int16_t  );    break;
+    case GAL_TYPE_UINT32:   BLANK_SPANS( uint32_t );    break;
+    case GAL_TYPE_INT32:    BLANK_SPANS( int32_t  );    break;
+    case GAL_TYPE_UINT64:   BLANK_SPANS( uint64_t );    break;
+    case GAL_TYPE_INT64:    BLANK_SPANS( int64_t  );    break;
+    case GAL_TYPE_FLOAT32:  BLANK_SPANS( float    );    break;
+    case GAL_TYPE_FLOAT64:  BLANK_SPANS( double   );    break;
+    default:
+      error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at %s to fix "
+            "the problem. Type code %d is not recognized", __func__,
+            PACKAGE_BUGREPORT, input->type);
+    }
+
+  /* Return the number of spans (or non-blank elements). */
+  return out;
+}
+
+
+
+
+
+/* Return the contiguous spans of non-blank elements in a contiguous
+   numeric dataset (not a tile). The output has a 'size_t' type and two
+   elements for each span: the index of the span's first element and the
+   number of elements in it (so it has 'ndim=1' and an even size). When
+   the dataset has no blank values, the output will have a single span
+   covering the whole dataset (without parsing the dataset if its flags
+   already show that), and when all the elements are blank, the output
+   will have zero elements. If 'updateflag' is non-zero, the blank flags
+   of the input will also be updated (the whole dataset has to be parsed
+   in any case). */
+gal_data_t *
+gal_blank_spans(gal_data_t *input, int updateflag)
+{
+  size_t *spans, num;
+  gal_data_t *out;
+
+  /* Sanity checks. */
+  if(input->block)
+    error(EXIT_FAILURE, 0, "%s: tiles are not supported", __func__);
+  if( !( gal_type_is_int(input->type)
+         || input->type==GAL_TYPE_FLOAT32
+         || input->type==GAL_TYPE_FLOAT64 ) )
+    error(EXIT_FAILURE, 0, "%s: type '%s' is not supported", __func__,
+          gal_type_name(input->type, 1));
+
+  /* If it is already known that the dataset has no blank values, there
+     is no need to parse it. */
+  if( (input->flag & GAL_DATA_FLAG_BLANK_CH)
+      && !(input->flag & GAL_DATA_FLAG_HASBLANK) )
+    {
+      num = input->size ? 2 : 0;
+      out=gal_data_alloc(NULL, GAL_TYPE_SIZE_T, 1, &num, NULL, 0, -1, 1,
+                         NULL, NULL, NULL);
+      if(num) { spans=out->array; spans[0]=0; spans[1]=input->size; }
+      return out;
+    }
+
+  /* Count the spans, allocate the output and fill it. */
+  num = 2 * blank_spans(input, NULL, 0);
+  out=gal_data_alloc(NULL, GAL_TYPE_SIZE_T, 1, &num, NULL, 0,
+                     input->minmapsize, input->quietmmap, NULL, NULL, NULL);
+  if(num) blank_spans(input, out->array, 0);
+
+  /* Update the flags if requested: there are no blank values only when
+     there is a single span over the whole dataset (an empty dataset
+     doesn't have any blanks either). */
+  if(updateflag)
+    {
+      spans=out->array;
+      input->flag |= GAL_DATA_FLAG_BLANK_CH;
+      if( input->size==0 || (num==2 && spans[1]==input->size) )
+        input->flag &= ~GAL_DATA_FLAG_HASBLANK;
+      else
+        input->flag |= GAL_DATA_FLAG_HASBLANK;
+    }
+
+  /* Return the output. */
+  return out;
+}
+
+
+
+
+
 /* Remove blank elements from a dataset, convert it to a 1D dataset and
    adjust the size properly. In practice this function doesn't 'realloc'
    the input array, all it does is to shift the blank eleemnts to the end
-   and adjust the size elements of the 'gal_data_t'. */
-#define BLANK_REMOVE(IT) {                                              \
-    IT b, *a=input->array, *af=a+input->size, *o=input->array;          \
-    gal_blank_write(&b, input->type);                                   \
-    if(b==b)       /* Blank value can be be checked with equal. */      \
-      do if(*a!=b)  { ++num; *o++=*a; } while(++a<af);                  \
-    else           /* Blank value will fail on equal comparison. */     \
-      do if(*a==*a) { ++num; *o++=*a; } while(++a<af);                  \
-  }
+   and adjust the size elements of the 'gal_data_t'. For numeric types,
+   the non-blank spans are moved as a whole (see 'blank_spans'). */
 void
 gal_blank_remove(gal_data_t *input)
 {
@@ -916,16 +1118,18 @@ gal_blank_remove(gal_data_t *input)
       /* Shift all non-blank elements to the start of the array. */
       switch(input->type)
         {
-        case GAL_TYPE_UINT8:    BLANK_REMOVE( uint8_t  );    break;
-        case GAL_TYPE_INT8:     BLANK_REMOVE( int8_t   );    break;
-        case GAL_TYPE_UINT16:   BLANK_REMOVE( uint16_t );    break;
-        case GAL_TYPE_INT16:    BLANK_REMOVE( int16_t  );    break;
-        case GAL_TYPE_UINT32:   BLANK_REMOVE( uint32_t );    break;
-        case GAL_TYPE_INT32:    BLANK_REMOVE( int32_t  );    break;
-        case GAL_TYPE_UINT64:   BLANK_REMOVE( uint64_t );    break;
-        case GAL_TYPE_INT64:    BLANK_REMOVE( int64_t  );    break;
-        case GAL_TYPE_FLOAT32:  BLANK_REMOVE( float    );    break;
-        case GAL_TYPE_FLOAT64:  BLANK_REMOVE( double   );    break;
+        case GAL_TYPE_UINT8:
+        case GAL_TYPE_INT8:
+        case GAL_TYPE_UINT16:
+        case GAL_TYPE_INT16:
+        case GAL_TYPE_UINT32:
+        case GAL_TYPE_INT32:
+        case GAL_TYPE_UINT64:
+        case GAL_TYPE_INT64:
+        case GAL_TYPE_FLOAT32:
+        case GAL_TYPE_FLOAT64:
+          num=blank_spans(input, NULL, 1);
+          break;
         case GAL_TYPE_STRING:
           strarr=input->array;
           for(i=0;i<input->size;++i)
@@ -972,6 +1176,15 @@ gal_blank_remove_realloc(gal_data_t *input)
 
 
 
+/* Add the blank elements of this column into the flag: for numeric
+   columns, this is done directly in the (shared) flag without allocating
+   a separate flag for each column. */
+#define BLANK_FLAG_MERGE(IT) {                                          \
+    IT b, *a=thisdata->array;                                           \
+    gal_blank_write(&b, thisdata->type);                                \
+    if(b==b) for(i=0;i<flag->size;++i) u[i] |= a[i]==b;                 \
+    else     for(i=0;i<flag->size;++i) u[i] |= a[i]!=a[i];              \
+  }
 static gal_data_t *
 blank_remove_in_list_merge_flags(gal_data_t *thisdata, gal_data_t *flag,
                                  int onlydim0)
@@ -983,34 +1196,46 @@ blank_remove_in_list_merge_flags(gal_data_t *thisdata, gal_data_t *flag,
 
   /* Ignore the dataset if it has more than one dimension and 'onlydim0' is
      called*/
-  if(onlydim0 && thisdata->ndim>1 && warningprinted==0)
+  if(onlydim0 && thisdata->ndim>1)
     {
-      warningprinted=1;
-      error(EXIT_SUCCESS, 0, "%s: WARNING: multi-dimensional columns "
-            "are not supported when 'onlydim0' is non-zero", __func__);
-      return NULL;
+      if(warningprinted==0)
+        {
+          warningprinted=1;
+          error(EXIT_SUCCESS, 0, "%s: WARNING: multi-dimensional columns "
+                "are not supported when 'onlydim0' is non-zero", __func__);
+        }
+      return flag;
     }
 
-  /* Build the flag of blank elements for this column. */
-  flagtmp=gal_blank_flag(thisdata);
+  /* If this is the first column, allocate the flag (with the same size as
+     this column). */
+  if(flag==NULL)
+    flag=gal_data_alloc(NULL, GAL_TYPE_UINT8, thisdata->ndim,
+                        thisdata->dsize, NULL, 1, thisdata->minmapsize,
+                        thisdata->quietmmap, NULL, NULL, NULL);
 
-  /* If this is the first column, then use flagtmp as flag. */
-  if(flag)
+  /* Add the blank elements of this column to the flag. */
+  u=flag->array;
+  switch(thisdata->type)
     {
-      u=flag->array;
+    case GAL_TYPE_UINT8:    BLANK_FLAG_MERGE( uint8_t  );    break;
+    case GAL_TYPE_INT8:     BLANK_FLAG_MERGE( int8_t   );    break;
+    case GAL_TYPE_UINT16:   BLANK_FLAG_MERGE( uint16_t );    break;
+    case GAL_TYPE_INT16:    BLANK_FLAG_MERGE( int16_t  );    break;
+    case GAL_TYPE_UINT32:   BLANK_FLAG_MERGE( uint32_t );    break;
+    case GAL_TYPE_INT32:    BLANK_FLAG_MERGE( int32_t  );    break;
+    case GAL_TYPE_UINT64:   BLANK_FLAG_MERGE( uint64_t );    break;
+    case GAL_TYPE_INT64:    BLANK_FLAG_MERGE( int64_t  );    break;
+    case GAL_TYPE_FLOAT32:  BLANK_FLAG_MERGE( float    );    break;
+    case GAL_TYPE_FLOAT64:  BLANK_FLAG_MERGE( double   );    break;
+
+    /* Other types (the checks are done in 'gal_blank_flag'). */
+    default:
+      flagtmp=gal_blank_flag(thisdata);
       tu=flagtmp->array;
       for(i=0;i<flag->size;++i) u[i] = u[i] || tu[i];
       gal_data_free(flagtmp);
     }
-  else
-    flag=flagtmp;
-
-  /* For a check.
-  u=flag->array;
-  double *d=thisdata->array;
-  for(i=0;i<flag->size;++i) printf("%f, %u\n", d[i], u[i]);
-  printf("\n");
-  */
 
   /* Return the flag dataset. */
   return flag;
@@ -1020,6 +1245,65 @@ blank_remove_in_list_merge_flags(gal_data_t *thisdata, gal_data_t *flag,
 
 
 
+/* Parameters to remove the flagged rows of all columns. */
+struct blank_remove_rows_params
+{
+  gal_data_t           *flag;  /* Flag of rows to remove.              */
+  size_t              *spans;  /* Spans of rows to keep.               */
+  size_t              nspans;  /* Number of spans.                     */
+  int               onlydim0;  /* Flag only on the first dimension.    */
+};
+
+
+
+
+
+/* Remove the flagged rows of one column. */
+static void
+blank_remove_rows_column(struct blank_remove_rows_params *rrp,
+                         gal_data_t *col)
+{
+  size_t d, num;
+
+  /* Strings need to be freed, so they are done separately. */
+  if(col->type==GAL_TYPE_STRING)
+    {
+      if(col->ndim==1 || rrp->onlydim0==0)
+        gal_blank_flag_remove(col, rrp->flag);
+      else
+        blank_flag_remove_dim0(col, rrp->flag);
+    }
+
+  /* Numeric columns: all the columns use the same spans, so they are
+     only found once. */
+  else
+    {
+      if(col->ndim==1 || rrp->onlydim0==0)
+        {
+          if(gal_dimension_is_different(col, rrp->flag))
+            error(EXIT_FAILURE, 0, "%s: the flag doesn't have the same "
+                  "size as the column", __func__);
+          num=blank_spans_apply(col, rrp->spans, rrp->nspans, 1);
+          col->ndim=1;
+          col->dsize[0]=col->size=num;
+        }
+      else
+        {
+          if(col->dsize[0]!=rrp->flag->dsize[0])
+            error(EXIT_FAILURE, 0, "%s: the flag doesn't have the same "
+                  "number of rows as the column", __func__);
+          col->dsize[0]=blank_spans_apply(col, rrp->spans, rrp->nspans,
+                                          col->size/col->dsize[0]);
+          col->size=1;
+          for(d=0;d<col->ndim;++d) col->size*=col->dsize[d];
+        }
+    }
+}
+
+
+
+
+
 /* Remove any row that has a blank in any of the given columns. */
 gal_data_t *
 gal_blank_remove_rows(gal_data_t *columns, gal_list_sizet_t *column_indexs,
@@ -1028,6 +1312,7 @@ gal_blank_remove_rows(gal_data_t *columns, gal_list_sizet_t *column_indexs,
   size_t i;
   gal_list_sizet_t *tcol;
   gal_data_t *tmp, *flag=NULL;
+  struct blank_remove_rows_params rrp;
 
   /* If any columns are requested, only use the given columns for the
      flags, otherwise use all the input columns. */
@@ -1053,12 +1338,18 @@ gal_blank_remove_rows(gal_data_t *columns, gal_list_sizet_t *column_indexs,
     for(tmp=columns; tmp!=NULL; tmp=tmp->next)
       flag=blank_remove_in_list_merge_flags(tmp, flag, onlydim0);
 
-  /* Now that the flags have been set, remove the rows. */
+  /* If no column could be used for the flag, there is nothing to do. */
+  if(flag==NULL) return NULL;
+
+  /* Now that the flags have been set, find the spans of rows to keep
+     (only once for all the columns) and remove the flagged rows of all
+     the columns. */
+  rrp.flag=flag;
+  rrp.onlydim0=onlydim0;
+  rrp.spans=blank_flag_spans(flag, &rrp.nspans);
   for(tmp=columns; tmp!=NULL; tmp=tmp->next)
-    {
-      if(tmp->ndim==1 || onlydim0==0) gal_blank_flag_remove(tmp, flag);
-      else blank_flag_remove_dim0(tmp, flag);
-    }
+    blank_remove_rows_column(&rrp, tmp);
+  if(rrp.spans) free(rrp.spans);
 
   /* For a check.
   double *d1=columns->array, *d2=columns->next->array;
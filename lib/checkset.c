@@ -29,8 +29,10 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <sys/stat.h>
 #include <sys/fcntl.h>
+#include <sys/resource.h>
 
 #include <gnuastro/data.h>
 
@@ -258,6 +260,145 @@ gal_checkset_ram_available(int quietmmap)
 
 
 
+/* Resident (in RAM) size of this process in bytes. On systems with the
+   '/proc' file system, the second number in '/proc/self/statm' is the
+   number of resident pages (reading this single line is much cheaper than
+   parsing '/proc/meminfo'). If it can't be read, the maximum resident size
+   until now (from 'getrusage') is returned. */
+size_t
+gal_checkset_ram_used(void)
+{
+  FILE *file;
+  struct rusage usage;
+  unsigned long size, resident;
+
+  /* Read the resident pages. */
+  if( (file=fopen("/proc/self/statm", "r")) )
+    {
+      if( fscanf(file, "%lu %lu", &size, &resident)==2 )
+        {
+          fclose(file);
+          return resident * (size_t)sysconf(_SC_PAGESIZE);
+        }
+      fclose(file);
+    }
+
+  /* Fall-back: 'ru_maxrss' is in kilo-bytes. */
+  return getrusage(RUSAGE_SELF, &usage)==0 ? usage.ru_maxrss*1024UL : 0;
+}
+
+
+
+
+
+/* Process-wide memory budget. When 'checkset_maxmemory' is non-zero, the
+   decision to keep a large allocation in RAM is based on the resident
+   size of this process plus the requested size (compared with the
+   budget), not the RAM that is available on the whole system. This gives
+   a predictable upper limit on the memory of each program when many are
+   run in parallel on one node. */
+static size_t checkset_maxmemory=0;
+static uint8_t checkset_spillmode=GAL_CHECKSET_SPILL_FILE;
+static size_t checkset_spillnum=0, checkset_spillbytes=0;
+static pthread_mutex_t checkset_budget_mutex=PTHREAD_MUTEX_INITIALIZER;
+
+static void
+checkset_memory_report(void)
+{
+  struct rusage usage;
+  double peak=0.0f, mb=1024.0f*1024.0f;
+
+  /* 'ru_maxrss' is in kilo-bytes. */
+  if( getrusage(RUSAGE_SELF, &usage)==0 )
+    peak=usage.ru_maxrss*1024.0f;
+
+  /* Print the report. */
+  if(checkset_maxmemory)
+    error(EXIT_SUCCESS, 0, "peak memory: %.2f MB (budget: %.2f MB); "
+          "%zu allocation(s) (%.2f MB in total) did not fit in the "
+          "budget", peak/mb, checkset_maxmemory/mb, checkset_spillnum,
+          checkset_spillbytes/mb);
+  else
+    error(EXIT_SUCCESS, 0, "peak memory: %.2f MB", peak/mb);
+}
+
+
+
+
+
+/* Set the memory budget ('maxmemory==0' means there is no budget) and
+   what to do when an allocation doesn't fit in it. If 'report' is
+   non-zero, the peak memory usage will be printed when the program
+   exits. */
+void
+gal_checkset_memory_budget(size_t maxmemory, uint8_t spillmode,
+                           int report)
+{
+  checkset_maxmemory=maxmemory;
+  checkset_spillmode = ( spillmode==GAL_CHECKSET_SPILL_INVALID
+                         ? GAL_CHECKSET_SPILL_FILE
+                         : spillmode );
+  if(report) atexit(checkset_memory_report);
+}
+
+
+
+
+
+/* When there is a memory budget, decide if an allocation of 'bytesize'
+   bytes should be memory-mapped. */
+static int
+checkset_need_mmap_budget(size_t bytesize, int quietmmap)
+{
+  int needmmap=0;
+  static int noticeprinted=0;
+  size_t used=gal_checkset_ram_used();
+
+  /* If it fits, there is nothing to do. */
+  if( used + bytesize <= checkset_maxmemory ) return 0;
+
+  /* Keep the statistics for the final report (allocations can happen on
+     multiple threads). */
+  pthread_mutex_lock(&checkset_budget_mutex);
+  ++checkset_spillnum;
+  checkset_spillbytes+=bytesize;
+  pthread_mutex_unlock(&checkset_budget_mutex);
+
+  /* Act based on the requested mode. */
+  switch(checkset_spillmode)
+    {
+    case GAL_CHECKSET_SPILL_FILE: needmmap=1; break;
+    case GAL_CHECKSET_SPILL_RAM:
+      if(quietmmap==0 && noticeprinted==0)
+        {
+          noticeprinted=1;
+          error(EXIT_SUCCESS, 0, "WARNING: the memory budget (%zu bytes, "
+                "from '--maxmemory') is exceeded, but due to "
+                "'--spillmode=ram' the arrays will be allocated in RAM. "
+                "This warning is only printed once", checkset_maxmemory);
+        }
+      break;
+    case GAL_CHECKSET_SPILL_FAIL:
+      error(EXIT_FAILURE, 0, "allocating %zu bytes would exceed the "
+            "memory budget of %zu bytes (%zu bytes are already in use). "
+            "Please increase the budget with '--maxmemory', or use "
+            "'--spillmode=file' to memory-map the arrays that don't fit "
+            "into files", bytesize, checkset_maxmemory, used);
+      break;
+    default:
+      error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at %s to fix "
+            "the problem. The code %u is not a recognized spill mode",
+            __func__, PACKAGE_BUGREPORT, checkset_spillmode);
+    }
+
+  /* Return the final decision. */
+  return needmmap;
+}
+
+
+
+
+
 int
 gal_checkset_need_mmap(size_t bytesize, size_t minmapsize, int quietmmap)
 {
@@ -291,6 +432,12 @@ gal_checkset_need_mmap(size_t bytesize, size_t minmapsize, int quietmmap)
      available memory can be expensive. */
   if( bytesize >= minimumtommap )
     {
+      /* When there is a memory budget, the available RAM on the system
+         is not used. */
+      if(checkset_maxmemory)
+        return ( bytesize >= minmapsize
+                 || checkset_need_mmap_budget(bytesize, quietmmap) );
+
       /* Find the available RAM space (only relevant for Linux). */
       availableram=gal_checkset_ram_available(quietmmap);
 
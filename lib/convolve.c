@@ -35,6 +35,7 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <gnuastro/convolve.h>
 #include <gnuastro/dimension.h>
 
+#include <gnuastro-internal/timing.h>
 #include <gnuastro-internal/checkset.h>
 
 
@@ -524,7 +525,7 @@ gal_convolve_spatial_general(gal_data_t *tiles, gal_data_t *kernel,
 
       /* Spatial convolution won't change the blank bit-flag, so use the
          block structure's blank bit flag. */
-      out->flag = ( block->flag
+      out->flag = ( ( block->flag & ~GAL_DATA_FLAG_FOREIGN )
                     | ( GAL_DATA_FLAG_BLANK_CH | GAL_DATA_FLAG_HASBLANK ) );
     }
 
@@ -571,13 +572,18 @@ gal_data_t *
 gal_convolve_spatial(gal_data_t *tiles, gal_data_t *kernel,
                      size_t numthreads, int edgecorrection, int convoverch)
 {
+  gal_data_t *out;
+
   /* When there isn't any tile structure, 'convoverch' must be set to
      one. Recall that the input can be a single full dataset also. */
   if(tiles->block==NULL) convoverch=1;
 
   /* Call the general function. */
-  return gal_convolve_spatial_general(tiles, kernel, numthreads,
-                                      edgecorrection, convoverch, NULL);
+  gal_timing_trace_begin("convolve: spatial");
+  out=gal_convolve_spatial_general(tiles, kernel, numthreads,
+                                   edgecorrection, convoverch, NULL);
+  gal_timing_trace_end("convolve: spatial");
+  return out;
 }
 
 
@@ -608,6 +614,8 @@ gal_convolve_spatial_correct_ch_edge(gal_data_t *tiles, gal_data_t *kernel,
           gal_type_name(tocorrect->type, 1), gal_type_name(block->type, 1));
 
   /* Call the general function, which will do the correction. */
+  gal_timing_trace_begin("convolve: channel edges");
   gal_convolve_spatial_general(tiles, kernel, numthreads,
                                edgecorrection, 0, tocorrect);
+  gal_timing_trace_end("convolve: channel edges");
 }
@@ -25,12 +25,19 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <time.h>
 #include <errno.h>
 #include <error.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include <gsl/gsl_const_mksa.h>
 #include <gsl/gsl_integration.h>
 
+#include <gnuastro/data.h>
+#include <gnuastro/blank.h>
+#include <gnuastro/threads.h>
+#include <gnuastro/pointer.h>
+#include <gnuastro/cosmology.h>
+
 
 
 
@@ -60,6 +67,61 @@ struct cosmology_integrand_t
 
 
 
+/* For the interpolation tables (used when a cosmological quantity is
+   requested over many redshifts):
+
+   - COSMOLOGY_TABLE_EPSREL: maximum relative error of the interpolated
+       value at the middle of each interval (where the error of a cubic
+       Hermite interpolation is largest) compared to a direct integration.
+       It is an order of magnitude smaller than 'GSLIEPSREL', so the
+       tables are as precise as the single-redshift functions.
+   - COSMOLOGY_TABLE_EPSABS: absolute error floor (in the dimension-less
+       units of the integrals) to avoid infinitely refining the table
+       when the integral is very close to zero (for example around z=0).
+   - COSMOLOGY_TABLE_MININTERVALS: number of intervals in the first
+       trial of building the table. On every failed trial, the number of
+       intervals is doubled until 'COSMOLOGY_TABLE_MAXINTERVALS'.
+   - COSMOLOGY_CHUNK_SIZE: number of elements in each chunk of the input
+       that is given to each thread (in the order of the L2 cache). */
+#define COSMOLOGY_TABLE_EPSREL       1e-8
+#define COSMOLOGY_TABLE_EPSABS       1e-12
+#define COSMOLOGY_TABLE_MININTERVALS 64
+#define COSMOLOGY_TABLE_MAXINTERVALS 65536
+#define COSMOLOGY_CHUNK_SIZE         16384
+
+
+
+/* An interpolation table of an integral ('f') and its derivative ('df')
+   over equally-spaced nodes in 'x=ln(1+z)'. Using 'ln(1+z)' (instead of
+   'z') allows a single table to be precise over both low and very high
+   redshifts. Both 'f' and 'df' are with respect to 'x'. */
+struct cosmology_table
+{
+  size_t             num;   /* Number of nodes (intervals + 1).      */
+  double            xmin;   /* 'ln(1+z)' of the first node.          */
+  double              dx;   /* Spacing between nodes in 'ln(1+z)'.   */
+  double              *f;   /* Value of integral on each node.       */
+  double             *df;   /* Derivative (to 'ln(1+z)') on nodes.   */
+};
+
+
+
+/* Parameters for the multi-threaded evaluation over an array. */
+struct cosmology_array_params
+{
+  int           quantity;   /* Desired quantity ('GAL_COSMOLOGY_*').   */
+  double             *in;   /* Input redshifts (double precision).     */
+  double            *out;   /* Output array.                           */
+  size_t            size;   /* Number of elements in input/output.     */
+  size_t         nchunks;   /* Number of chunks (actions of threads).  */
+  double             H0s;   /* H0 in units of 1/seconds.               */
+  double              cH;   /* Hubble distance (c/H0) in Mpc.          */
+  struct cosmology_integrand_t   *p;  /* Cosmological parameters.      */
+  struct cosmology_table     *table;  /* Interpolation table.          */
+};
+
+
+
 
 
 
@@ -403,3 +465,403 @@ gal_cosmology_z_from_velocity(double v)
   double c=GSL_CONST_MKSA_SPEED_OF_LIGHT/1000;
   return sqrt( (c+v)/(c-v) ) - 1;
 }
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/**************************************************************/
+/************         Interpolation tables        *************/
+/**************************************************************/
+/* For the integrals that start from a fixed redshift (zero) and end on the
+   desired redshift, the tables are cumulative (the integral over each
+   interval is added to the previous node). But the age of the universe is
+   an integral from the desired redshift to infinity: in this case
+   ('toinf!=0'), the table is built from the largest redshift (its
+   integral to infinity is directly calculated), and the integral over
+   each interval is added to the next node. This avoids subtracting two
+   large numbers at high redshifts (where the age is very small). */
+static double
+cosmology_table_integrate(gsl_function *F, double zlo, double zhi,
+                          int toinf, gsl_integration_workspace *w)
+{
+  double result, error;
+
+  if(toinf)
+    gsl_integration_qagiu(F, zlo, GSLIEPSABS, GSLIEPSREL, GSLILIMIT, w,
+                          &result, &error);
+  else
+    gsl_integration_qag(F, zlo, zhi, GSLIEPSABS, GSLIEPSREL, GSLILIMIT,
+                        GSL_INTEG_GAUSS41, w, &result, &error);
+  return result;
+}
+
+
+
+
+
+/* Cubic Hermite interpolation within the table. Since the derivative on
+   each node is exactly known (it is the integrand), the interpolation is
+   fourth order and monotonic for the smooth (and positive) integrands of
+   cosmology. */
+static double
+cosmology_table_eval(struct cosmology_table *t, double z)
+{
+  size_t i;
+  double x=log1p(z), u, u2, u3;
+
+  /* Find the interval (the first and last intervals are used for any
+     redshift outside the table, but that can only happen due to floating
+     point errors because the table is built over the full range). */
+  u=(x - t->xmin)/t->dx;
+  if(u<0) u=0;
+  i = u>=t->num-1 ? t->num-2 : (size_t)u;
+  u-=i;
+
+  /* Return the cubic Hermite interpolation. */
+  u2=u*u; u3=u2*u;
+  return ( ( 2*u3 - 3*u2 + 1 ) * t->f[i]
+           + ( u3 - 2*u2 + u )  * t->dx * t->df[i]
+           + (-2*u3 + 3*u2 )    * t->f[i+1]
+           + ( u3 - u2 )        * t->dx * t->df[i+1] );
+}
+
+
+
+
+
+/* Build the table of the integral of 'integrand' between the redshifts
+   'zmin' and 'zmax'. In every trial, the table is checked against direct
+   integration in the middle of each interval (where the error of the
+   Hermite interpolation is largest). If the error is larger than the
+   requested bound, the number of intervals is doubled. */
+static void
+cosmology_table_build(struct cosmology_table *t,
+                      double (*integrand)(double, void *),
+                      struct cosmology_integrand_t *p, int toinf,
+                      double zmin, double zmax)
+{
+  gsl_function F;
+  int converged=0;
+  size_t i, nint=COSMOLOGY_TABLE_MININTERVALS;
+  double xmax=log1p(zmax), z, zl, zh, zm, exact, approx;
+  gsl_integration_workspace *w=gsl_integration_workspace_alloc(GSLILIMIT);
+
+  /* Set the GSL function. */
+  F.params=p;
+  F.function=integrand;
+
+  /* Initialize the table. */
+  t->f=t->df=NULL;
+  t->xmin=log1p(zmin);
+
+  /* Build the table until it converges. */
+  while(converged==0)
+    {
+      /* Allocate the table's arrays. */
+      t->num=nint+1;
+      t->dx=(xmax-t->xmin)/nint;
+      if(t->f) { free(t->f); free(t->df); }
+      t->f=gal_pointer_allocate(GAL_TYPE_FLOAT64, t->num, 0, __func__,
+                                "t->f");
+      t->df=gal_pointer_allocate(GAL_TYPE_FLOAT64, t->num, 0, __func__,
+                                 "t->df");
+
+      /* Derivatives over 'x=ln(1+z)': 'dF/dx = dF/dz * (1+z)'. Note that
+         when the integral is to infinity, its derivative is negative. */
+      for(i=0;i<t->num;++i)
+        {
+          z=expm1(t->xmin + i*t->dx);
+          t->df[i] = (toinf ? -1.0 : 1.0) * integrand(z, p) * (1+z);
+        }
+
+      /* Values of the integral on each node. */
+      if(toinf)
+        {
+          t->f[t->num-1]=cosmology_table_integrate(&F, zmax, NAN, 1, w);
+          for(i=t->num-1;i>0;--i)
+            t->f[i-1] = t->f[i]
+              + cosmology_table_integrate(&F, expm1(t->xmin+(i-1)*t->dx),
+                                          expm1(t->xmin+i*t->dx), 0, w);
+        }
+      else
+        {
+          t->f[0]=cosmology_table_integrate(&F, 0.0, zmin, 0, w);
+          for(i=1;i<t->num;++i)
+            t->f[i] = t->f[i-1]
+              + cosmology_table_integrate(&F, expm1(t->xmin+(i-1)*t->dx),
+                                          expm1(t->xmin+i*t->dx), 0, w);
+        }
+
+      /* Check the interpolation error in the middle of each interval. */
+      converged=1;
+      for(i=0;i<t->num-1;++i)
+        {
+          zl=expm1(t->xmin + i*t->dx);
+          zh=expm1(t->xmin + (i+1)*t->dx);
+          zm=expm1(t->xmin + (i+0.5)*t->dx);
+          exact = ( toinf
+                    ? t->f[i+1] + cosmology_table_integrate(&F, zm, zh, 0, w)
+                    : t->f[i]   + cosmology_table_integrate(&F, zl, zm, 0, w) );
+          approx=cosmology_table_eval(t, zm);
+          if( fabs(approx-exact) > ( COSMOLOGY_TABLE_EPSREL*fabs(exact)
+                                     + COSMOLOGY_TABLE_EPSABS ) )
+            { converged=0; break; }
+        }
+
+      /* Prepare for the next trial (if necessary). If the maximum number
+         of intervals has been reached, the table will be used, but not
+         silently: the values may be less accurate than requested. */
+      if(converged==0)
+        {
+          if(nint>=COSMOLOGY_TABLE_MAXINTERVALS)
+            {
+              error(EXIT_SUCCESS, 0, "WARNING: %s: the interpolation "
+                    "table between redshifts %g and %g didn't reach the "
+                    "requested relative precision (%g) with %d intervals; "
+                    "the relative error of some values may be larger",
+                    __func__, zmin, zmax, COSMOLOGY_TABLE_EPSREL,
+                    COSMOLOGY_TABLE_MAXINTERVALS);
+              converged=1;
+            }
+          else nint*=2;
+        }
+    }
+
+  /* Clean up. */
+  gsl_integration_workspace_free(w);
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/**************************************************************/
+/************        Cosmology over arrays        *************/
+/**************************************************************/
+/* Return the value of the desired quantity for a single redshift, using
+   the interpolation table (if necessary). */
+static double
+cosmology_array_one(struct cosmology_array_params *cp, double z)
+{
+  double H, ld;
+  double c=GSL_CONST_MKSA_SPEED_OF_LIGHT;
+
+  /* Redshifts that are blank, or smaller than -1 are not defined. */
+  if( isnan(z) || z<=-1.0 ) return NAN;
+
+  /* Calculate the output. */
+  switch(cp->quantity)
+    {
+    case GAL_COSMOLOGY_AGE:
+      return ( cosmology_table_eval(cp->table, z) / cp->H0s
+               / (365*GSL_CONST_MKSA_DAY) / 1e9 );
+
+    case GAL_COSMOLOGY_PROPER_DISTANCE:
+      return cosmology_table_eval(cp->table, z) * cp->cH;
+
+    case GAL_COSMOLOGY_ANGULAR_DISTANCE:
+      return cosmology_table_eval(cp->table, z) * cp->cH / (1+z);
+
+    case GAL_COSMOLOGY_LUMINOSITY_DISTANCE:
+      return cosmology_table_eval(cp->table, z) * cp->cH * (1+z);
+
+    case GAL_COSMOLOGY_DISTANCE_MODULUS:
+      ld=cosmology_table_eval(cp->table, z) * cp->cH * (1+z);
+      return 5*(log10(ld*1000000)-1);
+
+    case GAL_COSMOLOGY_TO_ABSOLUTE_MAG:
+      ld=cosmology_table_eval(cp->table, z) * cp->cH * (1+z);
+      return 5*(log10(ld*1000000)-1) - 2.5*log10(1.0+z);
+
+    case GAL_COSMOLOGY_COMOVING_VOLUME:
+      return ( cosmology_table_eval(cp->table, z) * 4 * M_PI
+               * cp->cH * cp->cH * cp->cH );
+
+    case GAL_COSMOLOGY_CRITICAL_DENSITY:
+      H = cp->H0s * cosmology_integrand_Ez(z, cp->p);
+      return 3*H*H/(8*M_PI*GSL_CONST_MKSA_GRAVITATIONAL_CONSTANT)/1000;
+
+    case GAL_COSMOLOGY_VELOCITY_FROM_Z:
+      return c * ( (1+z)*(1+z) - 1 ) / ( (1+z)*(1+z) + 1 ) / 1000;
+
+    default:
+      error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at '%s' to "
+            "fix the problem. The code '%d' isn't recognized for the "
+            "'quantity' argument", __func__, PACKAGE_BUGREPORT,
+            cp->quantity);
+    }
+
+  /* Control should not reach here. */
+  return NAN;
+}
+
+
+
+
+
+/* Each thread is given a set of chunks of the input/output arrays (to
+   avoid allocating one index per element in 'gal_threads_spin_off'). */
+static void *
+cosmology_array_on_thread(void *in_prm)
+{
+  struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
+  struct cosmology_array_params *cp=tprm->params;
+
+  size_t i, j, start, end;
+  double *in=cp->in, *out=cp->out;
+
+  /* Go over all the chunks that were assigned to this thread. */
+  for(i=0; tprm->indexs[i] != GAL_BLANK_SIZE_T; ++i)
+    {
+      start = tprm->indexs[i] * COSMOLOGY_CHUNK_SIZE;
+      end   = start + COSMOLOGY_CHUNK_SIZE;
+      if(end>cp->size) end=cp->size;
+      for(j=start;j<end;++j)
+        out[j]=cosmology_array_one(cp, in[j]);
+    }
+
+  /* Wait for all the other threads to finish, then return. */
+  if(tprm->b) pthread_barrier_wait(tprm->b);
+  return NULL;
+}
+
+
+
+
+
+/* Calculate the desired quantity (one of the 'GAL_COSMOLOGY_*' macros)
+   for all the redshifts in 'zin'. The output is always a newly allocated
+   dataset of 64-bit floating point type with the same size as the input.
+   The integrals are only done once (over the range of redshifts in the
+   input) to build a cubic Hermite interpolation table. The interpolation
+   is then evaluated for each element on 'numthreads' threads. */
+gal_data_t *
+gal_cosmology_array(gal_data_t *zin, int quantity, double H0,
+                    double o_lambda_0, double o_matter_0,
+                    double o_radiation_0, size_t numthreads)
+{
+  size_t i;
+  int toinf=0;
+  gal_data_t *z, *out;
+  struct cosmology_table table={0};
+  struct cosmology_array_params cp={0};
+  double (*integrand)(double, void *)=NULL;
+  double *d, zmin=INFINITY, zmax=-INFINITY;
+  double H0s=H0/1000/GSL_CONST_MKSA_PARSEC;  /* H0 in units of seconds. */
+  double o_curv_0 = 1.0 - ( o_lambda_0 + o_matter_0 + o_radiation_0 );
+  struct cosmology_integrand_t p={o_lambda_0, o_curv_0, o_matter_0,
+                                  o_radiation_0};
+
+  /* Basic checks. */
+  cosmology_density_check(o_lambda_0, o_matter_0, o_radiation_0);
+  if(numthreads==0)
+    error(EXIT_FAILURE, 0, "%s: the number of threads cannot be zero",
+          __func__);
+
+  /* Convert the input into double precision (if necessary) and allocate
+     the output. */
+  z = ( zin->type==GAL_TYPE_FLOAT64
+        ? zin
+        : gal_data_copy_to_new_type(zin, GAL_TYPE_FLOAT64) );
+  out=gal_data_alloc(NULL, GAL_TYPE_FLOAT64, zin->ndim, zin->dsize,
+                     zin->wcs, 0, zin->minmapsize, zin->quietmmap,
+                     NULL, NULL, NULL);
+  if(out->size==0) { if(z!=zin) gal_data_free(z); return out; }
+
+  /* Set the integrand of the table (if one is necessary). */
+  switch(quantity)
+    {
+    case GAL_COSMOLOGY_AGE:
+      toinf=1;
+      integrand=cosmology_integrand_age;
+      break;
+
+    case GAL_COSMOLOGY_PROPER_DISTANCE:
+    case GAL_COSMOLOGY_ANGULAR_DISTANCE:
+    case GAL_COSMOLOGY_LUMINOSITY_DISTANCE:
+    case GAL_COSMOLOGY_DISTANCE_MODULUS:
+    case GAL_COSMOLOGY_TO_ABSOLUTE_MAG:
+      integrand=cosmology_integrand_proper_dist;
+      break;
+
+    case GAL_COSMOLOGY_COMOVING_VOLUME:
+      integrand=cosmology_integrand_comoving_volume;
+      break;
+
+    case GAL_COSMOLOGY_CRITICAL_DENSITY:
+    case GAL_COSMOLOGY_VELOCITY_FROM_Z:
+      break; /* These don't need an integral. */
+
+    default:
+      error(EXIT_FAILURE, 0, "%s: the code '%d' isn't recognized for the "
+            "'quantity' argument", __func__, quantity);
+    }
+
+  /* Find the range of (usable) redshifts in the input. */
+  d=z->array;
+  for(i=0;i<z->size;++i)
+    if( !isnan(d[i]) && d[i]>-1.0 )
+      {
+        if(d[i]<zmin) zmin=d[i];
+        if(d[i]>zmax) zmax=d[i];
+      }
+
+  /* Build the table. When all the usable redshifts are the same (for
+     example a single-element input), an interval is still necessary: so
+     the table is built from 'zmin' to a slightly larger value. */
+  if(integrand && zmin<=zmax)
+    {
+      if(zmax-zmin < 1e-6*(1+zmax)) zmax = zmin + 1e-6*(1+zmin);
+      cosmology_table_build(&table, integrand, &p, toinf, zmin, zmax);
+    }
+
+  /* Set the parameters and spin-off the threads. */
+  cp.p=&p;
+  cp.H0s=H0s;
+  cp.in=z->array;
+  cp.out=out->array;
+  cp.table=&table;
+  cp.size=z->size;
+  cp.quantity=quantity;
+  cp.cH=GSL_CONST_MKSA_SPEED_OF_LIGHT / H0s / (1e6 * GSL_CONST_MKSA_PARSEC);
+  cp.nchunks=(z->size + COSMOLOGY_CHUNK_SIZE - 1)/COSMOLOGY_CHUNK_SIZE;
+  gal_threads_spin_off(cosmology_array_on_thread, &cp, cp.nchunks,
+                       numthreads, z->minmapsize, z->quietmmap);
+
+  /* Clean up and return. */
+  if(z!=zin) gal_data_free(z);
+  if(table.f) { free(table.f); free(table.df); }
+  return out;
+}
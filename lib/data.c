@@ -280,15 +280,17 @@ gal_data_free_contents(gal_data_t *data)
   /* If the data type is string, then each element in the array is actually
      a pointer to the array of characters, so free them before freeing the
      actual array. */
-  if(data->type==GAL_TYPE_STRING && data->array)
+  if(data->type==GAL_TYPE_STRING && data->array
+     && !(data->flag & GAL_DATA_FLAG_FOREIGN))
     {
       strarr=data->array;
       for(i=0;i<data->size;++i) if(strarr[i]) free(strarr[i]);
     }
 
-  /* Free the array (if it was separately allocated: not part of a block),
-     then set the 'array' to NULL. */
-  if(data->array && data->block==NULL)
+  /* Free the array (if it was separately allocated: not part of a block
+     and not foreign), then set the 'array' to NULL. */
+  if(data->array && data->block==NULL
+     && !(data->flag & GAL_DATA_FLAG_FOREIGN))
     {
       if(data->mmapname)
         gal_pointer_mmap_free(&data->mmapname, data->quietmmap);
@@ -318,6 +320,61 @@ gal_data_free(gal_data_t *data)
 
 
 
+/* Fill the 'view' to describe an existing 'array' with the given type and
+   size without any allocation (see the description of 'gal_data_view_t'
+   in 'gnuastro/data.h') and return a pointer to its dataset. When 'block'
+   is not NULL, the view is a tile over it (with the same convention as
+   'gal_data_t's 'block' element): 'array' should then point to the first
+   element of the tile within the block's array and 'minmapsize' and
+   'quietmmap' are taken from the block. */
+gal_data_t *
+gal_data_view(gal_data_view_t *view, void *array, uint8_t type,
+              size_t ndim, size_t *dsize, gal_data_t *block)
+{
+  size_t i;
+  gal_data_t *data=&view->data;
+
+  /* Sanity check. */
+  if(ndim==0 || ndim>GAL_DATA_VIEW_MAXDIM)
+    error(EXIT_FAILURE, 0, "%s: a view can have 1 to %d dimensions, "
+          "but %zu was given", __func__, GAL_DATA_VIEW_MAXDIM, ndim);
+
+  /* Set the size along each dimension. */
+  data->size=1;
+  data->dsize=view->dsize;
+  for(i=0;i<ndim;++i) data->size *= ( view->dsize[i] = dsize[i] );
+
+  /* Set the rest of the elements. Similar to 'gal_data_initialize', the
+     display elements are set to impossible values so the defaults are
+     used if/when printing. */
+  data->flag       = 0;
+  data->nwcs       = 0;
+  data->status     = 0;
+  data->wcs        = NULL;
+  data->ndim       = ndim;
+  data->type       = type;
+  data->name       = NULL;
+  data->unit       = NULL;
+  data->next       = NULL;
+  data->array      = array;
+  data->block      = block;
+  data->comment    = NULL;
+  data->mmapname   = NULL;
+  data->disp_width = -1;
+  data->quietmmap  = block ? block->quietmmap  : 1;
+  data->minmapsize = block ? block->minmapsize : -1;
+  data->disp_precision=GAL_BLANK_INT;
+  data->disp_fmt=GAL_TABLE_DISPLAY_FMT_INVALID;
+
+  /* Return the dataset. */
+  return data;
+}
+
+
+
+
+
+
 
 
 
@@ -771,6 +828,111 @@ data_copy_to_string(gal_data_t *from, gal_data_t *to)
 
 
 
+/* Conversion of contiguous arrays. When the input is not a tile, the
+   type conversion can be done in simple index-based loops without any
+   dependency between the elements. The compiler can therefore vectorize
+   them (the blank values are mapped with a comparison and a select, not a
+   branch). When it is known that no blank mapping is necessary (for
+   example between floating point types, where a NaN is converted to a
+   NaN, or when the input is flagged to not have any blank values), the
+   loop only does the conversion.
+
+   The conversion is done on the calling thread: this function is called
+   by many other functions (including from within the workers of
+   'gal_threads_spin_off'), without any knowledge of the number of threads
+   the user has requested. */
+#define DATA_COPY_CONTIG_OT_IT(OT, IT) {                                \
+    OT ob, *restrict o=out->array;                                      \
+    IT ib, *restrict i=in->array;                                       \
+                                                                        \
+    if(checkblank)                                                      \
+      {                                                                 \
+        gal_blank_write(&ob, out->type);                                \
+        gal_blank_write(&ib, in->type);                                 \
+        if(ib==ib) for(k=0;k<num;++k) o[k] = i[k]==ib   ? ob : i[k];    \
+        else       for(k=0;k<num;++k) o[k] = i[k]!=i[k] ? ob : i[k];    \
+      }                                                                 \
+    else for(k=0;k<num;++k) o[k]=i[k];                                  \
+  }
+
+#define DATA_COPY_CONTIG_OT(OT)                                         \
+  switch(in->type)                                                      \
+    {                                                                   \
+    case GAL_TYPE_UINT8:   DATA_COPY_CONTIG_OT_IT(OT, uint8_t  ); break; \
+    case GAL_TYPE_INT8:    DATA_COPY_CONTIG_OT_IT(OT, int8_t   ); break; \
+    case GAL_TYPE_UINT16:  DATA_COPY_CONTIG_OT_IT(OT, uint16_t ); break; \
+    case GAL_TYPE_INT16:   DATA_COPY_CONTIG_OT_IT(OT, int16_t  ); break; \
+    case GAL_TYPE_UINT32:  DATA_COPY_CONTIG_OT_IT(OT, uint32_t ); break; \
+    case GAL_TYPE_INT32:   DATA_COPY_CONTIG_OT_IT(OT, int32_t  ); break; \
+    case GAL_TYPE_UINT64:  DATA_COPY_CONTIG_OT_IT(OT, uint64_t ); break; \
+    case GAL_TYPE_INT64:   DATA_COPY_CONTIG_OT_IT(OT, int64_t  ); break; \
+    case GAL_TYPE_FLOAT32: DATA_COPY_CONTIG_OT_IT(OT, float    ); break; \
+    case GAL_TYPE_FLOAT64: DATA_COPY_CONTIG_OT_IT(OT, double   ); break; \
+    default:                                                            \
+      error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at %s to "   \
+            "fix the problem. Input type code %d is not recognized",    \
+            "DATA_COPY_CONTIG_OT", PACKAGE_BUGREPORT, in->type);        \
+    }
+
+static void
+data_copy_contig(gal_data_t *in, gal_data_t *out, int checkblank)
+{
+  size_t k, num=in->size;
+  switch(out->type)
+    {
+    case GAL_TYPE_UINT8:   DATA_COPY_CONTIG_OT( uint8_t  ); break;
+    case GAL_TYPE_INT8:    DATA_COPY_CONTIG_OT( int8_t   ); break;
+    case GAL_TYPE_UINT16:  DATA_COPY_CONTIG_OT( uint16_t ); break;
+    case GAL_TYPE_INT16:   DATA_COPY_CONTIG_OT( int16_t  ); break;
+    case GAL_TYPE_UINT32:  DATA_COPY_CONTIG_OT( uint32_t ); break;
+    case GAL_TYPE_INT32:   DATA_COPY_CONTIG_OT( int32_t  ); break;
+    case GAL_TYPE_UINT64:  DATA_COPY_CONTIG_OT( uint64_t ); break;
+    case GAL_TYPE_INT64:   DATA_COPY_CONTIG_OT( int64_t  ); break;
+    case GAL_TYPE_FLOAT32: DATA_COPY_CONTIG_OT( float    ); break;
+    case GAL_TYPE_FLOAT64: DATA_COPY_CONTIG_OT( double   ); break;
+    default:
+      error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at %s to fix "
+            "the problem. Output type code %d is not recognized",
+            __func__, PACKAGE_BUGREPORT, out->type);
+    }
+}
+
+
+
+
+
+/* Return 1 if the conversion was done, and 0 if the input and output
+   don't qualify (so the generic tile-aware loop should be used). */
+static int
+data_copy_contig_numeric(gal_data_t *in, gal_data_t *out)
+{
+  int checkblank;
+
+  /* Only different numeric (real) types, on a contiguous input. */
+  if( in->block || in->type==out->type
+      || !( gal_type_is_int(in->type)
+            || in->type==GAL_TYPE_FLOAT32 || in->type==GAL_TYPE_FLOAT64 )
+      || !( gal_type_is_int(out->type)
+            || out->type==GAL_TYPE_FLOAT32 || out->type==GAL_TYPE_FLOAT64 ) )
+    return 0;
+
+  /* See if the blank values need to be mapped. */
+  checkblank = !( ( ( in->type==GAL_TYPE_FLOAT32
+                      || in->type==GAL_TYPE_FLOAT64 )
+                    && ( out->type==GAL_TYPE_FLOAT32
+                         || out->type==GAL_TYPE_FLOAT64 ) )
+                  || ( (in->flag & GAL_DATA_FLAG_BLANK_CH)
+                       && !(in->flag & GAL_DATA_FLAG_HASBLANK) ) );
+
+  /* Do the conversion. */
+  data_copy_contig(in, out, checkblank);
+  return 1;
+}
+
+
+
+
+
 /* Wrapper for 'gal_data_copy_to_new_type', but will copy to the same type
    as the input. Recall that if the input is a tile (a part of the input,
    which is not-contiguous if it has more than one dimension), then the
@@ -882,7 +1044,8 @@ gal_data_copy_to_allocated(gal_data_t *in, gal_data_t *out)
   if(out->comment) free(out->comment);
 
   /* Write the basic meta-data. */
-  out->flag           = in->flag;
+  out->flag           = ( (in->flag  & ~GAL_DATA_FLAG_FOREIGN)
+                          | (out->flag &  GAL_DATA_FLAG_FOREIGN) );
   out->next           = in->next;
   out->status         = in->status;
   out->disp_width     = in->disp_width;
@@ -891,34 +1054,38 @@ gal_data_copy_to_allocated(gal_data_t *in, gal_data_t *out)
   gal_checkset_allocate_copy(in->unit,    &out->unit);
   gal_checkset_allocate_copy(in->comment, &out->comment);
 
-  /* Do the copying. */
+  /* Do the copying. Conversion between two numeric types of a contiguous
+     input has a dedicated (vectorized) implementation. */
   if(in->array)
-    switch(out->type)
-      {
-      case GAL_TYPE_UINT8:   COPY_OT_SET( uint8_t  );      break;
-      case GAL_TYPE_INT8:    COPY_OT_SET( int8_t   );      break;
-      case GAL_TYPE_UINT16:  COPY_OT_SET( uint16_t );      break;
-      case GAL_TYPE_INT16:   COPY_OT_SET( int16_t  );      break;
-      case GAL_TYPE_UINT32:  COPY_OT_SET( uint32_t );      break;
-      case GAL_TYPE_INT32:   COPY_OT_SET( int32_t  );      break;
-      case GAL_TYPE_UINT64:  COPY_OT_SET( uint64_t );      break;
-      case GAL_TYPE_INT64:   COPY_OT_SET( int64_t  );      break;
-      case GAL_TYPE_FLOAT32: COPY_OT_SET( float    );      break;
-      case GAL_TYPE_FLOAT64: COPY_OT_SET( double   );      break;
-      case GAL_TYPE_STRING:  data_copy_to_string(in, out); break;
-
-      case GAL_TYPE_BIT:
-      case GAL_TYPE_STRLL:
-      case GAL_TYPE_COMPLEX32:
-      case GAL_TYPE_COMPLEX64:
-        error(EXIT_FAILURE, 0, "%s: copying to %s type not yet supported",
-              __func__, gal_type_name(out->type, 1));
-        break;
-
-      default:
-        error(EXIT_FAILURE, 0, "%s: type %d not recognized for 'out->type'",
-              __func__, out->type);
-      }
+    {
+      if( data_copy_contig_numeric(in, out)==0 )
+        switch(out->type)
+          {
+          case GAL_TYPE_UINT8:   COPY_OT_SET( uint8_t  );      break;
+          case GAL_TYPE_INT8:    COPY_OT_SET( int8_t   );      break;
+          case GAL_TYPE_UINT16:  COPY_OT_SET( uint16_t );      break;
+          case GAL_TYPE_INT16:   COPY_OT_SET( int16_t  );      break;
+          case GAL_TYPE_UINT32:  COPY_OT_SET( uint32_t );      break;
+          case GAL_TYPE_INT32:   COPY_OT_SET( int32_t  );      break;
+          case GAL_TYPE_UINT64:  COPY_OT_SET( uint64_t );      break;
+          case GAL_TYPE_INT64:   COPY_OT_SET( int64_t  );      break;
+          case GAL_TYPE_FLOAT32: COPY_OT_SET( float    );      break;
+          case GAL_TYPE_FLOAT64: COPY_OT_SET( double   );      break;
+          case GAL_TYPE_STRING:  data_copy_to_string(in, out); break;
+
+          case GAL_TYPE_BIT:
+          case GAL_TYPE_STRLL:
+          case GAL_TYPE_COMPLEX32:
+          case GAL_TYPE_COMPLEX64:
+            error(EXIT_FAILURE, 0, "%s: copying to %s type not yet "
+                  "supported", __func__, gal_type_name(out->type, 1));
+            break;
+
+          default:
+            error(EXIT_FAILURE, 0, "%s: type %d not recognized for "
+                  "'out->type'", __func__, out->type);
+          }
+    }
   else out->array=NULL;
 
   /* Correct the sizes of the output to be the same as the input. If it is
@@ -29,7 +29,10 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <string.h>
 #include <stdlib.h>
 
+#include <fitsio.h>
+
 #include <gnuastro/wcs.h>
+#include <gnuastro/fits.h>
 #include <gnuastro/pointer.h>
 #include <gnuastro/threads.h>
 #include <gnuastro/dimension.h>
@@ -362,44 +365,38 @@ gal_dimension_dist_elliptical(double *center, double *pa_deg, double *q,
 /************************************************************************/
 /********************    Collapsing a dimension    **********************/
 /************************************************************************/
-enum dimension_collapse_operation
-{
- DIMENSION_COLLAPSE_INVALID,    /* ==0 by C standard. */
-
- DIMENSION_COLLAPSE_SUM,
- DIMENSION_COLLAPSE_MAX,
- DIMENSION_COLLAPSE_MIN,
- DIMENSION_COLLAPSE_MEAN,
- DIMENSION_COLLAPSE_MEDIAN,
- DIMENSION_COLLAPSE_NUMBER,
- DIMENSION_COLLAPSE_SIGCLIP_STD,
- DIMENSION_COLLAPSE_SIGCLIP_MEAN,
- DIMENSION_COLLAPSE_SIGCLIP_MEDIAN,
- DIMENSION_COLLAPSE_SIGCLIP_NUMBER,
-};
+/* Number of output elements that are processed in one action of the
+   threaded collapsing functions. The accumulators of one action (a few
+   arrays of this many 8-byte elements) should comfortably fit in the CPU
+   cache while each input row is being parsed. */
+#define DIMENSION_COLLAPSE_CHUNK 4096
+
+/* When collapsing directly from a file, roughly this many bytes of the
+   input will be read (and collapsed) at every step. */
+#define DIMENSION_COLLAPSE_STREAM_BYTES 67108864
 
 
 
 
 
 static gal_data_t *
-dimension_collapse_sanity_check(gal_data_t *in, gal_data_t *weight,
-                                size_t c_dim, int hasblank, size_t *cnum,
-                                double **warr)
+dimension_collapse_sanity_check(size_t ndim, size_t *dsize,
+                                gal_data_t *weight, size_t c_dim,
+                                int hasblank, size_t *cnum, double **warr)
 {
   gal_data_t *wht=NULL;
 
   /* The requested dimension to collapse cannot be larger than the input's
      number of dimensions. */
-  if( c_dim > (in->ndim-1) )
+  if( c_dim > (ndim-1) )
     error(EXIT_FAILURE, 0, "%s: the input has %zu dimension(s), but you have "
-          "asked to collapse dimension %zu", __func__, in->ndim, c_dim);
+          "asked to collapse dimension %zu", __func__, ndim, c_dim);
 
   /* If there is no blank value, there is no point in calculating the
      number of points in each collapsed dataset (when necessary). In that
      case, 'cnum!=0'. */
   if(hasblank==0)
-    *cnum=in->dsize[c_dim];
+    *cnum=dsize[c_dim];
 
   /* Weight sanity checks. */
   if(weight)
@@ -407,10 +404,10 @@ dimension_collapse_sanity_check(gal_data_t *in, gal_data_t *weight,
       if( weight->ndim!=1 )
         error(EXIT_FAILURE, 0, "%s: the weight dataset has %zu dimensions, "
               "it must be one-dimensional", __func__, weight->ndim);
-      if( in->dsize[c_dim]!=weight->size )
+      if( dsize[c_dim]!=weight->size )
         error(EXIT_FAILURE, 0, "%s: the weight dataset has %zu elements, "
               "but the input dataset has %zu elements in dimension %zu",
-              __func__, weight->size, in->dsize[c_dim], c_dim);
+              __func__, weight->size, dsize[c_dim], c_dim);
       wht = ( weight->type == GAL_TYPE_FLOAT64
               ? weight
               : gal_data_copy_to_new_type(weight, GAL_TYPE_FLOAT64) );
@@ -426,18 +423,18 @@ dimension_collapse_sanity_check(gal_data_t *in, gal_data_t *weight,
 
 /* Set the collapsed output sizes. */
 static void
-dimension_collapse_sizes(gal_data_t *in, size_t c_dim, size_t *outndim,
-                         size_t *outdsize)
+dimension_collapse_sizes(size_t ndim, size_t *dsize, size_t c_dim,
+                         size_t *outndim, size_t *outdsize)
 {
   size_t i, a=0;
 
-  if(in->ndim==1)
+  if(ndim==1)
     *outndim=outdsize[0]=1;
   else
     {
-      *outndim=in->ndim-1;
-      for(i=0;i<in->ndim;++i)
-        if(i!=c_dim) outdsize[a++]=in->dsize[i];
+      *outndim=ndim-1;
+      for(i=0;i<ndim;++i)
+        if(i!=c_dim) outdsize[a++]=dsize[i];
     }
 }
 
@@ -445,290 +442,347 @@ dimension_collapse_sizes(gal_data_t *in, size_t c_dim, size_t *outndim,
 
 
 
-/* Depending on the operator, write the result into the output. */
-#define COLLAPSE_WRITE(OIND,IIND) {                                     \
-    /* Sum */                                                           \
-    if(farr)                                                            \
-      farr[ OIND ] += (warr ? warr[w] : 1) * inarr[ IIND ];             \
-                                                                        \
-    /* Number */                                                        \
-    if(iarr)                                                            \
-      {                                                                 \
-        if(num->type==GAL_TYPE_UINT8) iarr[ OIND ] = 1;                 \
-        else                        ++iarr[ OIND ];                     \
-      }                                                                 \
-                                                                        \
-    /* Sum of weights. */                                               \
-    if(wsumarr) wsumarr[ OIND ] += warr[w];                             \
-                                                                        \
-    /* Minimum or maximum. */                                           \
-    if(mmarr)                                                           \
-      mmarr[OIND] = ( max1_min0                                         \
-                      ? (mmarr[OIND]>inarr[IIND]?mmarr[OIND]:inarr[IIND]) \
-                      : (mmarr[OIND]<inarr[IIND]?mmarr[OIND]:inarr[IIND]) ); \
-  }
+/* Any dataset can be viewed as a 3D dataset around the dimension that
+   should be collapsed: 'outer' is the number of elements in the
+   dimensions that are slower than the collapsed dimension, 'clen' is the
+   length of the collapsed dimension and 'inner' is the number of elements
+   in the faster dimensions. In this view, the input element (o, c, i) is
+   collapsed into the output element 'o*inner+i'. */
+static void
+dimension_collapse_view(size_t ndim, size_t *dsize, size_t c_dim,
+                        size_t *outer, size_t *clen, size_t *inner)
+{
+  size_t i;
+  *clen=dsize[c_dim];
+  *outer=*inner=1;
+  for(i=0;i<c_dim;++i)      *outer *= dsize[i];
+  for(i=c_dim+1;i<ndim;++i) *inner *= dsize[i];
+}
 
 
-/* Deal properly with blanks. */
-#define COLLAPSE_CHECKBLANK(OIND,IIND) {                                \
-    if(hasblank)                                                        \
-      {                                                                 \
-        if(B==B) /* An integer type: blank can be checked with '=='. */ \
-          {                                                             \
-            if( inarr[IIND] != B )           COLLAPSE_WRITE(OIND,IIND); \
-          }                                                             \
-        else     /* A floating point type where NAN != NAN. */          \
-          {                                                             \
-            if( inarr[IIND] == inarr[IIND] ) COLLAPSE_WRITE(OIND,IIND); \
-          }                                                             \
-      }                                                                 \
-    else                                     COLLAPSE_WRITE(OIND,IIND); \
-  }
 
 
 
-#define COLLAPSE_DIM(IT) {                                              \
-    IT m, B, *inarr=in->array, *mmarr=minmax?minmax->array:NULL;        \
-    if(hasblank) gal_blank_write(&B, in->type);                         \
-                                                                        \
-    /* Initialize the array for minimum or maximum. */                  \
-    if(mmarr)                                                           \
-      {                                                                 \
-        if(max1_min0) gal_type_min(in->type, &m);                       \
-        else          gal_type_max(in->type, &m);                       \
-        for(i=0;i<minmax->size;++i) mmarr[i]=m;                         \
-      }                                                                 \
+/* Parameters of the threaded collapsing functions. The '*arr' pointers
+   are the accumulators of the full output, but each call to
+   'dimension_collapse_block' may only be given part of the input (in the
+   streaming mode): 'ostart' and 'wstart' are then the indexs of the first
+   output element and first weight that correspond to the block. */
+struct dimension_collapse_p
+{
+  int         operator;   /* Operator code.                         */
+  int        max1_min0;   /* For min/max: 1 for max., 0 for min.    */
+  int         hasblank;   /* If the block has blank elements.       */
+  gal_data_t    *block;   /* Block of the input dataset to collapse.*/
+  size_t         outer;   /* Elements before collapsed dimension.   */
+  size_t          clen;   /* Length of collapsed dimension.         */
+  size_t         inner;   /* Elements after collapsed dimension.    */
+  size_t        ostart;   /* Index of first output of this block.   */
+  size_t        wstart;   /* Index of first weight of this block.   */
+  double         *warr;   /* Weights (one for each collapsed elem). */
+  double         *sarr;   /* Sum of (weighted) values.              */
+  double      *wsumarr;   /* Sum of weights (when there are blanks).*/
+  int32_t        *iarr;   /* Number of non-blank elements.          */
+  void          *mmarr;   /* Minimum or maximum.                    */
+};
+
+
+
+
+
+#define DIMENSION_COLLAPSE_KERNEL(IT) {                                 \
+    double w=1.0f;                                                      \
+    IT B, v, *ia, *inarr=p->block->array, *mmarr=p->mmarr;              \
+    if(p->hasblank) gal_blank_write(&B, p->block->type);                \
                                                                         \
-    /* Collapse the dataset. */                                         \
-    switch(in->ndim)                                                    \
+    /* Go over the output elements of this chunk, one (part of an)      \
+       'inner' row at a time. Within each row, we go over all the       \
+       collapsed elements (the slow 'c' loop) and parse the contiguous  \
+       inner elements in the fast loop, so the input is read in the     \
+       same order that it is kept in memory. */                         \
+    for(o=ostart; o<oend; o+=e-s)                                       \
       {                                                                 \
-      /* 1D input dataset. */                                           \
-      case 1:                                                           \
-        for(i=0;i<in->dsize[0];++i)                                     \
+        oi = o / inner;                                                 \
+        s  = o % inner;                                                 \
+        e  = s + (oend-o) < inner ? s + (oend-o) : inner;               \
+        for(c=0;c<clen;++c)                                             \
           {                                                             \
-            if(weight) w=i;                                             \
-            COLLAPSE_CHECKBLANK(0,i);                                   \
-          }                                                             \
-        break;                                                          \
-                                                                        \
-      /* 2D input dataset. */                                           \
-      case 2:                                                           \
-        for(i=0;i<in->dsize[0];++i)                                     \
-          for(j=0;j<in->dsize[1];++j)                                   \
-            {                                                           \
-              /* In a more easy to understand format:                   \
-                 dim==0 --> a=j;                                        \
-                 dim==1 --> a=i; */                                     \
-              a = c_dim==0 ? j : i;                                     \
-              if(weight) w = c_dim == 0 ? i : j;                        \
-              COLLAPSE_CHECKBLANK(a, i*in->dsize[1] + j);               \
-            }                                                           \
-        break;                                                          \
-                                                                        \
-      /* 3D input dataset. */                                           \
-      case 3:                                                           \
-        slice=in->dsize[1]*in->dsize[2];                                \
-        for(i=0;i<in->dsize[0];++i)                                     \
-          for(j=0;j<in->dsize[1];++j)                                   \
-            for(k=0;k<in->dsize[2];++k)                                 \
+            if(warr) w=warr[c];                                         \
+            ia = inarr + (oi*clen + c)*inner;                           \
+            for(j=s;j<e;++j)                                            \
               {                                                         \
-                /* In a more easy to understand format:                 \
-                   dim==0 --> a=j; b=k;                                 \
-                   dim==1 --> a=i; b=k;                                 \
-                   dim==2 --> a=i; b=j;   */                            \
-                a = c_dim==0 ? j : i;                                   \
-                b = c_dim==2 ? j : k;                                   \
-                if(weight) w = c_dim==0 ? i : (c_dim==1 ? j : k);       \
-                COLLAPSE_CHECKBLANK(a*outdsize[1]+b,                    \
-                                    i*slice + j*in->dsize[2] + k);      \
-              }                                                         \
-        break;                                                          \
+                /* Ignore blank elements. */                            \
+                v=ia[j];                                                \
+                if(p->hasblank)                                         \
+                  { if( B==B ? v==B : v!=v ) continue; }                \
                                                                         \
-        /* Input dataset's dimensionality not yet supported. */         \
-      default:                                                          \
-        error(EXIT_FAILURE, 0, "%s: %zu-dimensional datasets not yet "  \
-              "supported, please contact us at %s to add this feature", \
-              __func__, in->ndim, PACKAGE_BUGREPORT);                   \
+                /* Write the value into the accumulators. */            \
+                k = p->ostart + oi*inner + j;                           \
+                if(sarr)    sarr[k] += w * v;                           \
+                if(wsumarr) wsumarr[k] += w;                            \
+                if(iarr)    ++iarr[k];                                  \
+                if(mmarr)                                               \
+                  mmarr[k] = ( p->max1_min0                             \
+                               ? (mmarr[k]>v ? mmarr[k] : v)            \
+                               : (mmarr[k]<v ? mmarr[k] : v) );         \
+              }                                                         \
+          }                                                             \
       }                                                                 \
-                                                                        \
-    /* For minimum or maximum, elements with no input must be blank. */ \
-    if(mmarr && iarr)                                                   \
-      for(i=0;i<minmax->size;++i) if(iarr[i]==0) mmarr[i]=B;            \
   }
 
+static void *
+dimension_collapse_worker(void *in_prm)
+{
+  struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
+  struct dimension_collapse_p *p=(struct dimension_collapse_p *)tprm->params;
+
+  /* Subsequent definitions. */
+  size_t i, c, j, k, o, oi, s, e, ostart, oend;
+  double *sarr=p->sarr, *wsumarr=p->wsumarr;
+  int32_t *iarr=p->iarr;
+  size_t clen=p->clen, inner=p->inner, osize=p->outer*p->inner;
+  double *warr = p->warr ? p->warr + p->wstart : NULL;
+
+  /* Go over all the actions (chunks of output elements) that were assigned
+     to this thread. */
+  for(i=0; tprm->indexs[i] != GAL_BLANK_SIZE_T; ++i)
+    {
+      /* Output elements of this chunk (relative to this block). */
+      ostart = tprm->indexs[i] * DIMENSION_COLLAPSE_CHUNK;
+      oend   = ( ostart + DIMENSION_COLLAPSE_CHUNK < osize
+                 ? ostart + DIMENSION_COLLAPSE_CHUNK : osize );
+
+      /* Collapse the chunk. */
+      switch(p->block->type)
+        {
+        case GAL_TYPE_UINT8:   DIMENSION_COLLAPSE_KERNEL( uint8_t  ); break;
+        case GAL_TYPE_INT8:    DIMENSION_COLLAPSE_KERNEL( int8_t   ); break;
+        case GAL_TYPE_UINT16:  DIMENSION_COLLAPSE_KERNEL( uint16_t ); break;
+        case GAL_TYPE_INT16:   DIMENSION_COLLAPSE_KERNEL( int16_t  ); break;
+        case GAL_TYPE_UINT32:  DIMENSION_COLLAPSE_KERNEL( uint32_t ); break;
+        case GAL_TYPE_INT32:   DIMENSION_COLLAPSE_KERNEL( int32_t  ); break;
+        case GAL_TYPE_UINT64:  DIMENSION_COLLAPSE_KERNEL( uint64_t ); break;
+        case GAL_TYPE_INT64:   DIMENSION_COLLAPSE_KERNEL( int64_t  ); break;
+        case GAL_TYPE_FLOAT32: DIMENSION_COLLAPSE_KERNEL( float    ); break;
+        case GAL_TYPE_FLOAT64: DIMENSION_COLLAPSE_KERNEL( double   ); break;
+        default:
+          error(EXIT_FAILURE, 0, "%s: type value (%d) not recognized",
+                __func__, p->block->type);
+        }
+    }
+
+  /* Wait for all the other threads to finish, then return. */
+  if(tprm->b) pthread_barrier_wait(tprm->b);
+  return NULL;
+}
+
 
 
 
 
-gal_data_t *
-gal_dimension_collapse_sum(gal_data_t *in, size_t c_dim, gal_data_t *weight)
+/* Collapse the given block of the input into the accumulators. */
+static void
+dimension_collapse_block(struct dimension_collapse_p *p, gal_data_t *block,
+                         size_t c_dim, int hasblank, size_t ostart,
+                         size_t wstart, size_t numthreads)
 {
-  int max1_min0=0;
-  double *wsumarr=NULL;
-  uint8_t *ii, *iarr=NULL;
-  size_t a, b, i, j, k, w=-1, cnum=0;
-  size_t outdsize[10], slice, outndim;
-  int hasblank=gal_blank_present(in, 0);
-  double *dd, *df, *warr=NULL, *farr=NULL;
-  gal_data_t *sum=NULL, *wht=NULL, *num=NULL, *minmax=NULL;
+  size_t numactions;
+
+  /* Set the block-specific parameters. */
+  p->block=block;
+  p->ostart=ostart;
+  p->wstart=wstart;
+  p->hasblank=hasblank;
+  dimension_collapse_view(block->ndim, block->dsize, c_dim, &p->outer,
+                          &p->clen, &p->inner);
+
+  /* Spin-off the threads over the chunks of the output. */
+  numactions = ( p->outer*p->inner + DIMENSION_COLLAPSE_CHUNK - 1 )
+               / DIMENSION_COLLAPSE_CHUNK;
+  gal_threads_spin_off(dimension_collapse_worker, p, numactions,
+                       numthreads, block->minmapsize, block->quietmmap);
+}
 
-  /* Basic sanity checks. */
-  wht=dimension_collapse_sanity_check(in, weight, c_dim, hasblank,
-                                      &cnum, &warr);
 
-  /* Set the size of the collapsed output. */
-  dimension_collapse_sizes(in, c_dim, &outndim, outdsize);
 
-  /* Allocate the sum (output) dataset. */
-  sum=gal_data_alloc(NULL, GAL_TYPE_FLOAT64, outndim, outdsize, in->wcs,
-                     1, in->minmapsize, in->quietmmap, NULL, NULL, NULL);
 
-  /* The number dataset (when there are blank values). */
-  if(hasblank)
-    num=gal_data_alloc(NULL, GAL_TYPE_INT8, outndim, outdsize, NULL,
-                       1, in->minmapsize, in->quietmmap, NULL, NULL, NULL);
 
-  /* Set the array pointers. */
-  if(sum) farr=sum->array;
-  if(num) iarr=num->array;
+/* Allocate the output and the necessary accumulators. When 'hasblank' is
+   zero (the whole input is known to be free of blank elements), the
+   number of elements will not be counted unless it is the requested
+   output. */
+static gal_data_t *
+dimension_collapse_prepare(struct dimension_collapse_p *p, int operator,
+                           uint8_t type, size_t ndim, size_t *dsize,
+                           struct wcsprm *wcs, size_t c_dim,
+                           gal_data_t *weight, int hasblank,
+                           size_t minmapsize, int quietmmap,
+                           gal_data_t **num, gal_data_t **wht,
+                           double **wsumarr, size_t *cnum)
+{
+  size_t i;
+  gal_data_t *out=NULL;
+  size_t outdsize[10], outndim;
 
-  /* Parse the dataset. */
-  switch(in->type)
+  /* Basic sanity checks and the output's size. */
+  *cnum=0;
+  p->warr=NULL;
+  *wht=dimension_collapse_sanity_check(ndim, dsize, weight, c_dim,
+                                       hasblank, cnum, &p->warr);
+  dimension_collapse_sizes(ndim, dsize, c_dim, &outndim, outdsize);
+
+  /* Initialize the accumulators. */
+  *num=NULL;
+  *wsumarr=NULL;
+  p->max1_min0=0;
+  p->operator=operator;
+  p->sarr=p->wsumarr=NULL; p->iarr=NULL; p->mmarr=NULL;
+
+  /* Allocate the output and accumulators. */
+  switch(operator)
     {
-    case GAL_TYPE_UINT8:     COLLAPSE_DIM( uint8_t  );   break;
-    case GAL_TYPE_INT8:      COLLAPSE_DIM( int8_t   );   break;
-    case GAL_TYPE_UINT16:    COLLAPSE_DIM( uint16_t );   break;
-    case GAL_TYPE_INT16:     COLLAPSE_DIM( int16_t  );   break;
-    case GAL_TYPE_UINT32:    COLLAPSE_DIM( uint32_t );   break;
-    case GAL_TYPE_INT32:     COLLAPSE_DIM( int32_t  );   break;
-    case GAL_TYPE_UINT64:    COLLAPSE_DIM( uint64_t );   break;
-    case GAL_TYPE_INT64:     COLLAPSE_DIM( int64_t  );   break;
-    case GAL_TYPE_FLOAT32:   COLLAPSE_DIM( float    );   break;
-    case GAL_TYPE_FLOAT64:   COLLAPSE_DIM( double   );   break;
+    case GAL_DIMENSION_COLLAPSE_SUM:
+    case GAL_DIMENSION_COLLAPSE_MEAN:
+      out=gal_data_alloc(NULL, GAL_TYPE_FLOAT64, outndim, outdsize, wcs,
+                         1, minmapsize, quietmmap, NULL, NULL, NULL);
+      p->sarr=out->array;
+      break;
+
+    case GAL_DIMENSION_COLLAPSE_NUMBER:
+      out=gal_data_alloc(NULL, GAL_TYPE_INT32, outndim, outdsize, wcs,
+                         1, minmapsize, quietmmap, NULL, NULL, NULL);
+      p->iarr=out->array;
+      p->warr=NULL;
+      break;
+
+    case GAL_DIMENSION_COLLAPSE_MIN:
+    case GAL_DIMENSION_COLLAPSE_MAX:
+      p->warr=NULL;
+      p->max1_min0 = operator==GAL_DIMENSION_COLLAPSE_MAX;
+      out=gal_data_alloc(NULL, type, outndim, outdsize, wcs,
+                         0, minmapsize, quietmmap, NULL, NULL, NULL);
+      p->mmarr=out->array;
+      for(i=0;i<out->size;++i)
+        {
+          if(p->max1_min0)
+            gal_type_min(type, gal_pointer_increment(out->array, i, type));
+          else
+            gal_type_max(type, gal_pointer_increment(out->array, i, type));
+        }
+      break;
+
     default:
-      error(EXIT_FAILURE, 0, "%s: type value (%d) not recognized",
-            __func__, in->type);
+      error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at '%s' to fix "
+            "the problem. The operator code %d isn't recognized",
+            __func__, PACKAGE_BUGREPORT, operator);
     }
 
-  /* If 'num' is zero on any element, set its sum to NaN. */
-  if(num)
+  /* When there are blank values, we need to count the number of elements
+     that went into the calculation of each output. */
+  if(hasblank && p->iarr==NULL)
     {
-      ii = num->array;
-      df = (dd=sum->array) + sum->size;
-      do if(*ii++==0) *dd=NAN; while(++dd<df);
+      *num=gal_data_alloc(NULL, GAL_TYPE_INT32, outndim, outdsize, NULL,
+                          1, minmapsize, quietmmap, NULL, NULL, NULL);
+      p->iarr=(*num)->array;
     }
 
-  /* Remove the respective dimension in the WCS structure also (if any
-     exists). Note that 'sum->ndim' has already been changed. So we'll use
-     'in->wcs'. */
-  gal_wcs_remove_dimension(sum->wcs, in->ndim-c_dim);
+  /* For a weighted mean with blank values, the sum of weights will be
+     different for each output element. */
+  if(hasblank && p->warr && operator==GAL_DIMENSION_COLLAPSE_MEAN)
+    *wsumarr=p->wsumarr=gal_pointer_allocate(GAL_TYPE_FLOAT64, out->size,
+                                             1, __func__, "wsumarr");
 
-  /* Clean up and return. */
-  if(wht!=weight) gal_data_free(wht);
-  if(num) gal_data_free(num);
-  return sum;
+  /* Return the output. */
+  return out;
 }
 
 
 
 
 
-gal_data_t *
-gal_dimension_collapse_mean(gal_data_t *in, size_t c_dim,
-                            gal_data_t *weight)
+/* Finalize the collapsed values from the accumulators. */
+static void
+dimension_collapse_finalize(struct dimension_collapse_p *p, gal_data_t *out,
+                            size_t ndim, size_t c_dim, gal_data_t *weight,
+                            gal_data_t *num, gal_data_t *wht,
+                            double *wsumarr, size_t cnum)
 {
-  int max1_min0=0;
-  double wsum=NAN;
-  double *wsumarr=NULL;
-  int32_t *ii, *iarr=NULL;
-  size_t a, b, i, j, k, w=-1, cnum=0;
-  size_t outdsize[10], slice, outndim;
-  int hasblank=gal_blank_present(in, 0);
-  double *dd, *dw, *df, *warr=NULL, *farr=NULL;
-  gal_data_t *sum=NULL, *wht=NULL, *num=NULL, *minmax=NULL;
-
-
-  /* Basic sanity checks. */
-  wht=dimension_collapse_sanity_check(in, weight, c_dim, hasblank,
-                                      &cnum, &warr);
-
-  /* Set the size of the collapsed output. */
-  dimension_collapse_sizes(in, c_dim, &outndim, outdsize);
+  size_t i;
+  int32_t *ii;
+  double *dd, *df, wsum=0.0f;
 
-  /* The sum array. */
-  sum=gal_data_alloc(NULL, GAL_TYPE_FLOAT64, outndim, outdsize, in->wcs,
-                     1, in->minmapsize, in->quietmmap, NULL, NULL, NULL);
+  /* Elements that didn't have any input. */
+  if(num)
+    {
+      ii=num->array;
+      for(i=0;i<out->size;++i)
+        if(ii[i]==0)
+          gal_blank_write(gal_pointer_increment(out->array, i, out->type),
+                          out->type);
+    }
 
-  /* If a weighted mean is requested. */
-  if( weight )
+  /* For the mean, divide the sum by the number (or sum of weights). */
+  if(p->operator==GAL_DIMENSION_COLLAPSE_MEAN)
     {
-      /* There are blank values, so we'll need to keep the sums of the
-         weights for each collapsed dimension. */
-      if( hasblank )
-        wsumarr=gal_pointer_allocate(GAL_TYPE_FLOAT64, sum->size, 1,
-                                     __func__, "wsumarr");
-
-      /* There aren't any blank values, so one summation over the
-         weights is enough to calculate the weighted mean. */
+      df=(dd=out->array)+out->size;
+      if(p->warr)
+        {
+          if(wsumarr) do *dd /= *wsumarr++; while(++dd<df);
+          else
+            {
+              for(i=0;i<wht->size;++i) wsum += p->warr[i];
+              do *dd /= wsum; while(++dd<df);
+            }
+        }
       else
         {
-          wsum=0.0f;
-          df=(dd=weight->array)+weight->size;
-          do wsum += *dd++; while(dd<df);
+          if(num) { ii=num->array; do *dd /= *ii++; while(++dd<df); }
+          else                     do *dd /= cnum;  while(++dd<df);
         }
     }
-  /* No weight is given, so we'll need the number of elements. */
-  else if( hasblank )
-    num=gal_data_alloc(NULL, GAL_TYPE_INT32, outndim, outdsize, NULL,
-                       1, in->minmapsize, in->quietmmap, NULL, NULL, NULL);
 
-  /* Set the array pointers. */
-  if(sum) farr=sum->array;
-  if(num) iarr=num->array;
+  /* Remove the respective dimension in the WCS structure also (if any
+     exists). Note that 'out->ndim' has already been changed. So we'll use
+     the input's dimensions. */
+  gal_wcs_remove_dimension(out->wcs, ndim-c_dim);
 
-  /* Parse the dataset. */
-  switch(in->type)
-    {
-    case GAL_TYPE_UINT8:     COLLAPSE_DIM( uint8_t  );   break;
-    case GAL_TYPE_INT8:      COLLAPSE_DIM( int8_t   );   break;
-    case GAL_TYPE_UINT16:    COLLAPSE_DIM( uint16_t );   break;
-    case GAL_TYPE_INT16:     COLLAPSE_DIM( int16_t  );   break;
-    case GAL_TYPE_UINT32:    COLLAPSE_DIM( uint32_t );   break;
-    case GAL_TYPE_INT32:     COLLAPSE_DIM( int32_t  );   break;
-    case GAL_TYPE_UINT64:    COLLAPSE_DIM( uint64_t );   break;
-    case GAL_TYPE_INT64:     COLLAPSE_DIM( int64_t  );   break;
-    case GAL_TYPE_FLOAT32:   COLLAPSE_DIM( float    );   break;
-    case GAL_TYPE_FLOAT64:   COLLAPSE_DIM( double   );   break;
-    default:
-      error(EXIT_FAILURE, 0, "%s: type value (%d) not recognized",
-            __func__, in->type);
-    }
+  /* Clean up. */
+  if(wht!=weight) gal_data_free(wht);
+  if(num) gal_data_free(num);
+}
 
-  /* If 'num' is zero on any element, set its sum to NaN. */
-  if(num)
-    {
-      ii = num->array;
-      df = (dd=sum->array) + sum->size;
-      do if(*ii++==0) *dd=NAN; while(++dd<df);
-    }
 
-  /* Divide the sum by the number. */
-  df = (dd=sum->array) + sum->size;
-  if(weight)
-    {
-      if(hasblank) { dw=wsumarr;  do *dd /= *dw++; while(++dd<df); }
-      else                        do *dd /= wsum;  while(++dd<df);
-    }
+
+
+
+static gal_data_t *
+dimension_collapse_threaded(gal_data_t *in, size_t c_dim, int operator,
+                            gal_data_t *weight, size_t numthreads)
+{
+  size_t i, cnum;
+  double *wsumarr;
+  gal_data_t *out, *num, *wht;
+  struct dimension_collapse_p p;
+  int hasblank=gal_blank_present(in, 0);
+
+  /* Allocate the output and accumulators. */
+  out=dimension_collapse_prepare(&p, operator, in->type, in->ndim,
+                                 in->dsize, in->wcs, c_dim, weight,
+                                 hasblank, in->minmapsize, in->quietmmap,
+                                 &num, &wht, &wsumarr, &cnum);
+
+  /* When the number of elements is requested and there are no blank
+     values, there is no need to parse the input. */
+  if(operator==GAL_DIMENSION_COLLAPSE_NUMBER && hasblank==0)
+    for(i=0;i<out->size;++i) p.iarr[i]=cnum;
   else
-    if(num) { ii = num->array;    do *dd /= *ii++; while(++dd<df); }
-    else                          do *dd /= cnum;  while(++dd<df);
+    dimension_collapse_block(&p, in, c_dim, hasblank, 0, 0, numthreads);
 
-  /* Correct the WCS, clean up and return. */
-  gal_wcs_remove_dimension(sum->wcs, in->ndim-c_dim);
-  if(wht!=weight) gal_data_free(wht);
+  /* Finalize the output and return it. */
+  dimension_collapse_finalize(&p, out, in->ndim, c_dim, weight, num, wht,
+                              wsumarr, cnum);
   if(wsumarr) free(wsumarr);
-  gal_data_free(num);
-  return sum;
+  return out;
 }
 
 
@@ -736,63 +790,36 @@ gal_dimension_collapse_mean(gal_data_t *in, size_t c_dim,
 
 
 gal_data_t *
-gal_dimension_collapse_number(gal_data_t *in, size_t c_dim)
+gal_dimension_collapse_sum(gal_data_t *in, size_t c_dim, gal_data_t *weight,
+                           size_t numthreads)
 {
-  int max1_min0=0;
-  double *wsumarr=NULL;
-  double *warr=NULL, *farr=NULL;
-  int32_t *ii, *iif, *iarr=NULL;
-  size_t a, b, i, j, k, w, cnum=0;
-  size_t outdsize[10], slice, outndim;
-  int hasblank=gal_blank_present(in, 0);
-  gal_data_t *weight=NULL, *wht=NULL, *num=NULL, *minmax=NULL;
+  return dimension_collapse_threaded(in, c_dim, GAL_DIMENSION_COLLAPSE_SUM,
+                                     weight, numthreads);
+}
 
-  /* Basic sanity checks. */
-  wht=dimension_collapse_sanity_check(in, weight, c_dim, hasblank,
-                                      &cnum, &warr);
 
-  /* Set the size of the collapsed output. */
-  dimension_collapse_sizes(in, c_dim, &outndim, outdsize);
 
-  /* The number dataset (when there are blank values).*/
-  num=gal_data_alloc(NULL, GAL_TYPE_INT32, outndim, outdsize, in->wcs,
-                     1, in->minmapsize, in->quietmmap, NULL, NULL, NULL);
 
-  /* Set the array pointers. */
-  iarr=num->array;
 
-  /* Parse the input dataset (if necessary). */
-  if(hasblank)
-    switch(in->type)
-      {
-      case GAL_TYPE_UINT8:     COLLAPSE_DIM( uint8_t  );   break;
-      case GAL_TYPE_INT8:      COLLAPSE_DIM( int8_t   );   break;
-      case GAL_TYPE_UINT16:    COLLAPSE_DIM( uint16_t );   break;
-      case GAL_TYPE_INT16:     COLLAPSE_DIM( int16_t  );   break;
-      case GAL_TYPE_UINT32:    COLLAPSE_DIM( uint32_t );   break;
-      case GAL_TYPE_INT32:     COLLAPSE_DIM( int32_t  );   break;
-      case GAL_TYPE_UINT64:    COLLAPSE_DIM( uint64_t );   break;
-      case GAL_TYPE_INT64:     COLLAPSE_DIM( int64_t  );   break;
-      case GAL_TYPE_FLOAT32:   COLLAPSE_DIM( float    );   break;
-      case GAL_TYPE_FLOAT64:   COLLAPSE_DIM( double   );   break;
-      default:
-        error(EXIT_FAILURE, 0, "%s: type value (%d) not recognized",
-              __func__, in->type);
-      }
-  else
-    {
-      iif=(ii=num->array)+num->size;
-      do *ii++ = cnum; while(ii<iif);
-    }
+gal_data_t *
+gal_dimension_collapse_mean(gal_data_t *in, size_t c_dim,
+                            gal_data_t *weight, size_t numthreads)
+{
+  return dimension_collapse_threaded(in, c_dim, GAL_DIMENSION_COLLAPSE_MEAN,
+                                     weight, numthreads);
+}
 
-  /* Remove the respective dimension in the WCS structure also (if any
-     exists). Note that 'sum->ndim' has already been changed. So we'll use
-     'in->wcs'. */
-  gal_wcs_remove_dimension(num->wcs, in->ndim-c_dim);
 
-  /* Return. */
-  if(wht!=weight) gal_data_free(wht);
-  return num;
+
+
+
+gal_data_t *
+gal_dimension_collapse_number(gal_data_t *in, size_t c_dim,
+                              size_t numthreads)
+{
+  return dimension_collapse_threaded(in, c_dim,
+                                     GAL_DIMENSION_COLLAPSE_NUMBER,
+                                     NULL, numthreads);
 }
 
 
@@ -800,62 +827,136 @@ gal_dimension_collapse_number(gal_data_t *in, size_t c_dim)
 
 
 gal_data_t *
-gal_dimension_collapse_minmax(gal_data_t *in, size_t c_dim, int max1_min0)
+gal_dimension_collapse_minmax(gal_data_t *in, size_t c_dim, int max1_min0,
+                              size_t numthreads)
 {
-  uint8_t *iarr=NULL;
-  double *wsumarr=NULL;
-  double *warr=NULL, *farr=NULL;
-  size_t a, b, i, j, k, w, cnum=0;
-  size_t outdsize[10], slice, outndim;
-  int hasblank=gal_blank_present(in, 0);
-  gal_data_t *weight=NULL, *wht=NULL, *num=NULL, *minmax=NULL;
+  return dimension_collapse_threaded(in, c_dim,
+                                     ( max1_min0
+                                       ? GAL_DIMENSION_COLLAPSE_MAX
+                                       : GAL_DIMENSION_COLLAPSE_MIN ),
+                                     NULL, numthreads);
+}
 
-  /* Basic sanity checks. */
-  wht=dimension_collapse_sanity_check(in, weight, c_dim, hasblank,
-                                      &cnum, &warr);
 
-  /* Set the size of the collapsed output. */
-  dimension_collapse_sizes(in, c_dim, &outndim, outdsize);
-
-  /* Allocate the necessary datasets. If there are blank pixels, we'll need
-     to count how many elements whent into the calculation so we can set
-     them to blank. */
-  minmax=gal_data_alloc(NULL, in->type, outndim, outdsize, in->wcs,
-                        0, in->minmapsize, in->quietmmap, NULL, NULL, NULL);
-  if(hasblank)
+
+
+
+/* Collapse the image in the given FITS file/HDU without reading it
+   completely into memory: blocks of the slowest dimension are read and
+   collapsed one after another. Dimensions of length 1 are removed before
+   collapsing (like Arithmetic), so 'c_dim' is counted after their
+   removal. */
+gal_data_t *
+gal_dimension_collapse_fits(char *filename, char *hdu, size_t c_dim,
+                            int operator, gal_data_t *weight,
+                            size_t numthreads, size_t minmapsize,
+                            int quietmmap)
+{
+  void *blank;
+  fitsfile *fptr;
+  double *wsumarr;
+  struct dimension_collapse_p p;
+  gal_data_t *out, *num, *wht, *block;
+  int type, anyblank, status=0, hasblank;
+  char *name=NULL, *unit=NULL;
+  size_t i, ndim, cnum, nslice, bslices, slicesize, *dsize, bdsize[10];
+
+  /* Only reductions that can be calculated incrementally can be done on
+     a stream. */
+  switch(operator)
     {
-      num=gal_data_alloc(NULL, GAL_TYPE_UINT8, outndim, outdsize, in->wcs,
-                         1, in->minmapsize, in->quietmmap, NULL, NULL, NULL);
-      iarr=num->array;
+    case GAL_DIMENSION_COLLAPSE_SUM:
+    case GAL_DIMENSION_COLLAPSE_MIN:
+    case GAL_DIMENSION_COLLAPSE_MAX:
+    case GAL_DIMENSION_COLLAPSE_MEAN:
+    case GAL_DIMENSION_COLLAPSE_NUMBER:
+      break;
+    default:
+      error(EXIT_FAILURE, 0, "%s: only the sum, mean, number, minimum "
+            "and maximum operators can be used when collapsing a file, "
+            "but the operator code %d has been given", __func__,
+            operator);
     }
 
-  /* Parse the input dataset (if necessary). */
-  switch(in->type)
+  /* Open the file and read the basic information. */
+  fptr=gal_fits_hdu_open_format(filename, hdu, 0);
+  gal_fits_img_info(fptr, &type, &ndim, &dsize, &name, &unit);
+  if(ndim==0)
+    error(EXIT_FAILURE, 0, "%s (hdu: %s): has 0 dimensions", filename,
+          hdu);
+  ndim=gal_dimension_remove_extra(ndim, dsize, NULL);
+  if(ndim>10)
+    error(EXIT_FAILURE, 0, "%s: %zu dimensions are not supported",
+          __func__, ndim);
+
+  /* Allocate the output and accumulators. Since we don't know if the
+     dataset has blank values before reading all of it, we'll assume it
+     does. */
+  out=dimension_collapse_prepare(&p, operator, type, ndim, dsize, NULL,
+                                 c_dim, weight, 1, minmapsize, quietmmap,
+                                 &num, &wht, &wsumarr, &cnum);
+
+  /* Number of slices (along the slowest dimension) to read in each
+     step. */
+  nslice=dsize[0];
+  slicesize=gal_dimension_total_size(ndim, dsize)/nslice;
+  bslices=DIMENSION_COLLAPSE_STREAM_BYTES/(slicesize*gal_type_sizeof(type));
+  if(bslices==0) bslices=1;
+  if(bslices>nslice) bslices=nslice;
+
+  /* Allocate the block (with the maximum number of slices). */
+  for(i=0;i<ndim;++i) bdsize[i]=dsize[i];
+  bdsize[0]=bslices;
+  block=gal_data_alloc(NULL, type, ndim, bdsize, NULL, 0, minmapsize,
+                       quietmmap, NULL, NULL, NULL);
+  blank=gal_blank_alloc_write(type);
+
+  /* Read the blocks and collapse each one. */
+  for(i=0;i<nslice;i+=bslices)
     {
-    case GAL_TYPE_UINT8:     COLLAPSE_DIM( uint8_t  );   break;
-    case GAL_TYPE_INT8:      COLLAPSE_DIM( int8_t   );   break;
-    case GAL_TYPE_UINT16:    COLLAPSE_DIM( uint16_t );   break;
-    case GAL_TYPE_INT16:     COLLAPSE_DIM( int16_t  );   break;
-    case GAL_TYPE_UINT32:    COLLAPSE_DIM( uint32_t );   break;
-    case GAL_TYPE_INT32:     COLLAPSE_DIM( int32_t  );   break;
-    case GAL_TYPE_UINT64:    COLLAPSE_DIM( uint64_t );   break;
-    case GAL_TYPE_INT64:     COLLAPSE_DIM( int64_t  );   break;
-    case GAL_TYPE_FLOAT32:   COLLAPSE_DIM( float    );   break;
-    case GAL_TYPE_FLOAT64:   COLLAPSE_DIM( double   );   break;
-    default:
-      error(EXIT_FAILURE, 0, "%s: type value (%d) not recognized",
-            __func__, in->type);
+      /* Correct the size of the last block. */
+      if(i+bslices>nslice)
+        {
+          block->dsize[0]=nslice-i;
+          block->size=block->dsize[0]*slicesize;
+        }
+
+      /* Read the block. */
+      fits_read_img(fptr, gal_fits_type_to_datatype(type),
+                    (LONGLONG)(i*slicesize+1), block->size, blank,
+                    block->array, &anyblank, &status);
+      if(status) gal_fits_io_error(status, NULL);
+      hasblank=gal_blank_present(block, 0);
+
+      /* Collapse it: when the collapsed dimension is the slowest, the
+         block's elements go into all the outputs (with the weights that
+         correspond to these slices). Otherwise, each slice goes into its
+         own outputs. */
+      if(c_dim==0)
+        dimension_collapse_block(&p, block, c_dim, hasblank, 0, i,
+                                 numthreads);
+      else
+        dimension_collapse_block(&p, block, c_dim, hasblank,
+                                 i*(slicesize/dsize[c_dim]), 0,
+                                 numthreads);
     }
 
-  /* Remove the respective dimension in the WCS structure also (if any
-     exists). Note that 'minmax->ndim' has already been changed. So we'll
-     use 'in->wcs'. */
-  gal_wcs_remove_dimension(minmax->wcs, in->ndim-c_dim);
+  /* Close the file. */
+  fits_close_file(fptr, &status);
+  gal_fits_io_error(status, NULL);
+
+  /* Finalize the output. */
+  dimension_collapse_finalize(&p, out, ndim, c_dim, weight, num, wht,
+                              wsumarr, cnum);
 
   /* Clean up and return. */
-  if(wht!=weight) gal_data_free(wht);
-  if(num) gal_data_free(num);
-  return minmax;
+  free(blank);
+  free(dsize);
+  if(name) free(name);
+  if(unit) free(unit);
+  if(wsumarr) free(wsumarr);
+  gal_data_free(block);
+  return out;
 }
 
 
@@ -904,9 +1005,13 @@ dimension_collapse_sortbased_worker(void *in_prm)
 
   /* Subsequent definitions. */
   gal_data_t *work, *stat=NULL;
-  size_t a, b, c, sind=GAL_BLANK_SIZE_T;
+  size_t o, n, outer, inner, sind=GAL_BLANK_SIZE_T;
   size_t i, j, index, c_dim=p->c_dim, wdsize=in->dsize[c_dim];
 
+  /* View the input around the collapsed dimension. */
+  dimension_collapse_view(in->ndim, in->dsize, c_dim, &outer, &wdsize,
+                          &inner);
+
   /* Allocate the dataset that will be sorted. */
   work=gal_data_alloc(NULL, in->type, 1, &wdsize, NULL, 0,
                       p->minmapsize, p->quietmmap, NULL, NULL, NULL);
@@ -925,64 +1030,19 @@ dimension_collapse_sortbased_worker(void *in_prm)
       work->flag=0;
       work->size=work->dsize[0]=wdsize;
 
-      /* Extract the necessary components into an array. */
-      switch(in->ndim)
-        {
-        /* One-dimensional data. */
-        case 1:
-          memcpy(work->array, in->array, in->size*gal_type_sizeof(in->type));
-          break;
-
-        /* Two dimensional data. */
-        case 2:
-          a=in->dsize[0];
-          b=in->dsize[1];
-          if(c_dim) /* c_dim==1 The dim. to collapse is already contiguous. */
-            memcpy(work->array,
-                   gal_pointer_increment(in->array,   index*b, in->type),
-                   b*gal_type_sizeof(in->type));
-          else      /* c_dim==0 */
-            for(j=0;j<a;++j) dimension_csb_copy(in, j*b+index, work, j);
-          break;
-
-        /* Three dimensional data. */
-        case 3:
-          a=in->dsize[0];
-          b=in->dsize[1];
-          c=in->dsize[2];
-          switch(c_dim)
-            {
-            case 0:
-              for(j=0;j<a;++j)
-                dimension_csb_copy(in, j*b*c+index, work, j);
-              break;
-
-            case 1:
-              for(j=0;j<b;++j)
-                dimension_csb_copy(in, (index/c)*b*c+j*c+(index%c), work, j);
-              break;
-
-            case 2: /* Fastest dimension: contiguous in memory. */
-              memcpy(work->array,
-                     gal_pointer_increment(in->array,
-                                           (index/b)*b*c+(index%b)*c,
-                                           in->type),
-                     c*gal_type_sizeof(in->type));
-              break;
-
-            default:
-              error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at "
-                    "'%s' to solve the problem. The dimension counter "
-                    "%zu isn't recognized for a 3D dataset", __func__,
-                    PACKAGE_BUGREPORT, c_dim);
-            }
-          break;
-
-        default:
-          error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at '%s' "
-                "to find the cause. This function doesn't support %zu "
-                "dimensions", __func__, PACKAGE_BUGREPORT, in->ndim);
-        }
+      /* Extract the necessary components into an array. In the view of
+         'dimension_collapse_view', this output element's inputs are
+         separated by 'inner' elements. When 'inner==1', they are
+         contiguous in memory. */
+      o=index/inner;
+      n=index%inner;
+      if(inner==1)
+        memcpy(work->array,
+               gal_pointer_increment(in->array, o*wdsize, in->type),
+               wdsize*gal_type_sizeof(in->type));
+      else
+        for(j=0;j<wdsize;++j)
+          dimension_csb_copy(in, (o*wdsize+j)*inner+n, work, j);
 
       /* For a check.
       if(index==0)
@@ -997,24 +1057,24 @@ dimension_collapse_sortbased_worker(void *in_prm)
       /* Do the necessary statistical operation. */
       switch(p->operator)
         {
-        case DIMENSION_COLLAPSE_MEDIAN:
+        case GAL_DIMENSION_COLLAPSE_MEDIAN:
           sind=0;
           stat=gal_statistics_median(work, 1);
           break;
-        case DIMENSION_COLLAPSE_SIGCLIP_STD:
-        case DIMENSION_COLLAPSE_SIGCLIP_MEAN:
-        case DIMENSION_COLLAPSE_SIGCLIP_MEDIAN:
-        case DIMENSION_COLLAPSE_SIGCLIP_NUMBER:
+        case GAL_DIMENSION_COLLAPSE_SIGCLIP_STD:
+        case GAL_DIMENSION_COLLAPSE_SIGCLIP_MEAN:
+        case GAL_DIMENSION_COLLAPSE_SIGCLIP_MEDIAN:
+        case GAL_DIMENSION_COLLAPSE_SIGCLIP_NUMBER:
           stat=gal_statistics_sigma_clip(work, p->sclipmultip,
                                          p->sclipparam, 1, 1);
           switch(p->operator)
             {
-            case DIMENSION_COLLAPSE_SIGCLIP_STD:     sind=3; break;
-            case DIMENSION_COLLAPSE_SIGCLIP_MEAN:    sind=2; break;
-            case DIMENSION_COLLAPSE_SIGCLIP_MEDIAN:
+            case GAL_DIMENSION_COLLAPSE_SIGCLIP_STD:     sind=3; break;
+            case GAL_DIMENSION_COLLAPSE_SIGCLIP_MEAN:    sind=2; break;
+            case GAL_DIMENSION_COLLAPSE_SIGCLIP_MEDIAN:
               stat=gal_data_copy_to_new_type_free(stat, in->type);
               sind=1; break;
-            case DIMENSION_COLLAPSE_SIGCLIP_NUMBER:
+            case GAL_DIMENSION_COLLAPSE_SIGCLIP_NUMBER:
               stat=gal_data_copy_to_new_type_free(stat, GAL_TYPE_UINT32);
               sind=0; break;
             }
@@ -1063,23 +1123,24 @@ dimension_collapse_sortbased(gal_data_t *in, size_t c_dim, int operator,
   int hasblank=0;
 
   /* Basic sanity checks. */
-  if( dimension_collapse_sanity_check(in, NULL, c_dim, hasblank,
-                                      &cnum, &warr)!=NULL )
+  if( dimension_collapse_sanity_check(in->ndim, in->dsize, NULL, c_dim,
+                                      hasblank, &cnum, &warr)!=NULL )
     error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at '%s' to fix "
           "the problem. This functions should always return NULL here",
           __func__, PACKAGE_BUGREPORT);
 
   /* Set the size of the collapsed output. */
-  dimension_collapse_sizes(in, c_dim, &outndim, outdsize);
+  dimension_collapse_sizes(in->ndim, in->dsize, c_dim, &outndim,
+                           outdsize);
 
   /* The output array (and its type). */
   switch(operator)
     {
-    case DIMENSION_COLLAPSE_MEDIAN:         otype=in->type;         break;
-    case DIMENSION_COLLAPSE_SIGCLIP_STD:    otype=GAL_TYPE_FLOAT32; break;
-    case DIMENSION_COLLAPSE_SIGCLIP_MEAN:   otype=GAL_TYPE_FLOAT32; break;
-    case DIMENSION_COLLAPSE_SIGCLIP_MEDIAN: otype=in->type;         break;
-    case DIMENSION_COLLAPSE_SIGCLIP_NUMBER: otype=GAL_TYPE_UINT32;  break;
+    case GAL_DIMENSION_COLLAPSE_MEDIAN:         otype=in->type;         break;
+    case GAL_DIMENSION_COLLAPSE_SIGCLIP_STD:    otype=GAL_TYPE_FLOAT32; break;
+    case GAL_DIMENSION_COLLAPSE_SIGCLIP_MEAN:   otype=GAL_TYPE_FLOAT32; break;
+    case GAL_DIMENSION_COLLAPSE_SIGCLIP_MEDIAN: otype=in->type;         break;
+    case GAL_DIMENSION_COLLAPSE_SIGCLIP_NUMBER: otype=GAL_TYPE_UINT32;  break;
     default:
       error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at '%s' "
             "to fix the problem. The operator code %d is not a "
@@ -1120,7 +1181,7 @@ gal_dimension_collapse_median(gal_data_t *in, size_t c_dim,
                               size_t numthreads, size_t minmapsize,
                               int quietmmap)
 {
-  int op=DIMENSION_COLLAPSE_MEDIAN;
+  int op=GAL_DIMENSION_COLLAPSE_MEDIAN;
   return dimension_collapse_sortbased(in, c_dim, op, NAN, NAN,
                                       numthreads, minmapsize,
                                       quietmmap);
@@ -1136,7 +1197,7 @@ gal_dimension_collapse_sclip_std(gal_data_t *in, size_t c_dim,
                                  size_t numthreads, size_t minmapsize,
                                  int quietmmap)
 {
-  int op=DIMENSION_COLLAPSE_SIGCLIP_STD;
+  int op=GAL_DIMENSION_COLLAPSE_SIGCLIP_STD;
   return dimension_collapse_sortbased(in, c_dim, op, multip, param,
                                       numthreads, minmapsize, quietmmap);
 }
@@ -1151,7 +1212,7 @@ gal_dimension_collapse_sclip_mean(gal_data_t *in, size_t c_dim,
                                   size_t numthreads, size_t minmapsize,
                                   int quietmmap)
 {
-  int op=DIMENSION_COLLAPSE_SIGCLIP_MEAN;
+  int op=GAL_DIMENSION_COLLAPSE_SIGCLIP_MEAN;
   return dimension_collapse_sortbased(in, c_dim, op, multip, param,
                                       numthreads, minmapsize, quietmmap);
 }
@@ -1166,7 +1227,7 @@ gal_dimension_collapse_sclip_median(gal_data_t *in, size_t c_dim,
                                     size_t numthreads, size_t minmapsize,
                                     int quietmmap)
 {
-  int op=DIMENSION_COLLAPSE_SIGCLIP_MEDIAN;
+  int op=GAL_DIMENSION_COLLAPSE_SIGCLIP_MEDIAN;
   return dimension_collapse_sortbased(in, c_dim, op, multip, param,
                                       numthreads, minmapsize, quietmmap);
 }
@@ -1177,7 +1238,7 @@ gal_dimension_collapse_sclip_number(gal_data_t *in, size_t c_dim,
                                     size_t numthreads, size_t minmapsize,
                                     int quietmmap)
 {
-  int op=DIMENSION_COLLAPSE_SIGCLIP_NUMBER;
+  int op=GAL_DIMENSION_COLLAPSE_SIGCLIP_NUMBER;
   return dimension_collapse_sortbased(in, c_dim, op, multip, param,
                                       numthreads, minmapsize, quietmmap);
 }
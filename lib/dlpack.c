@@ -0,0 +1,402 @@
+/*********************************************************************
+dlpack -- Zero-copy exchange of arrays with other libraries.
+This is part of GNU Astronomy Utilities (Gnuastro) package.
+
+Original author:
+     Mohammad Akhlaghi <mohammad@akhlaghi.org>
+Contributing author(s):
+Copyright (C) 2026 Free Software Foundation, Inc.
+
+Gnuastro is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation, either version 3 of the License, or (at your
+option) any later version.
+
+Gnuastro is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+#include <config.h>
+
+#include <errno.h>
+#include <error.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include <gnuastro/tile.h>
+#include <gnuastro/type.h>
+#include <gnuastro/dlpack.h>
+#include <gnuastro/pointer.h>
+
+
+
+
+
+/*************************************************************
+ **************           Type codes           ***************
+ *************************************************************/
+/* Fill the DLPack type description of a Gnuastro type. */
+static void
+dlpack_dtype_from_type(uint8_t type, gal_dlpack_dtype_t *dtype)
+{
+  dtype->lanes=1;
+  dtype->bits=8*gal_type_sizeof(type);
+  switch(type)
+    {
+    case GAL_TYPE_INT8:
+    case GAL_TYPE_INT16:
+    case GAL_TYPE_INT32:
+    case GAL_TYPE_INT64:     dtype->code=GAL_DLPACK_CODE_INT;     break;
+    case GAL_TYPE_UINT8:
+    case GAL_TYPE_UINT16:
+    case GAL_TYPE_UINT32:
+    case GAL_TYPE_UINT64:    dtype->code=GAL_DLPACK_CODE_UINT;    break;
+    case GAL_TYPE_FLOAT32:
+    case GAL_TYPE_FLOAT64:   dtype->code=GAL_DLPACK_CODE_FLOAT;   break;
+    case GAL_TYPE_COMPLEX32:
+    case GAL_TYPE_COMPLEX64: dtype->code=GAL_DLPACK_CODE_COMPLEX; break;
+    default:
+      error(EXIT_FAILURE, 0, "%s: type '%s' cannot be described in "
+            "DLPack", __func__, gal_type_name(type, 1));
+    }
+}
+
+
+
+
+
+/* Return the Gnuastro type of a DLPack type description. */
+static uint8_t
+dlpack_dtype_to_type(gal_dlpack_dtype_t *dtype)
+{
+  if(dtype->lanes==1)
+    switch(dtype->code)
+      {
+      case GAL_DLPACK_CODE_INT:
+        switch(dtype->bits)
+          {
+          case 8:   return GAL_TYPE_INT8;
+          case 16:  return GAL_TYPE_INT16;
+          case 32:  return GAL_TYPE_INT32;
+          case 64:  return GAL_TYPE_INT64;
+          }
+        break;
+
+      /* A boolean is stored as one byte per element in DLPack. */
+      case GAL_DLPACK_CODE_BOOL:
+      case GAL_DLPACK_CODE_UINT:
+        switch(dtype->bits)
+          {
+          case 8:   return GAL_TYPE_UINT8;
+          case 16:  return GAL_TYPE_UINT16;
+          case 32:  return GAL_TYPE_UINT32;
+          case 64:  return GAL_TYPE_UINT64;
+          }
+        break;
+
+      case GAL_DLPACK_CODE_FLOAT:
+        switch(dtype->bits)
+          {
+          case 32:  return GAL_TYPE_FLOAT32;
+          case 64:  return GAL_TYPE_FLOAT64;
+          }
+        break;
+
+      case GAL_DLPACK_CODE_COMPLEX:
+        switch(dtype->bits)
+          {
+          case 64:  return GAL_TYPE_COMPLEX32;
+          case 128: return GAL_TYPE_COMPLEX64;
+          }
+        break;
+      }
+
+  /* If control reaches here, the type isn't supported. */
+  error(EXIT_FAILURE, 0, "%s: DLPack type with code %u, %u bits and %u "
+        "lanes has no Gnuastro equivalent", __func__, dtype->code,
+        dtype->bits, dtype->lanes);
+  return GAL_TYPE_INVALID;
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/*************************************************************
+ **************        Foreign datasets        ***************
+ *************************************************************/
+/* Allocate a dataset over an existing (foreign) array: the array will
+   never be freed by 'gal_data_free'. */
+static gal_data_t *
+dlpack_foreign(void *array, uint8_t type, size_t ndim, size_t *dsize)
+{
+  gal_data_t *out=gal_data_alloc(array, type, ndim, dsize, NULL, 0, -1,
+                                 1, NULL, NULL, NULL);
+  out->flag |= GAL_DATA_FLAG_FOREIGN;
+  return out;
+}
+
+
+
+
+
+/* Describe an existing array (owned by another library) as a Gnuastro
+   dataset without copying it. The 'shape' and 'strides' follow the
+   conventions of NumPy and Python's buffer protocol: 'strides' is in
+   bytes and can be NULL (for a contiguous, row-major array).
+
+   When the array is contiguous, the output is a single dataset. When it
+   is a row-major sub-set of a larger contiguous array (for example a
+   slice like 'a[10:20, 5:50]' in NumPy), the output is a tile (with the
+   same conventions as Gnuastro's tiles, see 'gnuastro/tile.h') over a
+   foreign block that describes the layout of the larger array from the
+   tile's first element. Therefore the output's 'block' only describes
+   the strides: it is not guaranteed that all of its elements are within
+   the foreign array, so it shouldn't be used independently.
+
+   If the strides cannot be described in Gnuastro (for example a
+   transposed array or negative strides), this function returns NULL and
+   the caller should make a contiguous copy. When the length of any
+   dimension is zero, the output is an empty 1D dataset (a
+   multi-dimensional dataset can't have a zero length in Gnuastro). In
+   any case, the output should be freed with 'gal_dlpack_view_free'. */
+gal_data_t *
+gal_dlpack_view(void *array, uint8_t type, size_t ndim, int64_t *shape,
+                int64_t *strides)
+{
+  int64_t *st, width;
+  gal_data_t *out, *block;
+  int valid=1, strided=0;
+  size_t *dsize, *bdsize;
+  size_t i, zero=0, one=1;
+
+  /* A zero-dimensional array (scalar) is a one-element 1D dataset. */
+  if(ndim==0)
+    return dlpack_foreign(array, type, 1, &one);
+
+  /* An array with no element is an empty 1D dataset. */
+  for(i=0;i<ndim;++i)
+    if(shape[i]<0)
+      error(EXIT_FAILURE, 0, "%s: length of dimension %zu is negative "
+            "(%"PRId64")", __func__, i, shape[i]);
+  for(i=0;i<ndim;++i)
+    if(shape[i]==0)
+      return dlpack_foreign(array, type, 1, &zero);
+
+  /* Allocate the necessary spaces and set the size along each
+     dimension. */
+  width=gal_type_sizeof(type);
+  st=gal_pointer_allocate(GAL_TYPE_INT64, ndim, 0, __func__, "st");
+  dsize=gal_pointer_allocate(GAL_TYPE_SIZE_T, ndim, 0, __func__, "dsize");
+  bdsize=gal_pointer_allocate(GAL_TYPE_SIZE_T, ndim, 0, __func__, "bdsize");
+  for(i=0;i<ndim;++i) dsize[i]=shape[i];
+
+  /* Check the strides and find the sizes of the hosting block. The stride
+     of a dimension with a length of 1 is irrelevant (NumPy can give any
+     value for it), so it is replaced by the tightest possible value. */
+  if(strides)
+    {
+      st[ndim-1] = shape[ndim-1]==1 ? width : strides[ndim-1];
+      if(st[ndim-1]!=width) valid=0;
+      for(i=ndim-1; valid && i-- > 0;)
+        {
+          st[i] = shape[i]==1 ? st[i+1]*shape[i+1] : strides[i];
+          if( st[i]<=0 || st[i]%st[i+1] || st[i]/st[i+1]<shape[i+1] )
+            valid=0;
+          else bdsize[i+1]=st[i]/st[i+1];
+        }
+      bdsize[0]=dsize[0];
+
+      /* The array is strided when its hosting block is larger. */
+      if(valid)
+        for(i=0;i<ndim;++i)
+          if(bdsize[i]!=dsize[i]) { strided=1; break; }
+    }
+  free(st);
+
+  /* The strides cannot be described in Gnuastro. */
+  if(valid==0) { free(dsize); free(bdsize); return NULL; }
+
+  /* Build the output. */
+  if(strided)
+    {
+      block=dlpack_foreign(array, type, ndim, bdsize);
+      out=dlpack_foreign(array, type, ndim, dsize);
+      out->block=block;
+    }
+  else out=dlpack_foreign(array, type, ndim, dsize);
+
+  /* Clean up and return. */
+  free(dsize);
+  free(bdsize);
+  return out;
+}
+
+
+
+
+
+/* Free the output of 'gal_dlpack_view' (or 'gal_dlpack_import'): only
+   Gnuastro's own allocations are freed, not the foreign array. */
+void
+gal_dlpack_view_free(gal_data_t *view)
+{
+  if(view==NULL) return;
+  if(view->block && (view->block->flag & GAL_DATA_FLAG_FOREIGN))
+    gal_data_free(view->block);
+  gal_data_free(view);
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/*************************************************************
+ **************        DLPack exchange         ***************
+ *************************************************************/
+/* Describe the array of a DLPack managed tensor as a Gnuastro dataset
+   without copying it. The managed tensor is not released here: the
+   caller should call its 'deleter' after the output has been freed (with
+   'gal_dlpack_view_free'). Similar to 'gal_dlpack_view', NULL is returned
+   when the strides can't be described in Gnuastro. */
+gal_data_t *
+gal_dlpack_import(gal_dlpack_managed_t *managed)
+{
+  size_t i;
+  uint8_t type;
+  gal_data_t *out;
+  int64_t *bstrides=NULL;
+  gal_dlpack_tensor_t *t=&managed->dl_tensor;
+
+  /* Basic sanity checks. */
+  if(t->device.device_type!=GAL_DLPACK_DEVICE_CPU)
+    error(EXIT_FAILURE, 0, "%s: only arrays in the CPU's memory can be "
+          "imported, but the given array is on device type %d", __func__,
+          (int)t->device.device_type);
+  if(t->ndim<0)
+    error(EXIT_FAILURE, 0, "%s: the number of dimensions (%d) is "
+          "negative", __func__, (int)t->ndim);
+  type=dlpack_dtype_to_type(&t->dtype);
+
+  /* DLPack's strides are in units of elements, but 'gal_dlpack_view'
+     needs them in bytes. */
+  if(t->strides && t->ndim)
+    {
+      bstrides=gal_pointer_allocate(GAL_TYPE_INT64, t->ndim, 0, __func__,
+                                    "bstrides");
+      for(i=0;i<(size_t)t->ndim;++i)
+        bstrides[i]=t->strides[i]*gal_type_sizeof(type);
+    }
+
+  /* Build the view, clean up and return. */
+  out=gal_dlpack_view((char *)t->data + t->byte_offset, type, t->ndim,
+                      t->shape, bstrides);
+  if(bstrides) free(bstrides);
+  return out;
+}
+
+
+
+
+
+/* Deleter of the managed tensors that are exported by Gnuastro: the
+   shape and strides are in the same allocation as the structure. */
+static void
+dlpack_deleter(gal_dlpack_managed_t *self)
+{
+  if(self->manager_ctx) gal_data_free(self->manager_ctx);
+  free(self);
+}
+
+
+
+
+
+/* Export a Gnuastro dataset as a DLPack managed tensor without copying
+   its array. When 'data' is a tile, the strides are set from its root
+   block, so tiles can also be exported (the tile's block is never
+   freed by the deleter).
+
+   If 'steal' is non-zero, the managed tensor will own 'data' (it will be
+   freed with 'gal_data_free' when the consumer calls the 'deleter'), so
+   the caller shouldn't use or free it any more. Otherwise, 'data' should
+   not be freed before the consumer calls the deleter. */
+gal_dlpack_managed_t *
+gal_dlpack_export(gal_data_t *data, int steal)
+{
+  size_t i;
+  gal_dlpack_tensor_t *t;
+  gal_dlpack_managed_t *out;
+  gal_data_t *block=gal_tile_block(data);
+
+  /* Basic sanity checks. */
+  if(data->array==NULL)
+    error(EXIT_FAILURE, 0, "%s: the dataset has no array", __func__);
+  if(block->ndim!=data->ndim)
+    error(EXIT_FAILURE, 0, "%s: the tile and its block have different "
+          "numbers of dimensions (%zu and %zu)", __func__, data->ndim,
+          block->ndim);
+
+  /* Allocate the structure with the shape and strides after it (so a
+     single 'free' is enough in the deleter). */
+  errno=0;
+  out=malloc( sizeof *out + 2 * data->ndim * sizeof(int64_t) );
+  if(out==NULL)
+    error(EXIT_FAILURE, errno, "%s: couldn't allocate %zu bytes for 'out'",
+          __func__, sizeof *out + 2 * data->ndim * sizeof(int64_t));
+
+  /* Fill the tensor. */
+  t=&out->dl_tensor;
+  t->data=data->array;
+  t->byte_offset=0;
+  t->ndim=data->ndim;
+  t->device.device_id=0;
+  t->device.device_type=GAL_DLPACK_DEVICE_CPU;
+  dlpack_dtype_from_type(data->type, &t->dtype);
+  t->shape=(int64_t *)(out+1);
+  t->strides=t->shape+data->ndim;
+  for(i=0;i<data->ndim;++i) t->shape[i]=data->dsize[i];
+  t->strides[data->ndim-1]=1;
+  for(i=data->ndim-1; i-- > 0;)
+    t->strides[i] = t->strides[i+1] * block->dsize[i+1];
+
+  /* Set the manager and return. */
+  out->deleter=dlpack_deleter;
+  out->manager_ctx = steal ? data : NULL;
+  return out;
+}
@@ -210,12 +210,19 @@ eps_convert_to_bitstream(gal_data_t *in, size_t *numbytes, uint8_t bitone)
 
 
 
+/* The encoded characters of the image are first written into a buffer
+   of this size (in bytes), then written into the file with one 'fwrite'
+   (instead of one 'fprintf' for every byte). */
+#define EPS_ENCODE_BUFFER 65536
+
 static void
 eps_write_hex(gal_data_t *write, FILE *fp, size_t numbytes)
 {
   unsigned char *arr;
   gal_data_t *channel;
+  char buf[EPS_ENCODE_BUFFER], *b;
   size_t i=0, j, elem_for_newline=35;
+  static const char hex[]="0123456789ABCDEF";
 
   for(channel=write; channel!=NULL; channel=channel->next)
     {
@@ -224,12 +231,19 @@ eps_write_hex(gal_data_t *write, FILE *fp, size_t numbytes)
       else
         {
           arr=channel->array;
+          b=buf;
           fprintf(fp, "{<");
           for(j=0;j<numbytes;++j)
             {
-              fprintf(fp, "%02X", arr[j]);
-              if(j%elem_for_newline==0) fprintf(fp, "\n");
+              *b++=hex[arr[j]>>4];
+              *b++=hex[arr[j]&0xf];
+              if(j%elem_for_newline==0) *b++='\n';
+
+              /* Each byte needs at most 3 characters. */
+              if(b-buf+3>EPS_ENCODE_BUFFER)
+                { fwrite(buf, 1, b-buf, fp); b=buf; }
             }
+          fwrite(buf, 1, b-buf, fp);
           fprintf(fp, ">}\n");
         }
       ++i;
@@ -246,6 +260,7 @@ eps_write_ascii85(gal_data_t *write, FILE *fp, size_t numbytes)
   unsigned char *arr;
   gal_data_t *channel;
   uint32_t anint, base;
+  char buf[EPS_ENCODE_BUFFER], *b;
   size_t i=0, j, k, elem_for_newline=15;   /* 15*5=75 */
 
   for(channel=write; channel!=NULL; channel=channel->next)
@@ -254,6 +269,7 @@ eps_write_ascii85(gal_data_t *write, FILE *fp, size_t numbytes)
         fprintf(fp, "{<00>} %% Channel %zu is blank\n", i);
       else
         {
+          b=buf;
           arr=channel->array;
           fprintf(fp, "{<~");
           for(j=0;j<numbytes;j+=4)
@@ -270,7 +286,7 @@ eps_write_ascii85(gal_data_t *write, FILE *fp, size_t numbytes)
                         + arr[j+2]*256     + arr[j+3]         );
 
               /* If all four bytes are zero, then just print 'z'. */
-              if(anint==0) fprintf(fp, "z");
+              if(anint==0) *b++='z';
               else
                 {
                   /* To check, just change the fprintf below to printf:
@@ -282,14 +298,19 @@ eps_write_ascii85(gal_data_t *write, FILE *fp, size_t numbytes)
                   /* Do the ASCII85 encoding: */
                   for(k=0;k<5;++k)
                     {
-                      fprintf(fp, "%c", anint/base+33);
+                      *b++=anint/base+33;
                       anint%=base;
                       base/=85;
                     }
                 }
               /* Go to the next line if on the right place: */
-              if(j%elem_for_newline==0) fprintf(fp, "\n");
+              if(j%elem_for_newline==0) *b++='\n';
+
+              /* Each four bytes need at most 6 characters. */
+              if(b-buf+6>EPS_ENCODE_BUFFER)
+                { fwrite(buf, 1, b-buf, fp); b=buf; }
             }
+          fwrite(buf, 1, b-buf, fp);
           fprintf(fp, "~>}\n");
         }
       ++i;
@@ -22,6 +22,7 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 **********************************************************************/
 #include <config.h>
 
+#include <math.h>
 #include <stdio.h>
 #include <errno.h>
 #include <error.h>
@@ -33,6 +34,7 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 
 #include <gnuastro/fit.h>
 #include <gnuastro/blank.h>
+#include <gnuastro/threads.h>
 #include <gnuastro/pointer.h>
 
 #include <gnuastro-internal/checkset.h>
@@ -479,6 +481,32 @@ fit_1d_polynomial_prepare(gal_data_t *xin,  gal_data_t *yin,
 
 
 
+/* Return the GSL robust function type corresponding to 'robustid'. */
+static const gsl_multifit_robust_type *
+fit_robust_type(uint8_t robustid, const char *func)
+{
+  switch(robustid)
+    {
+    case GAL_FIT_ROBUST_BISQUARE: return gsl_multifit_robust_bisquare;
+    case GAL_FIT_ROBUST_CAUCHY:   return gsl_multifit_robust_cauchy;
+    case GAL_FIT_ROBUST_FAIR:     return gsl_multifit_robust_fair;
+    case GAL_FIT_ROBUST_HUBER:    return gsl_multifit_robust_huber;
+    case GAL_FIT_ROBUST_OLS:      return gsl_multifit_robust_ols;
+    case GAL_FIT_ROBUST_WELSCH:   return gsl_multifit_robust_welsch;
+    default:
+      error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at "
+            "'%s' to fix the problem. the 'robustid' value '%d' "
+            "isn't recognize", func, PACKAGE_BUGREPORT, robustid);
+    }
+
+  /* Control should not reach here. */
+  return NULL;
+}
+
+
+
+
+
 gal_data_t *
 gal_fit_1d_polynomial_base(gal_data_t *xin, gal_data_t *yin,
                            gal_data_t *ywht, size_t maxpower,
@@ -525,25 +553,7 @@ gal_fit_1d_polynomial_base(gal_data_t *xin, gal_data_t *yin,
   else
     {
       /* Select the robust function type. */
-      switch(robustid)
-        {
-        case GAL_FIT_ROBUST_BISQUARE: rtype=gsl_multifit_robust_bisquare;
-          break;
-        case GAL_FIT_ROBUST_CAUCHY:   rtype=gsl_multifit_robust_cauchy;
-          break;
-        case GAL_FIT_ROBUST_FAIR:     rtype=gsl_multifit_robust_fair;
-          break;
-        case GAL_FIT_ROBUST_HUBER:    rtype=gsl_multifit_robust_huber;
-          break;
-        case GAL_FIT_ROBUST_OLS:      rtype=gsl_multifit_robust_ols;
-          break;
-        case GAL_FIT_ROBUST_WELSCH:   rtype=gsl_multifit_robust_welsch;
-          break;
-        default:
-          error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at "
-                "'%s' to fix the problem. the 'robustid' value '%d' "
-                "isn't recognize", __func__, PACKAGE_BUGREPORT, robustid);
-        }
+      rtype=fit_robust_type(robustid, __func__);
 
       /* Initialize the worker and do the fit (depending on if a weight
          image was provided). */
@@ -665,3 +675,710 @@ gal_fit_1d_polynomial_estimate(gal_data_t *fit, gal_data_t *xin)
   free(xvec.data);
   return out;
 }
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/**********************************************************************/
+/****************            Batched fitting           ****************/
+/**********************************************************************/
+/* Parameters of a batch of independent fits: one fit for every group of
+   rows ('gal_fit_1d_groups'), or one fit for every line of a dataset along
+   one of its dimensions ('gal_fit_1d_polynomial_dim'). */
+struct fit_batch_params
+{
+  /* Type of fit. */
+  uint8_t             fitid;  /* Type of fit ('GAL_FIT_*').            */
+  uint8_t          robustid;  /* Robust function ('GAL_FIT_ROBUST_*'). */
+  size_t             nconst;  /* Number of fitted constants.           */
+  size_t               ncov;  /* Elements in upper triangle of cov.    */
+  size_t               nmax;  /* Maximum number of rows in one fit.    */
+
+  /* Groups of rows. */
+  double                 *x;  /* Independent (X) values.               */
+  double                 *y;  /* Measured (Y) values.                  */
+  double                 *w;  /* Weights of Y (can be NULL).           */
+  size_t             *index;  /* Row indexs sorted by group.           */
+  size_t             *start;  /* Start of each group within 'index'.   */
+  size_t            *number;  /* Number of rows used in each fit.      */
+  double            **ocols;  /* Arrays of the output columns.         */
+
+  /* Lines along one dimension. */
+  gal_data_t            *in;  /* Input dataset (32 or 64-bit float).   */
+  gal_data_t           *out;  /* Model or constants.                   */
+  size_t               dlen;  /* Length of the fitted dimension.       */
+  size_t              inner;  /* Elements after the fitted dimension.  */
+  int                 model;  /* Output is the evaluated model.        */
+};
+
+
+
+
+
+/* Buffers and GSL workspaces of one thread. They are allocated once and
+   re-used for all the fits that are done on the thread. The GSL workspaces
+   depend on the number of rows, so they are only re-allocated when the
+   number of usable rows changes from one fit to the next. */
+struct fit_batch_work
+{
+  double                            *x;  /* Gathered X values.         */
+  double                            *y;  /* Gathered Y values.         */
+  double                            *w;  /* Gathered weights.          */
+  double                           *dm;  /* Design matrix.             */
+  double                            *c;  /* Fitted constants.          */
+  double                          *cov;  /* Upper triangle of cov.     */
+  size_t                         nwork;  /* Rows of GSL workspace.     */
+  gsl_vector                     *cvec;  /* GSL's fitted constants.    */
+  gsl_matrix                     *cmat;  /* GSL's covariance matrix.   */
+  gsl_multifit_linear_workspace *work_n; /* Ordinary least squares.    */
+  gsl_multifit_robust_workspace *work_r; /* Robust least squares.      */
+  const gsl_multifit_robust_type *rtype; /* Robust function.           */
+};
+
+
+
+
+
+static void
+fit_batch_work_alloc(struct fit_batch_params *p, struct fit_batch_work *fw)
+{
+  size_t n=p->nmax;
+
+  fw->x   = gal_pointer_allocate(GAL_TYPE_FLOAT64, n, 0, __func__,
+                                 "fw->x");
+  fw->y   = gal_pointer_allocate(GAL_TYPE_FLOAT64, n, 0, __func__,
+                                 "fw->y");
+  fw->w   = ( p->w
+              ? gal_pointer_allocate(GAL_TYPE_FLOAT64, n, 0, __func__,
+                                     "fw->w")
+              : NULL );
+  fw->c   = gal_pointer_allocate(GAL_TYPE_FLOAT64, p->nconst, 0,
+                                 __func__, "fw->c");
+  fw->cov = gal_pointer_allocate(GAL_TYPE_FLOAT64, p->ncov, 0,
+                                 __func__, "fw->cov");
+
+  /* Structures that are only necessary for polynomial fits. */
+  fw->nwork=0;
+  fw->dm=NULL;
+  fw->cvec=NULL;
+  fw->cmat=NULL;
+  fw->work_n=NULL;
+  fw->work_r=NULL;
+  fw->rtype=NULL;
+  switch(p->fitid)
+    {
+    case GAL_FIT_POLYNOMIAL:
+    case GAL_FIT_POLYNOMIAL_ROBUST:
+    case GAL_FIT_POLYNOMIAL_WEIGHTED:
+      fw->dm   = gal_pointer_allocate(GAL_TYPE_FLOAT64, n*p->nconst, 0,
+                                      __func__, "fw->dm");
+      fw->cvec = gsl_vector_alloc(p->nconst);
+      fw->cmat = gsl_matrix_alloc(p->nconst, p->nconst);
+      if(p->fitid==GAL_FIT_POLYNOMIAL_ROBUST)
+        fw->rtype=fit_robust_type(p->robustid, __func__);
+      break;
+    }
+}
+
+
+
+
+
+static void
+fit_batch_work_free(struct fit_batch_work *fw)
+{
+  free(fw->x);
+  free(fw->y);
+  free(fw->w);
+  free(fw->c);
+  free(fw->dm);
+  free(fw->cov);
+  if(fw->cvec)   gsl_vector_free(fw->cvec);
+  if(fw->cmat)   gsl_matrix_free(fw->cmat);
+  if(fw->work_n) gsl_multifit_linear_free(fw->work_n);
+  if(fw->work_r) gsl_multifit_robust_free(fw->work_r);
+}
+
+
+
+
+
+/* Polynomial fit on the 'n' gathered rows of 'fw' (using the GSL
+   workspaces of the thread). The returned value is the chi^2 (for weighted
+   fits) or the residual sum of squares. */
+static double
+fit_batch_polynomial(struct fit_batch_params *p, struct fit_batch_work *fw,
+                     size_t n)
+{
+  size_t i, j;
+  double *row, chisq=NAN, sse=NAN;
+  size_t nconst=p->nconst, covind=0;
+
+  /* The GSL structures can directly use the thread's buffers (like
+     'gal_fit_1d_polynomial_estimate'). */
+  gsl_matrix xmat={n, nconst, nconst, fw->dm, NULL, 0};
+  gsl_vector yvec={n, 1, fw->y, NULL, 0};
+  gsl_vector wvec={n, 1, fw->w, NULL, 0};
+
+  /* Fill the design matrix (see 'fit_1d_polynomial_prepare'). */
+  for(i=0;i<n;++i)
+    {
+      row=fw->dm+i*nconst;
+      row[0]=1.0f;
+      for(j=1;j<nconst;++j) row[j]=row[j-1]*fw->x[i];
+    }
+
+  /* Do the fit. */
+  if(p->fitid==GAL_FIT_POLYNOMIAL_ROBUST)
+    {
+      if(fw->work_r==NULL || fw->nwork!=n)
+        {
+          if(fw->work_r) gsl_multifit_robust_free(fw->work_r);
+          fw->work_r=gsl_multifit_robust_alloc(fw->rtype, n, nconst);
+          fw->nwork=n;
+        }
+      gsl_multifit_robust(&xmat, &yvec, fw->cvec, fw->cmat, fw->work_r);
+      sse=gsl_multifit_robust_statistics(fw->work_r).sse;
+    }
+  else
+    {
+      if(fw->work_n==NULL || fw->nwork!=n)
+        {
+          if(fw->work_n) gsl_multifit_linear_free(fw->work_n);
+          fw->work_n=gsl_multifit_linear_alloc(n, nconst);
+          fw->nwork=n;
+        }
+      if(fw->w)
+        gsl_multifit_wlinear(&xmat, &wvec, &yvec, fw->cvec, fw->cmat,
+                             &chisq, fw->work_n);
+      else
+        gsl_multifit_linear(&xmat, &yvec, fw->cvec, fw->cmat, &sse,
+                            fw->work_n);
+    }
+
+  /* Copy the constants and the upper triangle of the covariance
+     matrix. */
+  memcpy(fw->c, fw->cvec->data, nconst*sizeof *fw->c);
+  for(i=0;i<nconst;++i)
+    for(j=i;j<nconst;++j)
+      fw->cov[covind++]=fw->cmat->data[i*nconst+j];
+
+  /* Return the chi^2 or the residual sum of squares. */
+  return isnan(chisq) ? sse : chisq;
+}
+
+
+
+
+
+/* Do the fit on the 'n' rows that have been gathered in 'fw' and return
+   the reduced chi^2. The fitted constants and the upper triangle of the
+   covariance matrix (row by row) are written in 'fw->c' and 'fw->cov'. The
+   number of degrees of freedom has to be positive, so when there aren't
+   enough rows, all the outputs will be NaN. */
+static double
+fit_batch_one(struct fit_batch_params *p, struct fit_batch_work *fw,
+              size_t n)
+{
+  size_t i;
+  double chisq, *c=fw->c, *cov=fw->cov;
+
+  /* Not enough rows for this fit. */
+  if(n<=p->nconst)
+    {
+      for(i=0;i<p->nconst;++i) c[i]=NAN;
+      for(i=0;i<p->ncov;++i) cov[i]=NAN;
+      return NAN;
+    }
+
+  /* Do the fit. The order of GSL's outputs for the linear fits is
+     identical to the order of constants and covariance matrix here. See
+     'fit_1d_linear_base' for the reduced chi^2. */
+  switch(p->fitid)
+    {
+    case GAL_FIT_LINEAR:
+      gsl_fit_linear(fw->x, 1, fw->y, 1, n, c, c+1, cov, cov+1, cov+2,
+                     &chisq);
+      break;
+    case GAL_FIT_LINEAR_WEIGHTED:
+      gsl_fit_wlinear(fw->x, 1, fw->w, 1, fw->y, 1, n, c, c+1, cov,
+                      cov+1, cov+2, &chisq);
+      break;
+    case GAL_FIT_LINEAR_NO_CONSTANT:
+      gsl_fit_mul(fw->x, 1, fw->y, 1, n, c, cov, &chisq);
+      break;
+    case GAL_FIT_LINEAR_NO_CONSTANT_WEIGHTED:
+      gsl_fit_wmul(fw->x, 1, fw->w, 1, fw->y, 1, n, c, cov, &chisq);
+      break;
+    case GAL_FIT_POLYNOMIAL:
+    case GAL_FIT_POLYNOMIAL_ROBUST:
+    case GAL_FIT_POLYNOMIAL_WEIGHTED:
+      chisq=fit_batch_polynomial(p, fw, n);
+      break;
+    default:
+      error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at '%s' "
+            "to fix the problem. The fitting id '%d' isn't recognized",
+            __func__, PACKAGE_BUGREPORT, p->fitid);
+    }
+
+  /* Return the reduced chi^2. */
+  return chisq / (n - p->nconst);
+}
+
+
+
+
+
+/* Check the fitting identifiers and return the number of constants. */
+static size_t
+fit_batch_nconst(uint8_t fitid, size_t maxpower, uint8_t robustid,
+                 gal_data_t *ywht, const char *func)
+{
+  switch(fitid)
+    {
+    case GAL_FIT_LINEAR:
+    case GAL_FIT_POLYNOMIAL:
+    case GAL_FIT_POLYNOMIAL_ROBUST:
+    case GAL_FIT_LINEAR_NO_CONSTANT:
+      if(ywht)
+        error(EXIT_FAILURE, 0, "%s: the '%s' fit doesn't use weights, "
+              "but 'ywht' is not NULL", func, gal_fit_name_from_id(fitid));
+      break;
+    case GAL_FIT_LINEAR_WEIGHTED:
+    case GAL_FIT_POLYNOMIAL_WEIGHTED:
+    case GAL_FIT_LINEAR_NO_CONSTANT_WEIGHTED:
+      if(ywht==NULL)
+        error(EXIT_FAILURE, 0, "%s: the '%s' fit needs weights, but "
+              "'ywht' is NULL", func, gal_fit_name_from_id(fitid));
+      break;
+    default:
+      error(EXIT_FAILURE, 0, "%s: the fitting id '%d' isn't recognized",
+            func, fitid);
+    }
+
+  /* The robust function is only relevant for robust fits. */
+  if(fitid==GAL_FIT_POLYNOMIAL_ROBUST
+     && ( robustid==GAL_FIT_ROBUST_INVALID
+          || robustid>=GAL_FIT_ROBUST_NUMBER ) )
+    error(EXIT_FAILURE, 0, "%s: the robust function id '%d' isn't "
+          "recognized", func, robustid);
+
+  /* Return the number of constants. */
+  switch(fitid)
+    {
+    case GAL_FIT_LINEAR:
+    case GAL_FIT_LINEAR_WEIGHTED:             return 2;
+    case GAL_FIT_LINEAR_NO_CONSTANT:
+    case GAL_FIT_LINEAR_NO_CONSTANT_WEIGHTED: return 1;
+    default:                                  return maxpower+1;
+    }
+}
+
+
+
+
+
+static void *
+fit_batch_groups_worker(void *in_prm)
+{
+  struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
+  struct fit_batch_params *p=(struct fit_batch_params *)tprm->params;
+
+  size_t i, j, k, g, r, n;
+  double redchisq, *x=p->x, *y=p->y, *w=p->w;
+  struct fit_batch_work fw;
+
+  /* Allocate the buffers of this thread. */
+  fit_batch_work_alloc(p, &fw);
+
+  /* Go over all the groups that were assigned to this thread. */
+  for(i=0; tprm->indexs[i]!=GAL_BLANK_SIZE_T; ++i)
+    {
+      /* Gather the usable rows of this group. */
+      n=0;
+      g=tprm->indexs[i];
+      for(j=p->start[g]; j<p->start[g+1]; ++j)
+        {
+          r=p->index[j];
+          if( isnan(x[r]) || isnan(y[r]) || (w && isnan(w[r])) ) continue;
+          fw.x[n]=x[r];
+          fw.y[n]=y[r];
+          if(w) fw.w[n]=w[r];
+          ++n;
+        }
+
+      /* Do the fit and write the outputs in the respective columns. */
+      redchisq=fit_batch_one(p, &fw, n);
+      for(k=0;k<p->nconst;++k) p->ocols[k][g]=fw.c[k];
+      for(k=0;k<p->ncov;++k)   p->ocols[p->nconst+k][g]=fw.cov[k];
+      p->ocols[p->nconst+p->ncov][g]=redchisq;
+      p->number[g]=n;
+    }
+
+  /* Clean up, wait for all threads to finish and return. */
+  fit_batch_work_free(&fw);
+  if(tprm->b) pthread_barrier_wait(tprm->b);
+  return NULL;
+}
+
+
+
+
+
+/* Double precision copy of the input (if necessary). */
+static gal_data_t *
+fit_batch_to_double(gal_data_t *in, gal_data_t *ref, const char *func)
+{
+  if(in->ndim!=1)
+    error(EXIT_FAILURE, 0, "%s: inputs must have one dimension", func);
+  if(in->size!=ref->size)
+    error(EXIT_FAILURE, 0, "%s: all inputs must have the same size",
+          func);
+  return ( in->type==GAL_TYPE_FLOAT64
+           ? in
+           : gal_data_copy_to_new_type(in, GAL_TYPE_FLOAT64) );
+}
+
+
+
+
+
+/* For sorting the rows by their group (rows of a group will keep their
+   original order). */
+struct fit_batch_row
+{
+  int64_t group;
+  size_t  index;
+};
+
+static int
+fit_batch_row_cmp(const void *a, const void *b)
+{
+  const struct fit_batch_row *ra=a, *rb=b;
+  return ( ra->group==rb->group
+           ? (ra->index>rb->index) - (ra->index<rb->index)
+           : (ra->group>rb->group) - (ra->group<rb->group) );
+}
+
+
+
+
+
+/* Make the output columns of 'gal_fit_1d_groups'. */
+static gal_data_t *
+fit_batch_groups_columns(struct fit_batch_params *p, gal_data_t *group,
+                         size_t ngroups, int64_t **gcol)
+{
+  char *name, *comment;
+  gal_data_t *tmp, *out=NULL;
+  size_t i, j, k, minmapsize=group->minmapsize;
+  int quietmmap=group->quietmmap, noconst=(p->nconst==1);
+
+  /* The group and number of rows. */
+  gal_list_data_add_alloc(&out, NULL, GAL_TYPE_INT64, 1, &ngroups, NULL,
+                          0, minmapsize, quietmmap,
+                          group->name ? group->name : "GROUP",
+                          group->unit, "Group identifier.");
+  gal_list_data_add_alloc(&out, NULL, GAL_TYPE_SIZE_T, 1, &ngroups, NULL,
+                          0, minmapsize, quietmmap, "NUMBER", "counter",
+                          "Number of rows used in the fit.");
+
+  /* The constants (in the linear fit without a constant, the only
+     constant is 'C1'). */
+  for(i=0;i<p->nconst;++i)
+    {
+      if( asprintf(&name, "C%zu", noconst ? 1 : i)<0 )
+        error(EXIT_FAILURE, 0, "%s: asprintf for 'name'", __func__);
+      if( asprintf(&comment, "Multiple of X^%zu.", noconst ? 1 : i)<0 )
+        error(EXIT_FAILURE, 0, "%s: asprintf for 'comment'", __func__);
+      gal_list_data_add_alloc(&out, NULL, GAL_TYPE_FLOAT64, 1, &ngroups,
+                              NULL, 0, minmapsize, quietmmap, name, NULL,
+                              comment);
+      free(comment);
+      free(name);
+    }
+
+  /* Upper triangle of the covariance matrix (counting from 1, similar to
+     the 'FCOVij' keywords of the Statistics program). */
+  for(i=0;i<p->nconst;++i)
+    for(j=i;j<p->nconst;++j)
+      {
+        if( asprintf(&name, "COV%zu%zu", i+1, j+1)<0 )
+          error(EXIT_FAILURE, 0, "%s: asprintf for 'name'", __func__);
+        if( asprintf(&comment, "Covariance matrix element (%zu,%zu).",
+                     i+1, j+1)<0 )
+          error(EXIT_FAILURE, 0, "%s: asprintf for 'comment'", __func__);
+        gal_list_data_add_alloc(&out, NULL, GAL_TYPE_FLOAT64, 1,
+                                &ngroups, NULL, 0, minmapsize, quietmmap,
+                                name, NULL, comment);
+        free(comment);
+        free(name);
+      }
+
+  /* The reduced chi^2. */
+  gal_list_data_add_alloc(&out, NULL, GAL_TYPE_FLOAT64, 1, &ngroups, NULL,
+                          0, minmapsize, quietmmap, "REDCHISQ", NULL,
+                          "Reduced chi^2 of fit.");
+
+  /* Put the columns in the same order they were defined and keep the
+     pointers to their arrays. */
+  gal_list_data_reverse(&out);
+  *gcol=out->array;
+  p->number=out->next->array;
+  p->ocols=malloc( (p->nconst+p->ncov+1) * sizeof *p->ocols );
+  if(p->ocols==NULL)
+    error(EXIT_FAILURE, errno, "%s: %zu bytes for 'p->ocols'", __func__,
+          (p->nconst+p->ncov+1) * sizeof *p->ocols);
+  for(k=0, tmp=out->next->next; tmp!=NULL; tmp=tmp->next)
+    p->ocols[k++]=tmp->array;
+  return out;
+}
+
+
+
+
+
+/* Do an independent fit on the rows of every group. */
+gal_data_t *
+gal_fit_1d_groups(gal_data_t *xin, gal_data_t *yin, gal_data_t *ywht,
+                  gal_data_t *group, uint8_t fitid, size_t maxpower,
+                  uint8_t robustid, size_t numthreads)
+{
+  int64_t *g, *gcol;
+  struct fit_batch_params p;
+  struct fit_batch_row *rows;
+  gal_data_t *x, *y, *w=NULL, *gdata, *out;
+  size_t i, nrows=0, ngroups=0, nthis, size=xin->size;
+
+  /* Basic sanity checks. */
+  p.fitid=fitid;
+  p.robustid=robustid;
+  p.nconst=fit_batch_nconst(fitid, maxpower, robustid, ywht, __func__);
+  p.ncov=p.nconst*(p.nconst+1)/2;
+  if(group->ndim!=1 || group->size!=size)
+    error(EXIT_FAILURE, 0, "%s: 'group' must be one dimensional with "
+          "the same size as the other inputs", __func__);
+  if( gal_type_is_int(group->type)==0 || group->type==GAL_TYPE_UINT64 )
+    error(EXIT_FAILURE, 0, "%s: 'group' must have a signed integer type "
+          "or an unsigned integer type with 32 bits or less, but it has "
+          "a '%s' type", __func__, gal_type_name(group->type, 1));
+
+  /* Double precision copies of the inputs (if necessary). */
+  x =        fit_batch_to_double(xin,  xin, __func__);
+  y =        fit_batch_to_double(yin,  xin, __func__);
+  if(ywht) w=fit_batch_to_double(ywht, xin, __func__);
+  p.x=x->array;
+  p.y=y->array;
+  p.w=w?w->array:NULL;
+  gdata = ( group->type==GAL_TYPE_INT64
+            ? group
+            : gal_data_copy_to_new_type(group, GAL_TYPE_INT64) );
+
+  /* Sort the (non-blank) row indexs by their group. */
+  g=gdata->array;
+  rows=malloc(size * sizeof *rows);
+  if(rows==NULL)
+    error(EXIT_FAILURE, errno, "%s: %zu bytes for 'rows'", __func__,
+          size * sizeof *rows);
+  for(i=0;i<size;++i)
+    if(g[i]!=GAL_BLANK_INT64)
+      { rows[nrows].group=g[i]; rows[nrows].index=i; ++nrows; }
+  qsort(rows, nrows, sizeof *rows, fit_batch_row_cmp);
+
+  /* Count the groups. */
+  for(i=0;i<nrows;++i)
+    if(i==0 || rows[i].group!=rows[i-1].group) ++ngroups;
+  if(ngroups==0)
+    error(EXIT_FAILURE, 0, "%s: all the group identifiers are blank",
+          __func__);
+
+  /* Allocate the outputs and set the start of every group. */
+  out=fit_batch_groups_columns(&p, group, ngroups, &gcol);
+  p.index=gal_pointer_allocate(GAL_TYPE_SIZE_T, nrows, 0, __func__,
+                               "p.index");
+  p.start=gal_pointer_allocate(GAL_TYPE_SIZE_T, ngroups+1, 0, __func__,
+                               "p.start");
+  p.nmax=nthis=ngroups=0;
+  for(i=0;i<nrows;++i)
+    {
+      if(i==0 || rows[i].group!=rows[i-1].group)
+        {
+          if(nthis>p.nmax) p.nmax=nthis;
+          gcol[ngroups]=rows[i].group;
+          p.start[ngroups++]=i;
+          nthis=0;
+        }
+      p.index[i]=rows[i].index;
+      ++nthis;
+    }
+  if(nthis>p.nmax) p.nmax=nthis;
+  p.start[ngroups]=nrows;
+  free(rows);
+
+  /* Do the fits on multiple threads. */
+  gal_threads_spin_off(fit_batch_groups_worker, &p, ngroups, numthreads,
+                       xin->minmapsize, xin->quietmmap);
+
+  /* Clean up and return. */
+  free(p.ocols);
+  free(p.index);
+  free(p.start);
+  if(x!=xin) gal_data_free(x);
+  if(y!=yin) gal_data_free(y);
+  if(w && w!=ywht) gal_data_free(w);
+  if(gdata!=group) gal_data_free(gdata);
+  return out;
+}
+
+
+
+
+
+static void *
+fit_batch_dim_worker(void *in_prm)
+{
+  struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
+  struct fit_batch_params *p=(struct fit_batch_params *)tprm->params;
+
+  double v, xv;
+  struct fit_batch_work fw;
+  size_t i, j, k, n, l, o, r, start, stride=p->inner;
+  size_t nconst=p->nconst;
+  int is64=p->in->type==GAL_TYPE_FLOAT64;
+  float  *i32=p->in->array,  *o32=p->out->array;
+  double *i64=p->in->array,  *o64=p->out->array;
+
+  /* Allocate the buffers of this thread. */
+  fit_batch_work_alloc(p, &fw);
+
+  /* Go over all the lines that were assigned to this thread. */
+  for(i=0; tprm->indexs[i]!=GAL_BLANK_SIZE_T; ++i)
+    {
+      /* First element of this line: the lines of one "outer" slice are
+         adjacent in memory (separated by one element). */
+      l=tprm->indexs[i];
+      o=l/stride;
+      r=l%stride;
+      start=o*p->dlen*stride+r;
+
+      /* Gather the non-blank elements of the line (X is the position
+         along the line, counting from 1). */
+      n=0;
+      for(j=0;j<p->dlen;++j)
+        {
+          v = is64 ? i64[start+j*stride] : i32[start+j*stride];
+          if(isnan(v)) continue;
+          fw.x[n]=j+1;
+          fw.y[n]=v;
+          ++n;
+        }
+
+      /* Do the fit. */
+      fit_batch_one(p, &fw, n);
+
+      /* Write the evaluated model over the whole line, or the constants.*/
+      if(p->model)
+        for(j=0;j<p->dlen;++j)
+          {
+            xv=j+1;
+            v=fw.c[nconst-1];
+            for(k=nconst-1;k>0;--k) v = v*xv + fw.c[k-1];
+            if(is64) o64[start+j*stride]=v;
+            else     o32[start+j*stride]=v;
+          }
+      else
+        {
+          start=o*nconst*stride+r;
+          for(k=0;k<nconst;++k) o64[start+k*stride]=fw.c[k];
+        }
+    }
+
+  /* Clean up, wait for all threads to finish and return. */
+  fit_batch_work_free(&fw);
+  if(tprm->b) pthread_barrier_wait(tprm->b);
+  return NULL;
+}
+
+
+
+
+
+/* Fit a polynomial over every line of the input along dimension 'dim'. */
+gal_data_t *
+gal_fit_1d_polynomial_dim(gal_data_t *in, size_t dim, size_t maxpower,
+                          uint8_t robustid, int model, size_t numthreads)
+{
+  size_t i, *dsize;
+  struct fit_batch_params p;
+
+  /* Sanity checks. */
+  if(dim>=in->ndim)
+    error(EXIT_FAILURE, 0, "%s: the input has %zu dimension(s), but "
+          "'dim' is %zu (it should be smaller than the number of "
+          "dimensions)", __func__, in->ndim, dim);
+  if(in->dsize[dim]==0 || in->size==0)
+    error(EXIT_FAILURE, 0, "%s: the input has no elements along "
+          "dimension %zu (counting from 0), so there is nothing to fit",
+          __func__, dim);
+
+  /* Basic settings. */
+  p.model=model;
+  p.robustid=robustid;
+  p.fitid = ( robustid==GAL_FIT_ROBUST_INVALID
+              ? GAL_FIT_POLYNOMIAL
+              : GAL_FIT_POLYNOMIAL_ROBUST );
+  p.nconst=fit_batch_nconst(p.fitid, maxpower, robustid, NULL, __func__);
+  p.ncov=p.nconst*(p.nconst+1)/2;
+  p.w=NULL;
+  p.nmax=p.dlen=in->dsize[dim];
+  for(p.inner=1, i=dim+1; i<in->ndim; ++i) p.inner*=in->dsize[i];
+
+  /* Floating point inputs are used directly, other types are converted to
+     double precision. */
+  p.in = ( ( in->type==GAL_TYPE_FLOAT32 || in->type==GAL_TYPE_FLOAT64 )
+           ? in
+           : gal_data_copy_to_new_type(in, GAL_TYPE_FLOAT64) );
+
+  /* Allocate the output: the model has the same size and type as the
+     (floating point) input, the constants replace the fitted dimension. */
+  if(model)
+    p.out=gal_data_alloc(NULL, p.in->type, in->ndim, in->dsize, in->wcs,
+                         0, in->minmapsize, in->quietmmap, "FIT-MODEL",
+                         in->unit, "Polynomial fitted along a dimension.");
+  else
+    {
+      dsize=gal_pointer_allocate(GAL_TYPE_SIZE_T, in->ndim, 0, __func__,
+                                 "dsize");
+      memcpy(dsize, in->dsize, in->ndim*sizeof *dsize);
+      dsize[dim]=p.nconst;
+      p.out=gal_data_alloc(NULL, GAL_TYPE_FLOAT64, in->ndim, dsize, NULL,
+                           0, in->minmapsize, in->quietmmap, "FIT-CONST",
+                           NULL, "Constants of polynomial fit along a "
+                           "dimension.");
+      free(dsize);
+    }
+
+  /* Do the fits on multiple threads (one action per line). */
+  gal_threads_spin_off(fit_batch_dim_worker, &p, in->size/p.dlen,
+                       numthreads, in->minmapsize, in->quietmmap);
+
+  /* Clean up and return. */
+  if(p.in!=in) gal_data_free(p.in);
+  return p.out;
+}
@@ -30,6 +30,9 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <stat-time.h>
 
 #include <gsl/gsl_version.h>
 
@@ -43,6 +46,7 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <gnuastro/threads.h>
 #include <gnuastro/pointer.h>
 
+#include <gnuastro-internal/timing.h>
 #include <gnuastro-internal/checkset.h>
 #include <gnuastro-internal/tableintern.h>
 #include <gnuastro-internal/fixedstringmacros.h>
@@ -2288,114 +2292,574 @@ gal_fits_key_write_config(gal_fits_list_key_t **keylist, char *title,
 
 
 
-/* From an input list of FITS files and a HDU, select those that have a
-   certain value(s) in a certain keyword.*/
-gal_list_str_t *
-gal_fits_with_keyvalue(gal_list_str_t *files, char *hdu, char *name,
-                       gal_list_str_t *values)
+/* Parameters to read the value of one keyword in many files. */
+struct fits_keyvalue_params
 {
-  int status=0;
-  fitsfile *fptr;
-  char keyvalue[FLEN_VALUE];
-  gal_list_str_t *f, *v, *out=NULL;
+  char              *hdu;  /* HDU to read in all files.                */
+  char             *name;  /* Name of the keyword.                     */
+  char           **files;  /* Names of the files.                      */
+  char          **values;  /* Values (NULL: not present).              */
+  struct stat    *stats;  /* 'stat' output of each file.              */
+  uint8_t         *found;  /* 1: file could be 'stat'ed.               */
+  gal_list_str_t *cother;  /* Cache lines with other HDU or keyword.   */
+  struct fits_keyvalue_cache *cache; /* Sorted cache of this HDU/key.  */
+  size_t          ncache;  /* Number of elements in the cache.         */
+};
+
+struct fits_keyvalue_cache
+{
+  char         *filename;  /* Name of file.                            */
+  long               sec;  /* Modification time (seconds).             */
+  long              nsec;  /* Modification time (nano-seconds).        */
+  long              size;  /* Size of file (bytes).                    */
+  char            *value;  /* Value of keyword (NULL: not present).    */
+  uint8_t           used;  /* File is in the input list.               */
+};
+
+
 
-  /* Go over the list of files and see if they have the requested
-     keyword(s). */
-  for(f=files; f!=NULL; f=f->next)
+
+
+/* Parse the value of a header card (80 characters, not NULL-terminated)
+   in the same way that CFITSIO's 'fits_read_key' does with a 'TSTRING'
+   type. If the card has no value, return NULL. If it is a long string
+   (that continues in the next card), return 'fits_keyvalue_long' so the
+   caller can fall back to CFITSIO. */
+static char fits_keyvalue_long;
+
+static char *
+fits_keyvalue_raw_parse(char *card)
+{
+  char *out, *o;
+  size_t i, j, start;
+
+  /* The card doesn't have a value. */
+  if(card[8]!='=' || card[9]!=' ') return NULL;
+
+  /* Skip the blank characters before the value. */
+  for(i=10; i<80 && card[i]==' '; ++i) {}
+  if(i==80) return NULL;
+
+  /* Allocate the output (a value can't be longer than a card). */
+  errno=0;
+  o=out=malloc(FLEN_CARD);
+  if(out==NULL)
+    error(EXIT_FAILURE, errno, "%s: allocating %d bytes", __func__,
+          FLEN_CARD);
+
+  /* String values: the quotes are removed, two single quotes are one
+     single quote and trailing blank characters are removed. */
+  if(card[i]=='\'')
     {
-      /* Open the file. */
-      fptr=gal_fits_hdu_open(f->v, hdu, READONLY, 0);
+      for(++i; i<80; ++i)
+        {
+          if(card[i]=='\'')
+            { if(i<79 && card[i+1]=='\'') ++i; else break; }
+          *o++=card[i];
+        }
+      while(o>out && o[-1]==' ') --o;
+      *o='\0';
+      if(o>out && o[-1]=='&') { free(out); return &fits_keyvalue_long; }
+      return out;
+    }
+
+  /* Other values: until the comment, without blank characters around. */
+  for(start=i; i<80 && card[i]!='/'; ++i) {}
+  for(j=i; j>start && card[j-1]==' '; --j) {}
+  memcpy(out, card+start, j-start);
+  out[j-start]='\0';
+  return out;
+}
+
+
+
+
+
+/* Read the integer value of a card. */
+static long
+fits_keyvalue_raw_long(char *card)
+{
+  char tmp[71];
+  memcpy(tmp, card+10, 70);
+  tmp[70]='\0';
+  return strtol(tmp, NULL, 10);
+}
+
+
+
+
+
+/* Read the value of a keyword by directly parsing the header blocks of
+   the file (each block is 2880 bytes, containing 36 cards of 80
+   characters). This is much faster than opening the file with CFITSIO
+   (which also parses all the keywords in the header), but only a plain
+   FITS file with a numeric HDU and a standard (maximum 8 character)
+   keyword name is supported. If this function can't be sure about the
+   result (for example a compressed file, a named HDU or a long string),
+   it will return 0 so the caller uses CFITSIO. On success, 1 is returned
+   and the value (or NULL if the keyword has no value or isn't present)
+   is put in 'value'. */
+#define FITS_KEYVALUE_MAXDIM 999
+static int
+fits_keyvalue_raw(char *filename, char *hdu, char *name, char **value)
+{
+  FILE *fp;
+  char *tailptr;
+  int ended, zimage, found=0;
+  char key[8], block[2880], *card, *val=NULL;
+  long bitpix, pcount, gcount, axis, naxisn[FITS_KEYVALUE_MAXDIM+1];
+  size_t i, h, ind, naxis, nbits, datasize;
+
+  /* The HDU must be a number and the name a standard keyword (CFITSIO
+     matches the keyword names case-insensitively). */
+  ind=strtoul(hdu, &tailptr, 10);
+  if(*tailptr!='\0' || hdu[0]=='\0' || strlen(name)>8) return 0;
+  memset(key, ' ', 8);
+  for(i=0;name[i]!='\0';++i)
+    {
+      if(name[i]==' ') return 0;
+      key[i]=toupper(name[i]);
+    }
+
+  /* Open the file (if it can't be opened, let CFITSIO decide). */
+  if( (fp=fopen(filename, "rb"))==NULL ) return 0;
+
+  /* Go over the HDUs until the desired one. */
+  for(h=0;h<=ind;++h)
+    {
+      /* Initialize the header's basic keywords. */
+      ended=zimage=0;
+      bitpix=pcount=0; gcount=1; naxis=0;
+      memset(naxisn, 0, sizeof naxisn);
+
+      /* Read the header blocks. Note that the first block of the file
+         must start with 'SIMPLE' (otherwise it may be compressed). */
+      while(ended==0)
+        {
+          if( fread(block, 1, 2880, fp)!=2880
+              || (h==0 && ftello(fp)==2880
+                  && strncmp(block, "SIMPLE  =", 9)) )
+            { fclose(fp); if(val!=&fits_keyvalue_long) free(val);
+              return 0; }
+
+          /* Parse the cards. */
+          for(card=block; card<block+2880; card+=80)
+            if( !strncmp(card, "END     ", 8) ) { ended=1; break; }
+            else if(h==ind)
+              {
+                if(found==0 && !strncmp(card, key, 8))
+                  { found=1; val=fits_keyvalue_raw_parse(card); }
+                if( !strncmp(card, "ZIMAGE  =", 9) ) zimage=1;
+              }
+            else if( !strncmp(card, "BITPIX  =", 9) )
+              bitpix=fits_keyvalue_raw_long(card);
+            else if( !strncmp(card, "NAXIS   =", 9) )
+              naxis=fits_keyvalue_raw_long(card);
+            else if( !strncmp(card, "NAXIS", 5) && isdigit(card[5]) )
+              {
+                axis=strtol(card+5, &tailptr, 10);
+                if(axis>0 && axis<=FITS_KEYVALUE_MAXDIM && *tailptr==' ')
+                  naxisn[axis]=fits_keyvalue_raw_long(card);
+              }
+            else if( !strncmp(card, "PCOUNT  =", 9) )
+              pcount=fits_keyvalue_raw_long(card);
+            else if( !strncmp(card, "GCOUNT  =", 9) )
+              gcount=fits_keyvalue_raw_long(card);
+        }
 
-      /* Only attempt to read the value if the requested HDU could be
-         opened ('fptr!=NULL'). */
-      if(fptr)
+      /* Skip the data of this HDU to go to the next. */
+      if(h<ind)
         {
-          /* Check if the keyword actually exists. */
-          if( gal_fits_key_exists_fptr(fptr, name) )
+          nbits=0;
+          if(naxis && naxis<=FITS_KEYVALUE_MAXDIM)
             {
-              /* Read the keyword. Note that we aren't checking for the
-                 'status' here. If for any reason CFITSIO couldn't read the
-                 value and status if non-zero, the next step won't consider
-                 the file any more. */
-              status=0;
-              fits_read_key(fptr, TSTRING, name, &keyvalue, NULL,
-                            &status);
-
-              /* If the value corresponds to any of the user's values for
-                 this keyword, add it to the list of output names. */
-              if(status==0)
-                for(v=values; v!=NULL; v=v->next)
-                  {
-                    if( strcmp(v->v, keyvalue)==0 )
-                      { gal_list_str_add(&out, f->v, 1); break; }
-                  }
+              for(datasize=1, i=1; i<=naxis; ++i) datasize*=naxisn[i];
+              nbits = labs(bitpix) * gcount * (pcount + datasize);
             }
-
-          /* Close the file. */
-          if( fits_close_file(fptr, &status) )
-            gal_fits_io_error(status, NULL);
+          datasize = ( nbits/8 + 2879 ) / 2880 * 2880;
+          if( datasize && fseeko(fp, datasize, SEEK_CUR) )
+            { fclose(fp); return 0; }
         }
     }
+  fclose(fp);
 
-  /* Reverse the list to be in same order as input and return. */
-  gal_list_str_reverse(&out);
-  return out;
+  /* Compressed images (and long strings) need CFITSIO's
+     interpretation. */
+  if(zimage || val==&fits_keyvalue_long)
+    {
+      if(val!=&fits_keyvalue_long) free(val);
+      return 0;
+    }
+
+  /* Return the value. */
+  *value=val;
+  return 1;
 }
 
 
 
 
 
-/* From an input list of FITS files and a HDU, select those that have a
-   certain value(s) in a certain keyword.*/
-gal_list_str_t *
-gal_fits_unique_keyvalues(gal_list_str_t *files, char *hdu, char *name)
+/* Read the value with CFITSIO. */
+static char *
+fits_keyvalue_cfitsio(char *filename, char *hdu, char *name)
 {
+  int status=0;
   fitsfile *fptr;
-  int status=0, newvalue;
-  char *keyv, keyvalue[FLEN_VALUE];
-  gal_list_str_t *f, *v, *out=NULL;
+  char *out=NULL, keyvalue[FLEN_VALUE];
 
-  /* Go over the list of files and see if they have the requested
-     keyword(s). */
-  for(f=files; f!=NULL; f=f->next)
+  /* Open the file. Only attempt to read the value if the requested HDU
+     could be opened ('fptr!=NULL'). */
+  fptr=gal_fits_hdu_open(filename, hdu, READONLY, 0);
+  if(fptr)
     {
-      /* Open the file. */
-      fptr=gal_fits_hdu_open(f->v, hdu, READONLY, 0);
+      /* Check if the keyword actually exists. */
+      if( gal_fits_key_exists_fptr(fptr, name) )
+        {
+          /* Read the keyword. Note that we aren't checking for the
+             'status' here. If for any reason CFITSIO couldn't read the
+             value and status if non-zero, the file will not be
+             considered. */
+          fits_read_key(fptr, TSTRING, name, &keyvalue, NULL, &status);
+          if(status==0) gal_checkset_allocate_copy(keyvalue, &out);
+        }
+
+      /* Close the file. */
+      status=0;
+      if( fits_close_file(fptr, &status) )
+        gal_fits_io_error(status, NULL);
+    }
+  return out;
+}
+
+
 
-      /* Only attempt to read the value if the requested HDU could be
-         opened ('fptr!=NULL'). */
-      if(fptr)
+
+
+static int
+fits_keyvalue_cache_cmp(const void *a, const void *b)
+{
+  return strcmp( ((struct fits_keyvalue_cache *)a)->filename,
+                 ((struct fits_keyvalue_cache *)b)->filename );
+}
+
+
+
+
+
+/* Worker function to read the keyword value of each file. */
+static void *
+fits_keyvalue_on_thread(void *in_prm)
+{
+  struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
+  struct fits_keyvalue_params *p=(struct fits_keyvalue_params *)tprm->params;
+
+  size_t i, ind;
+  struct fits_keyvalue_cache key, *c;
+
+  /* Go over all the files that were assigned to this thread. */
+  for(i=0; tprm->indexs[i] != GAL_BLANK_SIZE_T; ++i)
+    {
+      /* For easy reading. */
+      ind = tprm->indexs[i];
+
+      /* If there is a cache, see if the file has been read before (and
+         hasn't changed since then). */
+      if(p->stats)
         {
-          /* Check if the keyword actually exists. */
-          if( gal_fits_key_exists_fptr(fptr, name) )
+          p->found[ind] = stat(p->files[ind], &p->stats[ind])==0;
+          if(p->found[ind] && p->ncache)
             {
-              /* Read the keyword. Note that we aren't checking for the
-                 'status' here. If for any reason CFITSIO couldn't read the
-                 value and status if non-zero, the next step won't consider
-                 the file any more. */
-              status=0;
-              fits_read_key(fptr, TSTRING, name, &keyvalue, NULL,
-                            &status);
-
-              /* If the value is new, add it to the list. */
-              if(status==0)
+              key.filename=p->files[ind];
+              c=bsearch(&key, p->cache, p->ncache, sizeof *p->cache,
+                        fits_keyvalue_cache_cmp);
+              if(c) c->used=1;
+              if( c
+                  && c->sec  == (long)get_stat_mtime(&p->stats[ind]).tv_sec
+                  && c->nsec == get_stat_mtime(&p->stats[ind]).tv_nsec
+                  && c->size == (long)p->stats[ind].st_size )
                 {
-                  newvalue=1;
-                  keyv=gal_txt_trim_space(keyvalue);
-                  for(v=out; v!=NULL; v=v->next)
-                    { if( strcmp(v->v, keyv)==0 ) newvalue=0; }
-                  if(newvalue) gal_list_str_add(&out, keyv, 1);
+                  if(c->value)
+                    gal_checkset_allocate_copy(c->value, &p->values[ind]);
+                  continue;
                 }
             }
+        }
 
-          /* Close the file. */
-          if( fits_close_file(fptr, &status) )
-            gal_fits_io_error(status, NULL);
+      /* Read the value from the file. */
+      if( fits_keyvalue_raw(p->files[ind], p->hdu, p->name,
+                            &p->values[ind])==0 )
+        p->values[ind]=fits_keyvalue_cfitsio(p->files[ind], p->hdu,
+                                             p->name);
+    }
+
+  /* Wait for all the other threads to finish, then return. */
+  if(tprm->b) pthread_barrier_wait(tprm->b);
+  return NULL;
+}
+
+
+
+
+
+/* Read the cache file. Each line of the cache has the following
+   TAB-separated components: HDU, keyword name, modification time (seconds
+   and nano-seconds), size, a flag (1 if the keyword exists), file name and
+   value. Lines of other HDUs or keywords are kept to be written in the
+   updated cache. */
+static void
+fits_keyvalue_cache_read(struct fits_keyvalue_params *p, char *cachefile)
+{
+  FILE *fp;
+  ssize_t nread;
+  size_t len=0, alloc=0;
+  char *line=NULL, *c, *f[8];
+  struct fits_keyvalue_cache *e;
+  int i;
+
+  /* If the file doesn't exist, there is no cache. */
+  if( (fp=fopen(cachefile, "r"))==NULL ) return;
+
+  /* Parse each line. */
+  while( (nread=getline(&line, &len, fp))!=-1 )
+    {
+      /* Separate the components (the value is the last, so it can have
+         any character except a new-line). */
+      if(line[0]=='#') continue;
+      if(nread && line[nread-1]=='\n') line[nread-1]='\0';
+      for(c=line, i=0; i<8; ++i)
+        {
+          f[i]=c;
+          if(i<7) { if( (c=strchr(c, '\t'))==NULL ) break; *c++='\0'; }
+        }
+      if(i<8) continue;                         /* Corrupt line. */
+
+      /* Keep lines of other HDUs or keywords. */
+      if( strcmp(f[0], p->hdu) || strcasecmp(f[1], p->name) )
+        {
+          for(i=1;i<8;++i) f[i][-1]='\t';
+          gal_list_str_add(&p->cother, line, 1);
+          continue;
         }
+
+      /* Add this line to the cache. */
+      if(p->ncache==alloc)
+        {
+          alloc = alloc ? 2*alloc : 1024;
+          p->cache=realloc(p->cache, alloc*sizeof *p->cache);
+          if(p->cache==NULL)
+            error(EXIT_FAILURE, 0, "%s: couldn't allocate cache of %zu "
+                  "elements", __func__, alloc);
+        }
+      e=&p->cache[p->ncache++];
+      e->sec=atol(f[2]);
+      e->nsec=atol(f[3]);
+      e->size=atol(f[4]);
+      gal_checkset_allocate_copy(f[6], &e->filename);
+      e->used=0;
+      e->value=NULL;
+      if(f[5][0]=='1') gal_checkset_allocate_copy(f[7], &e->value);
+    }
+
+  /* Clean up and sort the cache by file name (for a binary search). */
+  free(line);
+  fclose(fp);
+  gal_list_str_reverse(&p->cother);
+  qsort(p->cache, p->ncache, sizeof *p->cache, fits_keyvalue_cache_cmp);
+}
+
+
+
+
+
+/* Write the updated cache into a temporary file and rename it to the
+   cache file's name (so parallel readers don't see a partial file). */
+static void
+fits_keyvalue_cache_write(struct fits_keyvalue_params *p, char *cachefile,
+                          size_t numfiles)
+{
+  FILE *fp;
+  size_t i;
+  char *tmpname;
+  gal_list_str_t *s;
+
+  /* Open the temporary file. */
+  if( asprintf(&tmpname, "%s.%ld.tmp", cachefile, (long)getpid())<0 )
+    error(EXIT_FAILURE, 0, "%s: asprintf allocation", __func__);
+  errno=0;
+  if( (fp=fopen(tmpname, "w"))==NULL )
+    {
+      error(EXIT_SUCCESS, errno, "%s: WARNING: couldn't write cache "
+            "(it will be ignored)", tmpname);
+      free(tmpname);
+      return;
+    }
+
+  /* Write the lines (the files of the old cache that were not in the
+     input list are also kept). Note that files with a TAB or new-line in
+     their name are not cached. */
+  fprintf(fp, "# Cache of FITS keyword values, written by Gnuastro "
+          "%s.\n", PACKAGE_VERSION);
+  for(s=p->cother; s!=NULL; s=s->next) fprintf(fp, "%s\n", s->v);
+  for(i=0;i<p->ncache;++i)
+    if(p->cache[i].used==0)
+      fprintf(fp, "%s\t%s\t%ld\t%ld\t%ld\t%d\t%s\t%s\n", p->hdu, p->name,
+              p->cache[i].sec, p->cache[i].nsec, p->cache[i].size,
+              p->cache[i].value!=NULL, p->cache[i].filename,
+              p->cache[i].value ? p->cache[i].value : "");
+  for(i=0;i<numfiles;++i)
+    if( p->found[i] && strpbrk(p->files[i], "\t\n")==NULL )
+      fprintf(fp, "%s\t%s\t%ld\t%ld\t%ld\t%d\t%s\t%s\n", p->hdu, p->name,
+              (long)get_stat_mtime(&p->stats[i]).tv_sec,
+              get_stat_mtime(&p->stats[i]).tv_nsec,
+              (long)p->stats[i].st_size, p->values[i]!=NULL,
+              p->files[i], p->values[i] ? p->values[i] : "");
+
+  /* Close the file and rename it. */
+  if( fclose(fp) || rename(tmpname, cachefile) )
+    {
+      error(EXIT_SUCCESS, errno, "%s: WARNING: couldn't write cache",
+            cachefile);
+      remove(tmpname);
+    }
+  free(tmpname);
+}
+
+
+
+
+
+/* Read the value of the given keyword in the given HDU of all the files
+   (in parallel). The returned array has one element for each file: the
+   value of the keyword, or NULL if it didn't exist. */
+static char **
+fits_keyvalue_read(gal_list_str_t *files, char *hdu, char *name,
+                   size_t numthreads, char *cachefile)
+{
+  size_t i, numfiles=gal_list_str_number(files);
+  struct fits_keyvalue_params p={0};
+  gal_list_str_t *f;
+
+  /* If the 'fits_is_reentrant' function exists, then use it to see if
+     CFITSIO was configured in multi-thread mode. Otherwise, just use a
+     single thread (files that can't be parsed directly are read with
+     CFITSIO). */
+#if GAL_CONFIG_HAVE_FITS_IS_REENTRANT == 1
+  size_t nthreads = ( fits_is_reentrant()
+                      ? (numthreads ? numthreads : gal_threads_number())
+                      : 1 );
+#else
+  size_t nthreads=1;
+#endif
+
+  /* Put the file names into an array and allocate the outputs. */
+  p.hdu=hdu;
+  p.name=name;
+  p.files=gal_pointer_allocate(GAL_TYPE_STRING, numfiles, 0, __func__,
+                               "p.files");
+  p.values=gal_pointer_allocate(GAL_TYPE_STRING, numfiles, 1, __func__,
+                                "p.values");
+  for(i=0, f=files; f!=NULL; f=f->next) p.files[i++]=f->v;
+
+  /* Read the cache. */
+  if(cachefile)
+    {
+      errno=0;
+      p.stats=malloc(numfiles*sizeof *p.stats);
+      if(p.stats==NULL)
+        error(EXIT_FAILURE, errno, "%s: allocating %zu bytes for 'stats'",
+              __func__, numfiles*sizeof *p.stats);
+      p.found=gal_pointer_allocate(GAL_TYPE_UINT8, numfiles, 1, __func__,
+                                   "p.found");
+      fits_keyvalue_cache_read(&p, cachefile);
     }
 
+  /* Read the values. */
+  gal_threads_spin_off(fits_keyvalue_on_thread, &p, numfiles, nthreads,
+                       -1, 1);
+
+  /* Write the cache and clean up. */
+  if(cachefile)
+    {
+      fits_keyvalue_cache_write(&p, cachefile, numfiles);
+      for(i=0;i<p.ncache;++i)
+        { free(p.cache[i].filename); free(p.cache[i].value); }
+      gal_list_str_free(p.cother, 1);
+      free(p.cache);
+      free(p.found);
+      free(p.stats);
+    }
+  free(p.files);
+  return p.values;
+}
+
+
+
+
+
+/* From an input list of FITS files and a HDU, select those that have a
+   certain value(s) in a certain keyword.*/
+gal_list_str_t *
+gal_fits_with_keyvalue(gal_list_str_t *files, char *hdu, char *name,
+                       gal_list_str_t *values, size_t numthreads,
+                       char *cachefile)
+{
+  size_t i;
+  char **keyvalues;
+  gal_list_str_t *f, *v, *out=NULL;
+
+  /* Read the values of the keyword in all files. */
+  keyvalues=fits_keyvalue_read(files, hdu, name, numthreads, cachefile);
+
+  /* If the value corresponds to any of the user's values for this
+     keyword, add it to the list of output names. */
+  for(i=0, f=files; f!=NULL; f=f->next, ++i)
+    if(keyvalues[i])
+      {
+        for(v=values; v!=NULL; v=v->next)
+          if( strcmp(v->v, keyvalues[i])==0 )
+            { gal_list_str_add(&out, f->v, 1); break; }
+        free(keyvalues[i]);
+      }
+
   /* Reverse the list to be in same order as input and return. */
+  free(keyvalues);
+  gal_list_str_reverse(&out);
+  return out;
+}
+
+
+
+
+
+/* From an input list of FITS files and a HDU, select those that have a
+   certain value(s) in a certain keyword.*/
+gal_list_str_t *
+gal_fits_unique_keyvalues(gal_list_str_t *files, char *hdu, char *name,
+                          size_t numthreads, char *cachefile)
+{
+  size_t i;
+  int newvalue;
+  char *keyv, **keyvalues;
+  gal_list_str_t *f, *v, *out=NULL;
+
+  /* Read the values of the keyword in all files. */
+  keyvalues=fits_keyvalue_read(files, hdu, name, numthreads, cachefile);
+
+  /* If the value is new, add it to the list. */
+  for(i=0, f=files; f!=NULL; f=f->next, ++i)
+    if(keyvalues[i])
+      {
+        newvalue=1;
+        keyv=gal_txt_trim_space(keyvalues[i]);
+        for(v=out; v!=NULL; v=v->next)
+          { if( strcmp(v->v, keyv)==0 ) newvalue=0; }
+        if(newvalue) gal_list_str_add(&out, keyv, 1);
+        free(keyvalues[i]);
+      }
+
+  /* Reverse the list to be in same order as input and return. */
+  free(keyvalues);
   gal_list_str_reverse(&out);
   return out;
 }
@@ -2533,6 +2997,25 @@ gal_fits_img_info_dim(char *filename, char *hdu, size_t *ndim)
 
 
 
+/* Total number of bytes read and written for the trace (images may be
+   read or written from different threads). */
+static double fits_bytes_read=0.0, fits_bytes_written=0.0;
+static pthread_mutex_t fits_bytes_mutex=PTHREAD_MUTEX_INITIALIZER;
+
+static void
+fits_bytes_trace(const char *name, double *total, gal_data_t *data)
+{
+  if(gal_timing_trace_is_active()==0) return;
+  pthread_mutex_lock(&fits_bytes_mutex);
+  *total += (double)(data->size) * gal_type_sizeof(data->type);
+  gal_timing_trace_counter(name, *total);
+  pthread_mutex_unlock(&fits_bytes_mutex);
+}
+
+
+
+
+
 /* Read a FITS image HDU into a Gnuastro data structure. */
 gal_data_t *
 gal_fits_img_read(char *filename, char *hdu, size_t minmapsize,
@@ -2548,6 +3031,7 @@ gal_fits_img_read(char *filename, char *hdu, size_t minmapsize,
 
 
   /* Check HDU for realistic conditions: */
+  gal_timing_trace_begin("fits: image read");
   fptr=gal_fits_hdu_open_format(filename, hdu, 0);
 
 
@@ -2597,6 +3081,8 @@ gal_fits_img_read(char *filename, char *hdu, size_t minmapsize,
   /* Close the input FITS file. */
   fits_close_file(fptr, &status);
   gal_fits_io_error(status, NULL);
+  fits_bytes_trace("fits: bytes read", &fits_bytes_read, img);
+  gal_timing_trace_end("fits: image read");
 
 
   /* Return the filled data structure */
@@ -2866,6 +3352,7 @@ gal_fits_img_write(gal_data_t *data, char *filename,
   fitsfile *fptr;
 
   /* Write the data array into a FITS file and keep it open: */
+  gal_timing_trace_begin("fits: image write");
   fptr=gal_fits_img_write_to_ptr(data, filename);
 
   /* Write all the headers and the version information. */
@@ -2874,6 +3361,8 @@ gal_fits_img_write(gal_data_t *data, char *filename,
   /* Close the FITS file. */
   fits_close_file(fptr, &status);
   gal_fits_io_error(status, NULL);
+  fits_bytes_trace("fits: bytes written", &fits_bytes_written, data);
+  gal_timing_trace_end("fits: image write");
 }
 
 
@@ -54,6 +54,16 @@ __BEGIN_C_DECLS  /* From C++ preparations */
 /**************************************************************/
 /**********               Environment              ************/
 /**************************************************************/
+/* What to do when an allocation doesn't fit in the memory budget. */
+enum gal_checkset_spill_modes
+{
+  GAL_CHECKSET_SPILL_INVALID,   /* ==0 by C standard (not set: 'file'). */
+
+  GAL_CHECKSET_SPILL_FILE,      /* Memory-map to a file (old behavior). */
+  GAL_CHECKSET_SPILL_RAM,       /* Allocate in RAM anyway (with notice). */
+  GAL_CHECKSET_SPILL_FAIL,      /* Abort with an error.                  */
+};
+
 gsl_rng *
 gal_checkset_gsl_rng(uint8_t envseed_bool, const char **name,
                      unsigned long int *seed);
@@ -61,6 +71,13 @@ gal_checkset_gsl_rng(uint8_t envseed_bool, const char **name,
 size_t
 gal_checkset_ram_available(int quietmmap);
 
+size_t
+gal_checkset_ram_used(void);
+
+void
+gal_checkset_memory_budget(size_t maxmemory, uint8_t spillmode,
+                           int report);
+
 int
 gal_checkset_need_mmap(size_t bytesize, size_t minmapsize, int quietmmap);
 
@@ -377,6 +377,85 @@ struct argp_option gal_commonopts_options[] =
       GAL_OPTIONS_NOT_MANDATORY,
       GAL_OPTIONS_NOT_SET
     },
+    {
+      "maxmemory",
+      GAL_OPTIONS_KEY_MAXMEMORY,
+      "INT",
+      0,
+      "Memory budget in bytes (0: no budget).",
+      GAL_OPTIONS_GROUP_OPERATING_MODE,
+      &cp->maxmemory,
+      GAL_TYPE_SIZE_T,
+      GAL_OPTIONS_RANGE_GE_0,
+      GAL_OPTIONS_NOT_MANDATORY,
+      GAL_OPTIONS_NOT_SET
+    },
+    {
+      "spillmode",
+      GAL_OPTIONS_KEY_SPILLMODE,
+      "STR",
+      0,
+      "Beyond '--maxmemory': 'file', 'ram', 'fail'.",
+      GAL_OPTIONS_GROUP_OPERATING_MODE,
+      &cp->spillmode,
+      GAL_TYPE_STRING,
+      GAL_OPTIONS_RANGE_ANY,
+      GAL_OPTIONS_NOT_MANDATORY,
+      GAL_OPTIONS_NOT_SET,
+      gal_options_read_spillmode
+    },
+    {
+      "memreport",
+      GAL_OPTIONS_KEY_MEMREPORT,
+      0,
+      0,
+      "Report the peak memory usage at exit.",
+      GAL_OPTIONS_GROUP_OPERATING_MODE,
+      &cp->memreport,
+      GAL_OPTIONS_NO_ARG_TYPE,
+      GAL_OPTIONS_RANGE_0_OR_1,
+      GAL_OPTIONS_NOT_MANDATORY,
+      GAL_OPTIONS_NOT_SET
+    },
+    {
+      "trace",
+      GAL_OPTIONS_KEY_TRACE,
+      "STR",
+      0,
+      "Write a trace of the stages (JSON) in this file.",
+      GAL_OPTIONS_GROUP_OPERATING_MODE,
+      &cp->trace,
+      GAL_TYPE_STRING,
+      GAL_OPTIONS_RANGE_ANY,
+      GAL_OPTIONS_NOT_MANDATORY,
+      GAL_OPTIONS_NOT_SET
+    },
+    {
+      "batch",
+      GAL_OPTIONS_KEY_BATCH,
+      0,
+      0,
+      "Run each line of standard input as a job.",
+      GAL_OPTIONS_GROUP_OPERATING_MODE,
+      &cp->batch,
+      GAL_OPTIONS_NO_ARG_TYPE,
+      GAL_OPTIONS_RANGE_0_OR_1,
+      GAL_OPTIONS_NOT_MANDATORY,
+      GAL_OPTIONS_NOT_SET
+    },
+    {
+      "server",
+      GAL_OPTIONS_KEY_SERVER,
+      "STR",
+      0,
+      "Run jobs sent to this (UNIX) socket.",
+      GAL_OPTIONS_GROUP_OPERATING_MODE,
+      &cp->server,
+      GAL_TYPE_STRING,
+      GAL_OPTIONS_RANGE_ANY,
+      GAL_OPTIONS_NOT_MANDATORY,
+      GAL_OPTIONS_NOT_SET
+    },
     {
       "log",
       GAL_OPTIONS_KEY_LOG,
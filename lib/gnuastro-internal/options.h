@@ -128,6 +128,12 @@ enum options_common_keys
   GAL_OPTIONS_KEY_INTERPMETRIC,
   GAL_OPTIONS_KEY_INTERPNUMNGB,
   GAL_OPTIONS_KEY_WCSLINEARMATRIX,
+  GAL_OPTIONS_KEY_MAXMEMORY,
+  GAL_OPTIONS_KEY_SPILLMODE,
+  GAL_OPTIONS_KEY_MEMREPORT,
+  GAL_OPTIONS_KEY_TRACE,
+  GAL_OPTIONS_KEY_BATCH,
+  GAL_OPTIONS_KEY_SERVER,
 };
 
 
@@ -207,6 +213,12 @@ struct gal_options_common_params
   size_t            numthreads; /* Number of threads to use.              */
   size_t            minmapsize; /* Minimum bytes necessary to use mmap.   */
   uint8_t            quietmmap; /* ==0: print mmap'd file name and size.  */
+  size_t             maxmemory; /* Memory budget (bytes), 0: no budget.  */
+  uint8_t            spillmode; /* What to do when budget is exceeded.    */
+  uint8_t            memreport; /* Report the peak memory at exit.        */
+  char                  *trace; /* Name of file to write the trace.       */
+  uint8_t                batch; /* Run jobs from stdin (only for --help). */
+  char                 *server; /* Server socket name (only for --help).  */
   uint8_t                  log; /* Make a log file.                       */
   char            *onlyversion; /* Redundant, kept/set for generality.    */
 
@@ -299,6 +311,10 @@ void *
 gal_options_read_interpmetric(struct argp_option *option, char *arg,
                               char *filename, size_t lineno, void *junk);
 
+void *
+gal_options_read_spillmode(struct argp_option *option, char *arg,
+                           char *filename, size_t lineno, void *junk);
+
 gal_data_t *
 gal_options_parse_list_of_numbers(char *string, char *filename,
                                   size_t lineno, uint8_t type);
@@ -376,6 +392,9 @@ gal_options_stdin_error(long stdintimeout, int precedence, char *name);
 gal_list_str_t *
 gal_options_check_stdin(char *inputname, long stdintimeout, char *name);
 
+void
+gal_options_batch(int *argc, char ***argv);
+
 
 
 
@@ -58,6 +58,21 @@ gal_timing_time_based_rng_seed();
 void
 gal_timing_report(struct timeval *t1, char *jobname, size_t level);
 
+void
+gal_timing_trace_start(char *filename);
+
+void
+gal_timing_trace_begin(const char *name);
+
+void
+gal_timing_trace_end(const char *name);
+
+void
+gal_timing_trace_counter(const char *name, double value);
+
+int
+gal_timing_trace_is_active(void);
+
 
 
 __END_C_DECLS    /* From C++ preparations */
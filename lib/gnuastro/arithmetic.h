@@ -67,6 +67,7 @@ __BEGIN_C_DECLS  /* From C++ preparations */
 #define GAL_ARITHMETIC_FLAG_NUMOK    4
 #define GAL_ARITHMETIC_FLAG_ENVSEED  8
 #define GAL_ARITHMETIC_FLAG_QUIET    16
+#define GAL_ARITHMETIC_FLAG_CLIPNUM  32
 
 #define GAL_ARITHMETIC_FLAGS_BASIC ( GAL_ARITHMETIC_FLAG_INPLACE   \
                                      | GAL_ARITHMETIC_FLAG_FREE    \
@@ -166,6 +167,15 @@ enum gal_arithmetic_operators
   GAL_ARITHMETIC_OP_LY_TO_AU,     /* Light-years to Astronomical units (AU). */
   GAL_ARITHMETIC_OP_AU_TO_LY,     /* Astronomical units (AU) to Light-years. */
 
+  GAL_ARITHMETIC_OP_Z_TO_AGE,     /* Age of universe at redshift (Gyr).  */
+  GAL_ARITHMETIC_OP_Z_TO_PROPER_DISTANCE,/* Proper distance (Mpc).       */
+  GAL_ARITHMETIC_OP_Z_TO_ANGULAR_DISTANCE,/* Angular diameter dist. (Mpc).*/
+  GAL_ARITHMETIC_OP_Z_TO_LUMINOSITY_DISTANCE,/* Luminosity dist. (Mpc).  */
+  GAL_ARITHMETIC_OP_Z_TO_DISTANCE_MODULUS,/* Distance modulus.           */
+  GAL_ARITHMETIC_OP_Z_TO_ABSMAG_CONV,/* Apparent to absolute mag. conv.  */
+  GAL_ARITHMETIC_OP_Z_TO_COMOVING_VOLUME,/* Comoving volume (Mpc^3).     */
+  GAL_ARITHMETIC_OP_Z_TO_CRITICAL_DENSITY,/* Critical density (g/cm^3).  */
+
   GAL_ARITHMETIC_OP_MINVAL,       /* Minimum value of array.               */
   GAL_ARITHMETIC_OP_MAXVAL,       /* Maximum value of array.               */
   GAL_ARITHMETIC_OP_NUMBERVAL,    /* Number of (non-blank) elements.       */
@@ -245,6 +255,11 @@ gal_arithmetic_load_col(char *str, int searchin, int ignorecase,
 gal_data_t *
 gal_arithmetic(int operator, size_t numthreads, int flags, ...);
 
+gal_data_t *
+gal_arithmetic_stack(int operator, size_t numthreads, int flags,
+                     gal_data_t *list, gal_data_t *params,
+                     float *weights, gal_data_t *masks);
+
 
 
 __END_C_DECLS    /* From C++ preparations */
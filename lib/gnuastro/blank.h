@@ -134,6 +134,9 @@ gal_blank_flag_not(gal_data_t *input);
 void
 gal_blank_flag_apply(gal_data_t *input, gal_data_t *flag);
 
+gal_data_t *
+gal_blank_spans(gal_data_t *input, int updateflag);
+
 void
 gal_blank_remove(gal_data_t *data);
 
@@ -25,6 +25,7 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 
 /* Include other headers if necessary here. Note that other header files
    must be included before the C++ preparations below */
+#include <gnuastro/data.h>
 
 
 
@@ -47,6 +48,25 @@ __BEGIN_C_DECLS  /* From C++ preparations */
 
 
 
+/* Quantities that can be calculated over an array of redshifts with
+   'gal_cosmology_array'. */
+enum gal_cosmology_quantities
+{
+  GAL_COSMOLOGY_INVALID,            /* Invalid (=0 by C standard).  */
+
+  GAL_COSMOLOGY_AGE,                /* Age of universe (Gyrs).      */
+  GAL_COSMOLOGY_PROPER_DISTANCE,    /* Proper distance (Mpc).       */
+  GAL_COSMOLOGY_COMOVING_VOLUME,    /* Comoving volume (Mpc^3).     */
+  GAL_COSMOLOGY_CRITICAL_DENSITY,   /* Critical density (g/cm^3).   */
+  GAL_COSMOLOGY_ANGULAR_DISTANCE,   /* Angular diameter dist. (Mpc).*/
+  GAL_COSMOLOGY_LUMINOSITY_DISTANCE,/* Luminosity distance (Mpc).   */
+  GAL_COSMOLOGY_DISTANCE_MODULUS,   /* Distance modulus (no units). */
+  GAL_COSMOLOGY_TO_ABSOLUTE_MAG,    /* Apparent to absolute mag.    */
+  GAL_COSMOLOGY_VELOCITY_FROM_Z,    /* Velocity from z (km/s).      */
+};
+
+
+
 
 /* Age of the universe (in Gyrs). */
 double
@@ -94,6 +114,12 @@ gal_cosmology_velocity_from_z(double z);
 double
 gal_cosmology_z_from_velocity(double v);
 
+/* Any of the quantities above over an array of redshifts. */
+gal_data_t *
+gal_cosmology_array(gal_data_t *zin, int quantity, double H0,
+                    double o_lambda_0, double o_matter_0,
+                    double o_radiation_0, size_t numthreads);
+
 __END_C_DECLS    /* From C++ preparations */
 
 #endif           /* __GAL_COSMOLOGY_H__ */
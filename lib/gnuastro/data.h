@@ -90,12 +90,18 @@ __BEGIN_C_DECLS  /* From C++ preparations */
 /* Bit 4: Dataset is sorted and decreasing. */
 #define GAL_DATA_FLAG_SORTED_D     0x10
 
+/* Bit 5: The array is foreign (owned by the caller or another library,
+          for example a NumPy array) and should never be freed by
+          'gal_data_free' or 'gal_data_free_contents'. Unlike the flags
+          above, this one is not copied into new datasets. */
+#define GAL_DATA_FLAG_FOREIGN      0x20
+
 /* Maximum internal flag value. Higher-level flags can be defined with the
    bitwise shift operators on this value to define internal flags for
    libraries/programs that depend on Gnuastro without causing any possible
    conflict with the internal flags or having to check the values manually
    on every release. */
-#define GAL_DATA_FLAG_MAXFLAG      GAL_DATA_FLAG_SORTED_D
+#define GAL_DATA_FLAG_MAXFLAG      GAL_DATA_FLAG_FOREIGN
 
 
 
@@ -230,6 +236,31 @@ typedef struct gal_data_t
 
 
 
+/* Light-weight view over an already allocated array.
+
+   Many low-level operations only need a 'gal_data_t' to describe an
+   existing array (or a part of it) to a library function, for example one
+   window, tile or sub-set of values in the inner loop of a thread. Using
+   'gal_data_alloc' in such cases will need three heap allocations (the
+   structure, its 'dsize' and the array) and the same number of frees on
+   every iteration. 'gal_data_view_t' keeps its 'dsize' within itself, so
+   it can be defined on the stack (or in an array allocated once) and
+   filled with 'gal_data_view'. It never owns anything: its 'array' is
+   from the caller and it should never be given to 'gal_data_free' or
+   'gal_data_free_contents'. It is valid until the variable holding it
+   goes out of scope and it is thread-safe as long as each thread has its
+   own view. */
+#define GAL_DATA_VIEW_MAXDIM 10
+typedef struct gal_data_view_t
+{
+  gal_data_t              data;  /* The dataset to pass to functions.     */
+  size_t dsize[GAL_DATA_VIEW_MAXDIM]; /* Space for 'data.dsize'.          */
+} gal_data_view_t;
+
+
+
+
+
 /*********************************************************************/
 /*************              allocation             *******************/
 /*********************************************************************/
@@ -253,6 +284,10 @@ gal_data_free_contents(gal_data_t *data);
 void
 gal_data_free(gal_data_t *data);
 
+gal_data_t *
+gal_data_view(gal_data_view_t *view, void *array, uint8_t type,
+              size_t ndim, size_t *dsize, gal_data_t *block);
+
 
 
 
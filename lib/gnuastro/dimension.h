@@ -127,18 +127,44 @@ gal_dimension_dist_elliptical(double *center, double *pa_deg, double *q,
 /************************************************************************/
 /********************    Collapsing a dimension    **********************/
 /************************************************************************/
+/* Operators that can be used in 'gal_dimension_collapse_fits'. */
+enum gal_dimension_collapse_operators
+{
+  GAL_DIMENSION_COLLAPSE_INVALID,    /* ==0 by C standard. */
+
+  GAL_DIMENSION_COLLAPSE_SUM,
+  GAL_DIMENSION_COLLAPSE_MAX,
+  GAL_DIMENSION_COLLAPSE_MIN,
+  GAL_DIMENSION_COLLAPSE_MEAN,
+  GAL_DIMENSION_COLLAPSE_MEDIAN,
+  GAL_DIMENSION_COLLAPSE_NUMBER,
+  GAL_DIMENSION_COLLAPSE_SIGCLIP_STD,
+  GAL_DIMENSION_COLLAPSE_SIGCLIP_MEAN,
+  GAL_DIMENSION_COLLAPSE_SIGCLIP_MEDIAN,
+  GAL_DIMENSION_COLLAPSE_SIGCLIP_NUMBER,
+};
+
 gal_data_t *
-gal_dimension_collapse_sum(gal_data_t *in, size_t c_dim, gal_data_t *weight);
+gal_dimension_collapse_sum(gal_data_t *in, size_t c_dim, gal_data_t *weight,
+                           size_t numthreads);
 
 gal_data_t *
 gal_dimension_collapse_mean(gal_data_t *in, size_t c_dim,
-                            gal_data_t *weight);
+                            gal_data_t *weight, size_t numthreads);
+
+gal_data_t *
+gal_dimension_collapse_number(gal_data_t *in, size_t c_dim,
+                              size_t numthreads);
 
 gal_data_t *
-gal_dimension_collapse_number(gal_data_t *in, size_t c_dim);
+gal_dimension_collapse_minmax(gal_data_t *in, size_t c_dim, int max1_min0,
+                              size_t numthreads);
 
 gal_data_t *
-gal_dimension_collapse_minmax(gal_data_t *in, size_t c_dim, int max1_min0);
+gal_dimension_collapse_fits(char *filename, char *hdu, size_t c_dim,
+                            int operator, gal_data_t *weight,
+                            size_t numthreads, size_t minmapsize,
+                            int quietmmap);
 
 gal_data_t *
 gal_dimension_collapse_median(gal_data_t *in, size_t c_dim,
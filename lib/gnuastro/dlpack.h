@@ -0,0 +1,132 @@
+/*********************************************************************
+dlpack -- Zero-copy exchange of arrays with other libraries.
+This is part of GNU Astronomy Utilities (Gnuastro) package.
+
+Original author:
+     Mohammad Akhlaghi <mohammad@akhlaghi.org>
+Contributing author(s):
+Copyright (C) 2026 Free Software Foundation, Inc.
+
+Gnuastro is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation, either version 3 of the License, or (at your
+option) any later version.
+
+Gnuastro is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+#ifndef __GAL_DLPACK_H__
+#define __GAL_DLPACK_H__
+
+/* Include other headers if necessary here. Note that other header files
+   must be included before the C++ preparations below */
+#include <stdint.h>
+#include <gnuastro/data.h>
+
+
+/* C++ Preparations */
+#undef __BEGIN_C_DECLS
+#undef __END_C_DECLS
+#ifdef __cplusplus
+# define __BEGIN_C_DECLS extern "C" {
+# define __END_C_DECLS }
+#else
+# define __BEGIN_C_DECLS                /* empty */
+# define __END_C_DECLS                  /* empty */
+#endif
+/* End of C++ preparations */
+
+
+
+
+
+/* Actual header contants (the above were for the Pre-processor). */
+__BEGIN_C_DECLS  /* From C++ preparations */
+
+
+
+
+
+/* DLPack (https://dmlc.github.io/dlpack) is the common in-memory tensor
+   structure that is used to exchange arrays between NumPy, CuPy, PyTorch,
+   JAX and many other libraries without copying. The structures below
+   have exactly the same layout (and thus ABI) as the 'DLDevice',
+   'DLDataType', 'DLTensor' and 'DLManagedTensor' structures of the
+   (version 0.8) 'dlpack.h' header, but are defined here with Gnuastro's
+   prefix so Gnuastro doesn't depend on that header (and doesn't conflict
+   with it when a caller also includes it). A pointer to one can therefore
+   be cast to a pointer to the other. */
+
+/* Device types (only 'GAL_DLPACK_DEVICE_CPU' is supported in Gnuastro). */
+#define GAL_DLPACK_DEVICE_CPU       1
+
+/* Type codes (the 'code' element of 'gal_dlpack_dtype_t'). */
+#define GAL_DLPACK_CODE_INT         0
+#define GAL_DLPACK_CODE_UINT        1
+#define GAL_DLPACK_CODE_FLOAT       2
+#define GAL_DLPACK_CODE_COMPLEX     5
+#define GAL_DLPACK_CODE_BOOL        6
+
+typedef struct gal_dlpack_device_t
+{
+  int32_t     device_type;      /* 'GAL_DLPACK_DEVICE_*' (enum in DLPack).*/
+  int32_t       device_id;      /* Identifier of the device (0 for CPU).  */
+} gal_dlpack_device_t;
+
+typedef struct gal_dlpack_dtype_t
+{
+  uint8_t            code;      /* 'GAL_DLPACK_CODE_*'.                   */
+  uint8_t            bits;      /* Number of bits in each element.        */
+  uint16_t          lanes;      /* Vector lanes (always 1 in Gnuastro).   */
+} gal_dlpack_dtype_t;
+
+typedef struct gal_dlpack_tensor_t
+{
+  void              *data;      /* Start of the array.                    */
+  gal_dlpack_device_t device;   /* Device hosting the array.              */
+  int32_t            ndim;      /* Number of dimensions.                  */
+  gal_dlpack_dtype_t dtype;     /* Type of each element.                  */
+  int64_t          *shape;      /* Length along each dimension.           */
+  int64_t        *strides;      /* Strides (in elements, not bytes).      */
+  uint64_t    byte_offset;      /* Offset of first element from 'data'.   */
+} gal_dlpack_tensor_t;
+
+typedef struct gal_dlpack_managed_t
+{
+  gal_dlpack_tensor_t dl_tensor;  /* Description of the array.            */
+  void           *manager_ctx;    /* Context of the producer.             */
+  void (*deleter)(struct gal_dlpack_managed_t *self); /* Release function.*/
+} gal_dlpack_managed_t;
+
+
+
+
+
+/*********************************************************************/
+/*************               Functions              ******************/
+/*********************************************************************/
+gal_data_t *
+gal_dlpack_view(void *array, uint8_t type, size_t ndim, int64_t *shape,
+                int64_t *strides);
+
+void
+gal_dlpack_view_free(gal_data_t *view);
+
+gal_data_t *
+gal_dlpack_import(gal_dlpack_managed_t *managed);
+
+gal_dlpack_managed_t *
+gal_dlpack_export(gal_data_t *data, int steal);
+
+
+
+
+
+__END_C_DECLS    /* From C++ preparations */
+
+#endif           /* __GAL_DLPACK_H__ */
@@ -121,6 +121,15 @@ gal_fit_1d_polynomial_robust(gal_data_t *xin, gal_data_t *yin,
 gal_data_t *
 gal_fit_1d_polynomial_estimate(gal_data_t *fit, gal_data_t *xin);
 
+gal_data_t *
+gal_fit_1d_groups(gal_data_t *xin, gal_data_t *yin, gal_data_t *ywht,
+                  gal_data_t *group, uint8_t fitid, size_t maxpower,
+                  uint8_t robustid, size_t numthreads);
+
+gal_data_t *
+gal_fit_1d_polynomial_dim(gal_data_t *in, size_t dim, size_t maxpower,
+                          uint8_t robustid, int model, size_t numthreads);
+
 __END_C_DECLS    /* From C++ preparations */
 
 #endif           /* __GAL_FIT_H__ */
@@ -26,6 +26,8 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 
 /* Include other headers if necessary here. Note that other header files
    must be included before the C++ preparations below */
+#include <stdint.h>
+#include <gnuastro/data.h>
 
 
 
@@ -55,6 +57,26 @@ __BEGIN_C_DECLS  /* From C++ preparations */
 
 
 
+/* A polygon that is prepared for checking many points (see
+   'gal_polygon_prepare'). */
+typedef struct gal_polygon_prepared_t
+{
+  size_t             n;   /* Number of vertices.                      */
+  double            *v;   /* Copy of the vertices (2*n elements).     */
+  int           convex;   /* Use the convex (not winding) test.       */
+  double        min[2];   /* Bottom-left corner of the grid.          */
+  double       cell[2];   /* Width of the grid cells along each axis. */
+  size_t         ngrid;   /* Number of cells along each axis.         */
+  uint8_t       *state;   /* Inside, outside or edge for each cell.   */
+  size_t    *slabstart;   /* First edge of each slab (ngrid+1).       */
+  size_t    *slabedges;   /* Edges overlapping each slab.             */
+  double          *vys;   /* Sorted second coordinate of vertices.    */
+} gal_polygon_prepared_t;
+
+
+
+
+
 /***************************************************************/
 /**************     Function declarations     ******************/
 /***************************************************************/
@@ -89,6 +111,25 @@ gal_polygon_clip(double *s, size_t n, double *c, size_t m,
 void
 gal_polygon_vertices_sort(double *in, size_t n, size_t *ordinds);
 
+gal_polygon_prepared_t *
+gal_polygon_prepare(double *v, size_t n, int convex);
+
+void
+gal_polygon_prepared_free(gal_polygon_prepared_t *pp);
+
+int
+gal_polygon_prepared_is_inside(gal_polygon_prepared_t *pp, double *p);
+
+gal_data_t *
+gal_polygon_prepared_is_inside_points(gal_polygon_prepared_t *pp,
+                                      gal_data_t *c1, gal_data_t *c2,
+                                      size_t numthreads);
+
+gal_data_t *
+gal_polygon_prepared_mask(gal_polygon_prepared_t *pp, size_t *dsize,
+                          size_t numthreads, size_t minmapsize,
+                          int quietmmap);
+
 __END_C_DECLS    /* From C++ preparations */
 
 #endif           /* __GAL_POLYGON_H__ */
@@ -45,6 +45,24 @@ __BEGIN_C_DECLS  /* From C++ preparations */
 
 
 
+/* Identifiers for each operator. */
+enum gal_pool_operators
+{
+  GAL_POOL_INVALID,  /* ==0 by C standard.          */
+
+  GAL_POOL_MAX,      /* Maximum the desired pixels. */
+  GAL_POOL_MIN,      /* Minimum the desired pixels. */
+  GAL_POOL_SUM,      /* Sum of desired pixels.      */
+  GAL_POOL_MEAN,     /* Mean the desired pixel.     */
+  GAL_POOL_MEDIAN,   /* Median the desired pixels.  */
+};
+
+
+
+gal_data_t *
+gal_pool_window(gal_data_t *input, int operator, size_t *wsize,
+                size_t *stride, size_t *before, size_t numthreads);
+
 gal_data_t *
 gal_pool_max(gal_data_t *input, size_t psize, size_t numthreads);
 
@@ -65,6 +65,22 @@ gal_python_type_from_numpy(int type);
 
 
 
+/*************************************************************
+ **************      Zero-copy arrays          ***************
+ *************************************************************/
+/* To avoid including 'Python.h' in this header (which would force it on
+   any program that includes this header), the Python objects are passed
+   as 'void *' (they are 'PyObject *'). */
+gal_data_t *
+gal_python_data_from_numpy(void *obj);
+
+void *
+gal_python_data_to_numpy(gal_data_t *data, int steal);
+
+
+
+
+
 __END_C_DECLS    /* From C++ preparations */
 
-#endif           /* __GAL_TABLE_H__ */
+#endif           /* __GAL_PYTHON_H__ */
@@ -25,6 +25,8 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 
 /* Include other headers if necessary here. Note that other header files
    must be included before the C++ preparations below */
+#include <stddef.h>
+#include <stdint.h>
 
 
 
@@ -203,6 +205,23 @@ gal_qsort_index_multi_i(const void *a, const void *b);
 
 
 
+
+
+
+/*****************************************************************/
+/***************      Radix and merge sort      ******************/
+/*****************************************************************/
+void
+gal_qsort_radix(void *array, uint8_t type, size_t size, int decreasing,
+                size_t numthreads, size_t minmapsize, int quietmmap);
+
+void
+gal_qsort_radix_index(void *values, uint8_t type, size_t *index,
+                      size_t size, int decreasing, size_t numthreads,
+                      size_t minmapsize, int quietmmap);
+
+
+
 __END_C_DECLS    /* From C++ preparations */
 
 #endif           /* __GAL_QSORT_H__ */
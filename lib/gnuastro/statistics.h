@@ -126,6 +126,10 @@ gal_statistics_has_negative(gal_data_t *data);
 gal_data_t *
 gal_statistics_mode(gal_data_t *input, float errorstd, int inplace);
 
+gal_data_t *
+gal_statistics_mode_hist(gal_data_t *input, float mirrordist,
+                         size_t numbins);
+
 gal_data_t *
 gal_statistics_mode_mirror_plots(gal_data_t *input, gal_data_t *value,
                                  size_t numbins, int inplace,
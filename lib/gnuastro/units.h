@@ -36,6 +36,8 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <gnuastro/config.h>
 #endif
 
+#include <gnuastro/data.h>
+
 
 /* C++ Preparations */
 #undef __BEGIN_C_DECLS
@@ -129,6 +131,20 @@ gal_units_ly_to_au(double ly);
 double
 gal_units_au_to_ly(double au);
 
+gal_data_t *
+gal_units_ra_to_degree_column(gal_data_t *in, size_t numthreads);
+
+gal_data_t *
+gal_units_dec_to_degree_column(gal_data_t *in, size_t numthreads);
+
+gal_data_t *
+gal_units_degree_to_ra_column(gal_data_t *in, int usecolon,
+                              size_t numthreads);
+
+gal_data_t *
+gal_units_degree_to_dec_column(gal_data_t *in, int usecolon,
+                               size_t numthreads);
+
 __END_C_DECLS    /* From C++ preparations */
 
 #endif           /* __GAL_UNITS_H__ */
@@ -354,9 +354,10 @@ static void
 jpeg_write_array(JSAMPLE *jsr, gal_data_t *in, char *filename,
                  uint8_t quality, float widthincm)
 {
-  JSAMPROW r[1];
+  size_t i;
+  JSAMPROW *rows;
   FILE * outfile;
-  int row_stride=0, c;
+  int row_stride=0;
   size_t *dsize=in->dsize;
   struct jpeg_error_mgr jerr;
   struct jpeg_compress_struct cinfo;
@@ -407,13 +408,20 @@ jpeg_write_array(JSAMPLE *jsr, gal_data_t *in, char *filename,
   cinfo.Y_density=cinfo.X_density=dsize[1]/(widthincm/2.54);
   jpeg_start_compress(&cinfo, TRUE);
 
-  /* cinfo.next_scanline is 'unsigned int' */
-  c=dsize[0]-1; /* In JPEG the first row is on the bottom!  */
+  /* Pointers to the start of each row (in JPEG the first row is on the
+     bottom!). All the rows are given to libjpeg together, so it can
+     compress as many rows as it needs in each call. Note that
+     'cinfo.next_scanline' is 'unsigned int'. */
+  errno=0;
+  rows=malloc(dsize[0] * sizeof *rows);
+  if(rows==NULL)
+    error(EXIT_FAILURE, errno, "%s: allocating %zu bytes for 'rows'",
+          __func__, dsize[0] * sizeof *rows);
+  for(i=0;i<dsize[0];++i) rows[i] = &jsr[ (dsize[0]-1-i) * row_stride ];
   while (cinfo.next_scanline < cinfo.image_height)
-    {
-      r[0] = & jsr[c-- * row_stride];
-      (void) jpeg_write_scanlines(&cinfo, r, 1);
-    }
+    (void) jpeg_write_scanlines(&cinfo, rows + cinfo.next_scanline,
+                                cinfo.image_height - cinfo.next_scanline);
+  free(rows);
 
   jpeg_finish_compress(&cinfo);
   fclose(outfile);
@@ -452,10 +460,20 @@ gal_jpeg_write(gal_data_t *in, char *filename, uint8_t quality,
           "write permssion. Note that the JPEG standard only allows one "
           "image per file", filename);
 
-  /* Make sure the JSAMPLE is 8bits, then allocate the necessary space
-     based on the number of channels. */
+  /* Make sure the JSAMPLE is 8bits. */
   if(sizeof *jsr!=1)
     error(EXIT_FAILURE, 0, "%s: JSAMPLE has to be 8bit", __func__);
+
+  /* With a single channel, there is no need to interleave the colors:
+     the channel's array can be written directly (as long as it isn't a
+     tile). */
+  if(numch==1 && in->block==NULL)
+    {
+      jpeg_write_array(in->array, in, filename, quality, widthincm);
+      return;
+    }
+
+  /* Allocate the necessary space based on the number of channels. */
   errno=0;
   jsr=malloc(numch * in->size * sizeof *jsr);
   if(jsr==NULL)
@@ -467,16 +485,23 @@ gal_jpeg_write(gal_data_t *in, char *filename, uint8_t quality,
   for(channel=in; channel!=NULL; channel=channel->next)
     colors[i++]=channel->array;
 
-  /* Write the different colors into jsr. */
-  for(pixel=0; pixel<in->size; ++pixel)
-    for(color=0;color<numch;++color)
-      {
-        jsr[pixel*numch+color] = colors[color][pixel];
-        /*
-        printf("color: %zu, pixel: %zu, jsr: %d\n", color, pixel,
-               (int)jsr[pixel*numch+color]);
-        */
-      }
+  /* Write the different colors into jsr (the common number of channels
+     have a dedicated loop with a fixed stride). */
+  switch(numch)
+    {
+    case 3:
+      for(pixel=0; pixel<in->size; ++pixel)
+        {
+          jsr[pixel*3  ] = colors[0][pixel];
+          jsr[pixel*3+1] = colors[1][pixel];
+          jsr[pixel*3+2] = colors[2][pixel];
+        }
+      break;
+    default:
+      for(pixel=0; pixel<in->size; ++pixel)
+        for(color=0;color<numch;++color)
+          jsr[pixel*numch+color] = colors[color][pixel];
+    }
 
   /* Write jsr to a JPEG image and clean up. */
   jpeg_write_array(jsr, in, filename, quality, widthincm);
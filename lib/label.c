@@ -239,19 +239,16 @@ gal_label_watershed(gal_data_t *values, gal_data_t *indexs,
 
 
   /* If the indexs aren't already sorted (by the value they correspond to),
-     sort them given indexs based on their flux ('gal_qsort_index_arr' is
-     defined as static in 'gnuastro/qsort.h') */
+     sort them given indexs based on their flux. This function may be
+     called on different tiles from different threads, so a sort that
+     doesn't need a global pointer is used. */
   if( !( (indexs->flag & GAL_DATA_FLAG_SORT_CH)
         && ( indexs->flag
              & (GAL_DATA_FLAG_SORTED_I
                 | GAL_DATA_FLAG_SORTED_D) ) ) )
-    {
-      gal_qsort_index_single=values->array;
-      qsort(indexs->array, indexs->size, sizeof(size_t),
-            ( min0_max1
-              ? gal_qsort_index_single_float32_d
-              : gal_qsort_index_single_float32_i) );
-    }
+    gal_qsort_radix_index(values->array, GAL_TYPE_FLOAT32, indexs->array,
+                          indexs->size, min0_max1, 1, indexs->minmapsize,
+                          indexs->quietmmap);
 
 
   /* Initialize the region we want to over-segment. */
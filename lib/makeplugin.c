@@ -31,6 +31,8 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <gnumake.h>
 
 #include <gnuastro/txt.h>
+#include <gnuastro/fits.h>
+#include <gnuastro/threads.h>
 
 #include <gnuastro-internal/options.h>
 #include <gnuastro-internal/checkset.h>
@@ -217,12 +219,30 @@ makeplugin_fits_check_input(char **argv, size_t numargs, char *name)
 
 
 
+/* Number of threads to read the keywords of the files with: when
+   CFITSIO isn't configured in multi-thread mode (or is older than
+   version 3.30 where 'fits_is_reentrant' was added), only use one. */
+static size_t
+makeplugin_fits_numthreads(void)
+{
+#if GAL_CONFIG_HAVE_FITS_IS_REENTRANT == 1
+  return fits_is_reentrant() ? gal_threads_number() : 1;
+#else
+  return 1;
+#endif
+}
+
+
+
+
+
 /* Select files, were a certain keyword has a certain value. It takes four
-   arguments:
+   arguments (and an optional fifth):
        0. Keyword name.
        1. Keyword value(s).
        2. HDU (fixed in all files).
-       3. List of files. */
+       3. List of files.
+       4. Cache file (optional). */
 static char *
 makeplugin_fits_with_keyvalue(const char *caller, unsigned int argc,
                               char **argv)
@@ -231,6 +251,7 @@ makeplugin_fits_with_keyvalue(const char *caller, unsigned int argc,
   char *name=gal_txt_trim_space(argv[0]);
   gal_list_str_t *files=NULL, *values=NULL;
   char *out, *hdu=gal_txt_trim_space(argv[2]);
+  char *cache = argc>4 ? gal_txt_trim_space(argv[4]) : NULL;
 
   /* If any of the inputs are empty, then don't bother continuing. */
   if( makeplugin_fits_check_input(argv, 4, fits_with_keyvalue_name)==0 )
@@ -240,7 +261,8 @@ makeplugin_fits_with_keyvalue(const char *caller, unsigned int argc,
      values and find the output files.*/
   files=gal_list_str_extract(argv[3]);
   values=gal_list_str_extract(argv[1]);
-  outlist=gal_fits_with_keyvalue(files, hdu, name, values);
+  outlist=gal_fits_with_keyvalue(files, hdu, name, values,
+                                 makeplugin_fits_numthreads(), cache);
 
   /* Write the output string */
   out=gal_list_str_cat(outlist, ' ');
@@ -256,10 +278,11 @@ makeplugin_fits_with_keyvalue(const char *caller, unsigned int argc,
 
 
 /* Return the unique values given to a certain keyword in many FITS
-   files. It takes three arguments.
+   files. It takes three arguments (and an optional fourth).
        0. Keyword name.
        1. HDU (fixed in all files).
-       2. List of files. */
+       2. List of files.
+       3. Cache file (optional). */
 static char *
 makeplugin_fits_unique_keyvalues(const char *caller, unsigned int argc,
                                  char **argv)
@@ -268,6 +291,7 @@ makeplugin_fits_unique_keyvalues(const char *caller, unsigned int argc,
   gal_list_str_t *outlist=NULL;
   char *name=gal_txt_trim_space(argv[0]);
   char *out, *hdu=gal_txt_trim_space(argv[1]);
+  char *cache = argc>3 ? gal_txt_trim_space(argv[3]) : NULL;
 
   /* If any of the inputs are empty, then don't bother continuing. */
   if( makeplugin_fits_check_input(argv, 3, fits_unique_keyvalues_name)==0 )
@@ -276,7 +300,8 @@ makeplugin_fits_unique_keyvalues(const char *caller, unsigned int argc,
   /* Extract the components in the arguments with possibly multiple
      values and find the output files.*/
   files=gal_list_str_extract(argv[2]);
-  outlist=gal_fits_unique_keyvalues(files, hdu, name);
+  outlist=gal_fits_unique_keyvalues(files, hdu, name,
+                                    makeplugin_fits_numthreads(), cache);
 
   /* Write the output value. */
   out=gal_list_str_cat(outlist, ' ');
@@ -308,15 +333,15 @@ libgnuastro_make_gmk_setup()
                    2, 2, GMK_FUNC_DEFAULT);
 
   /* Select files, were a certain keyword has a certain value. It takes
-     four arguments. */
+     four arguments (the fifth, optional, is the cache file). */
   gmk_add_function(fits_with_keyvalue_name, makeplugin_fits_with_keyvalue,
-                   4, 4, GMK_FUNC_DEFAULT);
+                   4, 5, GMK_FUNC_DEFAULT);
 
   /* Return the unique values given to a certain keyword in many FITS
      files.*/
   gmk_add_function(fits_unique_keyvalues_name,
                    makeplugin_fits_unique_keyvalues,
-                   3, 3, GMK_FUNC_DEFAULT);
+                   3, 4, GMK_FUNC_DEFAULT);
 
   /* Everything is good, return 1 (success). */
   return 1;
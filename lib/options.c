@@ -25,8 +25,14 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <argp.h>
 #include <errno.h>
 #include <error.h>
+#include <fcntl.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
 
 #include <gnuastro/wcs.h>
 #include <gnuastro/git.h>
@@ -675,6 +681,59 @@ gal_options_read_interpmetric(struct argp_option *option, char *arg,
 
 
 
+void *
+gal_options_read_spillmode(struct argp_option *option, char *arg,
+                           char *filename, size_t lineno, void *junk)
+{
+  char *str=NULL;
+  if(lineno==-1)
+    {
+      switch(*(uint8_t *)(option->value))
+        {
+        case GAL_CHECKSET_SPILL_FILE:
+          gal_checkset_allocate_copy("file", &str);
+          break;
+        case GAL_CHECKSET_SPILL_RAM:
+          gal_checkset_allocate_copy("ram", &str);
+          break;
+        case GAL_CHECKSET_SPILL_FAIL:
+          gal_checkset_allocate_copy("fail", &str);
+          break;
+        default:
+          error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at %s to "
+                "fix the problem. The code %u is not recognized as a "
+                "spill mode", __func__, PACKAGE_BUGREPORT,
+                *(uint8_t *)(option->value));
+        }
+      return str;
+    }
+  else
+    {
+      /* If the option is already set, just return. */
+      if(option->set) return NULL;
+
+      /* Set the value. */
+      if(       !strcmp(arg, "file") )
+        *(uint8_t *)(option->value) = GAL_CHECKSET_SPILL_FILE;
+      else if ( !strcmp(arg, "ram") )
+        *(uint8_t *)(option->value) = GAL_CHECKSET_SPILL_RAM;
+      else if ( !strcmp(arg, "fail") )
+        *(uint8_t *)(option->value) = GAL_CHECKSET_SPILL_FAIL;
+      else
+        error_at_line(EXIT_FAILURE, 0, filename, lineno, "'%s' (value to "
+                      "'%s' option) isn't valid. Currently only 'file', "
+                      "'ram' and 'fail' are recognized", arg, option->name);
+
+      /* For no un-used variable warning. This function doesn't need the
+         pointer. */
+      return junk=NULL;
+    }
+}
+
+
+
+
+
 /* If the current token (in a 'colon'-separated list) is a sexagesimal
    number, or a normal number, read it as a double, and return the pointer
    to the end of the string (to continue parsing). We have three types of
@@ -2476,6 +2535,332 @@ gal_options_check_stdin(char *inputname, long stdintimeout, char *name)
 
 
 
+/**********************************************************************/
+/************             Batch/Server mode             ***************/
+/**********************************************************************/
+/* Break a job line into separate arguments (after the 'nfixed' fixed
+   arguments, that are already in 'args'). Like the shell, white space
+   separates the arguments, single and double quotes can be used to keep
+   white space within one argument and a backslash escapes the next
+   character. The returned array is NULL-terminated (like 'argv'). */
+static char **
+options_batch_split(char *line, char **fixed, int nfixed, int *argc)
+{
+  int n=nfixed;
+  char **out, *w, *c=line, quote;
+  size_t num=nfixed+strlen(line)/2+2;
+
+  /* Allocate the output (the words can't be more than half the line). */
+  errno=0;
+  out=malloc(num*sizeof *out);
+  if(out==NULL)
+    error(EXIT_FAILURE, errno, "%s: allocating %zu bytes for 'out'",
+          __func__, num*sizeof *out);
+  memcpy(out, fixed, nfixed*sizeof *out);
+
+  /* Parse the line (the words are written in-place over 'line'). */
+  while(1)
+    {
+      /* Skip the white space before the next word. */
+      while(*c==' ' || *c=='\t' || *c=='\n' || *c=='\r') ++c;
+      if(*c=='\0') break;
+
+      /* Read the word. */
+      quote='\0';
+      out[n++]=w=c;
+      for(; *c!='\0'; ++c)
+        {
+          if(quote)
+            { if(*c==quote) { quote='\0'; continue; } }
+          else if(*c=='\'' || *c=='"') { quote=*c; continue; }
+          else if(*c==' ' || *c=='\t' || *c=='\n' || *c=='\r') break;
+          if(*c=='\\' && quote!='\'' && c[1]!='\0') ++c;
+          *w++=*c;
+        }
+      if(quote)
+        error(EXIT_FAILURE, 0, "unmatched %c in the job: %s", quote, line);
+      if(*c!='\0') ++c;
+      *w='\0';
+    }
+
+  /* Return the output. */
+  out[n]=NULL;
+  *argc=n;
+  return out;
+}
+
+
+
+
+
+/* Signal handler of the server (to clean up the socket on termination). */
+static volatile sig_atomic_t options_batch_stop=0;
+
+static void
+options_batch_signal(int sig)
+{
+  options_batch_stop=1;
+}
+
+
+
+
+
+/* Prepare the arguments of a job in the child process. */
+static void
+options_batch_child(char *line, char **fixed, int nfixed, int *argc,
+                    char ***argv)
+{
+  int fd;
+  char *copy;
+
+  /* Use the default signal handlers (not those of the server). */
+  signal(SIGINT, SIG_DFL);
+  signal(SIGTERM, SIG_DFL);
+
+  /* The standard input of the server (which may contain the next jobs)
+     should not be read by the job. */
+  if( (fd=open("/dev/null", O_RDONLY))>=0 )
+    { dup2(fd, STDIN_FILENO); close(fd); }
+
+  /* Separate the arguments (on a copy, since 'line' may be freed). */
+  gal_checkset_allocate_copy(line, &copy);
+  *argv=options_batch_split(copy, fixed, nfixed, argc);
+}
+
+
+
+
+
+/* Read the jobs from the standard input: each line is one job (one call
+   to the program), they are run one after each other. */
+static void
+options_batch_stdin(char **fixed, int nfixed, int *argc, char ***argv)
+{
+  pid_t pid;
+  ssize_t nread;
+  char *line=NULL;
+  int status, failed=0;
+  size_t len=0, lineno=0;
+
+  while( (nread=getline(&line, &len, stdin))!=-1 )
+    {
+      /* Ignore empty and commented lines. */
+      ++lineno;
+      if( line[strspn(line, " \t\r\n")]=='\0'
+          || line[strspn(line, " \t")]=='#' ) continue;
+
+      /* Run the job in a child process (the buffers are flushed so the
+         child doesn't print them again). */
+      fflush(stdout); fflush(stderr);
+      errno=0;
+      pid=fork();
+      if(pid<0) error(EXIT_FAILURE, errno, "couldn't fork for line %zu",
+                      lineno);
+      if(pid==0)
+        {
+          options_batch_child(line, fixed, nfixed, argc, argv);
+          free(line);
+          return;
+        }
+
+      /* Wait for it to finish and report a failure. */
+      waitpid(pid, &status, 0);
+      if( !WIFEXITED(status) || WEXITSTATUS(status)!=EXIT_SUCCESS )
+        {
+          failed=1;
+          error(EXIT_SUCCESS, 0, "job in line %zu of the standard input "
+                "failed", lineno);
+        }
+    }
+
+  /* Clean up and finish the program. */
+  free(line);
+  exit(failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+
+
+
+
+/* Server on a local (UNIX) socket: each connection sends one job (a line
+   that is terminated by a new-line character) and receives the standard
+   output and error of the job, followed by a final line containing its
+   exit status. Jobs of different connections run in parallel. */
+static void
+options_batch_server(char *sockname, char **fixed, int nfixed, int *argc,
+                     char ***argv)
+{
+  FILE *fp;
+  pid_t pid;
+  ssize_t nread;
+  char *line=NULL;
+  int sfd, cfd, status;
+  struct sigaction sa;
+  size_t len=0, numjobs=0;
+  struct sockaddr_un addr;
+
+  /* Prepare the socket. */
+  if( strlen(sockname) >= sizeof addr.sun_path )
+    error(EXIT_FAILURE, 0, "%s: socket name is too long (must be less "
+          "than %zu characters)", sockname, sizeof addr.sun_path);
+  errno=0;
+  sfd=socket(AF_UNIX, SOCK_STREAM, 0);
+  if(sfd<0) error(EXIT_FAILURE, errno, "couldn't create the socket");
+  memset(&addr, 0, sizeof addr);
+  addr.sun_family=AF_UNIX;
+  strcpy(addr.sun_path, sockname);
+  if( bind(sfd, (struct sockaddr *)&addr, sizeof addr) )
+    error(EXIT_FAILURE, errno, "%s: couldn't bind to socket (if a "
+          "previous server was killed, please delete the file)", sockname);
+  if( listen(sfd, 64) )
+    error(EXIT_FAILURE, errno, "%s: couldn't listen on socket", sockname);
+
+  /* On SIGINT or SIGTERM, the server should stop and delete the socket,
+     so the system calls shouldn't be restarted (to stop 'accept'). */
+  memset(&sa, 0, sizeof sa);
+  sa.sa_handler=options_batch_signal;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+
+  /* Accept the connections. */
+  while(options_batch_stop==0)
+    {
+      /* Wait for a connection. */
+      cfd=accept(sfd, NULL, NULL);
+      if(cfd<0)
+        {
+          if(errno==EINTR) continue;
+          error(EXIT_FAILURE, errno, "%s: couldn't accept a connection",
+                sockname);
+        }
+
+      /* Clean up the finished connections. */
+      while( waitpid(-1, NULL, WNOHANG)>0 ) {}
+
+      /* Each connection is managed in a separate process (so the server
+         can immediately accept the next one). */
+      fflush(stdout); fflush(stderr);
+      errno=0;
+      if( (pid=fork())<0 )
+        error(EXIT_FAILURE, errno, "couldn't fork for connection");
+      if(pid>0) { close(cfd); ++numjobs; continue; }
+      close(sfd);
+
+      /* Read the job. */
+      fp=fdopen(cfd, "r+");
+      if(fp==NULL || (nread=getline(&line, &len, fp))==-1)
+        _exit(EXIT_FAILURE);
+
+      /* Run the job in a child process with its standard output and error
+         written into the connection. */
+      fflush(fp);
+      if( (pid=fork())==0 )
+        {
+          dup2(cfd, STDOUT_FILENO);
+          dup2(cfd, STDERR_FILENO);
+          options_batch_child(line, fixed, nfixed, argc, argv);
+          free(line);
+          return;
+        }
+
+      /* Wait for the job and send its exit status. */
+      status=EXIT_FAILURE<<8;
+      if(pid>0) waitpid(pid, &status, 0);
+      fprintf(fp, "exit status: %d\n",
+              WIFEXITED(status) ? WEXITSTATUS(status) : EXIT_FAILURE);
+      fclose(fp);
+      _exit(EXIT_SUCCESS);
+    }
+
+  /* Clean up and finish the program. */
+  close(sfd);
+  unlink(sockname);
+  while( waitpid(-1, NULL, 0)>0 ) {}
+  error(EXIT_SUCCESS, 0, "%s: server stopped after %zu job(s)", sockname,
+        numjobs);
+  exit(EXIT_SUCCESS);
+}
+
+
+
+
+
+/* If '--batch' or '--server' are given on the command-line, the program
+   will become a batch server: each job is run in a separate (forked)
+   process of the already running program, so the 'exec' and the dynamic
+   linking (loading and relocating the libraries) are only done once.
+   Since each job's arguments are parsed after the fork, the configuration
+   files are still read once for every job (this also guarantees exactly
+   the same behavior as a separate call, for example on errors). This
+   function only returns in the forked process of each job with 'argc'
+   and 'argv' corresponding to the job, so it should be called at the
+   start of 'main' before the arguments are parsed. Any other option on
+   the command-line is used as a default for all jobs (it is placed before
+   the job's own arguments, so the job can over-write it).
+
+   When neither of the two options are given, this function will return
+   without any change. */
+void
+gal_options_batch(int *argc, char ***argv)
+{
+  int i, nfixed=1;
+  char **fixed, *sockname=NULL, **in=*argv;
+  uint8_t batch=0;
+
+  /* See if any of the options are given. */
+  for(i=1;i<*argc;++i)
+    {
+      if( !strcmp(in[i], "--") ) break;
+      if( !strcmp(in[i], "--batch") ) batch=1;
+      else if( !strncmp(in[i], "--server=", 9) ) sockname=in[i]+9;
+      else if( !strcmp(in[i], "--server") && i+1<*argc )
+        sockname=in[i+1];
+    }
+  if(batch==0 && sockname==NULL) return;
+  if(batch && sockname)
+    error(EXIT_FAILURE, 0, "'--batch' and '--server' cannot be called "
+          "together");
+
+  /* Keep the other arguments (they are the same for all jobs). */
+  errno=0;
+  fixed=malloc(*argc*sizeof *fixed);
+  if(fixed==NULL)
+    error(EXIT_FAILURE, errno, "%s: allocating %zu bytes for 'fixed'",
+          __func__, *argc*sizeof *fixed);
+  fixed[0]=in[0];
+  for(i=1;i<*argc;++i)
+    {
+      if( !strcmp(in[i], "--batch") || !strncmp(in[i], "--server=", 9) )
+        continue;
+      if( !strcmp(in[i], "--server") ) { ++i; continue; }
+      fixed[nfixed++]=in[i];
+    }
+
+  /* Start the server. */
+  if(batch) options_batch_stdin(fixed, nfixed, argc, argv);
+  else      options_batch_server(sockname, fixed, nfixed, argc, argv);
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
 /**********************************************************************/
 /************            Configuration files            ***************/
 /**********************************************************************/
@@ -2887,6 +3272,22 @@ gal_options_read_low_level_checks(struct gal_options_common_params *cp)
               suggested_mmap);
     }
 
+  /* Set the process-wide memory budget (and peak memory report). */
+  if(cp->maxmemory || cp->memreport)
+    gal_checkset_memory_budget(cp->maxmemory, cp->spillmode,
+                               cp->memreport && cp->checkconfig==0);
+
+  /* The batch/server mode options are read before the command-line is
+     parsed (in 'gal_options_batch'), so they can only be set here from a
+     configuration file. */
+  if(cp->batch || cp->server)
+    error(EXIT_FAILURE, 0, "the '--batch' and '--server' options can only "
+          "be given on the command-line (not in configuration files)");
+
+  /* Activate the tracing of the internal stages. */
+  if(cp->trace && cp->checkconfig==0)
+    gal_timing_trace_start(cp->trace);
+
   /* If the user wanted to check the parsing of configuration files, then
      the program must stop here. */
   if(cp->checkconfig) exit(0);
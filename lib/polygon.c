@@ -30,10 +30,12 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <float.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <gsl/gsl_sort.h>
 
 #include <gnuastro/pointer.h>
+#include <gnuastro/threads.h>
 #include <gnuastro/polygon.h>
 #include <gnuastro/permutation.h>
 
@@ -870,3 +872,659 @@ gal_polygon_vertices_sort(double *vertices, size_t n, size_t *ordinds)
   for(i=0;i<n;i++) printf("%ld\n", ordinds[i]);
   */
 }
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/***************************************************************/
+/*******      Prepared polygons (many points)      *************/
+/***************************************************************/
+/* State of each cell in the grid of a prepared polygon: cells that no edge
+   passes through are completely inside or outside. */
+#define POLYGON_CELL_OUT  0
+#define POLYGON_CELL_IN   1
+#define POLYGON_CELL_EDGE 2
+
+/* Number of grid cells along each dimension (per vertex) and its
+   limits. */
+#define POLYGON_GRID_PER_VERTEX 2
+#define POLYGON_GRID_MIN        16
+#define POLYGON_GRID_MAX        1024
+
+/* Number of points (or rows of a mask) in each thread action. */
+#define POLYGON_CHUNK           65536
+#define POLYGON_ROWS_CHUNK      16
+
+
+
+
+/* Index of the cell containing 'x' along dimension 'd'. Positions before
+   the grid (or NaN) are given an index of -1 and those after it, an
+   index of 'ngrid'. The comparison is done in floating point before
+   casting, because infinite or very large positions can't be represented
+   in a 'long'. */
+static long
+polygon_cell_index(gal_polygon_prepared_t *pp, double x, size_t d)
+{
+  double f=floor( (x-pp->min[d])/pp->cell[d] );
+  return ( f>=0.0
+           ? ( f<(double)pp->ngrid ? (long)f : (long)pp->ngrid )
+           : -1 );
+}
+
+
+
+
+
+/* Clamp the given index within the grid. */
+static size_t
+polygon_cell_clamp(gal_polygon_prepared_t *pp, long i)
+{
+  return i<0 ? 0 : ( i>=(long)pp->ngrid ? pp->ngrid-1 : (size_t)i );
+}
+
+
+
+
+
+/* The exact test (identical to the non-prepared functions), when the
+   point is in a cell that an edge passes through. For the winding number,
+   only the edges that overlap with the point's slab (row of the grid) can
+   change the winding number, so the rest are ignored. */
+static int
+polygon_prepared_exact(gal_polygon_prepared_t *pp, double *p, size_t slab)
+{
+  long wn=0;
+  double *v=pp->v;
+  size_t e, i, j, n=pp->n;
+
+  /* Convex polygons. */
+  if(pp->convex) return gal_polygon_is_inside_convex(v, p, n);
+
+  /* Winding number over the edges of this slab. */
+  for(e=pp->slabstart[slab]; e<pp->slabstart[slab+1]; ++e)
+    {
+      i=pp->slabedges[e];
+      j = i ? i-1 : n-1;
+      if(v[j*2+1] <= p[1])
+        {
+          if(v[i*2+1] > p[1]
+             && GAL_POLYGON_TRI_CROSS_PRODUCT(&v[j*2], &v[i*2], p) > 0 )
+            ++wn;
+        }
+      else if(v[i*2+1] <= p[1]
+              && GAL_POLYGON_TRI_CROSS_PRODUCT(&v[j*2], &v[i*2], p) < 0)
+        --wn;
+    }
+  return wn!=0;
+}
+
+
+
+
+
+/* Mark the cells that the edge ending on vertex 'i' passes through (along
+   with their neighbors to be safe from floating point errors in finding
+   the cell of a point). */
+static void
+polygon_prepare_mark_edge(gal_polygon_prepared_t *pp, size_t i)
+{
+  double *v=pp->v;
+  size_t j = i ? i-1 : pp->n-1, s, c, t, sa, sb, ca, cb;
+  double ya, yb, x1, x2, y1, y2, xlo, xhi, *A=&v[j*2], *B=&v[i*2];
+
+  /* Range of slabs this edge overlaps with. */
+  ya = A[1]<B[1] ? A[1] : B[1];
+  yb = A[1]<B[1] ? B[1] : A[1];
+  sa=polygon_cell_clamp(pp, polygon_cell_index(pp, ya, 1));
+  sb=polygon_cell_clamp(pp, polygon_cell_index(pp, yb, 1));
+
+  /* Go over the slabs and mark the cells. */
+  for(s=sa; s<=sb; ++s)
+    {
+      /* The part of the edge within this slab. */
+      y1=pp->min[1]+s*pp->cell[1];     if(y1<ya) y1=ya;
+      y2=pp->min[1]+(s+1)*pp->cell[1]; if(y2>yb) y2=yb;
+      if(B[1]==A[1]) { x1=A[0]; x2=B[0]; }
+      else
+        {
+          x1 = A[0] + (B[0]-A[0])*(y1-A[1])/(B[1]-A[1]);
+          x2 = A[0] + (B[0]-A[0])*(y2-A[1])/(B[1]-A[1]);
+        }
+      xlo = x1<x2 ? x1 : x2;
+      xhi = x1<x2 ? x2 : x1;
+
+      /* Mark the cells (and their neighbors). */
+      ca=polygon_cell_clamp(pp, polygon_cell_index(pp, xlo, 0)-1);
+      cb=polygon_cell_clamp(pp, polygon_cell_index(pp, xhi, 0)+1);
+      for(t = s ? s-1 : 0; t<=s+1 && t<pp->ngrid; ++t)
+        for(c=ca; c<=cb; ++c)
+          pp->state[t*pp->ngrid+c]=POLYGON_CELL_EDGE;
+    }
+}
+
+
+
+
+
+/* Prepare a polygon for checking many points. A grid is placed over the
+   polygon: cells that no edge passes through are completely inside or
+   outside the polygon, so the test for points within them is a single
+   look-up. For the points in the other cells, only the edges that overlap
+   with the point's "slab" (row of the grid) are checked. When 'convex' is
+   non-zero, the results are identical to 'gal_polygon_is_inside_convex',
+   otherwise, they are identical to 'gal_polygon_is_inside'. */
+gal_polygon_prepared_t *
+gal_polygon_prepare(double *v, size_t n, int convex)
+{
+  long s, sa, sb;
+  gal_polygon_prepared_t *pp;
+  size_t i, j, c, d, nslab, *count;
+  double p[2], ya, yb, max[2]={-DBL_MAX, -DBL_MAX};
+
+  /* Sanity check. */
+  if(n<3)
+    error(EXIT_FAILURE, 0, "%s: a polygon needs at least 3 vertices, but "
+          "%zu have been given", __func__, n);
+  for(i=0;i<2*n;++i)
+    if( !isfinite(v[i]) )
+      error(EXIT_FAILURE, 0, "%s: vertex %zu of the polygon is not a "
+            "finite number", __func__, i/2+1);
+
+  /* Allocate the structure and copy the vertices. */
+  errno=0;
+  pp=malloc(sizeof *pp);
+  if(pp==NULL)
+    error(EXIT_FAILURE, errno, "%s: allocating %zu bytes for 'pp'",
+          __func__, sizeof *pp);
+  pp->n=n;
+  pp->convex=convex;
+  pp->v=gal_pointer_allocate(GAL_TYPE_FLOAT64, 2*n, 0, __func__, "pp->v");
+  memcpy(pp->v, v, 2*n*sizeof *v);
+
+  /* Sorted Y-axis position of the vertices (used in masks). */
+  pp->vys=gal_pointer_allocate(GAL_TYPE_FLOAT64, n, 0, __func__,
+                               "pp->vys");
+  for(i=0;i<n;++i) pp->vys[i]=v[i*2+1];
+  gsl_sort(pp->vys, 1, n);
+
+  /* The grid: one empty cell is placed on each side of the polygon's
+     bounding box. */
+  pp->min[0]=pp->min[1]=DBL_MAX;
+  for(i=0;i<n;++i)
+    for(d=0;d<2;++d)
+      {
+        if(v[i*2+d]<pp->min[d]) pp->min[d]=v[i*2+d];
+        if(v[i*2+d]>max[d])     max[d]=v[i*2+d];
+      }
+  pp->ngrid=POLYGON_GRID_PER_VERTEX*n;
+  if(pp->ngrid<POLYGON_GRID_MIN) pp->ngrid=POLYGON_GRID_MIN;
+  if(pp->ngrid>POLYGON_GRID_MAX) pp->ngrid=POLYGON_GRID_MAX;
+  for(d=0;d<2;++d)
+    {
+      pp->cell[d] = ( max[d]>pp->min[d]
+                      ? (max[d]-pp->min[d])/(pp->ngrid-2)
+                      : 1.0 );
+      pp->min[d] -= pp->cell[d];
+    }
+
+  /* Edges overlapping with each slab (one slab more on each side, to be
+     safe from floating point errors). The edge ending on vertex 'i'
+     starts on vertex 'i-1'. */
+  nslab=pp->ngrid;
+  count=gal_pointer_allocate(GAL_TYPE_SIZE_T, nslab, 1, __func__,
+                             "count");
+  pp->slabstart=gal_pointer_allocate(GAL_TYPE_SIZE_T, nslab+1, 1,
+                                     __func__, "pp->slabstart");
+  for(i=0;i<n;++i)
+    {
+      j = i ? i-1 : n-1;
+      ya = v[j*2+1]<v[i*2+1] ? v[j*2+1] : v[i*2+1];
+      yb = v[j*2+1]<v[i*2+1] ? v[i*2+1] : v[j*2+1];
+      sa=polygon_cell_clamp(pp, polygon_cell_index(pp, ya, 1)-1);
+      sb=polygon_cell_clamp(pp, polygon_cell_index(pp, yb, 1)+1);
+      for(s=sa;s<=sb;++s) ++pp->slabstart[s+1];
+    }
+  for(s=0;s<(long)nslab;++s) pp->slabstart[s+1]+=pp->slabstart[s];
+  pp->slabedges=gal_pointer_allocate(GAL_TYPE_SIZE_T,
+                                     pp->slabstart[nslab], 0, __func__,
+                                     "pp->slabedges");
+  for(i=0;i<n;++i)
+    {
+      j = i ? i-1 : n-1;
+      ya = v[j*2+1]<v[i*2+1] ? v[j*2+1] : v[i*2+1];
+      yb = v[j*2+1]<v[i*2+1] ? v[i*2+1] : v[j*2+1];
+      sa=polygon_cell_clamp(pp, polygon_cell_index(pp, ya, 1)-1);
+      sb=polygon_cell_clamp(pp, polygon_cell_index(pp, yb, 1)+1);
+      for(s=sa;s<=sb;++s)
+        pp->slabedges[ pp->slabstart[s] + count[s]++ ] = i;
+    }
+
+  /* Set the state of the cells: first mark the cells that edges pass
+     through, then use the center of the others for their state. */
+  pp->state=gal_pointer_allocate(GAL_TYPE_UINT8, pp->ngrid*pp->ngrid, 1,
+                                 __func__, "pp->state");
+  for(i=0;i<n;++i) polygon_prepare_mark_edge(pp, i);
+  for(s=0;s<(long)nslab;++s)
+    for(c=0;c<pp->ngrid;++c)
+      if(pp->state[s*pp->ngrid+c]!=POLYGON_CELL_EDGE)
+        {
+          p[0]=pp->min[0]+(c+0.5f)*pp->cell[0];
+          p[1]=pp->min[1]+(s+0.5f)*pp->cell[1];
+          pp->state[s*pp->ngrid+c] = ( polygon_prepared_exact(pp, p, s)
+                                       ? POLYGON_CELL_IN
+                                       : POLYGON_CELL_OUT );
+        }
+
+  /* Clean up and return. */
+  free(count);
+  return pp;
+}
+
+
+
+
+
+void
+gal_polygon_prepared_free(gal_polygon_prepared_t *pp)
+{
+  if(pp==NULL) return;
+  free(pp->v);
+  free(pp->vys);
+  free(pp->state);
+  free(pp->slabstart);
+  free(pp->slabedges);
+  free(pp);
+}
+
+
+
+
+
+/* Return 1 if the point is inside the prepared polygon and 0 if it isn't
+   (see 'gal_polygon_prepare'). */
+int
+gal_polygon_prepared_is_inside(gal_polygon_prepared_t *pp, double *p)
+{
+  long c, s;
+
+  /* Points outside the grid are outside the polygon (recall that there
+     is one empty cell around the polygon). */
+  if( isnan(p[0]) || isnan(p[1]) ) return 0;
+  c=polygon_cell_index(pp, p[0], 0);
+  s=polygon_cell_index(pp, p[1], 1);
+  if(c<0 || s<0 || c>=(long)pp->ngrid || s>=(long)pp->ngrid) return 0;
+
+  /* Use the cell's state. */
+  switch(pp->state[s*pp->ngrid+c])
+    {
+    case POLYGON_CELL_IN:  return 1;
+    case POLYGON_CELL_OUT: return 0;
+    }
+  return polygon_prepared_exact(pp, p, s);
+}
+
+
+
+
+
+/* Parameters for the threads. */
+struct polygon_prepared_params
+{
+  gal_polygon_prepared_t *pp;  /* Prepared polygon.                   */
+  gal_data_t            *c1;   /* First coordinate of the points.     */
+  gal_data_t            *c2;   /* Second coordinate of the points.    */
+  gal_data_t           *out;   /* Output (1 for inside, 0 otherwise). */
+};
+
+
+
+
+
+/* Read the value of any numeric type as a double. */
+static double
+polygon_read_value(gal_data_t *col, size_t i)
+{
+  switch(col->type)
+    {
+    case GAL_TYPE_INT8:    return (( int8_t   *)col->array)[i];
+    case GAL_TYPE_UINT8:   return (( uint8_t  *)col->array)[i];
+    case GAL_TYPE_UINT16:  return (( uint16_t *)col->array)[i];
+    case GAL_TYPE_INT16:   return (( int16_t  *)col->array)[i];
+    case GAL_TYPE_UINT32:  return (( uint32_t *)col->array)[i];
+    case GAL_TYPE_INT32:   return (( int32_t  *)col->array)[i];
+    case GAL_TYPE_UINT64:  return (( uint64_t *)col->array)[i];
+    case GAL_TYPE_INT64:   return (( int64_t  *)col->array)[i];
+    case GAL_TYPE_FLOAT32: return (( float    *)col->array)[i];
+    case GAL_TYPE_FLOAT64: return (( double   *)col->array)[i];
+    default:
+      error(EXIT_FAILURE, 0, "%s: type code %d not recognized",
+            __func__, col->type);
+    }
+
+  /* Control should not reach here. */
+  return NAN;
+}
+
+
+
+
+
+static void *
+polygon_prepared_points_on_thread(void *in_prm)
+{
+  struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
+  struct polygon_prepared_params *prm=tprm->params;
+
+  double p[2];
+  size_t i, k, start, end;
+  uint8_t *o=prm->out->array;
+  double *x = prm->c1->type==GAL_TYPE_FLOAT64 ? prm->c1->array : NULL;
+  double *y = prm->c2->type==GAL_TYPE_FLOAT64 ? prm->c2->array : NULL;
+
+  /* Go over all the chunks that were assigned to this thread. */
+  for(i=0; tprm->indexs[i]!=GAL_BLANK_SIZE_T; ++i)
+    {
+      start=tprm->indexs[i]*POLYGON_CHUNK;
+      end = ( start+POLYGON_CHUNK > prm->out->size
+              ? prm->out->size : start+POLYGON_CHUNK );
+      for(k=start;k<end;++k)
+        {
+          p[0] = x ? x[k] : polygon_read_value(prm->c1, k);
+          p[1] = y ? y[k] : polygon_read_value(prm->c2, k);
+          o[k] = gal_polygon_prepared_is_inside(prm->pp, p);
+        }
+    }
+
+  /* Wait for all the other threads to finish, then return. */
+  if(tprm->b) pthread_barrier_wait(tprm->b);
+  return NULL;
+}
+
+
+
+
+
+/* Check if the points (with coordinates in 'c1' and 'c2', that can have
+   any numeric type) are inside the prepared polygon. The output has an
+   'uint8' type, and is 1 for the points inside the polygon. */
+gal_data_t *
+gal_polygon_prepared_is_inside_points(gal_polygon_prepared_t *pp,
+                                      gal_data_t *c1, gal_data_t *c2,
+                                      size_t numthreads)
+{
+  struct polygon_prepared_params prm={0};
+
+  /* Sanity check. */
+  if(c1->size!=c2->size)
+    error(EXIT_FAILURE, 0, "%s: the two coordinates have different "
+          "numbers of elements (%zu and %zu)", __func__, c1->size,
+          c2->size);
+
+  /* Allocate the output and check the points on multiple threads. */
+  prm.pp=pp;
+  prm.c1=c1;
+  prm.c2=c2;
+  prm.out=gal_data_alloc(NULL, GAL_TYPE_UINT8, 1, &c1->size, NULL, 0,
+                         c1->minmapsize, c1->quietmmap, NULL, NULL, NULL);
+  if(c1->size)
+    gal_threads_spin_off(polygon_prepared_points_on_thread, &prm,
+                         (c1->size+POLYGON_CHUNK-1)/POLYGON_CHUNK,
+                         numthreads, c1->minmapsize, c1->quietmmap);
+  return prm.out;
+}
+
+
+
+
+
+/* See if any vertex is within one pixel of the given row (where the
+   crossings can't be used). */
+static int
+polygon_mask_row_is_exact(gal_polygon_prepared_t *pp, double y)
+{
+  size_t lo=0, hi=pp->n, mid;
+
+  /* Binary search for the first vertex with a Y larger than 'y-1'. */
+  while(lo<hi)
+    {
+      mid=(lo+hi)/2;
+      if(pp->vys[mid] < y-1) lo=mid+1; else hi=mid;
+    }
+  return lo<pp->n && pp->vys[lo] <= y+1;
+}
+
+
+
+
+
+/* The first pixel (counting from 0) with a center after 'x' (in the FITS
+   convention, the center of pixel 'c' is at 'c+1'), clamped to the
+   width. */
+static size_t
+polygon_mask_first_after(double x, size_t width)
+{
+  if(x<0) return 0;
+  if(x>=width) return width;
+  return (size_t)floor(x);
+}
+
+
+
+
+
+/* Check the pixels in the given range exactly. */
+static void
+polygon_mask_row_exact(gal_polygon_prepared_t *pp, uint8_t *row,
+                       size_t from, size_t to, double y)
+{
+  size_t c;
+  double p[2];
+
+  p[1]=y;
+  for(c=from;c<to;++c)
+    {
+      p[0]=c+1;
+      row[c]=gal_polygon_prepared_is_inside(pp, p);
+    }
+}
+
+
+
+
+
+/* For convex polygons, the pixels of a row that are to the left of all
+   the edges (like 'gal_polygon_is_inside_convex') are a single span: the
+   condition for each edge (with the same tolerance) is linear in the
+   pixel's position. The pixels within one pixel of the two ends of the
+   span are checked exactly. */
+static void
+polygon_mask_row_convex(gal_polygon_prepared_t *pp, uint8_t *row,
+                        size_t width, double y)
+{
+  size_t i, j, from, to;
+  double c0, dy, x, lo=-INFINITY, hi=INFINITY, *v=pp->v;
+
+  /* Find the range of the span. */
+  for(i=0;i<pp->n;++i)
+    {
+      j = i ? i-1 : pp->n-1;
+      dy = v[i*2+1]-v[j*2+1];
+      c0 = (v[i*2]-v[j*2])*(y-v[j*2+1]);
+      if(dy==0.0f)
+        { if(c0 <= -GAL_POLYGON_ROUND_ERR) return; }
+      else
+        {
+          x = v[j*2] + (c0+GAL_POLYGON_ROUND_ERR)/dy;
+          if(dy>0) { if(x<hi) hi=x; }
+          else     { if(x>lo) lo=x; }
+        }
+    }
+  if(lo>=hi+2) return;
+
+  /* Fill the span, then check its two ends. */
+  from=polygon_mask_first_after(lo, width);
+  to=polygon_mask_first_after(hi, width);
+  if(to>from) memset(row+from, 1, to-from);
+  polygon_mask_row_exact(pp, row, polygon_mask_first_after(lo-2, width),
+                         polygon_mask_first_after(lo+2, width), y);
+  polygon_mask_row_exact(pp, row, polygon_mask_first_after(hi-2, width),
+                         polygon_mask_first_after(hi+2, width), y);
+}
+
+
+
+
+
+/* Fill one row of the mask: the edges crossing the row define the spans
+   of pixels inside the polygon (where the winding number is non-zero).
+   The pixels within one pixel of a crossing are checked exactly. When a
+   vertex is within one pixel of the row (for example horizontal edges),
+   all pixels are checked exactly (which is still fast because most of
+   them are in the inside or outside cells of the grid). */
+static void
+polygon_mask_row(gal_polygon_prepared_t *pp, uint8_t *row, size_t width,
+                 double y, double *xs, int64_t *dirs)
+{
+  int64_t w, dir;
+  double xint, *v=pp->v, *A, *B;
+  size_t e, i, j, k, nx=0, slab, from, to;
+  long s=polygon_cell_index(pp, y, 1);
+
+  /* Rows outside the grid are completely outside the polygon. */
+  memset(row, 0, width);
+  if(s<0 || s>=(long)pp->ngrid) return;
+  slab=s;
+
+  /* Convex polygons are done separately. */
+  if(pp->convex) { polygon_mask_row_convex(pp, row, width, y); return; }
+
+  /* When a vertex is close to this row, check every pixel. */
+  if( polygon_mask_row_is_exact(pp, y) )
+    { polygon_mask_row_exact(pp, row, 0, width, y); return; }
+
+  /* Find the crossings of the edges with this row (sorted by their
+     position with insertion sort: they are usually very few). */
+  for(e=pp->slabstart[slab]; e<pp->slabstart[slab+1]; ++e)
+    {
+      i=pp->slabedges[e];
+      j = i ? i-1 : pp->n-1;
+      A=&v[j*2]; B=&v[i*2];
+      if     (A[1]<=y && B[1]>y) dir=1;
+      else if(B[1]<=y && A[1]>y) dir=-1;
+      else continue;
+      xint = A[0] + (B[0]-A[0])*(y-A[1])/(B[1]-A[1]);
+      for(k=nx; k>0 && xs[k-1]>xint; --k)
+        { xs[k]=xs[k-1]; dirs[k]=dirs[k-1]; }
+      xs[k]=xint;
+      dirs[k]=dir;
+      ++nx;
+    }
+
+  /* Fill the spans: the winding number of pixel 'c' (at 'c+1') is the
+     sum of the directions of the crossings after it. The first pixel
+     after a crossing at 'xint' is 'floor(xint)'. */
+  for(w=0, k=0; k<nx; ++k) w+=dirs[k];
+  for(k=0; k<nx; ++k)
+    {
+      w-=dirs[k];
+      if(w==0) continue;
+      from = polygon_mask_first_after(xs[k], width);
+      to = k+1<nx ? polygon_mask_first_after(xs[k+1], width) : width;
+      if(to>from) memset(row+from, 1, to-from);
+    }
+
+  /* Check the pixels close to the crossings exactly. */
+  for(k=0; k<nx; ++k)
+    polygon_mask_row_exact(pp, row, polygon_mask_first_after(xs[k]-2,
+                                                             width),
+                           polygon_mask_first_after(xs[k]+2, width), y);
+}
+
+
+
+
+
+/* Parameters of the mask. */
+struct polygon_mask_params
+{
+  gal_polygon_prepared_t *pp;  /* Prepared polygon.                   */
+  gal_data_t           *out;   /* Output mask.                        */
+};
+
+static void *
+polygon_mask_on_thread(void *in_prm)
+{
+  struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
+  struct polygon_mask_params *prm=tprm->params;
+  gal_polygon_prepared_t *pp=prm->pp;
+
+  double *xs;
+  int64_t *dirs;
+  size_t i, r, start, end;
+  uint8_t *o=prm->out->array;
+  size_t h=prm->out->dsize[0], width=prm->out->dsize[1];
+
+  /* Allocate the space for the crossings of each row. */
+  xs=gal_pointer_allocate(GAL_TYPE_FLOAT64, pp->n, 0, __func__, "xs");
+  dirs=gal_pointer_allocate(GAL_TYPE_INT64, pp->n, 0, __func__, "dirs");
+
+  /* Go over all the rows that were assigned to this thread. */
+  for(i=0; tprm->indexs[i]!=GAL_BLANK_SIZE_T; ++i)
+    {
+      start=tprm->indexs[i]*POLYGON_ROWS_CHUNK;
+      end = start+POLYGON_ROWS_CHUNK > h ? h : start+POLYGON_ROWS_CHUNK;
+      for(r=start;r<end;++r)
+        polygon_mask_row(pp, o+r*width, width, r+1, xs, dirs);
+    }
+
+  /* Clean up, wait for all the other threads to finish, then return. */
+  free(xs);
+  free(dirs);
+  if(tprm->b) pthread_barrier_wait(tprm->b);
+  return NULL;
+}
+
+
+
+
+
+/* Build a 2D mask of the given size ('dsize' in C order), where each
+   pixel is 1 if its center is inside the prepared polygon. The polygon's
+   vertices are in the FITS pixel coordinates of the mask (the center of
+   the first pixel is at (1,1)). Instead of checking each pixel, the spans
+   between the crossings of the edges on each row are filled, so the
+   result is identical to checking every pixel with
+   'gal_polygon_prepared_is_inside', but much faster. */
+gal_data_t *
+gal_polygon_prepared_mask(gal_polygon_prepared_t *pp, size_t *dsize,
+                          size_t numthreads, size_t minmapsize,
+                          int quietmmap)
+{
+  struct polygon_mask_params prm={0};
+
+  prm.pp=pp;
+  prm.out=gal_data_alloc(NULL, GAL_TYPE_UINT8, 2, dsize, NULL, 0,
+                         minmapsize, quietmmap, NULL, NULL, NULL);
+  if(prm.out->size)
+    gal_threads_spin_off(polygon_mask_on_thread, &prm,
+                         (dsize[0]+POLYGON_ROWS_CHUNK-1)/POLYGON_ROWS_CHUNK,
+                         numthreads, minmapsize, quietmmap);
+  return prm.out;
+}
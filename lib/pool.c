@@ -23,6 +23,7 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 **********************************************************************/
 #include <config.h>
 
+#include <math.h>
 #include <stdio.h>
 #include <errno.h>
 #include <error.h>
@@ -31,12 +32,11 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 
 #include <gnuastro/wcs.h>
 #include <gnuastro/type.h>
-#include <gnuastro/fits.h>
+#include <gnuastro/blank.h>
 #include <gnuastro/pool.h>
 #include <gnuastro/pointer.h>
 #include <gnuastro/threads.h>
 #include <gnuastro/dimension.h>
-#include <gnuastro/statistics.h>
 
 #include <gnuastro-internal/checkset.h>
 
@@ -44,148 +44,590 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 
 
 
-/* Identifiers for each operator. */
-enum pool_operators
-{
-  POOL_MAX,      /* Maximum the desired pixels.  */
-  POOL_MIN,      /* Minimum the desired pixels.  */
-  POOL_SUM,      /* Sum of desired pixels.       */
-  POOL_MEAN,     /* Mean the desired pixel.      */
-  POOL_MEDIAN,   /* Median the desired pixels.   */
-};
+
+
+
+
+
+
+
+
+
+
 
 
 
 
 
 /**********************************************************************/
-/****************             Pooling                 *****************/
+/****************         Window geometry             *****************/
 /**********************************************************************/
-#define POOLING_DIM 10
+/* Maximum number of dimensions. */
+#define POOL_MAXDIM 10
 
-/* Main input/output parameters. */
-struct pooling
+/* Number of lines (or output rows) to process in each thread action. */
+#define POOL_LINES_CHUNK 64
+
+/* Parameters of the window (in each dimension) and the threads. */
+struct pool_params
 {
-  int       operator;     /* The type of pooling.             */
-  size_t    poolsize;     /* The size of pooling.             */
-  size_t      *osize;     /* The output size.                 */
-  gal_data_t  *input;     /* Dataset to print values of.      */
-  gal_data_t    *out;     /* Output data structure.           */
+  int          operator;  /* The type of pooling.                    */
+  size_t           ndim;  /* Number of dimensions.                   */
+  size_t         *wsize;  /* Window size along each dimension.       */
+  size_t        *stride;  /* Stride along each dimension.            */
+  size_t        *before;  /* Elements before the window's start.     */
+  size_t          *nout;  /* Output size along each dimension.       */
+
+  /* For the separable passes. */
+  size_t            dim;  /* Dimension of this pass.                 */
+  size_t          inner;  /* Elements after this dimension.          */
+  size_t         nlines;  /* Number of lines along this dimension.   */
+  int         max1_min0;  /* For min/max: 1 for max., 0 for min.     */
+  gal_data_t    *passin;  /* Input of this pass.                     */
+  gal_data_t   *passout;  /* Output of this pass.                    */
+
+  /* For the running median. */
+  gal_data_t     *input;  /* Input dataset (float64).                */
+  gal_data_t       *out;  /* Output dataset (float64).               */
 };
 
 
 
 
 
-/* Do the pooling on each thread.
+/* The range of input elements (from 'l' to 'r', 'r' is not inclusive)
+   that are used for output element 'o' along a dimension with 'n'
+   elements. The window starts 'b' elements before 'o*s' and has a length
+   of 'w' (it is clipped at the two edges). */
+static void
+pool_range(size_t o, size_t n, size_t w, size_t s, size_t b, size_t *l,
+           size_t *r)
+{
+  size_t start=o*s;
+  *l = start>=b ? start-b : 0;
+  *r = start+w>b ? start+w-b : 0;
+  if(*r>n) *r=n;
+  if(*l>*r) *l=*r;
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
 
-   Current assumptions:
 
-   - The size of pooling can be every single number (the pooling window is
-     a square).
-   - The width and height of the input are not necessarily divisible
-     by the size of the pooling. In other words, the image can be both
-     square and rectangular.
-   - We apply the pooling to our input with a stride of poolsize. So,
-     for example the stride is 2 when poolsize is equal to 2. */
+
+
+
+/**********************************************************************/
+/****************      Separable sliding reductions    *****************/
+/**********************************************************************/
+/* Sliding minimum/maximum over one line with the van Herk/Gil-Werman
+   algorithm: the line is divided into blocks of the window's length;
+   within each block, 'g' keeps the running extrema from the start and
+   'h' from the end of the block. Any window spans at most two blocks, so
+   its extrema is found with a single comparison of 'h' on its first
+   element and 'g' on its last. Therefore irrespective of the window's
+   size, each element only needs three comparisons.
+
+   The same is used for the sum (with an addition in place of the
+   comparison). Unlike a cumulative sum over the whole line (where the
+   sum of a window is the difference of two values), nothing is
+   subtracted: an infinity only affects the windows that contain it and
+   no precision is lost in the difference of two large sums. */
+#define POOL_MINMAX_LINE(IT) {                                          \
+    IT *x=buf, *g=gbuf, *h=hbuf, *o=pp->passout->array, m;              \
+    for(i=0;i<n;++i)                                                    \
+      g[i] = i%w ? POOL_EXTREMA(g[i-1], x[i]) : x[i];                   \
+    for(i=n;i-->0;)                                                     \
+      h[i] = ( (i%w==w-1 || i==n-1)                                     \
+               ? x[i] : POOL_EXTREMA(h[i+1], x[i]) );                   \
+    for(j=0;j<nout;++j)                                                 \
+      {                                                                 \
+        pool_range(j, n, w, s, b, &l, &r);                              \
+        if(l==r) { o[obase+j*inner]=x[0]; continue; } /* Not used. */   \
+        --r;                                                            \
+        if(l/w != r/w)              m=POOL_EXTREMA(h[l], g[r]);         \
+        else if(l%w==0)             m=g[r];                             \
+        else if(r%w==w-1 || r==n-1) m=h[l];                             \
+        else                                                            \
+          for(m=x[l], k=l+1; k<=r; ++k) m=POOL_EXTREMA(m, x[k]);        \
+        o[obase+j*inner]=m;                                             \
+      }                                                                 \
+  }
+
+#define POOL_GATHER(IT) {                                               \
+    IT *in=pp->passin->array, *x=buf;                                   \
+    for(i=0;i<n;++i) x[i]=in[ibase+i*inner];                            \
+  }
+
 static void *
-pool_type_on_thread(void *in_prm)
+pool_pass_on_thread(void *in_prm)
 {
   struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
-  struct pooling *pp=(struct pooling *)tprm->params;
-  gal_data_t *input=pp->input;
+  struct pool_params *pp=(struct pool_params *)tprm->params;
+
+  uint8_t type=pp->passin->type;
+  void *buf=NULL, *gbuf=NULL, *hbuf=NULL;
+  size_t a, i, j, k, l, r, line, ibase, obase, inner=pp->inner;
+  size_t d=pp->dim, n=pp->passin->dsize[d], nout=pp->nout[d];
+  size_t w=pp->wsize[d], s=pp->stride[d], b=pp->before[d];
+
+  /* Allocate the per-thread buffers. */
+  buf=gal_pointer_allocate(type, n, 0, __func__, "buf");
+  gbuf=gal_pointer_allocate(type, n, 0, __func__, "gbuf");
+  hbuf=gal_pointer_allocate(type, n, 0, __func__, "hbuf");
+
+  /* Go over all the chunks of lines that were assigned to this thread. */
+  for(a=0; tprm->indexs[a] != GAL_BLANK_SIZE_T; ++a)
+    for(line=tprm->indexs[a]*POOL_LINES_CHUNK;
+        line<(tprm->indexs[a]+1)*POOL_LINES_CHUNK && line<pp->nlines;
+        ++line)
+      {
+        /* Starting index of this line in the input and output. */
+        ibase = (line/inner)*n*inner    + line%inner;
+        obase = (line/inner)*nout*inner + line%inner;
+
+        /* Gather the line into the contiguous buffer. */
+        switch(type)
+          {
+          case GAL_TYPE_UINT8:   POOL_GATHER( uint8_t  ); break;
+          case GAL_TYPE_INT8:    POOL_GATHER( int8_t   ); break;
+          case GAL_TYPE_UINT16:  POOL_GATHER( uint16_t ); break;
+          case GAL_TYPE_INT16:   POOL_GATHER( int16_t  ); break;
+          case GAL_TYPE_UINT32:  POOL_GATHER( uint32_t ); break;
+          case GAL_TYPE_INT32:   POOL_GATHER( int32_t  ); break;
+          case GAL_TYPE_UINT64:  POOL_GATHER( uint64_t ); break;
+          case GAL_TYPE_INT64:   POOL_GATHER( int64_t  ); break;
+          case GAL_TYPE_FLOAT32: POOL_GATHER( float    ); break;
+          case GAL_TYPE_FLOAT64: POOL_GATHER( double   ); break;
+          default:
+            error(EXIT_FAILURE, 0, "%s: type code %d not recognized",
+                  __func__, type);
+          }
+
+        /* Sum (the input of the sum is always 'float64'). */
+        if(pp->operator==GAL_POOL_SUM)
+          {
+#define POOL_EXTREMA(A,B) ( (A)+(B) )
+            POOL_MINMAX_LINE( double );
+#undef POOL_EXTREMA
+          }
+
+        /* Minimum or maximum. */
+        else if(pp->max1_min0)
+          {
+#define POOL_EXTREMA(A,B) ( (A)>(B) ? (A) : (B) )
+            switch(type)
+              {
+              case GAL_TYPE_UINT8:   POOL_MINMAX_LINE( uint8_t  ); break;
+              case GAL_TYPE_INT8:    POOL_MINMAX_LINE( int8_t   ); break;
+              case GAL_TYPE_UINT16:  POOL_MINMAX_LINE( uint16_t ); break;
+              case GAL_TYPE_INT16:   POOL_MINMAX_LINE( int16_t  ); break;
+              case GAL_TYPE_UINT32:  POOL_MINMAX_LINE( uint32_t ); break;
+              case GAL_TYPE_INT32:   POOL_MINMAX_LINE( int32_t  ); break;
+              case GAL_TYPE_UINT64:  POOL_MINMAX_LINE( uint64_t ); break;
+              case GAL_TYPE_INT64:   POOL_MINMAX_LINE( int64_t  ); break;
+              case GAL_TYPE_FLOAT32: POOL_MINMAX_LINE( float    ); break;
+              case GAL_TYPE_FLOAT64: POOL_MINMAX_LINE( double   ); break;
+              }
+#undef POOL_EXTREMA
+          }
+        else
+          {
+#define POOL_EXTREMA(A,B) ( (A)<(B) ? (A) : (B) )
+            switch(type)
+              {
+              case GAL_TYPE_UINT8:   POOL_MINMAX_LINE( uint8_t  ); break;
+              case GAL_TYPE_INT8:    POOL_MINMAX_LINE( int8_t   ); break;
+              case GAL_TYPE_UINT16:  POOL_MINMAX_LINE( uint16_t ); break;
+              case GAL_TYPE_INT16:   POOL_MINMAX_LINE( int16_t  ); break;
+              case GAL_TYPE_UINT32:  POOL_MINMAX_LINE( uint32_t ); break;
+              case GAL_TYPE_INT32:   POOL_MINMAX_LINE( int32_t  ); break;
+              case GAL_TYPE_UINT64:  POOL_MINMAX_LINE( uint64_t ); break;
+              case GAL_TYPE_INT64:   POOL_MINMAX_LINE( int64_t  ); break;
+              case GAL_TYPE_FLOAT32: POOL_MINMAX_LINE( float    ); break;
+              case GAL_TYPE_FLOAT64: POOL_MINMAX_LINE( double   ); break;
+              }
+#undef POOL_EXTREMA
+          }
+      }
+
+  /* Clean up. */
+  free(buf);
+  free(gbuf);
+  free(hbuf);
+
+  /* Wait for all the other threads to finish, then return. */
+  if(tprm->b) pthread_barrier_wait(tprm->b);
+  return NULL;
+}
+
 
-  size_t pools= pp->poolsize;
-  size_t ndim=input->ndim;
-  size_t w=input->dsize[1], wr;
-  size_t h=input->dsize[0], hr;
-  gal_data_t *statv=NULL, *result=NULL;
-  size_t i, a, b, oind, iind, vc, numpixs, coord[POOLING_DIM], index;
 
-  /* All number of pixels that we selected each time par the pooling. */
-  numpixs=pools*pools;
 
-  /* Allocated memory for selected pixels of input to feed into the
-     statisitical operation. */
-  statv=gal_data_alloc(NULL, input->type, 1, &numpixs, NULL, 0,
-                       input->minmapsize, input->quietmmap,
-                       NULL, NULL, NULL);
 
-  /* Go over all the pixels that were assigned to this thread. */
-  for(i=0; tprm->indexs[i] != GAL_BLANK_SIZE_T; ++i)
+/* Do the sliding reduction along every dimension, one after the
+   other. The N-dimensional minimum, maximum or sum over a box is equal
+   to the one-dimensional reductions along each dimension, so the total
+   cost is proportional to the number of elements (multiplied by the
+   number of dimensions), not the window's volume. The input will be
+   freed. */
+static gal_data_t *
+pool_separable(struct pool_params *pp, gal_data_t *in, int operator,
+               int max1_min0, size_t numthreads)
+{
+  size_t d, i, dsize[POOL_MAXDIM];
+  gal_data_t *out;
+
+  /* Go over the dimensions. */
+  for(d=0; d<in->ndim; ++d)
     {
-      /* For easy reading, put the index in 'ind'. */
-      oind=tprm->indexs[i];
-
-      /* Get the coordinate of the pixel. */
-      gal_dimension_index_to_coord(oind, ndim, pp->osize, coord);
-
-      /* Convert the pixel coordinate to the desired pixel that we must
-         select to set the pooling's starting pointer. */
-      iind=pools*w*coord[0]+pools*coord[1];
-      hr=iind%h;
-      wr=iind%w;
-
-      /* In some cases, the pooling window doesn't cover a whole squared
-         window and only has maybe one pixel. So since we initialize the
-         statv by Null (=0 in C), some of these values fill with input
-         values and others remain zero. So these zeros will affect the
-         outputs.  Therefore we initialize the statv by blank value. */
-      gal_blank_initialize(statv);
-
-      /* Set the sorted and blank check flags to 0 so the statistical
-         operators re-check everytime for sorted or blank elements. */
-      statv->flag=0;
-
-      /* Depending on the size of pooling, we condider a set of pixels
-	 and fill the temporary 'values' array. Then we do the required
-         operation on them. */
-      vc=0;
-      for(a=0;a<pools && hr+a<=input->dsize[0];++a)
-	for(b=0;b<pools && wr+b<input->dsize[1];++b)
-	  {
-	    index=iind + a*w + b;
-	    if (index<input->size)
-	      {
-                memcpy(gal_pointer_increment(statv->array, vc,
-                                             statv->type),
-                       gal_pointer_increment(input->array, index,
-                                             input->type),
-                       gal_type_sizeof(input->type));
-                vc++;
-	      }
-	  }
-
-      /* Do the necessary calculation. */
-      switch(pp->operator)
-        {
-        case POOL_MAX:    result=gal_statistics_maximum(statv);   break;
-        case POOL_MIN:    result=gal_statistics_minimum(statv);   break;
-        case POOL_SUM:    result=gal_statistics_sum(statv);       break;
-        case POOL_MEAN:   result=gal_statistics_mean(statv);      break;
-        case POOL_MEDIAN: result=gal_statistics_median(statv, 1); break;
-        default:
-          error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at %s "
-                "to fix the problem. 'operator' code %d is not "
-                "recognized.", PACKAGE_BUGREPORT, __func__,
-                pp->operator);
-        }
+      /* Set the output size (only this dimension changes). */
+      for(i=0;i<in->ndim;++i) dsize[i]=in->dsize[i];
+      dsize[d]=pp->nout[d];
+      out=gal_data_alloc(NULL, ( operator==GAL_POOL_SUM
+                                 ? GAL_TYPE_FLOAT64 : in->type ),
+                         in->ndim, dsize, NULL, 0, in->minmapsize,
+                         in->quietmmap, NULL, NULL, NULL);
+
+      /* Set the parameters of this pass and spin-off the threads. */
+      pp->dim=d;
+      pp->passin=in;
+      pp->passout=out;
+      pp->operator=operator;
+      pp->max1_min0=max1_min0;
+      pp->nlines=in->size/in->dsize[d];
+      pp->inner=gal_dimension_total_size(in->ndim-d-1, in->dsize+d+1);
+      gal_threads_spin_off(pool_pass_on_thread, pp,
+                           ( (pp->nlines+POOL_LINES_CHUNK-1)
+                             / POOL_LINES_CHUNK ),
+                           numthreads, in->minmapsize, in->quietmmap);
+
+      /* Prepare for the next dimension. */
+      gal_data_free(in);
+      in=out;
+    }
+
+  /* Return the final output. */
+  return in;
+}
+
+
+
+
+
+
 
-      /* Make sure the output array type and the type of result are the
-         same. */
-      if(result->type!=pp->out->type)
-        result=gal_data_copy_to_new_type_free(result, pp->out->type);
 
-      /* Copy the result into the output array. */
-      memcpy(gal_pointer_increment(pp->out->array, oind, pp->out->type),
-             result->array, gal_type_sizeof(pp->out->type));
 
-      /* Clean up. */
-      gal_data_free(result);
+
+
+
+
+
+
+
+
+
+
+
+/**********************************************************************/
+/****************            Running median            *****************/
+/**********************************************************************/
+/* The running median is kept in two heaps: a max-heap containing the
+   lower half of the values and a min-heap containing the upper half. The
+   elements are added and removed in the same order (first-in, first-out),
+   and each element's position within its heap is kept, so adding or
+   removing an element is only 'O(log n)'. The median is always at the top
+   of the two heaps. */
+struct pool_median
+{
+  size_t      cap;    /* Maximum number of elements.              */
+  size_t      num;    /* Current number of elements.              */
+  size_t     head;    /* Slot of the oldest element.              */
+  double    *vals;    /* Value of each slot.                      */
+  size_t     *pos;    /* Position of each slot in its heap.       */
+  uint8_t   *inlo;    /* If the slot is in the lower (max) heap.  */
+  size_t      *lo;    /* Max-heap (of slots) with lower half.     */
+  size_t      *hi;    /* Min-heap (of slots) with upper half.     */
+  size_t      nlo;    /* Number of elements in the lower heap.    */
+  size_t      nhi;    /* Number of elements in the upper heap.    */
+};
+
+
+
+
+
+static void
+pool_median_alloc(struct pool_median *m, size_t cap)
+{
+  m->cap=cap;
+  m->num=m->head=m->nlo=m->nhi=0;
+  m->vals=gal_pointer_allocate(GAL_TYPE_FLOAT64, cap, 0, __func__, "vals");
+  m->pos =gal_pointer_allocate(GAL_TYPE_SIZE_T,  cap, 0, __func__, "pos");
+  m->inlo=gal_pointer_allocate(GAL_TYPE_UINT8,   cap, 0, __func__, "inlo");
+  m->lo  =gal_pointer_allocate(GAL_TYPE_SIZE_T,  cap, 0, __func__, "lo");
+  m->hi  =gal_pointer_allocate(GAL_TYPE_SIZE_T,  cap, 0, __func__, "hi");
+}
+
+
+
+
+
+static void
+pool_median_free(struct pool_median *m)
+{
+  free(m->vals); free(m->pos); free(m->inlo); free(m->lo); free(m->hi);
+}
+
+
+
+
+
+/* If the element at 'a' should be above the element at 'b' in the
+   heap. */
+#define POOL_HEAP_ABOVE(ISLO, HEAP, A, B)               \
+  ( (ISLO)                                              \
+    ? m->vals[(HEAP)[A]] > m->vals[(HEAP)[B]]           \
+    : m->vals[(HEAP)[A]] < m->vals[(HEAP)[B]] )
+
+static void
+pool_heap_swap(struct pool_median *m, size_t *heap, size_t a, size_t b)
+{
+  size_t t=heap[a];
+  heap[a]=heap[b];
+  heap[b]=t;
+  m->pos[heap[a]]=a;
+  m->pos[heap[b]]=b;
+}
+
+
+
+
+
+static void
+pool_heap_sift(struct pool_median *m, int islo, size_t i)
+{
+  size_t c, *heap = islo ? m->lo : m->hi, n = islo ? m->nlo : m->nhi;
+
+  /* Move up. */
+  while( i && POOL_HEAP_ABOVE(islo, heap, i, (i-1)/2) )
+    { pool_heap_swap(m, heap, i, (i-1)/2); i=(i-1)/2; }
+
+  /* Move down. */
+  while( (c=2*i+1) < n )
+    {
+      if( c+1<n && POOL_HEAP_ABOVE(islo, heap, c+1, c) ) ++c;
+      if( POOL_HEAP_ABOVE(islo, heap, c, i)==0 ) break;
+      pool_heap_swap(m, heap, i, c);
+      i=c;
     }
+}
+
+
+
+
+
+static void
+pool_heap_push(struct pool_median *m, int islo, size_t slot)
+{
+  size_t *heap = islo ? m->lo : m->hi, *n = islo ? &m->nlo : &m->nhi;
+  heap[*n]=slot;
+  m->pos[slot]=*n;
+  m->inlo[slot]=islo;
+  pool_heap_sift(m, islo, (*n)++);
+}
+
+
+
+
+
+static void
+pool_heap_remove(struct pool_median *m, int islo, size_t i)
+{
+  size_t *heap = islo ? m->lo : m->hi, *n = islo ? &m->nlo : &m->nhi;
+  if(i != --(*n))
+    {
+      heap[i]=heap[*n];
+      m->pos[heap[i]]=i;
+      pool_heap_sift(m, islo, i);
+    }
+}
+
+
+
+
+
+/* Keep the two heaps balanced: the lower heap has either the same number
+   of elements as the upper heap, or one more. */
+static void
+pool_median_balance(struct pool_median *m)
+{
+  size_t slot;
+  while(m->nlo > m->nhi+1)
+    {
+      slot=m->lo[0];
+      pool_heap_remove(m, 1, 0);
+      pool_heap_push(m, 0, slot);
+    }
+  while(m->nhi > m->nlo)
+    {
+      slot=m->hi[0];
+      pool_heap_remove(m, 0, 0);
+      pool_heap_push(m, 1, slot);
+    }
+}
+
+
+
+
+
+static void
+pool_median_add(struct pool_median *m, double v)
+{
+  size_t slot=(m->head+m->num++)%m->cap;
+  m->vals[slot]=v;
+  pool_heap_push(m, m->nlo==0 || v<=m->vals[m->lo[0]], slot);
+  pool_median_balance(m);
+}
+
+
+
+
+
+static void
+pool_median_remove_oldest(struct pool_median *m)
+{
+  size_t slot=m->head;
+  m->head=(m->head+1)%m->cap;
+  --m->num;
+  pool_heap_remove(m, m->inlo[slot], m->pos[slot]);
+  pool_median_balance(m);
+}
+
+
+
+
+
+static double
+pool_median_value(struct pool_median *m)
+{
+  if(m->num==0) return NAN;
+  return ( m->num%2
+           ? m->vals[m->lo[0]]
+           : (m->vals[m->lo[0]]+m->vals[m->hi[0]])/2 );
+}
+
+
+
+
+
+/* Each action is a chunk of output rows (along the fastest dimension).
+   Over each row, the window slides along the fastest dimension: the
+   input elements are added and removed as columns (all the elements in
+   the window that have the same coordinate in the fastest dimension), so
+   they leave the running median in the same order they entered it. */
+static void *
+pool_median_on_thread(void *in_prm)
+{
+  struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
+  struct pool_params *pp=(struct pool_params *)tprm->params;
+
+  struct pool_median m;
+  gal_data_t *input=pp->input;
+  size_t *dsize=input->dsize, ndim=input->ndim, f=ndim-1;
+  double *in=input->array, *out=pp->out->array, v;
+  size_t nrows=pp->out->size/pp->nout[f], row, a, d, i, j, cl, cr;
+  size_t l, r, nb, maxnb=1, *offs, *colnum, coord[POOL_MAXDIM];
+  size_t lo[POOL_MAXDIM], hi[POOL_MAXDIM], cur[POOL_MAXDIM];
+  size_t w=pp->wsize[f], s=pp->stride[f], b=pp->before[f];
+
+  /* Allocate the per-thread arrays: the offsets of the elements of one
+     column and the running median. */
+  for(d=0;d<f;++d)
+    maxnb *= pp->wsize[d]<dsize[d] ? pp->wsize[d] : dsize[d];
+  offs=gal_pointer_allocate(GAL_TYPE_SIZE_T, maxnb, 0, __func__, "offs");
+  colnum=gal_pointer_allocate(GAL_TYPE_SIZE_T, w, 0, __func__, "colnum");
+  pool_median_alloc(&m, maxnb*(w<dsize[f]?w:dsize[f]));
+
+  /* Go over the output rows of this thread. */
+  for(a=0; tprm->indexs[a] != GAL_BLANK_SIZE_T; ++a)
+    for(row=tprm->indexs[a]*POOL_LINES_CHUNK;
+        row<(tprm->indexs[a]+1)*POOL_LINES_CHUNK && row<nrows; ++row)
+      {
+        /* Coordinates of this row in the output (in all dimensions
+           except the fastest) and the range of input elements of its
+           window. */
+        gal_dimension_index_to_coord(row*pp->nout[f], ndim, pp->nout,
+                                     coord);
+        for(d=0;d<f;++d)
+          {
+            pool_range(coord[d], dsize[d], pp->wsize[d], pp->stride[d],
+                       pp->before[d], &lo[d], &hi[d]);
+            cur[d]=lo[d];
+          }
+
+        /* Offsets of all the elements of a column (with coordinate 0 in
+           the fastest dimension). */
+        nb=0;
+        for(d=0;d<f;++d) if(lo[d]==hi[d]) break;
+        if(d==f)       /* All dimensions have at least one element. */
+          while(1)
+            {
+              for(i=0, d=0;d<f;++d) i=i*dsize[d]+cur[d];
+              offs[nb++]=i*dsize[f];
+
+              /* Go to the next element (like an odometer). */
+              for(d=f; d>0; --d)
+                if(++cur[d-1]<hi[d-1]) break; else cur[d-1]=lo[d-1];
+              if(d==0) break;
+            }
+
+        /* Slide the window along the fastest dimension. */
+        m.num=m.head=m.nlo=m.nhi=0;
+        cl=cr=0;
+        for(j=0;j<pp->nout[f];++j)
+          {
+            pool_range(j, dsize[f], w, s, b, &l, &r);
+
+            /* If the new window doesn't overlap the old one, empty the
+               running median. */
+            if(l>=cr) { m.num=m.head=m.nlo=m.nhi=0; cl=cr=l; }
+
+            /* Remove the columns that have left the window. */
+            for(;cl<l;++cl)
+              for(i=0;i<colnum[cl%w];++i)
+                pool_median_remove_oldest(&m);
+
+            /* Add the new columns. */
+            for(;cr<r;++cr)
+              {
+                colnum[cr%w]=0;
+                for(i=0;i<nb;++i)
+                  if( !isnan( v=in[offs[i]+cr] ) )
+                    { pool_median_add(&m, v); ++colnum[cr%w]; }
+              }
+
+            /* Write the median. */
+            out[row*pp->nout[f]+j]=pool_median_value(&m);
+          }
+      }
 
   /* Clean up. */
-  gal_data_free(statv);
+  free(offs);
+  free(colnum);
+  pool_median_free(&m);
 
   /* Wait for all the other threads to finish, then return. */
   if(tprm->b) pthread_barrier_wait(tprm->b);
@@ -196,111 +638,281 @@ pool_type_on_thread(void *in_prm)
 
 
 
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/**********************************************************************/
+/****************           Generic window             *****************/
+/**********************************************************************/
+/* Number of usable (non-blank) elements within each output window. When
+   the input doesn't have any blank values, this is found from the
+   geometry of the windows, otherwise, a separable sum is done over an
+   array of ones and zeros. */
 static gal_data_t *
-pool_generic(gal_data_t *input, size_t psize, int operator, size_t numthreads)
+pool_number(struct pool_params *pp, gal_data_t *input, int hasblank,
+            size_t numthreads)
 {
-  struct pooling pp={0};
+  gal_data_t *num;
+  double *d, *df, *n;
+  size_t i, j, l, r, coord[POOL_MAXDIM];
+
+  /* With blank values. */
+  if(hasblank)
+    {
+      num=gal_data_alloc(NULL, GAL_TYPE_FLOAT64, input->ndim, input->dsize,
+                         NULL, 0, input->minmapsize, input->quietmmap,
+                         NULL, NULL, NULL);
+      n=num->array;
+      for(i=0;i<input->size;++i)
+        n[i] = gal_blank_is(gal_pointer_increment(input->array, i,
+                                                  input->type),
+                            input->type) ? 0.0f : 1.0f;
+      return pool_separable(pp, num, GAL_POOL_SUM, 0, numthreads);
+    }
+
+  /* Without blank values. */
+  num=gal_data_alloc(NULL, GAL_TYPE_FLOAT64, input->ndim, pp->nout, NULL,
+                     0, input->minmapsize, input->quietmmap, NULL, NULL,
+                     NULL);
+  df=(d=num->array)+num->size;
+  i=0;
+  do
+    {
+      *d=1.0f;
+      gal_dimension_index_to_coord(i++, input->ndim, pp->nout, coord);
+      for(j=0;j<input->ndim;++j)
+        {
+          pool_range(coord[j], input->dsize[j], pp->wsize[j],
+                     pp->stride[j], pp->before[j], &l, &r);
+          *d *= r-l;
+        }
+    }
+  while(++d<df);
+  return num;
+}
+
+
+
+
+
+/* Write blank values in the output elements that have no usable input
+   element (when 'num!=NULL'). */
+static void
+pool_blank_empty(gal_data_t *out, gal_data_t *num)
+{
+  size_t i;
+  double *n=num->array;
+  for(i=0;i<out->size;++i)
+    if(n[i]==0.0f)
+      gal_blank_write(gal_pointer_increment(out->array, i, out->type),
+                      out->type);
+}
+
 
-  int otype=GAL_TYPE_INVALID;
-  size_t outndim=input->ndim, i, r, diff;
 
-  /* Print a warning if the psize has a wrong value. It happens when the
-     user writes a negative value for the poolsize. */
-  if(psize>(size_t)(-1)/2 || psize==0)
-    error(EXIT_FAILURE, 0, "the value of poolsize must be positive, and "
-          "non zero)");
 
-  /* Make sure the given poolsize is lower than the input's width or
-     hight. */
-  if(psize>input->dsize[0] || psize>input->dsize[1])
-    error(EXIT_FAILURE, 0, "%s: the pool size along dimension must be "
-         "greater than the input's width or hight in that dimension",
-         __func__);
 
-  /* Set the pointers in the structure of the parameter. */
-  pp.input=input;
-  pp.poolsize=psize;
+gal_data_t *
+gal_pool_window(gal_data_t *input, int operator, size_t *wsize,
+                size_t *stride, size_t *before, size_t numthreads)
+{
+  struct pool_params pp={0};
+  gal_data_t *work, *num=NULL, *out=NULL;
+  int hasblank=gal_blank_present(input, 1);
+  void *ptr;
+  double *d, *df, *n, *o, *of;
+  size_t i, ndim=input->ndim, nrows, zeros[POOL_MAXDIM]={0};
+  size_t nout[POOL_MAXDIM], st[POOL_MAXDIM];
+
+  /* Sanity checks. */
+  if(ndim>POOL_MAXDIM)
+    error(EXIT_FAILURE, 0, "%s: datasets with more than %d dimensions "
+          "are not supported", __func__, POOL_MAXDIM);
+  if(input->block)
+    error(EXIT_FAILURE, 0, "%s: tiles are not yet supported", __func__);
+  for(i=0;i<ndim;++i)
+    {
+      st[i] = stride ? stride[i] : wsize[i];
+      if(wsize[i]==0 || st[i]==0 || wsize[i]>(size_t)(-1)/2)
+        error(EXIT_FAILURE, 0, "%s: the window size and stride along "
+              "each dimension must be positive (larger than zero). "
+              "Along dimension %zu (in C order), they are %zu and %zu "
+              "respectively", __func__, i, wsize[i], st[i]);
+      if(before && before[i]>=wsize[i])
+        error(EXIT_FAILURE, 0, "%s: the number of elements before the "
+              "window's reference element must be smaller than the "
+              "window size. Along dimension %zu (in C order), they are "
+              "%zu and %zu respectively", __func__, i, before[i],
+              wsize[i]);
+      nout[i] = input->dsize[i]/st[i] + (input->dsize[i]%st[i] ? 1 : 0);
+    }
+
+  /* Set the window parameters. */
+  pp.ndim=ndim;
+  pp.nout=nout;
+  pp.stride=st;
+  pp.wsize=wsize;
   pp.operator=operator;
+  pp.before=before?before:zeros;
 
-  if(pp.input->size==1) pp.out=pp.input;
-  else
+  /* Do the operation. */
+  switch(operator)
     {
-      /* Resize output when calculating pooling on it and the remainder
-         is not zero. So we must calculate the pooling one more time for
-         the remaining pixels. */
-      pp.osize=gal_pointer_allocate(GAL_TYPE_SIZE_T, input->ndim, 0,
-                                    __func__, "osize");
-
-      /* if the width is not divisible by the poolsize, we have to add one
-         dimension to the output dimension for these remaining pixels. */
-      for(i=0;i<input->ndim;++i)
+    case GAL_POOL_MAX:
+    case GAL_POOL_MIN:
+      /* Blank values are replaced by a value that doesn't affect the
+         extrema (the type's minimum for the maximum and vice-versa). */
+      work=gal_data_copy(input);
+      if(hasblank)
+        for(i=0;i<work->size;++i)
+          {
+            ptr=gal_pointer_increment(work->array, i, work->type);
+            if( gal_blank_is(ptr, work->type) )
+              {
+                if(operator==GAL_POOL_MAX) gal_type_min(work->type, ptr);
+                else                       gal_type_max(work->type, ptr);
+              }
+          }
+      out=pool_separable(&pp, work, operator, operator==GAL_POOL_MAX,
+                         numthreads);
+      if(hasblank)
         {
-          r=(input->dsize[i])%psize;
-          diff=((r==0)?0:1);
-          pp.osize[i]=(input->dsize[i]/psize)+diff;
+          num=pool_number(&pp, input, hasblank, numthreads);
+          pool_blank_empty(out, num);
         }
-
-      /* Set the type of the output dataset. */
-      switch(pp.operator)
+      break;
+
+    case GAL_POOL_SUM:
+    case GAL_POOL_MEAN:
+      /* Sum of the non-blank elements (blank elements are set to zero in
+         the float64 copy). */
+      work=gal_data_copy_to_new_type(input, GAL_TYPE_FLOAT64);
+      if(hasblank)
         {
-        case POOL_MAX:
-        case POOL_MIN:
-        case POOL_MEDIAN:
-          otype=pp.input->type;
-          break;
-
-        case POOL_SUM:
-        case POOL_MEAN:
-          otype=GAL_TYPE_FLOAT64;
-          break;
-
-        default:
-          error(EXIT_FAILURE, 0, "%s: a bug! please contact us at %s to fix "
-                "the problem. The 'operator' code %d is not recognized",
-                PACKAGE_BUGREPORT, __func__, operator);
+          df=(d=work->array)+work->size;
+          do if(isnan(*d)) *d=0.0f; while(++d<df);
         }
+      out=pool_separable(&pp, work, GAL_POOL_SUM, 0, numthreads);
 
-      /* Allocating an struct for the output data. */
-      pp.out=gal_data_alloc(NULL, otype, outndim, pp.osize, NULL, 0,
-                            pp.input->minmapsize, pp.input->quietmmap, NULL,
+      /* Divide by the number of elements for the mean and set the
+         windows without any usable element to blank. */
+      if(operator==GAL_POOL_MEAN || hasblank)
+        {
+          num=pool_number(&pp, input, hasblank, numthreads);
+          n=num->array;
+          of=(o=out->array)+out->size;
+          do
+            {
+              if(*n==0.0f) *o=NAN;
+              else if(operator==GAL_POOL_MEAN) *o /= *n;
+              ++n;
+            }
+          while(++o<of);
+        }
+      break;
+
+    case GAL_POOL_MEDIAN:
+      /* The running median is done in double precision (where blank
+         values are NaN), the output is then converted to the input's
+         type. */
+      pp.input = ( input->type==GAL_TYPE_FLOAT64
+                   ? input
+                   : gal_data_copy_to_new_type(input, GAL_TYPE_FLOAT64) );
+      pp.out=gal_data_alloc(NULL, GAL_TYPE_FLOAT64, ndim, nout, NULL, 0,
+                            input->minmapsize, input->quietmmap, NULL,
                             NULL, NULL);
-
-      /* Spin-off the threads and do the processing on each thread. */
-      gal_threads_spin_off(pool_type_on_thread, &pp, pp.out->size, numthreads,
-                           pp.input->minmapsize, pp.input->quietmmap);
+      nrows=pp.out->size/nout[ndim-1];
+      gal_threads_spin_off(pool_median_on_thread, &pp,
+                           (nrows+POOL_LINES_CHUNK-1)/POOL_LINES_CHUNK,
+                           numthreads, input->minmapsize,
+                           input->quietmmap);
+      out=gal_data_copy_to_new_type_free(pp.out, input->type);
+      if(pp.input!=input) gal_data_free(pp.input);
+      break;
+
+    default:
+      error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at '%s' to "
+            "fix the problem. The 'operator' code %d is not recognized",
+            __func__, PACKAGE_BUGREPORT, operator);
     }
 
-  /* Correct the WCS (if it has one). */
+  /* Correct the WCS (if it has one and the size has changed). */
   if(input->wcs)
     {
-      /* We currently assume that a 'cdelt' exists (due to a lack of
-         time)! */
-      if(pp.input->wcs->cdelt==NULL)
-        error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at '%s' to "
-              "fix the problem. The input WCS has no 'cdelt' component",
-              __func__, PACKAGE_BUGREPORT);
-
-      /* Copy the input WCS to the output and correct the values. */
-      pp.out->wcs=gal_wcs_copy(pp.input->wcs);
-      pp.out->wcs->crpix[0]/=psize;
-      pp.out->wcs->crpix[1]/=psize;
-      pp.out->wcs->cdelt[0]*=psize;
-      pp.out->wcs->cdelt[1]*=psize;
+      out->wcs=gal_wcs_copy(input->wcs);
+      for(i=0;i<ndim;++i)
+        if(st[i]!=1)
+          {
+            /* We currently assume that a 'cdelt' exists (due to a lack
+               of time)! */
+            if(out->wcs->cdelt==NULL)
+              error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at "
+                    "'%s' to fix the problem. The input WCS has no "
+                    "'cdelt' component", __func__, PACKAGE_BUGREPORT);
+            out->wcs->crpix[ndim-i-1] /= st[i];
+            out->wcs->cdelt[ndim-i-1] *= st[i];
+          }
     }
 
   /* Clean up and return. */
-  free(pp.osize);
-  return pp.out;
+  if(num) gal_data_free(num);
+  return out;
 }
 
 
 
 
 
+static gal_data_t *
+pool_generic(gal_data_t *input, size_t psize, int operator, size_t numthreads)
+{
+  size_t i, wsize[POOL_MAXDIM];
+
+  /* Print a warning if the psize has a wrong value. It happens when the
+     user writes a negative value for the poolsize. */
+  if(psize>(size_t)(-1)/2 || psize==0)
+    error(EXIT_FAILURE, 0, "the value of poolsize must be positive, and "
+          "non zero)");
+
+  /* Make sure the given poolsize is not larger than the input's length
+     along any dimension. */
+  if(input->ndim>POOL_MAXDIM)
+    error(EXIT_FAILURE, 0, "%s: datasets with more than %d dimensions "
+          "are not supported", __func__, POOL_MAXDIM);
+  for(i=0;i<input->ndim;++i)
+    {
+      if(psize>input->dsize[i])
+        error(EXIT_FAILURE, 0, "%s: the pool size (%zu) is larger than "
+              "the input's length along dimension %zu (%zu)", __func__,
+              psize, input->ndim-i, input->dsize[i]);
+      wsize[i]=psize;
+    }
+
+  /* Non-overlapping windows: the stride is equal to the window size. */
+  return gal_pool_window(input, operator, wsize, NULL, NULL, numthreads);
+}
+
+
+
+
+
+
 gal_data_t *
 gal_pool_max(gal_data_t *input, size_t psize, size_t numthreads)
 {
-  return pool_generic(input, psize, POOL_MAX, numthreads);
+  return pool_generic(input, psize, GAL_POOL_MAX, numthreads);
 }
 
 
@@ -310,7 +922,7 @@ gal_pool_max(gal_data_t *input, size_t psize, size_t numthreads)
 gal_data_t *
 gal_pool_min(gal_data_t *input, size_t psize, size_t numthreads)
 {
-  return pool_generic(input, psize, POOL_MIN, numthreads);
+  return pool_generic(input, psize, GAL_POOL_MIN, numthreads);
 }
 
 
@@ -320,7 +932,7 @@ gal_pool_min(gal_data_t *input, size_t psize, size_t numthreads)
 gal_data_t *
 gal_pool_sum(gal_data_t *input, size_t psize, size_t numthreads)
 {
-  return pool_generic(input, psize, POOL_SUM, numthreads);
+  return pool_generic(input, psize, GAL_POOL_SUM, numthreads);
 }
 
 
@@ -330,7 +942,7 @@ gal_pool_sum(gal_data_t *input, size_t psize, size_t numthreads)
 gal_data_t *
 gal_pool_mean(gal_data_t *input, size_t psize, size_t numthreads)
 {
-  return pool_generic(input, psize, POOL_MEAN, numthreads);
+  return pool_generic(input, psize, GAL_POOL_MEAN, numthreads);
 }
 
 
@@ -340,5 +952,5 @@ gal_pool_mean(gal_data_t *input, size_t psize, size_t numthreads)
 gal_data_t *
 gal_pool_median(gal_data_t *input, size_t psize, size_t numthreads)
 {
-  return pool_generic(input, psize, POOL_MEDIAN, numthreads);
+  return pool_generic(input, psize, GAL_POOL_MEDIAN, numthreads);
 }
@@ -23,6 +23,9 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 **********************************************************************/
 #include <config.h>
 
+/* 'Python.h' should be included before any standard header. */
+#include <Python.h>
+
 #include <errno.h>
 #include <error.h>
 
@@ -30,19 +33,20 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
    avoid the compiler from raising a warning message. */
 #define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
 
-/* This macro needs to be defined before including any NumPy headers so
-   that the NumPY C-API can be used without having to call the
-   'import_arra' function as mentioned here:
-   https://numpy.org/doc/1.17/reference/c-api.array.html#c.NO_IMPORT_ARRAY
-   This also helps to avoid any "defined but not used" while compiling this
-   file. */
-#define NO_IMPORT_ARRAY
-
-/* Import Numpy's necessary header(s). */
+/* Import Numpy's necessary header(s). Since 'NO_IMPORT_ARRAY' and
+   'PY_ARRAY_UNIQUE_SYMBOL' aren't defined, NumPy's C-API table
+   ('PyArray_API') is a static variable of this file: it is only visible
+   here (so it doesn't conflict with the table of the Python module that
+   calls these functions) and it is filled by 'python_import_numpy' before
+   the first usage of the C-API, see:
+   https://numpy.org/doc/stable/reference/c-api/array.html#importing-the-api */
 #include <numpy/arrayobject.h>
 
-/* Gnuastro's Python headers. */
+/* Gnuastro's headers. */
+#include <gnuastro/tile.h>
+#include <gnuastro/dlpack.h>
 #include <gnuastro/python.h>
+#include <gnuastro/pointer.h>
 
 
 
@@ -106,3 +110,164 @@ gal_python_type_from_numpy(int type)
     }
   return GAL_TYPE_INVALID;
 }
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/*************************************************************
+ **************      Zero-copy arrays          ***************
+ *************************************************************/
+/* Fill NumPy's C-API table (if it hasn't already been filled). This needs
+   Python's interpreter (it imports NumPy), so it is only called within
+   the functions that are called from Python. On failure, -1 is returned
+   with Python's error indicator set. */
+static int
+python_import_numpy(void)
+{
+  return PyArray_API ? 0 : _import_array();
+}
+
+
+
+
+
+/* Describe the array of a NumPy array object as a Gnuastro dataset
+   without copying it. The output is a tile over a block when the NumPy
+   array is a row-major sub-set of a larger array (see 'gal_dlpack_view')
+   and NULL is returned when the array can't be described in Gnuastro
+   (for example a transposed or byte-swapped array), so the caller can
+   make a contiguous copy (for example with 'numpy.ascontiguousarray').
+
+   The NumPy array must not be freed (its reference should be kept)
+   until the output is freed with 'gal_dlpack_view_free'. */
+gal_data_t *
+gal_python_data_from_numpy(void *in)
+{
+  int i, ndim;
+  gal_data_t *out;
+  PyArrayObject *arr;
+  PyObject *obj=in;
+  int64_t *shape, *strides;
+
+  /* Basic sanity checks. */
+  if( python_import_numpy() )
+    error(EXIT_FAILURE, 0, "%s: NumPy's C-API couldn't be imported",
+          __func__);
+  if( !PyArray_Check(obj) )
+    error(EXIT_FAILURE, 0, "%s: input is not a NumPy array", __func__);
+  arr=(PyArrayObject *)obj;
+  if( !PyArray_ISNOTSWAPPED(arr) || !PyArray_ISALIGNED(arr) )
+    return NULL;
+
+  /* NumPy's shape and strides are in 'npy_intp', not 'int64_t'. */
+  ndim=PyArray_NDIM(arr);
+  shape=gal_pointer_allocate(GAL_TYPE_INT64, ndim ? ndim : 1, 0,
+                             __func__, "shape");
+  strides=gal_pointer_allocate(GAL_TYPE_INT64, ndim ? ndim : 1, 0,
+                               __func__, "strides");
+  for(i=0;i<ndim;++i)
+    {
+      shape[i]=PyArray_DIMS(arr)[i];
+      strides[i]=PyArray_STRIDES(arr)[i];
+    }
+
+  /* Build the view, clean up and return. */
+  out=gal_dlpack_view(PyArray_DATA(arr),
+                      gal_python_type_from_numpy(PyArray_TYPE(arr)),
+                      ndim, shape, strides);
+  free(strides);
+  free(shape);
+  return out;
+}
+
+
+
+
+
+/* Destructor of the capsule that keeps a stolen dataset. */
+static void
+python_capsule_free(PyObject *capsule)
+{
+  gal_data_free(PyCapsule_GetPointer(capsule, "gnuastro.data"));
+}
+
+
+
+
+
+/* Return a NumPy array that uses the array of the given dataset (without
+   copying it). When 'data' is a tile, the NumPy array will have the
+   strides of its block (so tiles can also be viewed in NumPy).
+
+   If 'steal' is non-zero, 'data' will be owned by the NumPy array: it is
+   freed with 'gal_data_free' when Python frees the array (the block of a
+   tile is never freed), so it shouldn't be used or freed by the caller
+   afterwards. Otherwise, 'data' should not be freed while the NumPy array
+   is in use. On failure (within Python), NULL is returned with Python's
+   error indicator set. */
+void *
+gal_python_data_to_numpy(gal_data_t *data, int steal)
+{
+  size_t i;
+  int typenum;
+  PyObject *out, *capsule;
+  npy_intp *dims, *strides;
+  gal_data_t *block=gal_tile_block(data);
+
+  /* Basic sanity checks. NumPy's strings are fixed-width arrays of
+     characters, not an array of pointers. */
+  if(data->array==NULL || data->type==GAL_TYPE_STRING)
+    error(EXIT_FAILURE, 0, "%s: the dataset has no array or is a "
+          "string", __func__);
+  typenum=gal_python_type_to_numpy(data->type);
+  if( python_import_numpy() ) return NULL;
+
+  /* Set the shape and strides (in bytes). */
+  errno=0;
+  dims=malloc(2 * data->ndim * sizeof *dims);
+  if(dims==NULL)
+    error(EXIT_FAILURE, errno, "%s: couldn't allocate 'dims'", __func__);
+  strides=dims+data->ndim;
+  strides[data->ndim-1]=gal_type_sizeof(data->type);
+  for(i=data->ndim-1; i-- > 0;)
+    strides[i] = strides[i+1] * block->dsize[i+1];
+  for(i=0;i<data->ndim;++i) dims[i]=data->dsize[i];
+
+  /* Build the NumPy array over the dataset's array (NumPy will set the
+     contiguity and alignment flags itself). */
+  out=PyArray_New(&PyArray_Type, data->ndim, dims, typenum, strides,
+                  data->array, 0, NPY_ARRAY_WRITEABLE, NULL);
+  free(dims);
+  if(out==NULL) return NULL;
+
+  /* If the dataset should be owned by the array, keep it in a capsule
+     that is the array's base object. Note that 'PyArray_SetBaseObject'
+     steals the reference to the capsule (even on failure). */
+  if(steal)
+    {
+      capsule=PyCapsule_New(data, "gnuastro.data", python_capsule_free);
+      if(capsule==NULL) { Py_DECREF(out); return NULL; }
+      if( PyArray_SetBaseObject((PyArrayObject *)out, capsule) )
+        { Py_DECREF(out); return NULL; }
+    }
+
+  /* Return the output. */
+  return out;
+}
@@ -23,12 +23,19 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <config.h>
 
 #include <math.h>
+#include <errno.h>
+#include <error.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <fitsio.h>
 
+#include <gnuastro/type.h>
 #include <gnuastro/qsort.h>
+#include <gnuastro/blank.h>
+#include <gnuastro/threads.h>
+#include <gnuastro/pointer.h>
 
 
 /*****************************************************************/
@@ -113,49 +120,57 @@ gal_qsort_int16_i(const void *a, const void *b)
 int
 gal_qsort_uint32_d(const void *a, const void *b)
 {
-  return ( *(uint32_t *)b - *(uint32_t *)a );
+  uint32_t ta=*(uint32_t *)a, tb=*(uint32_t *)b;
+  return (tb > ta) - (tb < ta);
 }
 
 int
 gal_qsort_uint32_i(const void *a, const void *b)
 {
-  return ( *(uint32_t *)a - *(uint32_t *)b );
+  uint32_t ta=*(uint32_t *)a, tb=*(uint32_t *)b;
+  return (ta > tb) - (ta < tb);
 }
 
 int
 gal_qsort_int32_d(const void *a, const void *b)
 {
-  return ( *(int32_t *)b - *(int32_t *)a );
+  int32_t ta=*(int32_t *)a, tb=*(int32_t *)b;
+  return (tb > ta) - (tb < ta);
 }
 
 int
 gal_qsort_int32_i(const void *a, const void *b)
 {
-  return ( *(int32_t *)a - *(int32_t *)b );
+  int32_t ta=*(int32_t *)a, tb=*(int32_t *)b;
+  return (ta > tb) - (ta < tb);
 }
 
 int
 gal_qsort_uint64_d(const void *a, const void *b)
 {
-  return ( *(uint64_t *)b - *(uint64_t *)a );
+  uint64_t ta=*(uint64_t *)a, tb=*(uint64_t *)b;
+  return (tb > ta) - (tb < ta);
 }
 
 int
 gal_qsort_uint64_i(const void *a, const void *b)
 {
-  return ( *(uint64_t *)a - *(uint64_t *)b );
+  uint64_t ta=*(uint64_t *)a, tb=*(uint64_t *)b;
+  return (ta > tb) - (ta < tb);
 }
 
 int
 gal_qsort_int64_d(const void *a, const void *b)
 {
-  return ( *(int64_t *)b - *(int64_t *)a );
+  int64_t ta=*(int64_t *)a, tb=*(int64_t *)b;
+  return (tb > ta) - (tb < ta);
 }
 
 int
 gal_qsort_int64_i(const void *a, const void *b)
 {
-  return ( *(int64_t *)a - *(int64_t *)b );
+  int64_t ta=*(int64_t *)a, tb=*(int64_t *)b;
+  return (ta > tb) - (ta < tb);
 }
 
 int
@@ -414,3 +429,461 @@ gal_qsort_index_multi_i(const void *a, const void *b)
   int out=(ta > tb) - (ta < tb);
   return out ? out : COMPARE_FLOAT_POSTPROCESS;
 }
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/*****************************************************************/
+/***************      Radix and merge sort      ******************/
+/*****************************************************************/
+/* The comparison functions above need a function call (and for the
+   indexs, a global pointer) for every comparison. The functions in this
+   section don't use any comparison function: each value is first
+   converted to an unsigned integer "key" whose unsigned order is the same
+   as the order of the values. The keys are then sorted with a Least
+   Significant Digit (LSD) radix sort (one 8-bit digit in each pass).
+
+     - Unsigned integers: the value itself.
+     - Signed integers: the sign bit is flipped.
+     - Floating point: if the sign bit is set, all the bits are flipped,
+       otherwise only the sign bit is flipped. NaN values are given the
+       largest possible key so they are always at the end (like the
+       comparison functions above).
+
+   For a decreasing sort, the bits of the keys are flipped (except for
+   NaN). On multiple threads, the array is divided into one block per
+   thread, each block is radix-sorted independently and the sorted blocks
+   are then merged (two by two, on multiple threads). Both the radix sort
+   and the merge are stable, so elements with equal values keep their
+   original order. */
+#define QSORT_INSERTION_MAX 64      /* Smaller: insertion sort.      */
+#define QSORT_PARALLEL_MIN  1000000 /* Smaller: single-threaded.     */
+
+struct qsort_radix_params
+{
+  uint8_t          type;  /* Type of the values.                       */
+  int        decreasing;  /* Sort in decreasing order.                 */
+  void          *values;  /* Array of values.                          */
+  size_t         *index;  /* Indexs to sort (NULL: sort the values).   */
+  size_t          nbits;  /* Number of bits in the keys.               */
+  uint64_t         *key;  /* Keys of each element.                     */
+  uint64_t        *tkey;  /* Temporary space for keys.                 */
+  size_t        *tindex;  /* Temporary space for indexs.               */
+  size_t        *bstart;  /* Starting element of each block.           */
+  size_t      numblocks;  /* Number of blocks.                         */
+  size_t          width;  /* Number of blocks merged in this round.    */
+  int            totemp;  /* Merge into the temporary arrays.          */
+  size_t     minmapsize;  /* Minimum bytes to memory-map the arrays.   */
+  int         quietmmap;  /* Don't print a notice when memory-mapping. */
+};
+
+
+
+
+
+/* Fill the keys of the elements 's' to 'e' (not inclusive). */
+#define QSORT_KEY_INT(IT, SIGN) {                                       \
+    IT *v=p->values;                                                    \
+    for(i=s;i<e;++i)                                                    \
+      {                                                                 \
+        k = ( (uint64_t)( p->index ? v[ p->index[i] ] : v[i] ) ^ SIGN ) \
+            & mask;                                                     \
+        p->key[i] = p->decreasing ? (~k & mask) : k;                    \
+      }                                                                 \
+  }
+
+#define QSORT_KEY_FLT(IT, UT, SIGN) {                                   \
+    UT u;                                                               \
+    IT x, *v=p->values;                                                 \
+    for(i=s;i<e;++i)                                                    \
+      {                                                                 \
+        x = p->index ? v[ p->index[i] ] : v[i];                         \
+        if(isnan(x)) p->key[i]=mask;                                    \
+        else                                                            \
+          {                                                             \
+            memcpy(&u, &x, sizeof u);                                   \
+            k = (u & SIGN) ? (~(uint64_t)u & mask) : (u | SIGN);        \
+            p->key[i] = p->decreasing ? (~k & mask) : k;                \
+          }                                                             \
+      }                                                                 \
+  }
+
+static void
+qsort_radix_keys(struct qsort_radix_params *p, size_t s, size_t e)
+{
+  size_t i;
+  uint64_t k, mask=( p->nbits==64 ? (uint64_t)-1
+                     : ((uint64_t)1<<p->nbits)-1 );
+
+  switch(p->type)
+    {
+    case GAL_TYPE_UINT8:   QSORT_KEY_INT( uint8_t,  0                );  break;
+    case GAL_TYPE_INT8:    QSORT_KEY_INT( int8_t,   0x80             );  break;
+    case GAL_TYPE_UINT16:  QSORT_KEY_INT( uint16_t, 0                );  break;
+    case GAL_TYPE_INT16:   QSORT_KEY_INT( int16_t,  0x8000           );  break;
+    case GAL_TYPE_UINT32:  QSORT_KEY_INT( uint32_t, 0                );  break;
+    case GAL_TYPE_INT32:   QSORT_KEY_INT( int32_t,  0x80000000       );  break;
+    case GAL_TYPE_UINT64:  QSORT_KEY_INT( uint64_t, 0                );  break;
+    case GAL_TYPE_INT64:
+      QSORT_KEY_INT( int64_t, 0x8000000000000000 );                       break;
+    case GAL_TYPE_FLOAT32:
+      QSORT_KEY_FLT( float,  uint32_t, 0x80000000 );                      break;
+    case GAL_TYPE_FLOAT64:
+      QSORT_KEY_FLT( double, uint64_t, 0x8000000000000000 );              break;
+    default:
+      error(EXIT_FAILURE, 0, "%s: type code %d not recognized",
+            __func__, p->type);
+    }
+}
+
+
+
+
+
+/* Convert the sorted keys back to values (when the values themselves are
+   sorted). */
+#define QSORT_VALUE_INT(IT, SIGN) {                                     \
+    IT *v=p->values;                                                    \
+    for(i=0;i<size;++i)                                                 \
+      {                                                                 \
+        k = p->decreasing ? (~p->key[i] & mask) : p->key[i];            \
+        v[i] = (IT)(k ^ SIGN);                                          \
+      }                                                                 \
+  }
+
+#define QSORT_VALUE_FLT(IT, UT, SIGN) {                                 \
+    UT u;                                                               \
+    IT *v=p->values;                                                    \
+    for(i=0;i<size;++i)                                                 \
+      if(p->key[i]==mask) v[i]=NAN;                                     \
+      else                                                              \
+        {                                                               \
+          k = p->decreasing ? (~p->key[i] & mask) : p->key[i];          \
+          u = (k & SIGN) ? (k ^ SIGN) : (~k & mask);                    \
+          memcpy(&v[i], &u, sizeof u);                                  \
+        }                                                               \
+  }
+
+static void
+qsort_radix_values(struct qsort_radix_params *p, size_t size)
+{
+  size_t i;
+  uint64_t k, mask=( p->nbits==64 ? (uint64_t)-1
+                     : ((uint64_t)1<<p->nbits)-1 );
+
+  switch(p->type)
+    {
+    case GAL_TYPE_UINT8:   QSORT_VALUE_INT( uint8_t,  0                ); break;
+    case GAL_TYPE_INT8:    QSORT_VALUE_INT( int8_t,   0x80             ); break;
+    case GAL_TYPE_UINT16:  QSORT_VALUE_INT( uint16_t, 0                ); break;
+    case GAL_TYPE_INT16:   QSORT_VALUE_INT( int16_t,  0x8000           ); break;
+    case GAL_TYPE_UINT32:  QSORT_VALUE_INT( uint32_t, 0                ); break;
+    case GAL_TYPE_INT32:   QSORT_VALUE_INT( int32_t,  0x80000000       ); break;
+    case GAL_TYPE_UINT64:  QSORT_VALUE_INT( uint64_t, 0                ); break;
+    case GAL_TYPE_INT64:
+      QSORT_VALUE_INT( int64_t, 0x8000000000000000 );                      break;
+    case GAL_TYPE_FLOAT32:
+      QSORT_VALUE_FLT( float,  uint32_t, 0x80000000 );                     break;
+    case GAL_TYPE_FLOAT64:
+      QSORT_VALUE_FLT( double, uint64_t, 0x8000000000000000 );             break;
+    default:
+      error(EXIT_FAILURE, 0, "%s: type code %d not recognized",
+            __func__, p->type);
+    }
+}
+
+
+
+
+
+/* Sort the 'size' keys (and indexs, if 'index!=NULL') starting from
+   'key' (and 'index'). The 'tkey' and 'tindex' arrays are temporary
+   spaces with the same size. */
+static void
+qsort_radix_block(uint64_t *key, size_t *index, uint64_t *tkey,
+                  size_t *tindex, size_t size, size_t nbits)
+{
+  uint64_t k, *kt, *okey=key;
+  size_t *it, *oindex=index;
+  size_t i, j, b, d, sum, tmp=0, nbytes=nbits/8;
+  size_t count[8][256]={{0}};
+
+  /* For small arrays, a simple insertion sort is faster. */
+  if(size<=QSORT_INSERTION_MAX)
+    {
+      for(i=1;i<size;++i)
+        {
+          k=key[i];
+          if(index) tmp=index[i];
+          for(j=i; j>0 && key[j-1]>k; --j)
+            {
+              key[j]=key[j-1];
+              if(index) index[j]=index[j-1];
+            }
+          key[j]=k;
+          if(index) index[j]=tmp;
+        }
+      return;
+    }
+
+  /* Count the number of elements with each digit (for all the digits
+     in one pass). */
+  for(i=0;i<size;++i)
+    for(b=0;b<nbytes;++b)
+      ++count[b][ (key[i]>>(8*b)) & 0xff ];
+
+  /* Go over the digits, from the least significant. */
+  for(b=0;b<nbytes;++b)
+    {
+      /* If all the elements have the same digit, this pass is
+         redundant. */
+      if( count[b][ (key[0]>>(8*b)) & 0xff ] == size ) continue;
+
+      /* Convert the counts to starting positions. */
+      for(sum=d=0;d<256;++d)
+        { tmp=count[b][d]; count[b][d]=sum; sum+=tmp; }
+
+      /* Put each element in its place. */
+      for(i=0;i<size;++i)
+        {
+          j=count[b][ (key[i]>>(8*b)) & 0xff ]++;
+          tkey[j]=key[i];
+          if(index) tindex[j]=index[i];
+        }
+
+      /* Swap the pointers. */
+      kt=key;   key=tkey;     tkey=kt;
+      it=index; index=tindex; tindex=it;
+    }
+
+  /* If an odd number of passes were done, the sorted elements are in the
+     temporary arrays (the pointers have been swapped), so copy them
+     back. */
+  if(key!=okey)
+    {
+      memcpy(okey, key, size*sizeof *key);
+      if(index) memcpy(oindex, index, size*sizeof *index);
+    }
+}
+
+
+
+
+
+/* Worker function to fill the keys and sort each block on a thread. */
+static void *
+qsort_radix_sort_on_thread(void *in_prm)
+{
+  struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
+  struct qsort_radix_params *p=(struct qsort_radix_params *)tprm->params;
+
+  size_t i, b, s, e;
+
+  /* Go over all the blocks that were assigned to this thread. */
+  for(i=0; tprm->indexs[i] != GAL_BLANK_SIZE_T; ++i)
+    {
+      b=tprm->indexs[i];
+      s=p->bstart[b];
+      e=p->bstart[b+1];
+      qsort_radix_keys(p, s, e);
+      qsort_radix_block(p->key+s, p->index ? p->index+s : NULL,
+                        p->tkey+s, p->index ? p->tindex+s : NULL,
+                        e-s, p->nbits);
+    }
+
+  /* Wait for all the other threads to finish, then return. */
+  if(tprm->b) pthread_barrier_wait(tprm->b);
+  return NULL;
+}
+
+
+
+
+
+/* Worker function to merge two neighboring (sorted) groups of blocks. */
+static void *
+qsort_radix_merge_on_thread(void *in_prm)
+{
+  struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
+  struct qsort_radix_params *p=(struct qsort_radix_params *)tprm->params;
+
+  uint64_t *ik, *ok;
+  size_t *ii, *oi, w=p->width;
+  size_t a, i, j, l, s, m, e, lb, mb, rb;
+
+  /* Set the input and output arrays. */
+  ik = p->totemp ? p->key    : p->tkey;
+  ok = p->totemp ? p->tkey   : p->key;
+  ii = p->totemp ? p->index  : p->tindex;
+  oi = p->totemp ? p->tindex : p->index;
+
+  /* Go over all the pairs that were assigned to this thread. */
+  for(a=0; tprm->indexs[a] != GAL_BLANK_SIZE_T; ++a)
+    {
+      /* Range of elements in the two groups. */
+      lb = tprm->indexs[a]*2*w;
+      mb = lb+w   < p->numblocks ? lb+w   : p->numblocks;
+      rb = lb+2*w < p->numblocks ? lb+2*w : p->numblocks;
+      s=p->bstart[lb]; m=p->bstart[mb]; e=p->bstart[rb];
+
+      /* Merge the two groups (when the values are equal, the element
+         from the left group is used first, so the merge is stable). */
+      i=s; j=m; l=s;
+      while(i<m && j<e)
+        if(ik[j]<ik[i]) { ok[l]=ik[j]; if(ii) oi[l]=ii[j]; ++l; ++j; }
+        else            { ok[l]=ik[i]; if(ii) oi[l]=ii[i]; ++l; ++i; }
+      for(;i<m;++i,++l) { ok[l]=ik[i]; if(ii) oi[l]=ii[i]; }
+      for(;j<e;++j,++l) { ok[l]=ik[j]; if(ii) oi[l]=ii[j]; }
+    }
+
+  /* Wait for all the other threads to finish, then return. */
+  if(tprm->b) pthread_barrier_wait(tprm->b);
+  return NULL;
+}
+
+
+
+
+
+/* Low-level function for the two high-level functions below. */
+static void
+qsort_radix(struct qsort_radix_params *p, size_t size, size_t numthreads)
+{
+  size_t b;
+  char *kmmap=NULL, *tkmmap=NULL, *timmap=NULL;
+
+  /* Basic settings. */
+  if(size==0) return;
+  p->nbits=8*gal_type_sizeof(p->type);
+  p->numblocks = ( numthreads>1 && size>=QSORT_PARALLEL_MIN
+                   ? numthreads : 1 );
+
+  /* Allocate the necessary arrays (the keys and temporary arrays need 16
+     to 24 bytes per element, so they are memory-mapped when larger than
+     the caller's 'minmapsize'). */
+  p->key=gal_pointer_allocate_ram_or_mmap(GAL_TYPE_UINT64, size, 0,
+                                          p->minmapsize, &kmmap,
+                                          p->quietmmap, __func__, "key");
+  p->tkey=gal_pointer_allocate_ram_or_mmap(GAL_TYPE_UINT64, size, 0,
+                                           p->minmapsize, &tkmmap,
+                                           p->quietmmap, __func__,
+                                           "tkey");
+  p->tindex = ( p->index
+                ? gal_pointer_allocate_ram_or_mmap(GAL_TYPE_SIZE_T, size, 0,
+                                                   p->minmapsize, &timmap,
+                                                   p->quietmmap, __func__,
+                                                   "tindex")
+                : NULL );
+  p->bstart=gal_pointer_allocate(GAL_TYPE_SIZE_T, p->numblocks+1, 0,
+                                 __func__, "bstart");
+  for(b=0;b<=p->numblocks;++b) p->bstart[b]=b*size/p->numblocks;
+
+  /* Sort the blocks. */
+  if(p->numblocks==1)
+    {
+      qsort_radix_keys(p, 0, size);
+      qsort_radix_block(p->key, p->index, p->tkey, p->tindex, size,
+                        p->nbits);
+    }
+  else
+    {
+      /* Sort each block on a separate thread. */
+      gal_threads_spin_off(qsort_radix_sort_on_thread, p, p->numblocks,
+                           numthreads, p->minmapsize, p->quietmmap);
+
+      /* Merge the sorted blocks (two by two). In each round, the inputs
+         and outputs are swapped between the main and temporary
+         arrays. */
+      p->totemp=1;
+      for(p->width=1; p->width<p->numblocks; p->width*=2)
+        {
+          gal_threads_spin_off(qsort_radix_merge_on_thread, p,
+                               ( p->numblocks/(2*p->width)
+                                 + (p->numblocks%(2*p->width) ? 1 : 0) ),
+                               numthreads, p->minmapsize,
+                               p->quietmmap);
+          p->totemp=!p->totemp;
+        }
+
+      /* If the last merge was into the temporary arrays, copy them
+         back. */
+      if(p->totemp==0)
+        {
+          memcpy(p->key, p->tkey, size*sizeof *p->key);
+          if(p->index)
+            memcpy(p->index, p->tindex, size*sizeof *p->index);
+        }
+    }
+
+  /* When the values themselves are to be sorted, convert the keys back to
+     values. */
+  if(p->index==NULL) qsort_radix_values(p, size);
+
+  /* Clean up. */
+  if(kmmap)  gal_pointer_mmap_free(&kmmap, p->quietmmap);
+  else       free(p->key);
+  if(tkmmap) gal_pointer_mmap_free(&tkmmap, p->quietmmap);
+  else       free(p->tkey);
+  if(timmap) gal_pointer_mmap_free(&timmap, p->quietmmap);
+  else if(p->tindex) free(p->tindex);
+  free(p->bstart);
+}
+
+
+
+
+
+/* Sort the values of 'array' (with 'size' elements of type 'type') in
+   place. */
+void
+gal_qsort_radix(void *array, uint8_t type, size_t size, int decreasing,
+                size_t numthreads, size_t minmapsize, int quietmmap)
+{
+  struct qsort_radix_params p={0};
+  p.type=type;
+  p.index=NULL;
+  p.values=array;
+  p.quietmmap=quietmmap;
+  p.decreasing=decreasing;
+  p.minmapsize=minmapsize;
+  qsort_radix(&p, size, numthreads);
+}
+
+
+
+
+
+/* Sort the 'size' elements of 'index' based on the values they point to
+   in 'values' (of type 'type'). Unlike the 'gal_qsort_index_single_*'
+   functions, this doesn't use any global variable, so it can be called
+   on different arrays from different threads. */
+void
+gal_qsort_radix_index(void *values, uint8_t type, size_t *index,
+                      size_t size, int decreasing, size_t numthreads,
+                      size_t minmapsize, int quietmmap)
+{
+  struct qsort_radix_params p={0};
+  p.type=type;
+  p.index=index;
+  p.values=values;
+  p.quietmmap=quietmmap;
+  p.decreasing=decreasing;
+  p.minmapsize=minmapsize;
+  qsort_radix(&p, size, numthreads);
+}
@@ -790,6 +790,10 @@ struct statistics_mode_params
   size_t    numcheck;   /* Number of pixels after mode to check.      */
   size_t    interval;   /* Interval to check pixels.                  */
   float   mirrordist;   /* Distance after mirror to check ( x STD).   */
+  size_t        *cum;   /* Cumulative histogram (NULL: sorted 'data').*/
+  double      *edges;   /* Edges of the histogram bins.               */
+  size_t     numbins;   /* Number of histogram bins.                  */
+  size_t        size;   /* Number of elements in the histogram.       */
 };
 
 
@@ -808,6 +812,175 @@ struct statistics_mode_params
 
 
 
+
+/* Macros for the histogram-based mode estimator. */
+#define MODE_HIST_SAMPLE_PER_BIN 16  /* Sampled elements for each bin edge. */
+#define MODE_HIST_MIN_PER_BIN    4   /* Smaller inputs: use exact method.   */
+#define MODE_HIST_MIN_STRIDE     4   /* Sample at most 1/4 of the input.    */
+#define MODE_HIST_ISBLANK(V, B) ( (V)!=(V) || (V)==(B) )
+
+
+
+
+
+/* When the mode is estimated from a cumulative histogram (when 'cum' is
+   not NULL), the sorted array is never built: the value at a sorted index
+   and the sorted index of a value are interpolated within the bin that
+   contains them. The bins are equally populated (their edges are
+   quantiles of a sample of the input), so the error in the index is
+   roughly 'size/numbins' and the error in the value is at most one bin
+   width (which is small where the distribution is dense). To avoid
+   searching, the bin of the previous call is given in 'b', so for
+   monotonic series of calls the bins are found by walking. */
+static double
+mode_hist_value(struct statistics_mode_params *p, size_t k, size_t *b)
+{
+  size_t n, *cum=p->cum;
+
+  while(*b>0 && cum[*b]>k) --*b;
+  while(*b<p->numbins-1 && cum[*b+1]<=k) ++*b;
+  n=cum[*b+1]-cum[*b];
+  return ( p->edges[*b] + ( (p->edges[*b+1]-p->edges[*b])
+                            * ((double)(k-cum[*b])+0.5) / (double)n ) );
+}
+
+
+
+
+
+/* Number of elements that are smaller than 'v' (see
+   'mode_hist_value'). */
+static double
+mode_hist_index(struct statistics_mode_params *p, double v, size_t *b)
+{
+  double *edges=p->edges;
+
+  if(v<=edges[0]) return 0.0;
+  if(v>=edges[p->numbins]) return p->size;
+  while(*b>0 && edges[*b]>v) --*b;
+  while(*b<p->numbins-1 && edges[*b+1]<=v) ++*b;
+  return ( p->cum[*b] + ( (double)(p->cum[*b+1]-p->cum[*b])
+                          * (v-edges[*b]) / (edges[*b+1]-edges[*b]) ) );
+}
+
+
+
+
+
+/* Bin that probably contains the element with sorted index 'k' (to start
+   walking in the functions above). */
+static size_t
+mode_hist_bin_hint(struct statistics_mode_params *p, size_t k)
+{
+  size_t b=(double)k/(double)p->size*p->numbins;
+  return b<p->numbins ? b : p->numbins-1;
+}
+
+
+
+
+
+/* Index (relative to the mirror, 'm') of the element with a value
+   closest to 'mf' (the histogram equivalent of the loop in
+   'MIRR_MAX_DIFF'). */
+static size_t
+mode_hist_mirror_j(struct statistics_mode_params *p, size_t m, double mf,
+                   size_t prevj, size_t *b)
+{
+  size_t j, J=mode_hist_index(p, mf, b);
+
+  j = J>m ? J-m : 0;
+  if(j<prevj) j=prevj;
+  return j>p->size-m ? p->size-m : j;
+}
+
+
+
+
+
+/* Histogram version of 'mode_mirror_max_index_diff'. */
+static size_t
+mode_hist_max_index_diff(struct statistics_mode_params *p, size_t m)
+{
+  double zf, mf;
+  size_t i, j, vb, ib, absdiff, prevj=0, size=p->size;
+  size_t maxdiff=0, errordiff=p->mirrordist*sqrt(m);
+
+  /* Value at the mirror. */
+  vb=mode_hist_bin_hint(p, m);
+  zf=mode_hist_value(p, m, &vb);
+  ib=vb;
+
+  /* Go over the mirrored points (see 'mode_mirror_max_index_diff'). */
+  for(i=1; i<p->numcheck && i<=m && m+i<size ;i+=p->interval)
+    {
+      mf=2*zf-mode_hist_value(p, m-i, &vb);
+      j=mode_hist_mirror_j(p, m, mf, prevj, &ib);
+      if(i>j+errordiff)
+        {
+          maxdiff = MODE_MIRROR_ABOVE;
+          break;
+        }
+      absdiff  = i>j ? i-j : j-i;
+      if(absdiff>maxdiff) maxdiff=absdiff;
+      prevj=j;
+    }
+
+  /* Return the maximum difference  */
+  return maxdiff;
+}
+
+
+
+
+
+/* Histogram version of 'mode_symmetricity' (the value at the end of the
+   symmetricity is written into 'b_val' as a double). */
+static double
+mode_hist_symmetricity(struct statistics_mode_params *p, size_t m,
+                       double *b_val)
+{
+  double af, mf, bf, fi;
+  size_t i, j, ab, vb, ib, bi=0, topi, errdiff, prevj=0, size=p->size;
+
+  /* Set the basic constants. */
+  topi = 2*m>size-1 ? size-1 : 2*m;
+  errdiff = p->mirrordist * sqrt(m);
+
+  /* Set the values at the mirror and at the lower quantile. */
+  i=gal_statistics_quantile_index(2*m+1, MODE_SYM_LOW_Q);
+  ab=mode_hist_bin_hint(p, i);
+  af=mode_hist_value(p, i, &ab);
+  vb=mode_hist_bin_hint(p, m);
+  mf=mode_hist_value(p, m, &vb);
+  if(mf<=af) return 0;
+
+  /* Find the first point where the two distributions differ more than
+     the error. */
+  ib=vb;
+  for(i=1; i<topi-m ;i+=1)
+    {
+      fi=2*mf-mode_hist_value(p, m-i, &vb);
+      j=mode_hist_mirror_j(p, m, fi, prevj, &ib);
+      if(i>j+errdiff || j>i+errdiff)
+        {
+          bi=m+i;
+          break;
+        }
+      prevj=j;
+    }
+  if(bi==0) bi=topi;
+
+  /* Return the symmetricity. */
+  ab=mode_hist_bin_hint(p, bi);
+  bf = *b_val = mode_hist_value(p, bi, &ab);
+  return bf==af ? 0 : (bf-mf)/(mf-af);
+}
+
+
+
+
+
 /*
   Given a mirror point ('m'), return the maximum distance between the
   mirror distribution and the original distribution.
@@ -863,9 +1036,13 @@ mode_mirror_max_index_diff(struct statistics_mode_params *p, size_t m)
    prevj:    Index of previously checked point in the actual array.
    mf:       (in macro) Value that is approximately equal in both
              distributions.                                          */
-  size_t i, j, absdiff, prevj=0, size=p->data->size;
+  size_t i, j, absdiff, prevj=0, size;
   size_t  maxdiff=0, errordiff=p->mirrordist*sqrt(m);
 
+  /* When the histogram is used, there is no sorted array. */
+  if(p->cum) return mode_hist_max_index_diff(p, m);
+  size=p->data->size;
+
   /*
   printf("###############\n###############\n");
   printf("### Mirror pixel: %zu (mirrordist: %f, sqrt(m): %f)\n", m,
@@ -1112,7 +1289,11 @@ mode_golden_section(struct statistics_mode_params *p)
 static double
 mode_symmetricity(struct statistics_mode_params *p, size_t m, void *b_val)
 {
-  size_t i, j, bi=0, topi, errdiff, prevj=0, size=p->data->size;
+  size_t i, j, bi=0, topi, errdiff, prevj=0, size;
+
+  /* When the histogram is used, there is no sorted array. */
+  if(p->cum) return mode_hist_symmetricity(p, m, b_val);
+  size=p->data->size;
 
   /* Set the basic constants. */
   topi = 2*m>size-1 ? size-1 : 2*m;
@@ -1191,6 +1372,7 @@ gal_statistics_mode(gal_data_t *input, float mirrordist, int inplace)
 
 
   /* Make sure the input doesn't have blank values and is sorted.  */
+  p.cum=NULL;
   p.data=gal_statistics_no_blank_sorted(input, inplace);
 
 
@@ -1272,6 +1454,193 @@ gal_statistics_mode(gal_data_t *input, float mirrordist, int inplace)
 
 
 
+/* Build the equally populated cumulative histogram of the (contiguous)
+   input for 'gal_statistics_mode_hist': the interior bin edges are the
+   quantiles of a regularly spaced sample of the input (that is sorted),
+   then the input is parsed once to count the elements in each bin (and
+   find the minimum and maximum, which are the outer edges). The bin of
+   each element is found with a binary search that has no branches (the
+   bins are not uniform, and branches in such a search are mostly
+   mis-predicted). If the sample has no (non-blank) elements, the edges
+   can't be set, so nothing is kept and zero is returned. */
+#define MODE_HIST_SAMPLE(IT) {                                          \
+    IT *a=data->array, bv;                                              \
+    gal_blank_write(&bv, data->type);                                   \
+    for(i=0;i<data->size;i+=stride)                                     \
+      if( !MODE_HIST_ISBLANK(a[i], bv) ) sample[ns++]=a[i];             \
+  }
+#define MODE_HIST_COUNT(IT) {                                           \
+    IT *a=data->array, bv;                                              \
+    gal_blank_write(&bv, data->type);                                   \
+    for(i=0;i<data->size;++i)                                           \
+      if( !MODE_HIST_ISBLANK(a[i], bv) )                                \
+        {                                                               \
+          v=a[i];                                                       \
+          if(v<min) min=v;                                              \
+          if(v>max) max=v;                                              \
+          e=edges+1;                                                    \
+          for(n=nb-1; n>1; n-=half)                                     \
+            { half=n/2; e = e[half]<=v ? e+half : e; }                  \
+          ++cum[ e-edges + (*e<=v) ];                                   \
+        }                                                               \
+  }
+static int
+mode_hist_make(struct statistics_mode_params *p, gal_data_t *data,
+               size_t numbins)
+{
+  double *sample, *edges, *e, v, min=DBL_MAX, max=-DBL_MAX;
+  size_t i, b, n, half, *cum, ns=0, nb=numbins, stride;
+
+  /* Allocate the arrays. */
+  stride=data->size/(numbins*MODE_HIST_SAMPLE_PER_BIN);
+  if(stride<MODE_HIST_MIN_STRIDE) stride=MODE_HIST_MIN_STRIDE;
+  cum=gal_pointer_allocate(GAL_TYPE_SIZE_T, nb+1, 1, __func__, "cum");
+  edges=gal_pointer_allocate(GAL_TYPE_FLOAT64, nb+1, 0, __func__, "edges");
+  sample=gal_pointer_allocate(GAL_TYPE_FLOAT64, data->size/stride+1, 0,
+                              __func__, "sample");
+
+  /* Take the sample, sort it and set the interior edges. */
+  switch(data->type)
+    {
+    case GAL_TYPE_UINT8:     MODE_HIST_SAMPLE( uint8_t  );   break;
+    case GAL_TYPE_INT8:      MODE_HIST_SAMPLE( int8_t   );   break;
+    case GAL_TYPE_UINT16:    MODE_HIST_SAMPLE( uint16_t );   break;
+    case GAL_TYPE_INT16:     MODE_HIST_SAMPLE( int16_t  );   break;
+    case GAL_TYPE_UINT32:    MODE_HIST_SAMPLE( uint32_t );   break;
+    case GAL_TYPE_INT32:     MODE_HIST_SAMPLE( int32_t  );   break;
+    case GAL_TYPE_UINT64:    MODE_HIST_SAMPLE( uint64_t );   break;
+    case GAL_TYPE_INT64:     MODE_HIST_SAMPLE( int64_t  );   break;
+    case GAL_TYPE_FLOAT32:   MODE_HIST_SAMPLE( float    );   break;
+    case GAL_TYPE_FLOAT64:   MODE_HIST_SAMPLE( double   );   break;
+    default:
+      error(EXIT_FAILURE, 0, "%s: type code %d not recognized",
+            __func__, data->type);
+    }
+  if(ns==0) { free(sample); free(edges); free(cum); return 0; }
+  qsort(sample, ns, sizeof *sample, gal_qsort_float64_i);
+  for(b=1;b<nb;++b) edges[b]=sample[b*ns/nb];
+  free(sample);
+
+  /* Count the elements in each bin ('cum[b+1]' is the number of elements
+     in bin 'b' at this stage). */
+  switch(data->type)
+    {
+    case GAL_TYPE_UINT8:     MODE_HIST_COUNT( uint8_t  );   break;
+    case GAL_TYPE_INT8:      MODE_HIST_COUNT( int8_t   );   break;
+    case GAL_TYPE_UINT16:    MODE_HIST_COUNT( uint16_t );   break;
+    case GAL_TYPE_INT16:     MODE_HIST_COUNT( int16_t  );   break;
+    case GAL_TYPE_UINT32:    MODE_HIST_COUNT( uint32_t );   break;
+    case GAL_TYPE_INT32:     MODE_HIST_COUNT( int32_t  );   break;
+    case GAL_TYPE_UINT64:    MODE_HIST_COUNT( uint64_t );   break;
+    case GAL_TYPE_INT64:     MODE_HIST_COUNT( int64_t  );   break;
+    case GAL_TYPE_FLOAT32:   MODE_HIST_COUNT( float    );   break;
+    case GAL_TYPE_FLOAT64:   MODE_HIST_COUNT( double   );   break;
+    }
+
+  /* Make it cumulative and set the outer edges. */
+  for(b=1;b<=nb;++b) cum[b]+=cum[b-1];
+  edges[0]=min;
+  edges[nb]=max;
+
+  /* Put the histogram in the parameters structure. */
+  p->cum=cum;
+  p->edges=edges;
+  p->numbins=nb;
+  p->size=cum[nb];
+  return 1;
+}
+
+
+
+
+
+/* Similar to 'gal_statistics_mode', but the sorted array (and thus the
+   sorting) is replaced by an equally populated cumulative histogram with
+   'numbins' bins (see 'mode_hist_value'). The input is not modified.
+   When the input has less than 'MODE_HIST_MIN_PER_BIN' elements for each
+   bin (or the sample for the bin edges only has blank elements), the
+   histogram can't be fine enough, so the exact mode is returned. */
+gal_data_t *
+gal_statistics_mode_hist(gal_data_t *input, float mirrordist,
+                         size_t numbins)
+{
+  double *oa;
+  size_t vb, modeindex, dsize=4;
+  struct statistics_mode_params p;
+  gal_data_t *out, *contig;
+
+  /* Small sanity checks. */
+  if(mirrordist<=0)
+    error(EXIT_FAILURE, 0, "%s: %f not acceptable as a value to "
+          "'mirrordist'. Only positive values can be given to it",
+          __func__, mirrordist);
+  if(numbins<2)
+    error(EXIT_FAILURE, 0, "%s: at least two bins are necessary, but "
+          "'numbins' is %zu", __func__, numbins);
+
+
+  /* For small datasets, use the exact method. */
+  if(input->size < numbins*MODE_HIST_MIN_PER_BIN)
+    return gal_statistics_mode(input, mirrordist, 0);
+
+
+  /* Build the cumulative histogram (tiles are copied into a contiguous
+     array first). */
+  contig = input->block ? gal_data_copy(input) : input;
+  if( mode_hist_make(&p, contig, numbins)==0 )
+    {
+      if(contig!=input) gal_data_free(contig);
+      return gal_statistics_mode(input, mirrordist, 0);
+    }
+  if(contig!=input) gal_data_free(contig);
+
+
+  /* If there are no (non-blank) elements, set all outputs to NaN. */
+  out=gal_data_alloc(NULL, GAL_TYPE_FLOAT64, 1, &dsize, NULL, 1, -1, 1,
+                     NULL, NULL, NULL);
+  oa=out->array;
+  if(p.size==0)
+    {
+      oa[0]=oa[1]=oa[2]=oa[3]=NAN;
+      free(p.edges);
+      free(p.cum);
+      return out;
+    }
+
+
+  /* The rest is the same as 'gal_statistics_mode'. */
+  p.data         = NULL;
+  p.tolerance    = 0.01;
+  p.mirrordist   = mirrordist;
+  p.numcheck     = p.size/2;
+  p.interval     = p.numcheck>1000 ? p.numcheck/1000 : 1;
+  p.lowi         = gal_statistics_quantile_index(p.size, MODE_MIN_Q);
+  p.highi        = gal_statistics_quantile_index(p.size, MODE_MAX_Q);
+  p.midi = ( ( (float)p.highi + MODE_GOLDEN_RATIO * (float)p.lowi )
+             / ( 1 + MODE_GOLDEN_RATIO ) );
+  p.midd = mode_mirror_max_index_diff(&p, p.midi);
+  modeindex = mode_golden_section(&p);
+
+
+  /* Write the output values. */
+  vb=mode_hist_bin_hint(&p, modeindex);
+  oa[0] = mode_hist_value(&p, modeindex, &vb);
+  oa[1] = ((double)modeindex) / ((double)(p.size-1));
+  oa[2] = mode_symmetricity(&p, modeindex, &oa[3]);
+  if( !(oa[2]>GAL_STATISTICS_MODE_GOOD_SYM) )
+    oa[0]=oa[1]=oa[2]=oa[3]=NAN;
+
+
+  /* Clean up and return. */
+  free(p.edges);
+  free(p.cum);
+  return out;
+}
+
+
+
+
+
 /* Make the mirror array. */
 #define STATS_MKMIRROR(IT) {                                            \
     IT *a=noblank_sorted->array, *m=mirror->array;                      \
@@ -1486,10 +1855,9 @@ gal_statistics_is_sorted(gal_data_t *input, int updateflags)
 
 
 /* This function is ignorant to blank values, if you want to make sure
-   there is no blank values, you can call 'gal_blank_remove' first. */
-#define STATISTICS_SORT(QSORT_F) {                                      \
-    qsort(input->array, input->size, gal_type_sizeof(input->type), QSORT_F); \
-  }
+   there is no blank values, you can call 'gal_blank_remove' first. The
+   sorting is done with the radix sort of 'gal_qsort_radix' (which doesn't
+   need a comparison function for every pair of elements). */
 void
 gal_statistics_sort_increasing(gal_data_t *input)
 {
@@ -1498,25 +1866,18 @@ gal_statistics_sort_increasing(gal_data_t *input)
     switch(input->type)
       {
       case GAL_TYPE_UINT8:
-        STATISTICS_SORT(gal_qsort_uint8_i);    break;
       case GAL_TYPE_INT8:
-        STATISTICS_SORT(gal_qsort_int8_i);     break;
       case GAL_TYPE_UINT16:
-        STATISTICS_SORT(gal_qsort_uint16_i);   break;
       case GAL_TYPE_INT16:
-        STATISTICS_SORT(gal_qsort_int16_i);    break;
       case GAL_TYPE_UINT32:
-        STATISTICS_SORT(gal_qsort_uint32_i);   break;
       case GAL_TYPE_INT32:
-        STATISTICS_SORT(gal_qsort_int32_i);    break;
       case GAL_TYPE_UINT64:
-        STATISTICS_SORT(gal_qsort_uint64_i);   break;
       case GAL_TYPE_INT64:
-        STATISTICS_SORT(gal_qsort_int64_i);    break;
       case GAL_TYPE_FLOAT32:
-        STATISTICS_SORT(gal_qsort_float32_i);  break;
       case GAL_TYPE_FLOAT64:
-        STATISTICS_SORT(gal_qsort_float64_i);  break;
+        gal_qsort_radix(input->array, input->type, input->size, 0, 1,
+                        input->minmapsize, input->quietmmap);
+        break;
       default:
         error(EXIT_FAILURE, 0, "%s: type code %d not recognized",
               __func__, input->type);
@@ -1541,25 +1902,18 @@ gal_statistics_sort_decreasing(gal_data_t *input)
     switch(input->type)
       {
       case GAL_TYPE_UINT8:
-        STATISTICS_SORT(gal_qsort_uint8_d);    break;
       case GAL_TYPE_INT8:
-        STATISTICS_SORT(gal_qsort_int8_d);     break;
       case GAL_TYPE_UINT16:
-        STATISTICS_SORT(gal_qsort_uint16_d);   break;
       case GAL_TYPE_INT16:
-        STATISTICS_SORT(gal_qsort_int16_d);    break;
       case GAL_TYPE_UINT32:
-        STATISTICS_SORT(gal_qsort_uint32_d);   break;
       case GAL_TYPE_INT32:
-        STATISTICS_SORT(gal_qsort_int32_d);    break;
       case GAL_TYPE_UINT64:
-        STATISTICS_SORT(gal_qsort_uint64_d);   break;
       case GAL_TYPE_INT64:
-        STATISTICS_SORT(gal_qsort_int64_d);    break;
       case GAL_TYPE_FLOAT32:
-        STATISTICS_SORT(gal_qsort_float32_d);  break;
       case GAL_TYPE_FLOAT64:
-        STATISTICS_SORT(gal_qsort_float64_d);  break;
+        gal_qsort_radix(input->array, input->type, input->size, 1, 1,
+                        input->minmapsize, input->quietmmap);
+        break;
       default:
         error(EXIT_FAILURE, 0, "%s: type code %d not recognized",
               __func__, input->type);
@@ -31,6 +31,8 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <gnuastro/threads.h>
 #include <gnuastro/pointer.h>
 
+#include <gnuastro-internal/timing.h>
+
 #include <nproc.h>         /* from Gnulib, in Gnuastro's source */
 
 
@@ -265,6 +267,39 @@ gal_threads_attr_barrier_init(pthread_attr_t *attr, pthread_barrier_t *b,
 /*******************************************************************/
 /************     Run a function on multiple threads  **************/
 /*******************************************************************/
+/* When tracing is active, each thread's worker is called through this
+   function to record the time it spends on the thread. The worker waits
+   on the barrier at its end (after which the parameters may be freed by
+   the spinning thread) and the time spent waiting there should not be
+   counted for the worker. So the barrier is removed from the worker's
+   parameters and this function waits on it after recording the end of
+   the worker. */
+struct threads_trace_params
+{
+  void *(*worker)(void *);       /* Worker function of the caller.  */
+  struct gal_threads_params *prm; /* Parameters to pass to worker.   */
+};
+
+static void *
+threads_trace_worker(void *in_prm)
+{
+  struct threads_trace_params *tt=(struct threads_trace_params *)in_prm;
+  void *(*worker)(void *)=tt->worker;
+  struct gal_threads_params *prm=tt->prm;
+  pthread_barrier_t *b=prm->b;
+
+  prm->b=NULL;
+  gal_timing_trace_begin("threads: worker");
+  worker(prm);
+  gal_timing_trace_end("threads: worker");
+  if(b) pthread_barrier_wait(b);
+  return NULL;
+}
+
+
+
+
+
 /* Run a given function on the given tiles. The function has to be
    link-able with your final executable and has to have only one 'void *'
    argument and return a 'void *' value. To have access to
@@ -345,10 +380,12 @@ gal_threads_spin_off(void *(*worker)(void *), void *caller_params,
   pthread_attr_t attr;
   pthread_barrier_t b;
   struct gal_threads_params *prm;
+  struct threads_trace_params *tt=NULL;
   size_t i, *indexs, thrdcols, numbarriers;
 
   /* If there are no actions, then just return. */
   if(numactions==0) return;
+  gal_timing_trace_begin("threads: spin-off");
 
   /* Sanity check. */
   if(numthreads==0)
@@ -391,6 +428,16 @@ gal_threads_spin_off(void *(*worker)(void *), void *caller_params,
       numbarriers = (numactions<numthreads ? numactions : numthreads) + 1;
       gal_threads_attr_barrier_init(&attr, &b, numbarriers);
 
+      /* When tracing, the workers are called through the tracer. */
+      if( gal_timing_trace_is_active() )
+        {
+          errno=0;
+          tt=malloc(numthreads*sizeof *tt);
+          if(tt==NULL)
+            error(EXIT_FAILURE, errno, "%s: allocating %zu bytes for "
+                  "'tt'", __func__, numthreads*sizeof *tt);
+        }
+
       /* Spin-off the threads: */
       for(i=0;i<numthreads;++i)
         if(indexs[i*thrdcols]!=GAL_BLANK_SIZE_T)
@@ -399,7 +446,14 @@ gal_threads_spin_off(void *(*worker)(void *), void *caller_params,
             prm[i].b=&b;
             prm[i].params=caller_params;
             prm[i].indexs=&indexs[i*thrdcols];
-            err=pthread_create(&t, &attr, worker, &prm[i]);
+            if(tt)
+              {
+                tt[i].prm=&prm[i];
+                tt[i].worker=worker;
+                err=pthread_create(&t, &attr, threads_trace_worker, &tt[i]);
+              }
+            else
+              err=pthread_create(&t, &attr, worker, &prm[i]);
             if(err)
               {
                 fprintf(stderr, "can't create thread %zu", i);
@@ -422,4 +476,6 @@ gal_threads_spin_off(void *(*worker)(void *), void *caller_params,
 
   /* Clean up. */
   free(prm);
+  if(tt) free(tt);
+  gal_timing_trace_end("threads: spin-off");
 }
@@ -450,8 +450,9 @@ gal_tile_block_write_const_value(gal_data_t *tilevalues, gal_data_t *tilesll,
   if(withblank || initialize) gal_blank_initialize(tofill);
   else
     {
-      /* Copy the flags. */
-      tofill->flag=tilevalues->flag;
+      /* Copy the flags ('tofill' owns its own array, so it shouldn't
+         inherit the foreign flag). */
+      tofill->flag = tilevalues->flag & ~GAL_DATA_FLAG_FOREIGN;
 
       /* If we have more than one dimension, then remove the possibly
          sorted flags. */
@@ -556,14 +557,29 @@ tile_block_blank_flag(void *in_prm)
 
 
 
-/* Update the blank flag on the tiles within the list of input tiles. */
+/* Update the blank flag on the tiles within the list of input tiles. The
+   blank flag of the block is checked (and updated) first: when the block
+   has no blank values, none of its tiles will have any, so there is no
+   need to parse each tile. Since the result is kept in the block's flags,
+   the next tessellations over the same block also benefit. */
 void
 gal_tile_block_blank_flag(gal_data_t *tile_ll, size_t numthreads)
 {
+  gal_data_t *tile;
+
+  /* If the block has no blank values, just set the flags. */
+  if( gal_blank_present(gal_tile_block(tile_ll), 1)==0 )
+    for(tile=tile_ll; tile!=NULL; tile=tile->next)
+      {
+        tile->flag |=  GAL_DATA_FLAG_BLANK_CH;
+        tile->flag &= ~GAL_DATA_FLAG_HASBLANK;
+      }
+
   /* Go over all the tiles and update their blank flag. */
-  gal_threads_spin_off(tile_block_blank_flag, tile_ll,
-                       gal_list_data_number(tile_ll), numthreads,
-                       tile_ll->minmapsize, tile_ll->quietmmap);
+  else
+    gal_threads_spin_off(tile_block_blank_flag, tile_ll,
+                         gal_list_data_number(tile_ll), numthreads,
+                         tile_ll->minmapsize, tile_ll->quietmmap);
 }
 
 
@@ -23,7 +23,12 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <config.h>
 
 #include <stdio.h>
+#include <errno.h>
+#include <error.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 
 #include <gnuastro-internal/timing.h>
 
@@ -82,3 +87,232 @@ gal_timing_report(struct timeval *t1, char *jobname, size_t level)
       else printf("  ---- %s\n", jobname);
     }
 }
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/*********************************************************************/
+/*************              Tracing/profile            ***************/
+/*********************************************************************/
+/* A light-weight instrumentation of the major stages of the programs and
+   library. Each stage is a scope between 'gal_timing_trace_begin' and
+   'gal_timing_trace_end' (they can be nested and can be called on any
+   thread). Counters (for example bytes read or written) can also be
+   recorded with 'gal_timing_trace_counter'. When tracing is not
+   activated (with 'gal_timing_trace_start'), these functions return
+   immediately, so the overhead is one check of a global variable.
+
+   The events are kept in memory and are written (in the "Trace Event"
+   JSON format, that can be loaded into 'chrome://tracing' or Perfetto)
+   when the program exits. Besides the wall-clock time ('ts'), the CPU
+   time of the thread ('tts') is also stored for each event, so the
+   utilization of each stage and thread can be seen. The names must be
+   literal strings (they aren't copied). */
+struct timing_trace_event
+{
+  const char       *name;  /* Name of the scope or counter.          */
+  char                ph;  /* Phase: 'B' (begin), 'E' (end), 'C'.    */
+  size_t             tid;  /* Internal thread ID (counting from 1).  */
+  double              ts;  /* Wall-clock time (micro-seconds).       */
+  double             tts;  /* Thread CPU time (micro-seconds).       */
+  double           value;  /* Value of the counter ('C' only).       */
+};
+
+static int timing_trace_active=0;
+static char *timing_trace_filename=NULL;
+static struct timespec timing_trace_t0;
+static size_t timing_trace_num=0, timing_trace_alloc=0, timing_trace_ntid=0;
+static struct timing_trace_event *timing_trace_events=NULL;
+static pthread_key_t timing_trace_tidkey;
+static pthread_mutex_t timing_trace_mutex=PTHREAD_MUTEX_INITIALIZER;
+
+
+
+
+
+/* Write all the events into the output file. */
+static void
+timing_trace_write(void)
+{
+  size_t i;
+  FILE *fp;
+  struct timing_trace_event *e;
+
+  /* Open the file. */
+  errno=0;
+  fp=fopen(timing_trace_filename, "w");
+  if(fp==NULL)
+    {
+      error(EXIT_SUCCESS, errno, "%s: couldn't be opened to write the "
+            "trace", timing_trace_filename);
+      return;
+    }
+
+  /* Write the events. */
+  fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  for(i=0;i<timing_trace_num;++i)
+    {
+      e=&timing_trace_events[i];
+      if(e->ph=='C')
+        fprintf(fp, "{\"name\": \"%s\", \"ph\": \"C\", \"pid\": 1, "
+                "\"tid\": %zu, \"ts\": %.3f, \"args\": {\"value\": "
+                "%.17g}}", e->name, e->tid, e->ts, e->value);
+      else
+        fprintf(fp, "{\"name\": \"%s\", \"ph\": \"%c\", \"pid\": 1, "
+                "\"tid\": %zu, \"ts\": %.3f, \"tts\": %.3f}", e->name,
+                e->ph, e->tid, e->ts, e->tts);
+      fprintf(fp, "%s\n", i==timing_trace_num-1 ? "" : ",");
+    }
+  fprintf(fp, "]}\n");
+
+  /* Close the file and clean up. */
+  if(fclose(fp))
+    error(EXIT_SUCCESS, errno, "%s: couldn't be closed",
+          timing_trace_filename);
+  free(timing_trace_events);
+  free(timing_trace_filename);
+}
+
+
+
+
+
+/* Activate the tracing: the events will be written into 'filename' when
+   the program exits. */
+void
+gal_timing_trace_start(char *filename)
+{
+  /* Tracing can only be activated once. */
+  if(timing_trace_active) return;
+
+  /* Keep the file name (it may be freed by the caller). */
+  errno=0;
+  timing_trace_filename=malloc(strlen(filename)+1);
+  if(timing_trace_filename==NULL)
+    error(EXIT_FAILURE, errno, "%s: allocating %zu bytes", __func__,
+          strlen(filename)+1);
+  strcpy(timing_trace_filename, filename);
+
+  /* Prepare the thread IDs, the reference time and the output. */
+  if( pthread_key_create(&timing_trace_tidkey, free) )
+    error(EXIT_FAILURE, 0, "%s: couldn't create the thread key", __func__);
+  clock_gettime(CLOCK_MONOTONIC, &timing_trace_t0);
+  atexit(timing_trace_write);
+  timing_trace_active=1;
+}
+
+
+
+
+
+/* Add an event to the list. */
+static void
+timing_trace_add(const char *name, char ph, double value)
+{
+  size_t *tid;
+  struct timespec t, tt;
+  struct timing_trace_event *e;
+
+  /* Read the times as soon as possible. */
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &tt);
+
+  /* The internal ID of this thread (set on its first event). */
+  tid=pthread_getspecific(timing_trace_tidkey);
+  if(tid==NULL)
+    {
+      errno=0;
+      tid=malloc(sizeof *tid);
+      if(tid==NULL)
+        error(EXIT_FAILURE, errno, "%s: allocating thread ID", __func__);
+      pthread_mutex_lock(&timing_trace_mutex);
+      *tid=++timing_trace_ntid;
+      pthread_mutex_unlock(&timing_trace_mutex);
+      pthread_setspecific(timing_trace_tidkey, tid);
+    }
+
+  /* Add the event (allocating more space if necessary). */
+  pthread_mutex_lock(&timing_trace_mutex);
+  if(timing_trace_num==timing_trace_alloc)
+    {
+      timing_trace_alloc = timing_trace_alloc ? 2*timing_trace_alloc : 1024;
+      timing_trace_events=realloc(timing_trace_events, timing_trace_alloc
+                                  * sizeof *timing_trace_events);
+      if(timing_trace_events==NULL)
+        error(EXIT_FAILURE, 0, "%s: couldn't allocate %zu trace events",
+              __func__, timing_trace_alloc);
+    }
+
+  /* Fill the event while the lock is held: another thread may 'realloc'
+     the array as soon as it is released. */
+  e=&timing_trace_events[timing_trace_num++];
+  e->ph=ph;
+  e->tid=*tid;
+  e->name=name;
+  e->value=value;
+  e->ts  = ( (t.tv_sec - timing_trace_t0.tv_sec)*1e6
+             + (t.tv_nsec - timing_trace_t0.tv_nsec)/1e3 );
+  e->tts = tt.tv_sec*1e6 + tt.tv_nsec/1e3;
+  pthread_mutex_unlock(&timing_trace_mutex);
+}
+
+
+
+
+
+/* Beginning and end of a scope. */
+void
+gal_timing_trace_begin(const char *name)
+{
+  if(timing_trace_active) timing_trace_add(name, 'B', 0.0f);
+}
+
+void
+gal_timing_trace_end(const char *name)
+{
+  if(timing_trace_active) timing_trace_add(name, 'E', 0.0f);
+}
+
+
+
+
+
+/* Value of a counter at this moment (for example total bytes read). */
+void
+gal_timing_trace_counter(const char *name, double value)
+{
+  if(timing_trace_active) timing_trace_add(name, 'C', value);
+}
+
+
+
+
+
+/* Return 1 if tracing is active (to avoid preparations that are only
+   necessary for tracing). */
+int
+gal_timing_trace_is_active(void)
+{
+  return timing_trace_active;
+}
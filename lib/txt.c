@@ -23,6 +23,7 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 #include <config.h>
 
 #include <math.h>
+#include <float.h>
 #include <ctype.h>
 #include <stdio.h>
 #include <errno.h>
@@ -1790,43 +1791,664 @@ txt_fmts_for_printf(gal_data_t *datall, int leftadjust, int tab0_img1)
 
 
 
+/* Rows are formatted into memory in chunks of 'TXT_WRITE_CHUNK' rows and
+   each chunk is written with a single 'fwrite', so the used memory
+   doesn't grow with the number of rows. */
+#define TXT_WRITE_CHUNK        8192
+
+/* Length of the temporary string that a number is written into before
+   padding: the fast formatters are only used for precisions up to
+   'TXT_WRITE_PREC_MAX', so they never need more. */
+#define TXT_WRITE_NUM_LEN      64
+#define TXT_WRITE_PREC_MAX     30
+
+/* The fast floating point formatter needs a 'long double' with at least
+   64 bits of mantissa (x87 extended or IEEE quadruple precision): all
+   powers of ten up to 10^27 are exact in it and the error of scaling a
+   'double' by them is small enough to find the correctly rounded digits
+   of up to 17 significant digits. On other systems, 'snprintf' is always
+   used for floating point numbers. */
+#if LDBL_MANT_DIG==64 || LDBL_MANT_DIG==113
+#define TXT_WRITE_FAST_FLT     1
+#else
+#define TXT_WRITE_FAST_FLT     0
+#endif
+#define TXT_WRITE_POW10_MAX    27
+
+/* One 'printf' format string that is used for writing a column, parsed
+   into its components for the fast formatters. */
+struct txt_write_fmt
+{
+  char              *fmt;  /* Full 'printf' format string.             */
+  int               fast;  /* Can be written without 'printf'.         */
+  char              conv;  /* Conversion character.                    */
+  int              space;  /* The ' ' flag.                            */
+  int               left;  /* The '-' flag.                            */
+  size_t           width;  /* Minimum field width.                     */
+  int          precision;  /* Precision (-1 when not given).           */
+  char             *tail;  /* Characters after the conversion.         */
+  size_t         taillen;  /* Length of 'tail'.                        */
+  char     *nonfinite[4];  /* Full text for NaN, -NaN, inf and -inf.   */
+  size_t nonfinitelen[4];  /* Length of each 'nonfinite' string.       */
+};
+
+/* Growing output buffer of one chunk of rows. */
+struct txt_write_buf
+{
+  char                *a;  /* Allocated space.                         */
+  size_t            used;  /* Number of used bytes.                    */
+  size_t            size;  /* Number of allocated bytes.               */
+};
+
+/* Parameters for writing the rows. */
+struct txt_write_params
+{
+  gal_data_t       *input;  /* List of columns to write.               */
+  struct txt_write_fmt *f;  /* Two formats (normal and last) per col.  */
+  size_t            nrows;  /* Number of rows.                         */
+  char              point;  /* Decimal point character.                */
+};
+
+
+
+
+
+static void
+txt_write_fmt_parse(struct txt_write_fmt *f, char *fmt, uint8_t type)
+{
+  int i;
+  char *c=fmt;
+  double nonfinite[4]={NAN, -NAN, INFINITY, -INFINITY};
+
+  /* Initialize the structure, so any format that isn't recognized (or
+     isn't used, like an empty last format) is written by 'printf'. */
+  memset(f, 0, sizeof *f);
+  f->fmt=fmt;
+  f->precision=-1;
+  if(fmt==NULL || *c++!='%') return;
+
+  /* Flags, width, precision and length modifiers. */
+  for(; *c==' ' || *c=='-'; ++c)
+    if(*c==' ') f->space=1; else f->left=1;
+  while( isdigit(*c) ) f->width = f->width*10 + (*c++ - '0');
+  if(*c=='.')
+    {
+      f->precision=0;
+      for(++c; isdigit(*c); ++c)
+        if(f->precision<=TXT_WRITE_PREC_MAX)
+          f->precision = f->precision*10 + (*c - '0');
+    }
+  while(*c=='l' || *c=='h') ++c;
+  f->conv=*c;
+  if(*c=='\0') return;
+  f->tail=c+1;
+  f->taillen=strlen(f->tail);
+
+  /* See if the fast formatters can be used for this format and type. */
+  if( strchr(f->tail, '%') || f->precision>TXT_WRITE_PREC_MAX ) return;
+  switch(type)
+    {
+    case GAL_TYPE_STRING:
+      if(f->conv!='s' || f->precision>=0) return;
+      break;
+
+    case GAL_TYPE_FLOAT32:
+    case GAL_TYPE_FLOAT64:
+      if( !TXT_WRITE_FAST_FLT
+          || (f->conv!='e' && f->conv!='f' && f->conv!='g') )
+        return;
+
+      /* Non-finite values are rare, so their (full) string is written
+         once here with 'printf' itself. */
+      for(i=0;i<4;++i)
+        {
+          if( asprintf(&f->nonfinite[i], fmt, nonfinite[i])<0 )
+            error(EXIT_FAILURE, 0, "%s: asprintf allocation", __func__);
+          f->nonfinitelen[i]=strlen(f->nonfinite[i]);
+        }
+      break;
+
+    default:
+      if( f->conv!='d' && f->conv!='i' && f->conv!='u' && f->conv!='o'
+          && f->conv!='x' && f->conv!='X' )
+        return;
+    }
+  f->fast=1;
+}
+
+
+
+
+
 static void
-txt_print_value(FILE *fp, gal_data_t *data, size_t ind, char *fmt)
+txt_write_reserve(struct txt_write_buf *b, size_t n)
+{
+  size_t size;
+
+  if(b->used+n <= b->size) return;
+  size = 2*b->size > b->used+n ? 2*b->size : b->used+n+4096;
+  errno=0;
+  b->a=realloc(b->a, size);
+  if(b->a==NULL)
+    error(EXIT_FAILURE, errno, "%s: couldn't allocate %zu bytes",
+          __func__, size);
+  b->size=size;
+}
+
+
+
+
+
+static int
+txt_write_snprintf(char *out, size_t len, gal_data_t *data, size_t ind,
+                   char *fmt)
 {
   void *a=data->array;
 
   switch(data->type)
     {
       /* Numerical types. */
-    case GAL_TYPE_UINT8:   fprintf(fp, fmt, ((uint8_t *) a)[ind]); break;
-    case GAL_TYPE_INT8:    fprintf(fp, fmt, ((int8_t *)  a)[ind]); break;
-    case GAL_TYPE_UINT16:  fprintf(fp, fmt, ((uint16_t *)a)[ind]); break;
-    case GAL_TYPE_INT16:   fprintf(fp, fmt, ((int16_t *) a)[ind]); break;
-    case GAL_TYPE_UINT32:  fprintf(fp, fmt, ((uint32_t *)a)[ind]); break;
-    case GAL_TYPE_INT32:   fprintf(fp, fmt, ((int32_t *) a)[ind]); break;
-    case GAL_TYPE_UINT64:  fprintf(fp, fmt, ((uint64_t *)a)[ind]); break;
-    case GAL_TYPE_INT64:   fprintf(fp, fmt, ((int64_t *) a)[ind]); break;
-    case GAL_TYPE_FLOAT32: fprintf(fp, fmt, ((float *)   a)[ind]); break;
-    case GAL_TYPE_FLOAT64: fprintf(fp, fmt, ((double *)  a)[ind]); break;
+    case GAL_TYPE_UINT8:   return snprintf(out,len,fmt,((uint8_t *) a)[ind]);
+    case GAL_TYPE_INT8:    return snprintf(out,len,fmt,((int8_t *)  a)[ind]);
+    case GAL_TYPE_UINT16:  return snprintf(out,len,fmt,((uint16_t *)a)[ind]);
+    case GAL_TYPE_INT16:   return snprintf(out,len,fmt,((int16_t *) a)[ind]);
+    case GAL_TYPE_UINT32:  return snprintf(out,len,fmt,((uint32_t *)a)[ind]);
+    case GAL_TYPE_INT32:   return snprintf(out,len,fmt,((int32_t *) a)[ind]);
+    case GAL_TYPE_UINT64:  return snprintf(out,len,fmt,((uint64_t *)a)[ind]);
+    case GAL_TYPE_INT64:   return snprintf(out,len,fmt,((int64_t *) a)[ind]);
+    case GAL_TYPE_FLOAT32: return snprintf(out,len,fmt,((float *)   a)[ind]);
+    case GAL_TYPE_FLOAT64: return snprintf(out,len,fmt,((double *)  a)[ind]);
 
       /* Special consideration for strings. */
     case GAL_TYPE_STRING:
       if( !strcmp( ((char **)a)[ind], GAL_BLANK_STRING ) )
-        fprintf(fp, fmt, GAL_BLANK_STRING);
+        return snprintf(out, len, fmt, GAL_BLANK_STRING);
       else
-        fprintf(fp, fmt, ((char **)a)[ind]);
-      break;
+        return snprintf(out, len, fmt, ((char **)a)[ind]);
 
     default:
       error(EXIT_FAILURE, 0, "%s: type code %d not recognized",
             __func__, data->type);
     }
+
+  /* Control should not reach here. */
+  return -1;
+}
+
+
+
+
+
+/* Write the value with 'printf' (used when the fast formatters can't be
+   used). */
+static void
+txt_write_printf(struct txt_write_buf *b, gal_data_t *data, size_t ind,
+                 char *fmt)
+{
+  int n;
+
+  while(1)
+    {
+      n=txt_write_snprintf(b->a+b->used, b->size-b->used, data, ind, fmt);
+      if(n<0)
+        error(EXIT_FAILURE, errno, "%s: couldn't write value", __func__);
+      if( (size_t)n < b->size-b->used ) break;
+      txt_write_reserve(b, n+1);
+    }
+  b->used+=n;
 }
 
 
 
 
 
+/* Write the 'len' characters of 's' into the buffer with the padding and
+   trailing characters of the format. */
+static void
+txt_write_pad(struct txt_write_buf *b, char *s, size_t len,
+              struct txt_write_fmt *f)
+{
+  char *o;
+  size_t pad = f->width>len ? f->width-len : 0;
+
+  txt_write_reserve(b, len+pad+f->taillen);
+  o=b->a+b->used;
+  if(pad && !f->left) { memset(o, ' ', pad); o+=pad; }
+  memcpy(o, s, len); o+=len;
+  if(pad && f->left)  { memset(o, ' ', pad); o+=pad; }
+  memcpy(o, f->tail, f->taillen); o+=f->taillen;
+  b->used=o-b->a;
+}
+
+
+
+
+
+/* Write the decimal digits of 'q' into 'dig' with at least 'mindig'
+   digits (padding with zeros), return the number of digits. */
+static size_t
+txt_write_udigits(char *dig, uint64_t q, size_t mindig)
+{
+  size_t n;
+  char tmp[TXT_WRITE_NUM_LEN], *s=tmp+TXT_WRITE_NUM_LEN;
+
+  do { *--s = '0' + q%10; q/=10; } while(q);
+  while( (size_t)(tmp+TXT_WRITE_NUM_LEN-s) < mindig ) *--s='0';
+  n=tmp+TXT_WRITE_NUM_LEN-s;
+  memcpy(dig, s, n);
+  return n;
+}
+
+
+
+
+
+/* Write an integer (the absolute value is 'u' and 'neg' is its sign)
+   like 'printf' into the end of 'num'. Return the start of the string
+   (NULL if the conversion isn't recognized). */
+static char *
+txt_write_int(char *num, uint64_t u, int neg, struct txt_write_fmt *f,
+              size_t *len)
+{
+  unsigned base;
+  char *end=num+TXT_WRITE_NUM_LEN, *s=end;
+  char *digits = f->conv=='X' ? "0123456789ABCDEF" : "0123456789abcdef";
+
+  /* Set the base and check the sign. */
+  switch(f->conv)
+    {
+    case 'd': case 'i':           base=10; break;
+    case 'u': if(neg) return NULL; base=10; break;
+    case 'o': if(neg) return NULL; base=8;  break;
+    case 'x':
+    case 'X': if(neg) return NULL; base=16; break;
+    default: return NULL;
+    }
+
+  /* Write the digits (a precision of zero prints nothing for zero). */
+  if(base==10) while(u) { *--s = '0' + u%10;    u/=10;   }
+  else         while(u) { *--s = digits[u%base]; u/=base; }
+  if(f->precision<0) { if(s==end) *--s='0'; }
+  else while(end-s < f->precision) *--s='0';
+
+  /* The sign is only relevant for the signed conversions. */
+  if(base==10 && f->conv!='u')
+    { if(neg) *--s='-'; else if(f->space) *--s=' '; }
+  *len=end-s;
+  return s;
+}
+
+
+
+
+
+#if TXT_WRITE_FAST_FLT
+static const long double txt_write_pow10[TXT_WRITE_POW10_MAX+1]=
+  { 1e0L,  1e1L,  1e2L,  1e3L,  1e4L,  1e5L,  1e6L,  1e7L,  1e8L,  1e9L,
+    1e10L, 1e11L, 1e12L, 1e13L, 1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L,
+    1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L };
+
+
+
+
+
+/* Return 'x*10^s' (with at most two roundings), or a negative value if
+   the power is out of range. */
+static long double
+txt_write_scale(double x, int s)
+{
+  long double v=x;
+
+  if(s>2*TXT_WRITE_POW10_MAX || s<-2*TXT_WRITE_POW10_MAX) return -1.0L;
+  if(s>0)
+    {
+      if(s>TXT_WRITE_POW10_MAX)
+        { v*=txt_write_pow10[TXT_WRITE_POW10_MAX]; s-=TXT_WRITE_POW10_MAX; }
+      v*=txt_write_pow10[s];
+    }
+  else if(s<0)
+    {
+      s=-s;
+      if(s>TXT_WRITE_POW10_MAX)
+        { v/=txt_write_pow10[TXT_WRITE_POW10_MAX]; s-=TXT_WRITE_POW10_MAX; }
+      v/=txt_write_pow10[s];
+    }
+  return v;
+}
+
+
+
+
+
+/* Round the scaled value to the nearest integer. If it is too close to
+   a half-way point for the error of the scaling to be ignored (or too
+   large), return 0 so 'printf' is used (which uses the exact binary
+   value and the current rounding mode). */
+static int
+txt_write_round(long double v, uint64_t *q)
+{
+  uint64_t t;
+  long double r, m;
+
+  if(v<0.0L || v>=txt_write_pow10[18]) return 0;
+  t=(uint64_t)v;
+  r=v-t;
+  m=v*4*LDBL_EPSILON;
+  if(r>0.5L+m) ++t;
+  else if(r>=0.5L-m) return 0;
+  *q=t;
+  return 1;
+}
+
+
+
+
+
+/* The 'n' most significant decimal digits of 'x' (positive or zero) as
+   an integer ('q'), with 'e10' being the exponent of the first digit. */
+static int
+txt_write_digits_sig(double x, int n, uint64_t *q, int *e10)
+{
+  int e;
+  long double v;
+
+  /* Zero and the range of digits we can handle. */
+  if(x==0.0) { *q=0; *e10=0; return 1; }
+  if(n<1 || n>17) return 0;
+
+  /* Scale the value to have 'n' digits before the decimal point. The
+   'log10' estimate may be off by one close to powers of ten. */
+  e=floor(log10(x));
+  if( (v=txt_write_scale(x, n-1-e))<0.0L ) return 0;
+  if(v>=txt_write_pow10[n])
+    {
+      ++e;
+      if( (v=txt_write_scale(x, n-1-e))<0.0L
+          || v<txt_write_pow10[n-1] ) return 0;
+    }
+  else if(v<txt_write_pow10[n-1])
+    {
+      --e;
+      if( (v=txt_write_scale(x, n-1-e))<0.0L
+          || v>=txt_write_pow10[n] ) return 0;
+    }
+
+  /* Round, and correct for rounding up to the next power of ten. */
+  if( !txt_write_round(v, q) ) return 0;
+  if(*q==txt_write_pow10[n]) { *q/=10; ++e; }
+  *e10=e;
+  return 1;
+}
+
+
+
+
+
+/* Write 'n' significant digits ('q') with the exponent 'e10' in the
+   style of '%e' (when 'strip' is non-zero, trailing zeros of the
+   fraction are removed like '%g'). Return the end of the string. */
+static char *
+txt_write_estyle(char *o, uint64_t q, int n, int e10, char point,
+                 int strip)
+{
+  int nf, ae;
+  char dig[TXT_WRITE_NUM_LEN];
+
+  txt_write_udigits(dig, q, n);
+  *o++=dig[0];
+  nf=n-1;
+  if(strip) while(nf>0 && dig[nf]=='0') --nf;
+  if(nf) { *o++=point; memcpy(o, dig+1, nf); o+=nf; }
+  *o++='e';
+  *o++ = e10<0 ? '-' : '+';
+  ae = e10<0 ? -e10 : e10;
+  if(ae>=100) *o++ = '0' + ae/100;
+  *o++ = '0' + (ae/10)%10;
+  *o++ = '0' + ae%10;
+  return o;
+}
+
+
+
+
+
+/* Write the 'n' significant digits ('q', first digit has exponent 'e10',
+   which is in the range '-4<=e10<n') in the fixed-point style of '%g'
+   (without trailing zeros). Return the end of the string. */
+static char *
+txt_write_gfstyle(char *o, uint64_t q, int n, int e10, char point)
+{
+  int nf, z;
+  char dig[TXT_WRITE_NUM_LEN];
+
+  txt_write_udigits(dig, q, n);
+  while(n>0 && n>e10+1 && dig[n-1]=='0') --n;
+  if(e10>=0)
+    {
+      memcpy(o, dig, e10+1); o+=e10+1;
+      nf=n-e10-1;
+      if(nf>0) { *o++=point; memcpy(o, dig+e10+1, nf); o+=nf; }
+    }
+  else
+    {
+      *o++='0';
+      if(n>0)
+        {
+          *o++=point;
+          for(z=0;z<-e10-1;++z) *o++='0';
+          memcpy(o, dig, n); o+=n;
+        }
+    }
+  return o;
+}
+#endif
+
+
+
+
+
+/* Write a floating point number like 'printf' into 'num'. Return the
+   start of the string (or NULL if 'printf' should be used). */
+static char *
+txt_write_flt(char *num, double x, struct txt_write_fmt *f, char point,
+              size_t *len)
+{
+#if TXT_WRITE_FAST_FLT
+  size_t n;
+  uint64_t q;
+  int e10, P=f->precision<0 ? 6 : f->precision;
+  char *o=num+1, dig[TXT_WRITE_NUM_LEN];
+
+  switch(f->conv)
+    {
+    case 'e':
+      if( !txt_write_digits_sig(fabs(x), P+1, &q, &e10) ) return NULL;
+      o=txt_write_estyle(o, q, P+1, e10, point, 0);
+      break;
+
+    case 'f':
+      if( !txt_write_round(txt_write_scale(fabs(x), P), &q) ) return NULL;
+      n=txt_write_udigits(dig, q, P+1);
+      memcpy(o, dig, n-P); o+=n-P;
+      if(P) { *o++=point; memcpy(o, dig+n-P, P); o+=P; }
+      break;
+
+    case 'g':
+      if(P==0) P=1;
+      if( !txt_write_digits_sig(fabs(x), P, &q, &e10) ) return NULL;
+      o = ( (e10<-4 || e10>=P)
+            ? txt_write_estyle(o, q, P, e10, point, 1)
+            : txt_write_gfstyle(o, q, P, e10, point) );
+      break;
+
+    default: return NULL;
+    }
+
+  /* Add the sign. */
+  if( signbit(x) ) *num='-';
+  else if(f->space) *num=' ';
+  else ++num;
+  *len=o-num;
+  return num;
+#else
+  return NULL;
+#endif
+}
+
+
+
+
+
+/* Write one value of the dataset into the buffer. */
+#define TXT_WRITE_UINT(CTYPE)                                           \
+  s=txt_write_int(num, ((CTYPE *)a)[ind], 0, f, &len)
+#define TXT_WRITE_SINT(CTYPE) {                                         \
+    CTYPE v=((CTYPE *)a)[ind];                                          \
+    s=txt_write_int(num, v<0 ? -(uint64_t)v : (uint64_t)v, v<0, f,     \
+                    &len);                                              \
+  }
+static void
+txt_write_value(struct txt_write_buf *b, gal_data_t *data, size_t ind,
+                struct txt_write_fmt *f, char point)
+{
+  double x;
+  size_t len=0;
+  void *a=data->array;
+  char num[TXT_WRITE_NUM_LEN], *s=NULL;
+
+  if(f->fast)
+    switch(data->type)
+      {
+      case GAL_TYPE_UINT8:   TXT_WRITE_UINT(uint8_t);  break;
+      case GAL_TYPE_INT8:    TXT_WRITE_SINT(int8_t);   break;
+      case GAL_TYPE_UINT16:  TXT_WRITE_UINT(uint16_t); break;
+      case GAL_TYPE_INT16:   TXT_WRITE_SINT(int16_t);  break;
+      case GAL_TYPE_UINT32:  TXT_WRITE_UINT(uint32_t); break;
+      case GAL_TYPE_INT32:   TXT_WRITE_SINT(int32_t);  break;
+      case GAL_TYPE_UINT64:  TXT_WRITE_UINT(uint64_t); break;
+      case GAL_TYPE_INT64:   TXT_WRITE_SINT(int64_t);  break;
+
+      case GAL_TYPE_FLOAT32:
+      case GAL_TYPE_FLOAT64:
+        x = ( data->type==GAL_TYPE_FLOAT32
+              ? ((float *)a)[ind] : ((double *)a)[ind] );
+        if( !isfinite(x) )
+          {
+            len = isnan(x) ? (signbit(x)?1:0) : (signbit(x)?3:2);
+            txt_write_reserve(b, f->nonfinitelen[len]);
+            memcpy(b->a+b->used, f->nonfinite[len], f->nonfinitelen[len]);
+            b->used+=f->nonfinitelen[len];
+            return;
+          }
+        s=txt_write_flt(num, x, f, point, &len);
+        break;
+
+      case GAL_TYPE_STRING:
+        if( (s=((char **)a)[ind]) ) len=strlen(s);
+        break;
+      }
+
+  /* Write the value. */
+  if(s) txt_write_pad(b, s, len, f);
+  else  txt_write_printf(b, data, ind, f->fmt);
+}
+
+
+
+
+
+/* Write the given chunk of rows into the buffer. */
+static void
+txt_write_chunk(struct txt_write_params *p, size_t chunk,
+                struct txt_write_buf *b)
+{
+  gal_data_t *data;
+  size_t i, j, k, d1, end;
+
+  b->used=0;
+  end = (chunk+1)*TXT_WRITE_CHUNK;
+  if(end>p->nrows) end=p->nrows;
+  for(i=chunk*TXT_WRITE_CHUNK; i<end; ++i)
+    {
+      k=0; /* Column counter. */
+      for(data=p->input;data!=NULL;data=data->next)
+        {
+          if(data->ndim>1)  /* Vector column. */
+            {
+              d1=data->dsize[1];
+              for(j=0;j<d1;++j)
+                txt_write_value(b, data, i*d1+j,
+                  /* Last of vector column has a different format. */
+                  &p->f[ 2*k + (j==d1-1 && data->next==NULL) ],
+                  p->point);
+            }
+          else /* Non-vector column: simple! */
+            txt_write_value(b, data, i, &p->f[2*k], p->point);
+          ++k;
+        }
+      txt_write_reserve(b, 1);
+      b->a[b->used++]='\n';
+    }
+}
+
+
+
+
+
+/* Write all the rows of the columns. Each value is written like the
+   'printf' format that was prepared for its column, but without the
+   overhead of parsing the format for every value. */
+static void
+txt_write_rows(FILE *fp, gal_data_t *input, char **fmts, size_t num)
+{
+  char tmp[8];
+  size_t i, c, nchunks;
+  gal_data_t *data;
+  struct txt_write_params p;
+  struct txt_write_buf b={NULL, 0, 0};
+
+  /* Parse the formats of each column. */
+  errno=0;
+  p.f=malloc(2*num*sizeof *p.f);
+  if(p.f==NULL)
+    error(EXIT_FAILURE, errno, "%s: %zu bytes for 'p.f'", __func__,
+          2*num*sizeof *p.f);
+  for(i=0, data=input; data!=NULL; data=data->next, ++i)
+    {
+      txt_write_fmt_parse(&p.f[2*i],   fmts[i*FMTS_COLS],   data->type);
+      txt_write_fmt_parse(&p.f[2*i+1], fmts[i*FMTS_COLS+3], data->type);
+    }
+
+  /* The decimal point of the current locale. */
+  snprintf(tmp, sizeof tmp, "%.1f", 0.5);
+  p.point=tmp[1];
+
+  /* Format each chunk and write it. */
+  p.input=input;
+  p.nrows=input->dsize[0];
+  nchunks=(p.nrows+TXT_WRITE_CHUNK-1)/TXT_WRITE_CHUNK;
+  for(c=0;c<nchunks;++c)
+    {
+      txt_write_chunk(&p, c, &b);
+      errno=0;
+      if( fwrite(b.a, 1, b.used, fp)!=b.used )
+        error(EXIT_FAILURE, errno, "%s: couldn't write %zu bytes",
+              __func__, b.used);
+    }
+
+  /* Clean up. */
+  free(b.a);
+  for(i=0;i<2*num;++i)
+    for(c=0;c<4;++c)
+      free(p.f[i].nonfinite[c]);
+  free(p.f);
+}
+
+
+
+
+
+
 static void
 txt_write_metadata(FILE *fp, gal_data_t *datall, char **fmts,
                    int tab0_img1)
@@ -2000,7 +2622,7 @@ gal_txt_write(gal_data_t *input, struct gal_fits_list_key_t **keylist,
   FILE *fp;
   char **fmts;
   gal_list_str_t *strt;
-  size_t i, j, k, num=0, d1;
+  size_t i, num=0;
   gal_data_t *data, *nextimg=NULL;
 
   /* Make sure input is valid. */
@@ -2084,40 +2706,7 @@ gal_txt_write(gal_data_t *input, struct gal_fits_list_key_t **keylist,
 
 
   /* Print row-by-row (if we actually have data to print! */
-  if(input->array)
-    {
-      if(tab0_img1) /* Image. */
-        for(i=0;i<input->dsize[0];++i)
-          {
-            d1=input->dsize[1];
-            for(j=0;j<d1;++j)
-              txt_print_value(fp, input, i*d1+j, fmts[j==d1-1 ? 3 : 0]);
-            fprintf(fp, "\n");
-          }
-      else /* Table. */
-        {
-          for(i=0;i<input->dsize[0];++i)                  /* Row.    */
-            {
-              k=0; /* Column counter. */
-              for(data=input;data!=NULL;data=data->next)  /* Column. */
-                {
-                  if(data->ndim>1)  /* Vector column. */
-                    {
-                      d1=data->dsize[1];
-                      for(j=0;j<d1;++j)
-                        txt_print_value(fp, data, i*d1+j,
-                          fmts[ k * FMTS_COLS
-                      /* Last of vector column has a different format. */
-                                + (j==d1-1 && data->next==NULL ? 3 : 0) ]);
-                    }
-                  else /* Non-vector column: simple! */
-                    txt_print_value(fp, data, i, fmts[k * FMTS_COLS]);
-                  ++k;
-                }
-              fprintf(fp, "\n");
-            }
-        }
-    }
+  if(input->array) txt_write_rows(fp, input, fmts, num);
 
 
   /* Clean up. */
@@ -33,7 +33,10 @@ along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
 
 #include <gsl/gsl_math.h>
 
+#include <gnuastro/data.h>
 #include <gnuastro/type.h>
+#include <gnuastro/units.h>
+#include <gnuastro/threads.h>
 #include <gnuastro/pointer.h>
 
 
@@ -48,10 +51,11 @@ gal_units_extract_decimal(char *convert, const char *delimiter,
                           double *args, size_t n)
 {
   size_t i = 0;
-  char *copy, *token, *end;
+  char *copy, *token, *end, *saveptr;
 
   /* Create a copy of the string to be parsed and parse it. This is because
-     it will be modified during the parsing. */
+     it will be modified during the parsing. 'strtok_r' is used (not
+     'strtok') because this function may be called on many threads. */
   copy=strdup(convert);
   do
     {
@@ -65,7 +69,7 @@ gal_units_extract_decimal(char *convert, const char *delimiter,
         }
 
       /* Extract the substring till the next delimiter */
-      token=strtok(i==0?copy:NULL, delimiter);
+      token=strtok_r(i==0?copy:NULL, delimiter, &saveptr);
       if(token)
         {
           /* Parse extracted string as a number, and check if it worked. */
@@ -119,46 +123,92 @@ gal_units_extract_decimal(char *convert, const char *delimiter,
 /****************      Convert string to decimal      *****************/
 /**********************************************************************/
 
+/* Convert the three parsed (hour, minute and second) values of a right
+   ascension into degrees (NaN if any is out of range). */
+static double
+units_ra_values_to_degree(double *val)
+{
+  double decimal=0.0;
+
+  /* Check whether the first value is in within limits, and add it. We are
+     using 'signbit(val[0])' instead of 'val[0]<0.0f' because 'val[0]<0.0f'
+     can't distinguish negative zero (-0.0) from an unsigned zero (in other
+     words, '-0.0' will be interpretted to be positive). For the
+     declinations it is possible (see the comments in
+     'units_dec_values_to_degree'), so a user may mistakenly give that
+     format in Right Ascension. */
+  if(signbit(val[0]) || val[0]>24.0) return NAN;
+  decimal += val[0];
+
+  /* Check whether value of minutes is within limits, and add it. */
+  if(signbit(val[1]) || val[1]>60.0) return NAN;
+  decimal += val[1] / 60;
+
+  /* Check whether value of seconds is in within limits, and add it. */
+  if(signbit(val[2]) || val[2]>60.0) return NAN;
+  decimal += val[2] / 3600;
+
+  /* Convert value to degrees and return. */
+  decimal *= 15.0;
+  return decimal;
+}
+
+
+
+
+
 /* Parse the right ascension input as a string in form of hh:mm:ss to a
  * single decimal value calculated by (hh + mm / 60 + ss / 3600 ) * 15. */
 double
 gal_units_ra_to_degree(char *convert)
 {
   double val[3];
-  double decimal=0.0;
+  return ( gal_units_extract_decimal(convert, ":hms", val, 3)
+           ? units_ra_values_to_degree(val)
+           : NAN );
+}
 
-  /* Check whether the string is successfully parsed */
-  if(gal_units_extract_decimal(convert, ":hms", val, 3))
-    {
-      /* Check whether the first value is in within limits, and add it. We
-         are using 'signbit(val[0])' instead of 'val[0]<0.0f' because
-         'val[0]<0.0f' can't distinguish negative zero (-0.0) from an
-         unsigned zero (in other words, '-0.0' will be interpretted to be
-         positive). For the declinations it is possible (see the comments
-         in 'gal_units_dec_to_degree'), so a user may mistakenly give that
-         format in Right Ascension. */
-      if(signbit(val[0]) || val[0]>24.0) return NAN;
-      decimal += val[0];
-
-      /* Check whether value of minutes is within limits, and add it. */
-      if(signbit(val[1]) || val[1]>60.0) return NAN;
-      decimal += val[1] / 60;
-
-      /* Check whether value of seconds is in within limits, and add it. */
-      if(signbit(val[2]) || val[2]>60.0) return NAN;
-      decimal += val[2] / 3600;
-
-      /* Convert value to degrees and return. */
-      decimal *= 15.0;
-      return decimal;
-    }
-  else return NAN;
 
-  /* Control shouldn't reach this point. If it does, its a bug! */
-  error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at %s to fix the "
-        "problem. Control should not reach the end of this function",
-        __func__, PACKAGE_BUGREPORT);
-  return NAN;
+
+
+
+/* Convert the three parsed (degree, arc-minute and arc-second) values of
+   a declination into degrees (NaN if any is out of range). */
+static double
+units_dec_values_to_degree(double *val)
+{
+  int sign;
+  double decimal=0.0;
+
+  /* Check whether the first value is in within limits. */
+  if(val[0]<-90.0 || val[0]>90.0) return NAN;
+
+  /* If declination is negative, the first value in the array will be
+     negative and all other values will be positive. In that case, we set
+     sign equal to -1. Therefore, we multiply the first value by sign to
+     make it positive. The final answer is again multiplied by sign to
+     make its sign same as original.
+
+     We are using 'signbit(val[0])' instead of 'val[0]<0.0f' because
+     'val[0]<0.0f' can't distinguish negative zero (-0.0) from an unsigned
+     zero (in other words, '-0.0' will be interpretted to be positive). In
+     the case of declination, this can happen just below the equator
+     (where the declination is less than one degree), for example
+     '-00d:12:34'*/
+  sign = signbit(val[0]) ? -1 : 1;
+  decimal += val[0] * sign;
+
+  /* Check whether value of arc-minutes is in within limits. */
+  if(signbit(val[1]) || val[1]>60.0) return NAN;
+  decimal += val[1] / 60;
+
+  /* Check whether value of arc-seconds is in within limits */
+  if (signbit(val[2]) || val[2] > 60.0) return NAN;
+  decimal += val[2] / 3600;
+
+  /* Make the sign of the decimal value same as input and return. */
+  decimal *= sign;
+  return decimal;
 }
 
 
@@ -170,49 +220,10 @@ gal_units_ra_to_degree(char *convert)
 double
 gal_units_dec_to_degree(char *convert)
 {
-  int sign;
-  double val[3], decimal=0.0;
-
-  /* Parse the values in the input string. */
-  if(gal_units_extract_decimal(convert, ":dms", val, 3))
-    {
-      /* Check whether the first value is in within limits. */
-      if(val[0]<-90.0 || val[0]>90.0) return NAN;
-
-      /* If declination is negative, the first value in the array will be
-         negative and all other values will be positive. In that case, we
-         set sign equal to -1. Therefore, we multiply the first value by
-         sign to make it positive. The final answer is again multiplied by
-         sign to make its sign same as original.
-
-        We are using 'signbit(val[0])' instead of 'val[0]<0.0f' because
-        'val[0]<0.0f' can't distinguish negative zero (-0.0) from an
-        unsigned zero (in other words, '-0.0' will be interpretted to be
-        positive). In the case of declination, this can happen just below
-        the equator (where the declination is less than one degree), for
-        example '-00d:12:34'*/
-      sign = signbit(val[0]) ? -1 : 1;
-      decimal += val[0] * sign;
-
-      /* Check whether value of arc-minutes is in within limits. */
-      if(signbit(val[1]) || val[1]>60.0) return NAN;
-      decimal += val[1] / 60;
-
-      /* Check whether value of arc-seconds is in within limits */
-      if (signbit(val[2]) || val[2] > 60.0) return NAN;
-      decimal += val[2] / 3600;
-
-      /* Make the sign of the decimal value same as input and return. */
-      decimal *= sign;
-      return decimal;
-    }
-  else return NAN;
-
-  /* Control shouldn't reach this point. If it does, its a bug! */
-  error(EXIT_FAILURE, 0, "%s: a bug! Please contact us at %s to fix the "
-        "problem. Control should not reach the end of this function",
-        __func__, PACKAGE_BUGREPORT);
-  return NAN;
+  double val[3];
+  return ( gal_units_extract_decimal(convert, ":dms", val, 3)
+           ? units_dec_values_to_degree(val)
+           : NAN );
 }
 
 
@@ -241,19 +252,67 @@ gal_units_dec_to_degree(char *convert)
 /* Max-length of output string. */
 #define UNITS_RADECSTR_MAXLENGTH 50
 
+/* Break a right ascension (in degrees) into hours, minutes and seconds. */
+static void
+units_degree_to_ra_fields(double decimal, int *hours, int *minutes,
+                          float *seconds)
+{
+  /* Divide decimal value by 15 and extract integer part of decimal value
+     to obtain hours */
+  decimal /= 15.0;
+  *hours = (int)decimal;
+
+  /* Subtract hours from decimal and multiply remaining value by 60 to
+     obtain minutes. */
+  *minutes = (int)((decimal - *hours) * 60);
+
+  /* Subtract hours and minutes from decimal and multiply remaining value
+     by 3600 to obtain seconds (as a 'float' for sub-second accuracy). */
+  *seconds = (decimal - *hours - *minutes / 60.0) * 3600;
+}
+
+
+
+
+
+/* Break a declination (in degrees) into its sign, degrees, arc-minutes
+   and arc-seconds. */
+static void
+units_degree_to_dec_fields(double decimal, int *sign, int *degrees,
+                           int *arc_minutes, float *arc_seconds)
+{
+  /* If declination is negative, we set 'sign' equal to -1. We multiply the
+     decimal by to make sure it is positive. We then extract degrees,
+     arc-minutes and arc-seconds from the decimal. Finally, we add a minus
+     sign in beginning of string if input was negative. */
+  *sign = decimal<0.0 ? -1 : 1;
+  decimal *= *sign;
+
+  /* Extract integer part of decimal value to obtain degrees. */
+  *degrees=(int)decimal;
+
+  /* Subtract degrees from decimal and multiply remaining value by 60 to
+     obtain arc-minutes. */
+  *arc_minutes=(int)( (decimal - *degrees) * 60 );
+
+  /* Subtract degrees and arc-minutes from decimal and multiply remaining
+     value by 3600 to obtain arc-seconds. */
+  *arc_seconds = (decimal - *degrees - *arc_minutes / 60.0) * 3600;
+}
+
+
+
+
+
 /* Parse the right ascension input as a decimal to a string in form of
    hh:mm:ss.ss . */
 char *
 gal_units_degree_to_ra(double decimal, int usecolon)
 {
+  char *ra;
   size_t nchars;
-  int hours=0, minutes=0;
-  float seconds=0.0; /* For sub-second accuracy */
-
-  /* Allocate a long string which is large enough for string of format
-     hh:mm:ss.ss and sign */
-  char *ra=gal_pointer_allocate(GAL_TYPE_UINT8, UNITS_RADECSTR_MAXLENGTH,
-                                0, __func__, "ra");
+  float seconds;
+  int hours, minutes;
 
   /* Check if decimal value is within bounds otherwise return error */
   if (decimal<0 || decimal>360)
@@ -263,21 +322,14 @@ gal_units_degree_to_ra(double decimal, int usecolon)
       return NULL;
     }
 
-  /* Divide decimal value by 15 and extract integer part of decimal value
-     to obtain hours */
-  decimal /= 15.0;
-  hours = (int)decimal;
-
-  /* Subtract hours from decimal and multiply remaining value by 60 to
-     obtain minutes. */
-  minutes = (int)((decimal - hours) * 60);
-
-  /* Subtract hours and minutes from decimal and multiply remaining value
-     by 3600 to obtain seconds. */
-  seconds = (decimal - hours - minutes / 60.0) * 3600;
+  /* Allocate a long string which is large enough for string of format
+     hh:mm:ss.ss and sign */
+  ra=gal_pointer_allocate(GAL_TYPE_UINT8, UNITS_RADECSTR_MAXLENGTH, 0,
+                          __func__, "ra");
 
   /* Format the extracted hours, minutes and seconds as a string with
      leading zeros if required, in hh:mm:ss format */
+  units_degree_to_ra_fields(decimal, &hours, &minutes, &seconds);
   nchars = snprintf(ra, UNITS_RADECSTR_MAXLENGTH-1,
                     usecolon ? "%02d:%02d:%g" : "%02dh%02dm%g",
                     hours, minutes, seconds);
@@ -298,14 +350,10 @@ gal_units_degree_to_ra(double decimal, int usecolon)
 char *
 gal_units_degree_to_dec(double decimal, int usecolon)
 {
+  char *dec;
   size_t nchars;
-  float arc_seconds=0.0;
-  int sign, degrees=0, arc_minutes=0;
-
-  /* Allocate string of fixed length which is large enough for string of
-   * format hh:mm:ss.ss and sign */
-  char *dec=gal_pointer_allocate(GAL_TYPE_UINT8, UNITS_RADECSTR_MAXLENGTH,
-                                 0, __func__, "ra");
+  float arc_seconds;
+  int sign, degrees, arc_minutes;
 
   /* Check if decimal value is within bounds otherwise return error */
   if(decimal<-90 || decimal>90)
@@ -315,27 +363,16 @@ gal_units_degree_to_dec(double decimal, int usecolon)
       return NULL;
     }
 
-  /* If declination is negative, we set 'sign' equal to -1. We multiply the
-     decimal by to make sure it is positive. We then extract degrees,
-     arc-minutes and arc-seconds from the decimal. Finally, we add a minus
-     sign in beginning of string if input was negative. */
-  sign = decimal<0.0 ? -1 : 1;
-  decimal *= sign;
-
-  /* Extract integer part of decimal value to obtain degrees. */
-  degrees=(int)decimal;
-
-  /* Subtract degrees from decimal and multiply remaining value by 60 to
-     obtain arc-minutes. */
-  arc_minutes=(int)( (decimal - degrees) * 60 );
-
-  /* Subtract degrees and arc-minutes from decimal and multiply remaining
-     value by 3600 to obtain arc-seconds. */
-  arc_seconds = (decimal - degrees - arc_minutes / 60.0) * 3600;
+  /* Allocate string of fixed length which is large enough for string of
+   * format hh:mm:ss.ss and sign */
+  dec=gal_pointer_allocate(GAL_TYPE_UINT8, UNITS_RADECSTR_MAXLENGTH, 0,
+                           __func__, "dec");
 
   /* Format the extracted degrees, arc-minutes and arc-seconds as a string
      with leading zeros if required, in hh:mm:ss format with correct
      sign. */
+  units_degree_to_dec_fields(decimal, &sign, &degrees, &arc_minutes,
+                             &arc_seconds);
   nchars = snprintf(dec, UNITS_RADECSTR_MAXLENGTH-1,
                     usecolon ? "%s%02d:%02d:%g" : "%s%02dd%02dm%g",
                     sign<0?"-":"+", degrees, arc_minutes, arc_seconds);
@@ -609,3 +646,393 @@ gal_units_ly_to_au(double ly)
 {
   return ly * 63241.077f;
 }
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/**********************************************************************/
+/****************     Conversion of full columns      *****************/
+/**********************************************************************/
+/* Number of rows that are converted by each thread in one job. */
+#define UNITS_COLUMN_CHUNK 16384
+
+/* Check if a character is a delimiter of a sexagesimal string ('UNIT' is
+   'h' for right ascension and 'd' for declination). */
+#define UNITS_IS_SEXAGESIMAL_DELIMITER(C, UNIT)                        \
+  ( (C)==':' || (C)==(UNIT) || (C)=='m' || (C)=='s' )
+
+/* Parameters of the threads that convert columns. */
+struct units_column_params
+{
+  gal_data_t         *in;       /* Input column.                       */
+  gal_data_t        *out;       /* Output column.                      */
+  int              isdec;       /* Declination (not right ascension).  */
+  int           usecolon;       /* Use ':' to separate the components. */
+};
+
+
+
+
+
+/* Parse the three numbers of a sexagesimal string with the same result as
+   'gal_units_extract_decimal' (an arbitrary number of delimiters between
+   the numbers, like 'strtok'), but without any allocation. Only plain
+   decimal numbers (an optional sign, digits and an optional point) of up
+   to 15 digits are parsed here: such a number (as an integer) and the
+   power of ten to divide it by are both exactly representable in a
+   'double', so their division is correctly rounded and thus identical to
+   the output of 'strtod'. When this function returns 0, the string is
+   either invalid or has a more complex format, so the caller should use
+   the generic parser. */
+static int
+units_sexagesimal_parse(char *str, char unit, double *val)
+{
+  char *c=str;
+  uint64_t mantissa;
+  size_t i=0, ndigits, nfrac;
+  int negative, infraction;
+  static const double pow10[16]={1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6,
+                                 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+                                 1e13, 1e14, 1e15};
+
+  while(1)
+    {
+      /* Skip the delimiters and stop if the string has finished. */
+      while( UNITS_IS_SEXAGESIMAL_DELIMITER(*c, unit) ) ++c;
+      if(*c=='\0') break;
+
+      /* More than three numbers: the generic parser will also warn. */
+      if(i==3) return 0;
+
+      /* Parse the number. */
+      negative = *c=='-';
+      if(*c=='-' || *c=='+') ++c;
+      mantissa=ndigits=nfrac=infraction=0;
+      for(;;++c)
+        if(*c>='0' && *c<='9')
+          {
+            if(++ndigits>15) return 0;
+            mantissa = mantissa*10 + (*c-'0');
+            if(infraction) ++nfrac;
+          }
+        else if(*c=='.' && !infraction) infraction=1;
+        else break;
+
+      /* The number should end on a delimiter or the end of the string. */
+      if( ndigits==0
+          || ( *c!='\0' && !UNITS_IS_SEXAGESIMAL_DELIMITER(*c, unit) ) )
+        return 0;
+
+      /* Write the value (a negative zero should remain negative). */
+      val[i] = nfrac ? mantissa/pow10[nfrac] : (double)mantissa;
+      if(negative) val[i] = -val[i];
+      ++i;
+    }
+
+  /* Only three numbers are acceptable. */
+  return i==3;
+}
+
+
+
+
+
+/* Write the seconds (or arc-seconds) of a sexagesimal string with the
+   same characters as the '%g' format of 'printf'. Since 'seconds' is a
+   'float', it is exactly 'mantissa/2^shift' (with a 24-bit mantissa), so
+   the six significant digits of '%g' can be found with integer arithmetic
+   that follows the "round half to even" rule of 'printf'. Only zero and
+   the range [1, 60] (where the shift is between 18 and 23 and the integer
+   part has one or two digits) are written here, this function will return
+   0 for other values so the caller uses 'printf'. */
+static int
+units_seconds_write(char *str, float seconds)
+{
+  int exponent, shift;
+  uint64_t mantissa, q, r, half, div;
+  size_t i, ndecimal, intpart, frac;
+
+  /* Zero (a negative zero is printed as '-0' by 'printf'). */
+  if(seconds==0.0f && !signbit(seconds))
+    { str[0]='0'; str[1]='\0'; return 1; }
+  if( !(seconds>=1.0f && seconds<=60.0f) ) return 0;
+
+  /* Round the value to five (for 1 to 10) or four (for 10 to 60)
+     decimals. If the value rounds up to 10, '%g' will only print four
+     decimals (all zero). */
+  mantissa = ldexpf(frexpf(seconds, &exponent), 24);
+  shift = 24-exponent;
+  ndecimal = seconds>=10.0f ? 4 : 5;
+  div = ndecimal==4 ? 10000 : 100000;
+  q = mantissa*div >> shift;
+  r = mantissa*div & ( ((uint64_t)1<<shift) - 1 );
+  half = (uint64_t)1<<(shift-1);
+  if( r>half || (r==half && (q&1)) ) ++q;
+  if(q>=1000000) { q/=10; div/=10; ndecimal=4; }
+
+  /* Write the integer part. */
+  intpart=q/div;
+  frac=q%div;
+  if(intpart>=10) *str++ = '0' + intpart/10;
+  *str++ = '0' + intpart%10;
+
+  /* Write the fractional part without trailing zeros. */
+  if(frac)
+    {
+      while(frac%10==0) { frac/=10; --ndecimal; }
+      *str++='.';
+      for(i=ndecimal;i>0;--i) { str[i-1] = '0' + frac%10; frac/=10; }
+      str+=ndecimal;
+    }
+  *str='\0';
+  return 1;
+}
+
+
+
+
+
+/* Write the sexagesimal string of a right ascension or declination into
+   the fixed-width 'str' (with the same characters as the 'printf'
+   formats of 'gal_units_degree_to_ra' and 'gal_units_degree_to_dec').
+   When the value is out of range (or its seconds can't be written by
+   'units_seconds_write'), 0 is returned and the caller should use the
+   single-value functions. */
+static int
+units_degree_to_sexagesimal_write(char *str, double decimal, int isdec,
+                                  int usecolon)
+{
+  float seconds;
+  int sign=0, first, second;
+
+  /* Break the value into its components. */
+  if(isdec)
+    {
+      if( !(decimal>=-90 && decimal<=90) ) return 0;
+      units_degree_to_dec_fields(decimal, &sign, &first, &second,
+                                 &seconds);
+    }
+  else
+    {
+      if( !(decimal>=0 && decimal<=360) ) return 0;
+      units_degree_to_ra_fields(decimal, &first, &second, &seconds);
+    }
+  if(first>99 || second<0 || second>99) return 0;
+
+  /* Write the components. */
+  if(isdec) *str++ = sign<0 ? '-' : '+';
+  *str++ = '0' + first/10;
+  *str++ = '0' + first%10;
+  *str++ = usecolon ? ':' : (isdec ? 'd' : 'h');
+  *str++ = '0' + second/10;
+  *str++ = '0' + second%10;
+  *str++ = usecolon ? ':' : 'm';
+  return units_seconds_write(str, seconds);
+}
+
+
+
+
+
+/* Worker function on each thread: 'tprm->indexs' are the chunks of
+   'UNITS_COLUMN_CHUNK' rows. */
+static void *
+units_sexagesimal_to_degree_on_thread(void *in_prm)
+{
+  struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
+  struct units_column_params *p=(struct units_column_params *)tprm->params;
+
+  double val[3];
+  char **strarr=p->in->array;
+  double *out=p->out->array;
+  size_t i, j, start, end, size=p->in->size;
+
+  for(i=0; tprm->indexs[i]!=GAL_BLANK_SIZE_T; ++i)
+    {
+      start=tprm->indexs[i]*UNITS_COLUMN_CHUNK;
+      end=start+UNITS_COLUMN_CHUNK;
+      if(end>size) end=size;
+      for(j=start;j<end;++j)
+        if(strarr[j]==NULL) out[j]=NAN;
+        else if(p->isdec)
+          out[j] = ( units_sexagesimal_parse(strarr[j], 'd', val)
+                     ? units_dec_values_to_degree(val)
+                     : gal_units_dec_to_degree(strarr[j]) );
+        else
+          out[j] = ( units_sexagesimal_parse(strarr[j], 'h', val)
+                     ? units_ra_values_to_degree(val)
+                     : gal_units_ra_to_degree(strarr[j]) );
+    }
+
+  /* Wait for all the other threads to finish, then return. */
+  if(tprm->b) pthread_barrier_wait(tprm->b);
+  return NULL;
+}
+
+
+
+
+
+/* Worker function on each thread: 'tprm->indexs' are the chunks of
+   'UNITS_COLUMN_CHUNK' rows. */
+static void *
+units_degree_to_sexagesimal_on_thread(void *in_prm)
+{
+  struct gal_threads_params *tprm=(struct gal_threads_params *)in_prm;
+  struct units_column_params *p=(struct units_column_params *)tprm->params;
+
+  size_t len;
+  double *in=p->in->array;
+  char **out=p->out->array;
+  char str[UNITS_RADECSTR_MAXLENGTH];
+  size_t i, j, start, end, size=p->in->size;
+
+  for(i=0; tprm->indexs[i]!=GAL_BLANK_SIZE_T; ++i)
+    {
+      start=tprm->indexs[i]*UNITS_COLUMN_CHUNK;
+      end=start+UNITS_COLUMN_CHUNK;
+      if(end>size) end=size;
+      for(j=start;j<end;++j)
+        if( units_degree_to_sexagesimal_write(str, in[j], p->isdec,
+                                              p->usecolon) )
+          {
+            len=strlen(str)+1;
+            out[j]=gal_pointer_allocate(GAL_TYPE_UINT8, len, 0, __func__,
+                                        "out[j]");
+            memcpy(out[j], str, len);
+          }
+        else
+          out[j] = ( p->isdec
+                     ? gal_units_degree_to_dec(in[j], p->usecolon)
+                     : gal_units_degree_to_ra(in[j], p->usecolon) );
+    }
+
+  /* Wait for all the other threads to finish, then return. */
+  if(tprm->b) pthread_barrier_wait(tprm->b);
+  return NULL;
+}
+
+
+
+
+
+static gal_data_t *
+units_sexagesimal_to_degree_column(gal_data_t *in, int isdec,
+                                   size_t numthreads)
+{
+  gal_data_t *out;
+  struct units_column_params p;
+
+  /* Basic sanity check. */
+  if(in->type!=GAL_TYPE_STRING)
+    error(EXIT_FAILURE, 0, "%s: input must have a string type, but it "
+          "has a type of '%s'", __func__, gal_type_name(in->type, 1));
+
+  /* Allocate the output and do the conversion. */
+  out=gal_data_alloc(NULL, GAL_TYPE_FLOAT64, in->ndim, in->dsize, in->wcs,
+                     0, in->minmapsize, in->quietmmap, NULL, NULL, NULL);
+  if(in->size)
+    {
+      p.in=in;
+      p.out=out;
+      p.isdec=isdec;
+      p.usecolon=0;
+      gal_threads_spin_off(units_sexagesimal_to_degree_on_thread, &p,
+                           1+(in->size-1)/UNITS_COLUMN_CHUNK,
+                           numthreads, in->minmapsize, in->quietmmap);
+    }
+  return out;
+}
+
+
+
+
+
+static gal_data_t *
+units_degree_to_sexagesimal_column(gal_data_t *in, int isdec,
+                                   int usecolon, size_t numthreads)
+{
+  gal_data_t *out, *din;
+  struct units_column_params p;
+
+  /* The conversion is done in double precision. */
+  din = ( in->type==GAL_TYPE_FLOAT64
+          ? in
+          : gal_data_copy_to_new_type(in, GAL_TYPE_FLOAT64) );
+
+  /* Allocate the output and do the conversion. */
+  out=gal_data_alloc(NULL, GAL_TYPE_STRING, in->ndim, in->dsize, in->wcs,
+                     0, in->minmapsize, in->quietmmap, NULL, NULL, NULL);
+  if(in->size)
+    {
+      p.in=din;
+      p.out=out;
+      p.isdec=isdec;
+      p.usecolon=usecolon;
+      gal_threads_spin_off(units_degree_to_sexagesimal_on_thread, &p,
+                           1+(in->size-1)/UNITS_COLUMN_CHUNK,
+                           numthreads, in->minmapsize, in->quietmmap);
+    }
+
+  /* Clean up and return. */
+  if(din!=in) gal_data_free(din);
+  return out;
+}
+
+
+
+
+
+gal_data_t *
+gal_units_ra_to_degree_column(gal_data_t *in, size_t numthreads)
+{
+  return units_sexagesimal_to_degree_column(in, 0, numthreads);
+}
+
+
+
+
+
+gal_data_t *
+gal_units_dec_to_degree_column(gal_data_t *in, size_t numthreads)
+{
+  return units_sexagesimal_to_degree_column(in, 1, numthreads);
+}
+
+
+
+
+
+gal_data_t *
+gal_units_degree_to_ra_column(gal_data_t *in, int usecolon,
+                              size_t numthreads)
+{
+  return units_degree_to_sexagesimal_column(in, 0, usecolon, numthreads);
+}
+
+
+
+
+
+gal_data_t *
+gal_units_degree_to_dec_column(gal_data_t *in, int usecolon,
+                               size_t numthreads)
+{
+  return units_degree_to_sexagesimal_column(in, 1, usecolon, numthreads);
+}
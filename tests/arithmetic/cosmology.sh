@@ -0,0 +1,62 @@
+# Cosmological operators of Arithmetic with Planck-like parameters (a flat
+# universe where '1-olambda-omatter' is not exactly zero in floating point).
+#
+# See the Tests subsection of the manual for a complete explanation
+# (in the Installing gnuastro section).
+#
+# Original author:
+#     Mohammad Akhlaghi <mohammad@akhlaghi.org>
+# Contributing author(s):
+# Copyright (C) 2026 Free Software Foundation, Inc.
+#
+# Copying and distribution of this file, with or without modification,
+# are permitted in any medium without royalty provided the copyright
+# notice and this notice are preserved.  This file is offered as-is,
+# without any warranty.
+
+
+
+
+
+# Preliminaries
+# =============
+#
+# Set the variables (The executable is in the build tree). Do the
+# basic checks to see if the executable is made or if the defaults
+# file exists (basicchecks.sh is in the source tree).
+prog=arithmetic
+execname=../bin/$prog/ast$prog
+
+
+
+
+
+# Skip?
+# =====
+#
+# If the dependencies of the test don't exist, then skip it. There are two
+# types of dependencies:
+#
+#   - The executable was not made (for example due to a configure option).
+if [ ! -f $execname ]; then echo "$execname not created."; exit 77; fi
+
+
+
+
+
+# Actual test script
+# ==================
+#
+# 'check_with_program' can be something like Valgrind or an empty
+# string. Such programs will execute the command if present and help in
+# debugging when the developer doesn't have access to the user's system.
+#
+# The expected value (luminosity distance in Mpc at z=0.5) was found by
+# direct numerical integration for a flat universe with these parameters;
+# a relative difference larger than 1e-5 is a failure.
+expected=2918.4774
+out=$($check_with_program $execname 0.5 67.74 0.6911 0.3089 \
+                                    z-to-luminosity-distance)
+if [ $? != 0 ]; then exit 1; fi
+echo "$out" | awk -v e=$expected \
+                  '{d=($1-e)/e; if(d<0) d=-d; exit (NF==1 && d<1e-5) ? 0 : 1}'
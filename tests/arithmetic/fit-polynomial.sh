@@ -0,0 +1,75 @@
+# Fit polynomials along the first dimension of an image where every row is
+# an exact (and different) second order polynomial.
+#
+# See the Tests subsection of the manual for a complete explanation
+# (in the Installing gnuastro section).
+#
+# Original author:
+#     Mohammad Akhlaghi <mohammad@akhlaghi.org>
+# Contributing author(s):
+# Copyright (C) 2026 Free Software Foundation, Inc.
+#
+# Copying and distribution of this file, with or without modification,
+# are permitted in any medium without royalty provided the copyright
+# notice and this notice are preserved.  This file is offered as-is,
+# without any warranty.
+
+
+
+
+
+# Preliminaries
+# =============
+#
+# Set the variables (The executable is in the build tree). Do the
+# basic checks to see if the executable is made or if the defaults
+# file exists (basicchecks.sh is in the source tree).
+prog=arithmetic
+execname=../bin/$prog/ast$prog
+
+
+
+
+
+# Skip?
+# =====
+#
+# If the dependencies of the test don't exist, then skip it. There are two
+# types of dependencies:
+#
+#   - The executable was not made (for example due to a configure option).
+if [ ! -f $execname ]; then echo "$execname not created."; exit 77; fi
+
+
+
+
+
+# Actual test script
+# ==================
+#
+# 'check_with_program' can be something like Valgrind or an empty
+# string. Such programs will execute the command if present and help in
+# debugging when the developer doesn't have access to the user's system.
+#
+# In the 16x16 image, the pixel at position X (counting from 1) of row R
+# (counting from 0) has a value of '(R+1) + 0.5*R*X - 0.25*X^2'. So the
+# fitted model should be identical to the image (within floating point
+# errors). The robust fit needs a non-zero scatter, so a small
+# deterministic noise (of -0.001, 0 or 0.001) is added to its input and
+# its model should be close to the noise-less image.
+image="16 16 2 makenew indexonly set-i \
+       i 16 % float64 set-x0 \
+       i float64 x0 - 16 / set-r \
+       x0 1 + set-x \
+       r 1 + r 0.5 x * * + x x * 0.25 * - set-img \
+       i 3 % float64 1 - 0.001 * img + set-noisy"
+for check in "img fit-polynomial 1e-8" \
+             "noisy fit-polynomial-robust 0.005"; do
+    set -- $check
+    diff=$($check_with_program $execname $image \
+                               $1 1 2 $2 img - abs maxvalue --quiet)
+    if [ $? != 0 ]; then exit 1; fi
+    echo "$2: maximum difference: $diff"
+    echo "$diff" | awk -v t=$3 '{exit (NF==1 && $1<t) ? 0 : 1}'
+    if [ $? != 0 ]; then exit 1; fi
+done
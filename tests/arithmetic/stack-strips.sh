@@ -0,0 +1,126 @@
+# Stack FITS images strip by strip (without reading them into memory) and
+# compare the results with the same stacking operators in memory.
+#
+# See the Tests subsection of the manual for a complete explanation
+# (in the Installing gnuastro section).
+#
+# Original author:
+#     Mohammad Akhlaghi <mohammad@akhlaghi.org>
+# Contributing author(s):
+# Copyright (C) 2026 Free Software Foundation, Inc.
+#
+# Copying and distribution of this file, with or without modification,
+# are permitted in any medium without royalty provided the copyright
+# notice and this notice are preserved.  This file is offered as-is,
+# without any warranty.
+
+
+
+
+
+# Preliminaries
+# =============
+#
+# Set the variables (The executable is in the build tree). Do the
+# basic checks to see if the executable is made or if the defaults
+# file exists (basicchecks.sh is in the source tree).
+prog=arithmetic
+execname=../bin/$prog/ast$prog
+
+
+
+
+
+# Skip?
+# =====
+#
+# If the dependencies of the test don't exist, then skip it. There are two
+# types of dependencies:
+#
+#   - The executable was not made (for example due to a configure option).
+if [ ! -f $execname ]; then echo "$execname not created."; exit 77; fi
+
+
+
+
+
+# Actual test script
+# ==================
+#
+# 'check_with_program' can be something like Valgrind or an empty
+# string. Such programs will execute the command if present and help in
+# debugging when the developer doesn't have access to the user's system.
+#
+# Seven 17x17 inputs are made with different (deterministic) values. The
+# third has a large outlier in every fourth pixel (73 pixels in total) and
+# the fifth is blank in every sixth pixel. With only 7 inputs, a single
+# outlier is never beyond 3 sigma, so a multiple of 2 is used for the
+# clipping.
+inputs=""
+for k in 1 2 3 4 5 6 7; do
+    case $k in
+        3) extra="set-v v i 4 % 0 eq 1000 where";;
+        5) extra="set-v v i 6 % 0 eq nan where";;
+        *) extra="";;
+    esac
+    $execname 17 17 2 makenew indexonly set-i \
+              i $k 5 + * 3 + 13 % float32 10 + $extra \
+              --output=stack-strips-$k.fits --quiet
+    if [ $? != 0 ]; then exit 1; fi
+    inputs="$inputs stack-strips-$k.fits"
+done
+
+# Compare two images (with the given HDUs): the blank pixels should be
+# the same and the maximum absolute difference should be negligible.
+compare () {
+    d=$($execname $1 $3 - abs maxvalue -h$2 -h$4 --quiet)
+    if [ $? != 0 ]; then exit 1; fi
+    b=$($execname $1 isblank $3 isblank ne sumvalue -h$2 -h$4 --quiet)
+    if [ $? != 0 ]; then exit 1; fi
+    echo "$5: maximum difference: $d, different blanks: $b"
+    echo "$d $b" | awk '{exit ($1<1e-5 && $2==0) ? 0 : 1}'
+    if [ $? != 0 ]; then exit 1; fi
+}
+
+# For each operator, the in-memory stack is forced by a type conversion
+# after the operator (so the stacking operator isn't the last one). The
+# strips have 3 rows (so the last strip is shorter) and at most 2 inputs
+# are open at the same time.
+for op in "sigclip-mean 2 2" "sigclip-median 2 2" "median" "mean"; do
+    name=$(echo $op | awk '{print $1}')
+    params=$(echo $op | awk '{print $2, $3}')
+    $execname $inputs 7 $params $name float32 -g1 \
+              --output=stack-strips-mem.fits --quiet
+    if [ $? != 0 ]; then exit 1; fi
+    $check_with_program $execname $inputs 7 $params $name -g1 \
+                        --stackrows=3 --stackmaxopen=2 \
+                        --output=stack-strips-$name.fits \
+                        > stack-strips.log
+    if [ $? != 0 ]; then exit 1; fi
+    grep -q "Stacking 7 inputs in strips of 3 row(s) (at most 2 open" \
+         stack-strips.log
+    if [ $? != 0 ]; then exit 1; fi
+    compare stack-strips-mem.fits 1 stack-strips-$name.fits 1 $name
+done
+
+# The number of used inputs ('--stackcount') and the number of clipped
+# inputs ('--stackrejected') with the default strip size and number of
+# open files.
+$check_with_program $execname $inputs 7 2 2 sigclip-mean -g1 \
+                    --stackcount --stackrejected \
+                    --output=stack-strips-maps.fits --quiet
+if [ $? != 0 ]; then exit 1; fi
+$execname $inputs 7 number uint32 -g1 \
+          --output=stack-strips-num.fits --quiet
+if [ $? != 0 ]; then exit 1; fi
+$execname $inputs 7 number $inputs 7 2 2 sigclip-number - -g1 \
+          --output=stack-strips-rej.fits --quiet
+if [ $? != 0 ]; then exit 1; fi
+compare stack-strips-num.fits 1 stack-strips-maps.fits COUNT count
+compare stack-strips-rej.fits 1 stack-strips-maps.fits REJECTED rejected
+
+# The outliers should have actually been rejected.
+r=$($execname stack-strips-maps.fits sumvalue -hREJECTED --quiet)
+if [ $? != 0 ]; then exit 1; fi
+echo "rejected: $r"
+echo "$r" | awk '{exit ($1>=73) ? 0 : 1}'
@@ -0,0 +1,90 @@
+# Build a tiled pyramid from an image that only has a blank pixel in a
+# later strip (the higher levels should ignore it in the 2x2 means).
+#
+# See the Tests subsection of the manual for a complete explanation
+# (in the Installing gnuastro section).
+#
+# Original author:
+#     Mohammad Akhlaghi <mohammad@akhlaghi.org>
+# Contributing author(s):
+# Copyright (C) 2026 Free Software Foundation, Inc.
+#
+# Copying and distribution of this file, with or without modification,
+# are permitted in any medium without royalty provided the copyright
+# notice and this notice are preserved.  This file is offered as-is,
+# without any warranty.
+
+
+
+
+
+# Preliminaries
+# =============
+#
+# Set the variables (The executable is in the build tree). Do the
+# basic checks to see if the executable is made or if the defaults
+# file exists (basicchecks.sh is in the source tree).
+prog=convertt
+img=pyramid-blank.fits
+dir=pyramid-blank
+execname=../bin/$prog/ast$prog
+
+
+
+
+
+# Skip?
+# =====
+#
+# If the dependencies of the test don't exist, then skip it. There are two
+# types of dependencies:
+#
+#   - The executable was not made (for example due to a configure option),
+#
+#   - libjpeg was not present on the system.
+if [ ! -f $execname           ];then echo "$execname not created.";exit 77;fi
+if [ "x$haslibjpeg" != "xyes" ];then echo "libjpeg not present.";  exit 77;fi
+
+
+
+
+
+# Input image
+# ===========
+#
+# A 12x8 image with a constant value and one blank pixel. With tiles of 4
+# pixels, the blank pixel is in the second strip (in any orientation), so
+# the first strip that is pooled has no blank values.
+awk 'BEGIN{ for(i=1;i<=12;++i)
+              { for(j=1;j<=8;++j)
+                  printf "%s ", (i==6 && j==3) ? "nan" : "10";
+                printf "\n" } }' > pyramid-blank.txt
+$execname pyramid-blank.txt --type=float32 --output=$img
+if [ $? != 0 ]; then exit 1; fi
+
+
+
+
+
+# Actual test script
+# ==================
+#
+# 'check_with_program' can be something like Valgrind or an empty
+# string. Such programs will execute the command if present and help in
+# debugging when the developer doesn't have access to the user's system.
+rm -rf $dir
+$check_with_program $execname $img --hdu=1 --pyramid=$dir \
+                              --pyramidtile=4 --quality=100 \
+                              --fluxlow=0 --fluxhigh=10 \
+                              --forcemin --forcemax
+if [ $? != 0 ]; then exit 1; fi
+
+# Every pixel of the higher levels is the mean of non-blank values (that
+# are all at the maximum), so no pixel of their tiles should be dark.
+for tile in $dir/1/*.jpg $dir/2/*.jpg; do
+    $execname $tile --output=pyramid-blank-tile.txt
+    if [ $? != 0 ]; then exit 1; fi
+    awk '!/^#/{for(i=1;i<=NF;++i) if($i<200) bad=1} END{exit bad}' \
+        pyramid-blank-tile.txt
+    if [ $? != 0 ]; then exit 1; fi
+done
@@ -0,0 +1,570 @@
+/*********************************************************************
+Benchmark of some of the hot paths in Gnuastro's library.
+
+Original author:
+     Mohammad Akhlaghi <mohammad@akhlaghi.org>
+Contributing author(s):
+Copyright (C) 2026 Free Software Foundation, Inc.
+
+Gnuastro is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation, either version 3 of the License, or (at your
+option) any later version.
+
+Gnuastro is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+#include <time.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+
+#include "gnuastro/git.h"
+#include "gnuastro/wcs.h"
+#include "gnuastro/list.h"
+#include "gnuastro/warp.h"
+#include "gnuastro/match.h"
+#include "gnuastro/table.h"
+#include "gnuastro/kdtree.h"
+#include "gnuastro/threads.h"
+#include "gnuastro/convolve.h"
+#include "gnuastro/statistics.h"
+
+
+
+
+
+/* This program is not run with 'make check' (it takes too long). It is
+   built and run with 'make bench' (see 'tests/Makefile.am'):
+
+       $ make bench
+       $ make bench BENCH_NUMTHREADS=8 BENCH_REPEAT=10 BENCH_SCALE=2 \
+                    BENCH_OUTPUT=bench-$(git describe).txt
+
+   Each kernel is run on synthetic inputs of a few sizes (multiplied by
+   'BENCH_SCALE'), on 1, 2, 4, ... threads (until 'BENCH_NUMTHREADS', or
+   all available threads when it is zero) and repeated 'BENCH_REPEAT'
+   times. The minimum and median times of the repeats are written in the
+   output table, with the version of Gnuastro in its comments. Because the
+   inputs are built with a fixed random number generator seed, the tables
+   of different commits (or different machines) can be directly compared
+   (for example with Table's '--catcolumnfile'). */
+#define BENCH_MAXRESULTS 1024
+#define BENCH_TABLENAME  "benchmark-table.fits"
+
+struct bench_params
+{
+  size_t          repeat;     /* Number of times to run each kernel.    */
+  size_t      maxthreads;     /* Maximum number of threads.             */
+  size_t           scale;     /* Multiple of the default sizes.         */
+  gsl_rng           *rng;     /* Random number generator.               */
+
+  size_t            nres;     /* Number of results (rows of output).    */
+  char            **name;     /* Name of kernel.                        */
+  size_t           *size;     /* Size of input.                         */
+  size_t        *threads;     /* Number of threads.                     */
+  double         *mintime;    /* Minimum time of the repeats (seconds). */
+  double         *medtime;    /* Median time of the repeats (seconds).  */
+};
+
+
+
+
+
+/**************************************************************/
+/***************          Utilities           *****************/
+/**************************************************************/
+static double
+bench_now(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec/1e9;
+}
+
+
+
+
+
+static int
+bench_cmp_double(const void *a, const void *b)
+{
+  double ta=*(double *)a, tb=*(double *)b;
+  return ta<tb ? -1 : (ta>tb ? 1 : 0);
+}
+
+
+
+
+
+/* Add the timings of one kernel/size/threads combination to the results
+   (the 'times' array will be sorted). */
+static void
+bench_add_result(struct bench_params *p, char *name, size_t size,
+                 size_t threads, double *times)
+{
+  size_t i=p->nres;
+
+  if(p->nres==BENCH_MAXRESULTS)
+    {
+      fprintf(stderr, "too many benchmark results\n");
+      exit(EXIT_FAILURE);
+    }
+
+  qsort(times, p->repeat, sizeof *times, bench_cmp_double);
+  p->name[i]=malloc(strlen(name)+1);
+  if(p->name[i]==NULL)
+    { fprintf(stderr, "couldn't allocate name\n"); exit(EXIT_FAILURE); }
+  strcpy(p->name[i], name);
+  p->size[i]=size;
+  p->threads[i]=threads;
+  p->mintime[i]=times[0];
+  p->medtime[i]=times[p->repeat/2];
+  ++p->nres;
+
+  /* Report the result on the standard output also. */
+  printf("  %-16s size: %-10zu threads: %-4zu min: %.6f  median: %.6f\n",
+         name, size, threads, p->mintime[i], p->medtime[i]);
+}
+
+
+
+
+
+/* Next number of threads to test: powers of 2 up to the maximum. */
+static size_t
+bench_next_threads(struct bench_params *p, size_t nt)
+{
+  if(nt==p->maxthreads) return 0;
+  return 2*nt > p->maxthreads ? p->maxthreads : 2*nt;
+}
+
+
+
+
+
+/* A MkProf/MkNoise-like image: Gaussian profiles at random positions on
+   a flat background with Gaussian noise of sigma 1. */
+static gal_data_t *
+bench_image(struct bench_params *p, size_t side, uint8_t type)
+{
+  float *f;
+  gal_data_t *out;
+  long x, y, xc, yc, r;
+  size_t i, nprof, dsize[2]={side, side};
+  double *d, v, sigma, amp, fx, fy, *tmp;
+
+  tmp=malloc(side*side*sizeof *tmp);
+  if(tmp==NULL)
+    { fprintf(stderr, "couldn't allocate image\n"); exit(EXIT_FAILURE); }
+
+  /* The background and noise. */
+  for(i=0;i<side*side;++i) tmp[i]=gsl_ran_gaussian(p->rng, 1.0f);
+
+  /* The profiles (truncated at 5 sigma). */
+  nprof=side*side/2500;
+  for(i=0;i<nprof;++i)
+    {
+      fx=gsl_rng_uniform(p->rng)*side;
+      fy=gsl_rng_uniform(p->rng)*side;
+      sigma=1.0f+4.0f*gsl_rng_uniform(p->rng);
+      amp=50.0f*gsl_rng_uniform(p->rng);
+      xc=fx; yc=fy; r=5*sigma;
+      for(y=yc-r;y<=yc+r;++y)
+        for(x=xc-r;x<=xc+r;++x)
+          if(x>=0 && y>=0 && x<(long)side && y<(long)side)
+            {
+              v=((x-fx)*(x-fx)+(y-fy)*(y-fy))/(2*sigma*sigma);
+              tmp[y*side+x] += amp*exp(-v);
+            }
+    }
+
+  /* Put the values in the requested type. */
+  out=gal_data_alloc(NULL, type, 2, dsize, NULL, 0, -1, 1, NULL, NULL,
+                     NULL);
+  if(type==GAL_TYPE_FLOAT32)
+    { f=out->array; for(i=0;i<out->size;++i) f[i]=tmp[i]; }
+  else
+    { d=out->array; for(i=0;i<out->size;++i) d[i]=tmp[i]; }
+  free(tmp);
+  return out;
+}
+
+
+
+
+
+/* Random 2D coordinates: when 'ref' is given, the coordinates are the
+   reference coordinates with a small random shift. */
+static gal_data_t *
+bench_coords(struct bench_params *p, size_t num, gal_data_t *ref)
+{
+  size_t i, j;
+  double *c, *r;
+  gal_data_t *out=NULL, *tmp;
+
+  for(j=0;j<2;++j)
+    {
+      tmp=gal_data_alloc(NULL, GAL_TYPE_FLOAT64, 1, &num, NULL, 0, -1, 1,
+                         NULL, NULL, NULL);
+      c=tmp->array;
+      r = ref ? (j ? ref->next->array : ref->array) : NULL;
+      for(i=0;i<num;++i)
+        c[i] = ( r
+                 ? r[i] + gsl_ran_gaussian(p->rng, 0.1f)
+                 : gsl_rng_uniform(p->rng)*1000.0f );
+      gal_list_data_add(&out, tmp);
+    }
+  gal_list_data_reverse(&out);
+  return out;
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/**************************************************************/
+/***************           Kernels            *****************/
+/**************************************************************/
+static void
+bench_convolve(struct bench_params *p)
+{
+  float *k, sum=0;
+  double times[p->repeat], t0;
+  size_t s, i, nt, side, ksize[2]={11,11};
+  gal_data_t *img, *out, *kernel=gal_data_alloc(NULL, GAL_TYPE_FLOAT32, 2,
+                                                ksize, NULL, 0, -1, 1,
+                                                NULL, NULL, NULL);
+
+  /* A normalized Gaussian kernel (FWHM of 2 pixels). */
+  k=kernel->array;
+  for(i=0;i<kernel->size;++i)
+    sum += k[i] = exp( -( (i%11-5.0f)*(i%11-5.0f)
+                          + (i/11-5.0f)*(i/11-5.0f) ) / (2*0.849*0.849) );
+  for(i=0;i<kernel->size;++i) k[i]/=sum;
+
+  /* Run the convolution. */
+  for(s=1;s<=4;s*=2)
+    {
+      side=500*s*p->scale;
+      img=bench_image(p, side, GAL_TYPE_FLOAT32);
+      for(nt=1; nt; nt=bench_next_threads(p, nt))
+        {
+          for(i=0;i<p->repeat;++i)
+            {
+              t0=bench_now();
+              out=gal_convolve_spatial(img, kernel, nt, 1, 1);
+              times[i]=bench_now()-t0;
+              gal_data_free(out);
+            }
+          bench_add_result(p, "convolve", img->size, nt, times);
+        }
+      gal_data_free(img);
+    }
+  gal_data_free(kernel);
+}
+
+
+
+
+
+/* Sigma-clipping is not multi-threaded, so only one thread is used. */
+static void
+bench_sigma_clip(struct bench_params *p)
+{
+  size_t s, i;
+  gal_data_t *img, *out;
+  double times[p->repeat], t0;
+
+  for(s=1;s<=4;s*=2)
+    {
+      img=bench_image(p, 500*s*p->scale, GAL_TYPE_FLOAT32);
+      for(i=0;i<p->repeat;++i)
+        {
+          t0=bench_now();
+          out=gal_statistics_sigma_clip(img, 3.0f, 0.2f, 0, 1);
+          times[i]=bench_now()-t0;
+          gal_data_free(out);
+        }
+      bench_add_result(p, "sigma-clip", img->size, 1, times);
+      gal_data_free(img);
+    }
+}
+
+
+
+
+
+static void
+bench_match_kdtree(struct bench_params *p)
+{
+  size_t s, i, nt, num, root, nummatched;
+  double times[p->repeat], t0, aperture[3]={0.5f, 1.0f, 0.0f};
+  gal_data_t *coord1, *coord2, *kdtree, *out;
+
+  for(s=1;s<=100;s*=10)
+    {
+      /* Build the inputs and the k-d tree (not timed). */
+      num=10000*s*p->scale;
+      coord1=bench_coords(p, num, NULL);
+      coord2=bench_coords(p, num, coord1);
+      kdtree=gal_kdtree_create(coord1, &root);
+
+      /* Do the match. */
+      for(nt=1; nt; nt=bench_next_threads(p, nt))
+        {
+          for(i=0;i<p->repeat;++i)
+            {
+              t0=bench_now();
+              out=gal_match_kdtree(coord1, coord2, kdtree, root, aperture,
+                                   nt, -1, 1, &nummatched);
+              times[i]=bench_now()-t0;
+              gal_list_data_free(out);
+            }
+          bench_add_result(p, "match-kdtree", num, nt, times);
+        }
+
+      /* Clean up. */
+      gal_list_data_free(kdtree);
+      gal_list_data_free(coord1);
+      gal_list_data_free(coord2);
+    }
+}
+
+
+
+
+
+static void
+bench_warp_wcsalign(struct bench_params *p)
+{
+  size_t s, i, nt, side, two=2;
+  double times[p->repeat], t0;
+  char *cunit[2]={"deg", "deg"}, *ctype[2]={"RA---TAN", "DEC--TAN"};
+  double crpix[2], crval[2]={10.0f, 10.0f}, cdelt[2]={1e-4, 1e-4};
+  double pc[4]={-1.0f, 0.0f, 0.0f, 1.0f}, pcr[4]={-0.866, 0.5, 0.5, 0.866};
+  gal_warp_wcsalign_t wa;
+
+  for(s=1;s<=4;s*=2)
+    {
+      /* The input image and its WCS. */
+      side=250*s*p->scale;
+      crpix[0]=crpix[1]=side/2;
+      wa=gal_warp_wcsalign_template();
+      wa.input=bench_image(p, side, GAL_TYPE_FLOAT64);
+      wa.input->wcs=gal_wcs_create(crpix, crval, cdelt, pc, cunit, ctype,
+                                   2, GAL_WCS_LINEAR_MATRIX_PC);
+      wa.input->nwcs=1;
+
+      /* The output grid: rotated by 30 degrees, same pixel scale. */
+      wa.coveredfrac=1;
+      wa.edgesampling=0;
+      wa.twcs=gal_wcs_create(crpix, crval, cdelt, pcr, cunit, ctype, 2,
+                             GAL_WCS_LINEAR_MATRIX_PC);
+      wa.widthinpix=gal_data_alloc(NULL, GAL_TYPE_SIZE_T, 1, &two, NULL,
+                                   0, -1, 1, NULL, NULL, NULL);
+      ((size_t *)(wa.widthinpix->array))[0]=side;
+      ((size_t *)(wa.widthinpix->array))[1]=side;
+
+      /* Do the warp. */
+      for(nt=1; nt; nt=bench_next_threads(p, nt))
+        {
+          wa.numthreads=nt;
+          for(i=0;i<p->repeat;++i)
+            {
+              t0=bench_now();
+              gal_warp_wcsalign(&wa);
+              times[i]=bench_now()-t0;
+              gal_data_free(wa.output);
+              wa.output=NULL;
+            }
+          bench_add_result(p, "warp-wcsalign", wa.input->size, nt, times);
+        }
+
+      /* Clean up. */
+      gal_wcs_free(wa.twcs);
+      gal_data_free(wa.input);
+      gal_data_free(wa.widthinpix);
+    }
+}
+
+
+
+
+
+static void
+bench_fits_tab_read(struct bench_params *p)
+{
+  int32_t *id;
+  size_t s, i, nt, num;
+  gal_data_t *cols, *out;
+  double times[p->repeat], t0;
+
+  for(s=1;s<=100;s*=10)
+    {
+      /* Build and write the table (three columns) into a FITS file. */
+      num=10000*s*p->scale;
+      cols=bench_coords(p, num, NULL);
+      cols->next->next=gal_data_alloc(NULL, GAL_TYPE_INT32, 1, &num, NULL,
+                                      0, -1, 1, "ID", NULL, NULL);
+      id=cols->next->next->array;
+      for(i=0;i<num;++i) id[i]=i+1;
+      cols->name=malloc(2); strcpy(cols->name, "X");
+      cols->next->name=malloc(2); strcpy(cols->next->name, "Y");
+      remove(BENCH_TABLENAME);
+      gal_table_write(cols, NULL, NULL, GAL_TABLE_FORMAT_BFITS,
+                      BENCH_TABLENAME, "TABLE", 0);
+      gal_list_data_free(cols);
+
+      /* Read the table. */
+      for(nt=1; nt; nt=bench_next_threads(p, nt))
+        {
+          for(i=0;i<p->repeat;++i)
+            {
+              t0=bench_now();
+              out=gal_table_read(BENCH_TABLENAME, "1", NULL, NULL,
+                                 GAL_TABLE_SEARCH_NAME, 0, nt, -1, 1,
+                                 NULL);
+              times[i]=bench_now()-t0;
+              gal_list_data_free(out);
+            }
+          bench_add_result(p, "fits-tab-read", num, nt, times);
+        }
+    }
+  remove(BENCH_TABLENAME);
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+/**************************************************************/
+/***************        Output and main       *****************/
+/**************************************************************/
+static void
+bench_write(struct bench_params *p, char *filename)
+{
+  char *desc, str[512];
+  gal_data_t *cols=NULL;
+  gal_list_str_t *comments=NULL;
+
+  /* Build the columns: the 'name' array will be freed with the column. */
+  cols=gal_data_alloc(p->name, GAL_TYPE_STRING, 1, &p->nres, NULL, 0, -1,
+                      1, "KERNEL", NULL, "Name of benchmarked kernel.");
+  cols->next=gal_data_alloc(p->size, GAL_TYPE_SIZE_T, 1, &p->nres, NULL,
+                            0, -1, 1, "SIZE", "counter",
+                            "Number of elements in input.");
+  cols->next->next=gal_data_alloc(p->threads, GAL_TYPE_SIZE_T, 1,
+                                  &p->nres, NULL, 0, -1, 1, "THREADS",
+                                  "counter", "Number of threads.");
+  cols->next->next->next=gal_data_alloc(p->mintime, GAL_TYPE_FLOAT64, 1,
+                                        &p->nres, NULL, 0, -1, 1,
+                                        "MIN-TIME", "s",
+                                        "Minimum time of repeats.");
+  cols->next->next->next->next=gal_data_alloc(p->medtime,
+                                              GAL_TYPE_FLOAT64, 1,
+                                              &p->nres, NULL, 0, -1, 1,
+                                              "MEDIAN-TIME", "s",
+                                              "Median time of repeats.");
+
+  /* Comments to identify the run (added in reverse). */
+  desc=gal_git_describe();
+  snprintf(str, sizeof str, "Gnuastro %s%s%s; repeats: %zu; scale: %zu; "
+           "available threads: %zu", GAL_CONFIG_VERSION,
+           desc ? ", commit: " : "", desc ? desc : "", p->repeat,
+           p->scale, gal_threads_number());
+  gal_list_str_add(&comments, str, 1);
+  if(desc) free(desc);
+
+  /* Write the table and clean up. */
+  remove(filename);
+  gal_table_write(cols, NULL, comments, GAL_TABLE_FORMAT_BFITS, filename,
+                  "BENCHMARK", 0);
+  gal_list_str_free(comments, 1);
+  gal_list_data_free(cols);
+}
+
+
+
+
+
+int
+main(int argc, char *argv[])
+{
+  struct bench_params p={0};
+  char *output = argc>1 ? argv[1] : "benchmark.txt";
+
+  /* Read the arguments. */
+  p.maxthreads = argc>2 ? strtoul(argv[2], NULL, 10) : 0;
+  p.repeat     = argc>3 ? strtoul(argv[3], NULL, 10) : 5;
+  p.scale      = argc>4 ? strtoul(argv[4], NULL, 10) : 1;
+  if(p.maxthreads==0) p.maxthreads=gal_threads_number();
+  if(p.repeat==0) p.repeat=1;
+  if(p.scale==0) p.scale=1;
+
+  /* Allocate the result arrays and the random number generator (with a
+     fixed seed to have the same inputs on every run). */
+  p.name=malloc(BENCH_MAXRESULTS*sizeof *p.name);
+  p.size=malloc(BENCH_MAXRESULTS*sizeof *p.size);
+  p.threads=malloc(BENCH_MAXRESULTS*sizeof *p.threads);
+  p.mintime=malloc(BENCH_MAXRESULTS*sizeof *p.mintime);
+  p.medtime=malloc(BENCH_MAXRESULTS*sizeof *p.medtime);
+  if(!p.name || !p.size || !p.threads || !p.mintime || !p.medtime)
+    { fprintf(stderr, "couldn't allocate results\n"); exit(EXIT_FAILURE); }
+  p.rng=gsl_rng_alloc(gsl_rng_ranlxs1);
+  gsl_rng_set(p.rng, 1);
+
+  /* Run the kernels. */
+  printf("Benchmark (up to %zu threads, %zu repeats, scale %zu):\n",
+         p.maxthreads, p.repeat, p.scale);
+  bench_convolve(&p);
+  bench_sigma_clip(&p);
+  bench_match_kdtree(&p);
+  bench_warp_wcsalign(&p);
+  bench_fits_tab_read(&p);
+
+  /* Write the output and clean up. */
+  bench_write(&p, output);
+  printf("Results written to '%s'.\n", output);
+  gsl_rng_free(p.rng);
+  return EXIT_SUCCESS;
+}
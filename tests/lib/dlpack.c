@@ -0,0 +1,120 @@
+/*********************************************************************
+A test program for zero-copy exchange of arrays with DLPack.
+
+Original author:
+     Mohammad Akhlaghi <mohammad@akhlaghi.org>
+Contributing author(s):
+Copyright (C) 2026 Free Software Foundation, Inc.
+
+Gnuastro is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation, either version 3 of the License, or (at your
+option) any later version.
+
+Gnuastro is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "gnuastro/tile.h"
+#include "gnuastro/dlpack.h"
+#include "gnuastro/statistics.h"
+
+
+
+
+/* Report a failed check and abort. */
+#define CHECK(COND, MSG)                                                \
+  if( !(COND) )                                                         \
+    {                                                                   \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, MSG);          \
+      exit(EXIT_FAILURE);                                               \
+    }
+
+
+
+
+/* The "foreign" array is a 2D (6x8) array on the stack: if Gnuastro ever
+   tries to free it (which it shouldn't), the program will crash. The
+   views are built like a NumPy array, a slice of it and its transpose
+   (with strides in bytes) and the same sub-set is exported and imported
+   through DLPack (with strides in elements). */
+int
+main(void)
+{
+  gal_data_t *view, *sum;
+  size_t i, dsize[2]={6,8};
+  gal_dlpack_managed_t *managed;
+  int64_t *strides, shape[2]={6,8}, fstrides[2]={8*4, 4};
+  int64_t sshape[2]={3,4}, sstrides[2]={2*8*4, 4}, tstrides[2]={4, 8*4};
+  float array[6*8];
+
+  /* Fill the array: each element is its index. */
+  for(i=0;i<6*8;++i) array[i]=i;
+
+  /* Contiguous array: a single dataset (no block). */
+  view=gal_dlpack_view(array, GAL_TYPE_FLOAT32, 2, shape, fstrides);
+  CHECK(view && view->block==NULL && view->array==array
+        && view->size==48 && (view->flag & GAL_DATA_FLAG_FOREIGN),
+        "contiguous view");
+  sum=gal_statistics_sum(view);
+  CHECK( ((double *)(sum->array))[0]==47*48/2, "sum of contiguous view");
+  gal_data_free(sum);
+  gal_dlpack_view_free(view);
+
+  /* Every second row and the first four columns (like 'a[::2, :4]' in
+     NumPy): a 3x4 tile over a 3x16 block. */
+  view=gal_dlpack_view(array, GAL_TYPE_FLOAT32, 2, sshape, sstrides);
+  CHECK(view && view->block && view->dsize[0]==3 && view->dsize[1]==4
+        && view->block->dsize[0]==3 && view->block->dsize[1]==16,
+        "strided view");
+  sum=gal_statistics_sum(view);
+  CHECK( ((double *)(sum->array))[0]==(0+1+2+3)*3+4*(0+16+32),
+         "sum of strided view");
+  gal_data_free(sum);
+
+  /* Export the tile: the strides (in elements) should be the same as the
+     input (in bytes), and importing it again should give the same
+     tile. */
+  managed=gal_dlpack_export(view, 0);
+  strides=managed->dl_tensor.strides;
+  CHECK(managed->dl_tensor.data==array && strides[0]==16 && strides[1]==1
+        && managed->dl_tensor.shape[0]==3 && managed->dl_tensor.shape[1]==4,
+        "exported tile");
+  gal_dlpack_view_free(view);
+  view=gal_dlpack_import(managed);
+  CHECK(view && view->array==array && view->block
+        && view->block->dsize[1]==16, "imported tile");
+  gal_dlpack_view_free(view);
+  managed->deleter(managed);
+
+  /* A transposed array can't be described in Gnuastro. */
+  view=gal_dlpack_view(array, GAL_TYPE_FLOAT32, 2, shape, tstrides);
+  CHECK(view==NULL, "transposed view");
+
+  /* An array with no element (like 'a[:0, :]' in NumPy) is an empty 1D
+     dataset. */
+  shape[0]=0;
+  view=gal_dlpack_view(array, GAL_TYPE_FLOAT32, 2, shape, fstrides);
+  CHECK(view && view->ndim==1 && view->size==0 && view->block==NULL,
+        "empty view");
+  gal_dlpack_view_free(view);
+
+  /* Export a Gnuastro-allocated dataset and let the deleter free it. */
+  view=gal_data_alloc(NULL, GAL_TYPE_UINT16, 2, dsize, NULL, 1,
+                      -1, 1, NULL, NULL, NULL);
+  managed=gal_dlpack_export(view, 1);
+  CHECK(managed->dl_tensor.dtype.code==GAL_DLPACK_CODE_UINT
+        && managed->dl_tensor.dtype.bits==16, "exported type");
+  managed->deleter(managed);
+
+  /* Everything was fine. */
+  printf("All DLPack checks passed.\n");
+  return EXIT_SUCCESS;
+}
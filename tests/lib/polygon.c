@@ -0,0 +1,214 @@
+/*********************************************************************
+A test program comparing the prepared polygon functions with the direct
+checks on random points and masks.
+
+Original author:
+     Mohammad Akhlaghi <mohammad@akhlaghi.org>
+Contributing author(s):
+Copyright (C) 2026 Free Software Foundation, Inc.
+
+Gnuastro is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation, either version 3 of the License, or (at your
+option) any later version.
+
+Gnuastro is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Gnuastro. If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "gnuastro/data.h"
+#include "gnuastro/polygon.h"
+
+
+
+
+/* Maximum number of vertices and the number of random points checked for
+   each polygon. */
+#define MAXVERT   200
+#define NPOINTS   20000
+
+
+
+
+/* A simple (and portable) random number generator, so the same polygons
+   and points are checked on all systems. */
+static uint64_t state=1664015492;
+static double
+random_uniform(void)
+{
+  state = state*6364136223846793005ULL + 1442695040888963407ULL;
+  return (state>>11) * (1.0/9007199254740992.0);
+}
+
+
+
+
+
+/* Result of the direct (non-prepared) check. */
+static int
+direct(double *v, double *p, size_t n, int convex)
+{
+  return ( convex
+           ? gal_polygon_is_inside_convex(v, p, n)
+           : gal_polygon_is_inside(v, p, n) ) != 0;
+}
+
+
+
+
+
+/* Compare all the prepared functions with the direct check on the given
+   polygon, return the number of differences. */
+static size_t
+check_polygon(char *name, double *v, size_t n, int convex)
+{
+  uint8_t *o;
+  gal_data_t *x, *y, *out, *mask;
+  size_t i, r, c, bad=0, np=NPOINTS, dsize[2]={90, 110};
+  gal_polygon_prepared_t *pp=gal_polygon_prepare(v, n, convex);
+  double p[2], far[][2]={ {INFINITY, 50}, {50, -INFINITY},
+                          {1e300, 1e300}, {-1e300, 50},
+                          {NAN, 50}, {50, NAN} };
+
+  /* Random points (a third of them on a half-pixel grid, so some points
+     are exactly on the vertices or horizontal/vertical edges). */
+  x=gal_data_alloc(NULL, GAL_TYPE_FLOAT64, 1, &np, NULL, 0,
+                   -1, 1, NULL, NULL, NULL);
+  y=gal_data_alloc(NULL, GAL_TYPE_FLOAT64, 1, &np, NULL, 0,
+                   -1, 1, NULL, NULL, NULL);
+  for(i=0;i<NPOINTS;++i)
+    {
+      p[0]=random_uniform()*120-5;
+      p[1]=random_uniform()*100-5;
+      if(i%3==0) { p[0]=floor(p[0]*2)/2; p[1]=floor(p[1]*2)/2; }
+      ((double *)(x->array))[i]=p[0];
+      ((double *)(y->array))[i]=p[1];
+      if( gal_polygon_prepared_is_inside(pp, p)!=direct(v, p, n, convex) )
+        ++bad;
+    }
+
+  /* The same points, checked together. */
+  out=gal_polygon_prepared_is_inside_points(pp, x, y, 0);
+  o=out->array;
+  for(i=0;i<NPOINTS;++i)
+    {
+      p[0]=((double *)(x->array))[i];
+      p[1]=((double *)(y->array))[i];
+      if( o[i]!=direct(v, p, n, convex) ) ++bad;
+    }
+
+  /* Points that are infinite, very far or NaN are outside. */
+  for(i=0;i<sizeof far/sizeof *far;++i)
+    if( gal_polygon_prepared_is_inside(pp, far[i]) ) ++bad;
+
+  /* The mask: the center of each pixel is at its FITS coordinate. */
+  mask=gal_polygon_prepared_mask(pp, dsize, 0, -1, 1);
+  o=mask->array;
+  for(r=0;r<dsize[0];++r)
+    for(c=0;c<dsize[1];++c)
+      {
+        p[0]=c+1; p[1]=r+1;
+        if( o[r*dsize[1]+c]!=direct(v, p, n, convex) ) ++bad;
+      }
+
+  /* Report and clean up. */
+  if(bad) fprintf(stderr, "%s: %zu differences\n", name, bad);
+  gal_polygon_prepared_free(pp);
+  gal_data_free(mask);
+  gal_data_free(out);
+  gal_data_free(x);
+  gal_data_free(y);
+  return bad;
+}
+
+
+
+
+
+/* Reverse the order of the vertices (to make them clockwise). */
+static void
+reverse(double *v, size_t n)
+{
+  double t;
+  size_t i, d;
+  for(i=0;i<n/2;++i)
+    for(d=0;d<2;++d)
+      { t=v[2*i+d]; v[2*i+d]=v[2*(n-1-i)+d]; v[2*(n-1-i)+d]=t; }
+}
+
+
+
+
+
+int
+main(void)
+{
+  int trial;
+  size_t i, n, bad=0;
+  double a, rad, v[2*MAXVERT];
+
+  /* Random star-shaped (concave) polygons, in both orders, some with
+     their vertices on integer positions. */
+  for(trial=0;trial<20;++trial)
+    {
+      n = 5 + (size_t)(random_uniform()*(MAXVERT-5));
+      for(i=0;i<n;++i)
+        {
+          a=2*M_PI*i/n;
+          rad=10+30*random_uniform();
+          v[2*i]   = 55+rad*cos(a);
+          v[2*i+1] = 45+rad*sin(a);
+          if(trial%2) { v[2*i]=floor(v[2*i]); v[2*i+1]=floor(v[2*i+1]); }
+        }
+      bad+=check_polygon("concave", v, n, 0);
+      reverse(v, n);
+      bad+=check_polygon("concave (clockwise)", v, n, 0);
+    }
+
+  /* Convex polygons (regular, with a random rotation), in both orders
+     and with both the convex and the general checks. */
+  for(trial=0;trial<10;++trial)
+    {
+      n = 3 + trial*7;
+      a = random_uniform();
+      for(i=0;i<n;++i)
+        {
+          v[2*i]   = 55+35*cos(a+2*M_PI*i/n);
+          v[2*i+1] = 45+35*sin(a+2*M_PI*i/n);
+        }
+      bad+=check_polygon("convex", v, n, 1);
+      bad+=check_polygon("convex (general)", v, n, 0);
+      reverse(v, n);
+      bad+=check_polygon("convex (clockwise)", v, n, 1);
+    }
+
+  /* Degenerate polygons: an axis-aligned rectangle (with edges on the
+     pixel centers), a polygon with repeated and collinear vertices, and
+     polygons with no area (all vertices on a horizontal or a diagonal
+     line). */
+  {
+    double rect[]={10,10, 60,10, 60,50, 10,50};
+    double coll[]={10,10, 30,10, 30,10, 50,10, 50,40, 30,25, 10,40};
+    double flat[]={10,20, 40,20, 70,20};
+    double diag[]={10,10, 30,30, 50,50, 20,20};
+    bad+=check_polygon("rectangle", rect, 4, 1);
+    bad+=check_polygon("rectangle (general)", rect, 4, 0);
+    bad+=check_polygon("collinear", coll, 7, 0);
+    bad+=check_polygon("flat", flat, 3, 0);
+    bad+=check_polygon("diagonal", diag, 4, 0);
+  }
+
+  /* Final result. */
+  if(bad) return EXIT_FAILURE;
+  printf("All prepared polygon checks passed.\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+# Fit a polynomial on separate groups of rows with '--fitgroup' and compare
+# the coefficients with separate fits on the rows of each group.
+#
+# See the Tests subsection of the manual for a complete explanation
+# (in the Installing gnuastro section).
+#
+# Original author:
+#     Mohammad Akhlaghi <mohammad@akhlaghi.org>
+# Contributing author(s):
+# Copyright (C) 2026 Free Software Foundation, Inc.
+#
+# Copying and distribution of this file, with or without modification,
+# are permitted in any medium without royalty provided the copyright
+# notice and this notice are preserved.  This file is offered as-is,
+# without any warranty.
+
+
+
+
+
+# Preliminaries
+# =============
+#
+# Set the variables (The executable is in the build tree). Do the
+# basic checks to see if the executable is made or if the defaults
+# file exists (basicchecks.sh is in the source tree).
+prog=statistics
+execname=../bin/$prog/ast$prog
+table=$topsrc/tests/statistics/fitting-data.txt
+
+
+
+
+
+# Skip?
+# =====
+#
+# If the dependencies of the test don't exist, then skip it. There are two
+# types of dependencies:
+#
+#   - The executable was not made (for example due to a configure option),
+#
+#   - The input data was not made (for example the test that created the
+#     data file failed).
+if [ ! -f $execname ]; then echo "$execname not created."; exit 77; fi
+if [ ! -f $table    ]; then echo "$table does not exist."; exit 77; fi
+
+
+
+
+
+# Input tables
+# ============
+#
+# The rows of the fitting data are distributed between three groups (in
+# an interleaved order, so the rows of each group are not contiguous).
+# Each group is also written in a separate table.
+header="# Column 1: X [,f64,]
+# Column 2: Y [,f64,]
+# Column 3: G [,i32,]"
+echo "$header" > fitting-groups.txt
+for g in 0 1 2; do echo "$header" > fitting-groups-$g.txt; done
+awk '!/^#/ && NF{ g=n++%3; print $1, $2, g >> "fitting-groups.txt";
+                  print $1, $2, g >> ("fitting-groups-" g ".txt") }' $table
+
+
+
+
+
+# Actual test script
+# ==================
+#
+# 'check_with_program' can be something like Valgrind or an empty
+# string. Such programs will execute the command if present and help in
+# debugging when the developer doesn't have access to the user's system.
+$check_with_program $execname fitting-groups.txt -cX,Y --fitgroup=G \
+                              --fit=polynomial --fitmaxpower=2 \
+                              --output=fitting-groups-out.txt
+if [ $? != 0 ]; then exit 1; fi
+
+# The first two columns of the output are the group identifier and the
+# number of rows in it, followed by the three coefficients. The first line
+# of the quiet output of a single fit has the coefficients (printed with
+# 10 decimals).
+for g in 0 1 2; do
+    single=$($execname fitting-groups-$g.txt -cX,Y --fit=polynomial \
+                       --fitmaxpower=2 --quiet | head -1)
+    if [ $? != 0 ]; then exit 1; fi
+    awk -v g=$g -v s="$single" \
+        'BEGIN{ n=split(s, c, " ") }
+         !/^#/ && $1==g { found=1;
+                          for(i=1;i<=3;++i)
+                            { d=$(i+2)-c[i]; if(d<0) d=-d;
+                              if(d>1e-8*(c[i]<0?-c[i]:c[i])+1e-9) bad=1 } }
+         END{ exit (n>=3 && found && bad==0) ? 0 : 1 }' \
+        fitting-groups-out.txt
+    if [ $? != 0 ]; then echo "group $g is different"; exit 1; fi
+done
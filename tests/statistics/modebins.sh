@@ -0,0 +1,115 @@
+# Compare the mode from a cumulative histogram ('--modebins') with the
+# exact mode, and check the fall-back to the exact mode when the sample
+# of the histogram's bin edges only has blank elements.
+#
+# See the Tests subsection of the manual for a complete explanation
+# (in the Installing gnuastro section).
+#
+# Original author:
+#     Mohammad Akhlaghi <mohammad@akhlaghi.org>
+# Contributing author(s):
+# Copyright (C) 2026 Free Software Foundation, Inc.
+#
+# Copying and distribution of this file, with or without modification,
+# are permitted in any medium without royalty provided the copyright
+# notice and this notice are preserved.  This file is offered as-is,
+# without any warranty.
+
+
+
+
+
+# Preliminaries
+# =============
+#
+# Set the variables (The executable is in the build tree). Do the
+# basic checks to see if the executable is made or if the defaults
+# file exists (basicchecks.sh is in the source tree).
+prog=statistics
+execname=../bin/$prog/ast$prog
+converttname=../bin/convertt/astconvertt
+
+
+
+
+
+# Skip?
+# =====
+#
+# If the dependencies of the test don't exist, then skip it. There are two
+# types of dependencies:
+#
+#   - The executable was not made (for example due to a configure option),
+#
+#   - ConvertType (to build the image of the second check) was not made.
+if [ ! -f $execname     ]; then echo "$execname not created.";     exit 77; fi
+if [ ! -f $converttname ]; then echo "$converttname not created."; exit 77; fi
+
+
+
+
+
+# Histogram mode within the documented bound
+# ==========================================
+#
+# The input is 40000 Gaussian values (with a standard deviation of 1) and
+# 10% positive outliers, so it has a clear mode. With 100 bins, the
+# mode's quantile should be within 1/100 of the exact one, and its value
+# within the width of the (equally populated) bins around the exact mode.
+#
+# 'check_with_program' can be something like Valgrind or an empty
+# string. Such programs will execute the command if present and help in
+# debugging when the developer doesn't have access to the user's system.
+awk 'BEGIN{ srand(1664015492); pi=atan2(0,-1);
+            print "# Column 1: V [,f64,]";
+            for(i=0;i<40000;++i)
+              { v=sqrt(-2*log(1-rand()))*cos(2*pi*rand());
+                if(i%10==0) v+=2+4*rand();
+                print v } }' > modebins.txt
+exact=$($execname modebins.txt -cV --mode --modequant)
+if [ $? != 0 ]; then exit 1; fi
+hist=$($check_with_program $execname modebins.txt -cV --mode --modequant \
+                                     --modebins=100)
+if [ $? != 0 ]; then exit 1; fi
+qexact=$(echo "$exact" | awk '{print $2}')
+bounds=$($execname modebins.txt -cV \
+                   --quantile=$(echo $qexact | awk '{q=$1-0.01; print q<0?0:q}') \
+                   --quantile=$(echo $qexact | awk '{q=$1+0.01; print q>1?1:q}'))
+if [ $? != 0 ]; then exit 1; fi
+echo "exact: $exact; histogram: $hist; bounds: $bounds"
+echo "$exact $hist $bounds" \
+    | awk '{ dv=$3-$1; if(dv<0) dv=-dv; dq=$4-$2; if(dq<0) dq=-dq;
+             exit (NF==6 && $1==$1 && dq<=0.01+1e-6 && dv<=$6-$5) ? 0 : 1 }'
+if [ $? != 0 ]; then exit 1; fi
+
+
+
+
+
+# Fall-back to the exact mode
+# ===========================
+#
+# The bin edges come from a regularly spaced sample of the input that
+# starts from its first element. In this 1000x100 image (a single tile),
+# only the last 2000 pixels are not blank, so with two bins, the sample
+# is far too sparse to reach them and only has blank elements. The mode
+# should then be identical to the exact mode.
+awk 'BEGIN{ srand(1664015492); pi=atan2(0,-1);
+            for(r=0;r<100;++r)
+              { for(c=0;c<1000;++c)
+                  if(r<98) printf "nan ";
+                  else printf "%g ", sqrt(-2*log(1-rand()))*cos(2*pi*rand());
+                printf "\n" } }' > modebins-blank.txt
+$converttname modebins-blank.txt --type=float32 --output=modebins-blank.fits
+if [ $? != 0 ]; then exit 1; fi
+for bins in 0 2; do
+    $check_with_program $execname modebins-blank.fits --hdu=1 --ontile \
+                                  --tilesize=1000,100 --oneelempertile \
+                                  --mode --modebins=$bins \
+                                  --output=modebins-blank-$bins.fits
+    if [ $? != 0 ]; then exit 1; fi
+done
+exact=$($execname modebins-blank-0.fits --hdu=1 --maximum)
+hist=$($execname modebins-blank-2.fits --hdu=1 --maximum)
+echo "exact: $exact; histogram (only blank sample): $hist"
+if [ "x$exact" = x ] || [ "x$exact" != "x$hist" ]; then exit 1; fi
@@ -0,0 +1,88 @@
+# Convert a long column of sexagesimal right ascensions (with blank rows
+# and different formats mixed) to degrees on multiple threads and check
+# every row.
+#
+# See the Tests subsection of the manual for a complete explanation
+# (in the Installing gnuastro section).
+#
+# Original author:
+#     Mohammad Akhlaghi <mohammad@akhlaghi.org>
+# Contributing author(s):
+# Copyright (C) 2026 Free Software Foundation, Inc.
+#
+# Copying and distribution of this file, with or without modification,
+# are permitted in any medium without royalty provided the copyright
+# notice and this notice are preserved.  This file is offered as-is,
+# without any warranty.
+
+
+
+
+
+# Preliminaries
+# =============
+#
+# Set the variables (The executable is in the build tree). Do the
+# basic checks to see if the executable is made or if the defaults
+# file exists (basicchecks.sh is in the source tree).
+prog=table
+execname=../bin/$prog/ast$prog
+input=sexagesimal-threads.txt
+
+
+
+
+
+# Skip?
+# =====
+#
+# If the dependencies of the test don't exist, then skip it. There are two
+# types of dependencies:
+#
+#   - The executable was not made (for example due to a configure option),
+if [ ! -f $execname ]; then echo "$execname not created."; exit 77; fi
+
+
+
+
+
+# Input table
+# ===========
+#
+# The rows are converted in chunks of 16384 rows (one chunk on each
+# thread), so the table is long enough to be shared between 4 threads.
+# Every fourth row is blank and the other rows alternate between the
+# 'hms' format, the colon-separated format and an 'hm' format without a
+# trailing 's' (the latter two are not parsed by the fast path).
+awk 'BEGIN{ print "# Column 1: RA [, str20, n/a] Right Ascension";
+            for(i=1;i<=100000;++i)
+              { h=i%24; m=(i*7)%60; s=(i*13)%60+0.25;
+                if(i%4==0)      print "n/a";
+                else if(i%4==1) printf "%dh%dm%gs\n", h, m, s;
+                else if(i%4==2) printf "%d:%d:%g\n",  h, m, s;
+                else            printf "%dh%dm%g\n",  h, m, s; } }' \
+    > $input
+
+
+
+
+
+# Actual test script
+# ==================
+#
+# 'check_with_program' can be something like Valgrind or an empty
+# string. Such programs will execute the command if present and help in
+# debugging when the developer doesn't have access to the user's system.
+$check_with_program $execname $input --numthreads=4 \
+                              -c'arith RA ra-to-degree' \
+                              --output=sexagesimal-threads-out.txt
+if [ $? != 0 ]; then exit 1; fi
+
+# Blank rows should be NaN and the others should be within a rounding
+# error of the expected value.
+awk '!/^#/{ ++i; h=i%24; m=(i*7)%60; s=(i*13)%60+0.25;
+            e=15*(h+m/60+s/3600);
+            if(i%4==0) { if(tolower($1)!="nan") bad=1 }
+            else { d=$1-e; if(d<0) d=-d; if(d>1e-6) bad=1 } }
+     END{ exit (i==100000 && bad==0) ? 0 : 1 }' \
+    sexagesimal-threads-out.txt